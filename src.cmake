@@ -82,6 +82,7 @@ set(RENDERERLIST
     ${ENGINE_DIR}/renderer/shaders.cpp
     ${ENGINE_DIR}/renderer/tr_animation.cpp
     ${ENGINE_DIR}/renderer/tr_backend.cpp
+    ${ENGINE_DIR}/renderer/tr_bench.cpp
     ${ENGINE_DIR}/renderer/tr_bsp.cpp
     ${ENGINE_DIR}/renderer/tr_cmds.cpp
     ${ENGINE_DIR}/renderer/tr_curve.cpp
@@ -100,6 +101,7 @@ set(RENDERERLIST
     ${ENGINE_DIR}/renderer/tr_image_tga.cpp
     ${ENGINE_DIR}/renderer/tr_image_webp.cpp
     ${ENGINE_DIR}/renderer/tr_init.cpp
+    ${ENGINE_DIR}/renderer/tr_jobs.cpp
     ${ENGINE_DIR}/renderer/tr_light.cpp
     ${ENGINE_DIR}/renderer/tr_local.h
     ${ENGINE_DIR}/renderer/tr_main.cpp
@@ -218,9 +220,11 @@ set(SERVERLIST
     ${ENGINE_DIR}/server/server.h
     ${ENGINE_DIR}/server/sg_api.h
     ${ENGINE_DIR}/server/sg_msgdef.h
+    ${ENGINE_DIR}/server/sv_bench.cpp
     ${ENGINE_DIR}/server/sv_bot.cpp
     ${ENGINE_DIR}/server/sv_ccmds.cpp
     ${ENGINE_DIR}/server/sv_client.cpp
+    ${ENGINE_DIR}/server/sv_http.cpp
     ${ENGINE_DIR}/server/sv_init.cpp
     ${ENGINE_DIR}/server/sv_main.cpp
     ${ENGINE_DIR}/server/sv_net_chan.cpp
@@ -250,6 +254,8 @@ set(ENGINELIST
     ${ENGINE_DIR}/framework/CvarSystem.h
     ${ENGINE_DIR}/framework/LogSystem.cpp
     ${ENGINE_DIR}/framework/LogSystem.h
+    ${ENGINE_DIR}/framework/Profiler.cpp
+    ${ENGINE_DIR}/framework/Profiler.h
     ${ENGINE_DIR}/framework/Resource.cpp
     ${ENGINE_DIR}/framework/Resource.h
     ${ENGINE_DIR}/framework/System.cpp
@@ -324,6 +330,7 @@ set(CLIENTBASELIST
     ${ENGINE_DIR}/client/cl_main.cpp
     ${ENGINE_DIR}/client/cl_parse.cpp
     ${ENGINE_DIR}/client/cl_scrn.cpp
+    ${ENGINE_DIR}/client/cl_serverquery.cpp
     ${ENGINE_DIR}/client/dl_main.cpp
     ${ENGINE_DIR}/client/keycodes.h
     ${ENGINE_DIR}/client/keys.h
@@ -343,6 +350,8 @@ set(CLIENTLIST
     ${ENGINE_DIR}/audio/OpusCodec.cpp
     ${ENGINE_DIR}/audio/Sample.cpp
     ${ENGINE_DIR}/audio/Sample.h
+    ${ENGINE_DIR}/audio/SampleCache.cpp
+    ${ENGINE_DIR}/audio/SampleCache.h
     ${ENGINE_DIR}/audio/Sound.cpp
     ${ENGINE_DIR}/audio/Sound.h
     ${ENGINE_DIR}/audio/SoundCodec.cpp
@@ -53,6 +53,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <fcntl.h>
 #include <dirent.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #endif
 #ifdef __APPLE__
 #include <mach-o/dyld.h>
@@ -648,6 +649,66 @@ void File::SetLineBuffered(bool enable, std::error_code& err) const
 		ClearErrorCode(err);
 }
 
+#ifndef BUILD_VM
+MappedFile MappedFile::Map(const File& file, std::error_code& err)
+{
+	MappedFile out;
+	offset_t length = file.Length(err);
+	if (err)
+		return out;
+
+	// Empty files can't be mapped, but there is nothing to map anyways
+	if (length == 0) {
+		ClearErrorCode(err);
+		return out;
+	}
+	if (static_cast<uint64_t>(length) > std::numeric_limits<size_t>::max()) {
+		SetErrorCode(err, EFBIG, std::generic_category());
+		return out;
+	}
+
+#ifdef _WIN32
+	HANDLE mapping = CreateFileMappingW(reinterpret_cast<HANDLE>(_get_osfhandle(fileno(file.GetHandle()))), nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping) {
+		SetErrorCode(err, GetLastError(), std::system_category());
+		return out;
+	}
+
+	// The view keeps a reference to the mapping object
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	DWORD error = GetLastError();
+	CloseHandle(mapping);
+	if (!view) {
+		SetErrorCode(err, error, std::system_category());
+		return out;
+	}
+#else
+	void* view = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fileno(file.GetHandle()), 0);
+	if (view == MAP_FAILED) {
+		SetErrorCodeSystem(err);
+		return out;
+	}
+#endif
+
+	out.data = view;
+	out.size = length;
+	ClearErrorCode(err);
+	return out;
+}
+void MappedFile::Close()
+{
+	if (data) {
+#ifdef _WIN32
+		UnmapViewOfFile(data);
+#else
+		munmap(const_cast<void*>(data), size);
+#endif
+		data = nullptr;
+		size = 0;
+	}
+}
+#endif // BUILD_VM
+
 #ifdef BUILD_VM
 // Convert an IPC file handle to a File object
 static File FileFromIPC(Util::optional<IPC::OwnedFileHandle> ipcFile, openMode_t mode, std::error_code& err)
@@ -970,6 +1031,25 @@ static LoadedPakGuard loadedPaksGuard;
 // the offset_t is the position within the zip archive (unused for PAK_DIR).
 static std::unordered_map<std::string, std::pair<uint32_t, offset_t>> fileMap;
 
+// Map of filenames without their extension to the extensions they exist with,
+// ordered by the offset into loadedPaks. This lets asset loaders which accept
+// several formats find the best one with a single lookup.
+static std::unordered_map<std::string, std::vector<std::pair<std::string, uint32_t>>> extensionMap;
+
+// Add a file which was just added to fileMap to extensionMap
+static void AddToExtensionMap(Str::StringRef filename, uint32_t pakIndex)
+{
+	size_t dot = filename.rfind('.');
+	if (dot == std::string::npos || filename.find('/', dot) != std::string::npos)
+		return;
+
+	auto& extensions = extensionMap[filename.substr(0, dot)];
+	auto pos = std::find_if(extensions.begin(), extensions.end(), [pakIndex](const std::pair<std::string, uint32_t>& x) {
+		return x.second > pakIndex;
+	});
+	extensions.emplace(pos, filename.substr(dot + 1), pakIndex);
+}
+
 #ifndef BUILD_VM
 // Parse the dependencies file of a package
 // Each line of the dependencies file is a name followed by an optional version
@@ -1079,10 +1159,11 @@ static void InternalLoadPak(const PakInfo& pak, Util::optional<uint32_t> expecte
 				hasDeps = true;
 			else if (!Str::IsSuffix("/", *it) && Str::IsPrefix(pathPrefix, *it)) {
 #ifdef LIBSTDCXX_BROKEN_CXX11
-				fileMap.insert({*it, std::pair<uint32_t, offset_t>(loadedPaks.size() - 1, 0)});
+				if (fileMap.insert({*it, std::pair<uint32_t, offset_t>(loadedPaks.size() - 1, 0)}).second)
 #else
-				fileMap.emplace(*it, std::pair<uint32_t, offset_t>(loadedPaks.size() - 1, 0));
+				if (fileMap.emplace(*it, std::pair<uint32_t, offset_t>(loadedPaks.size() - 1, 0)).second)
 #endif
+					AddToExtensionMap(*it, loadedPaks.size() - 1);
 			}
 			it.increment(err);
 			if (err)
@@ -1120,10 +1201,11 @@ static void InternalLoadPak(const PakInfo& pak, Util::optional<uint32_t> expecte
 				return;
 			}
 #ifdef LIBSTDCXX_BROKEN_CXX11
-			fileMap.insert({filename, std::pair<uint32_t, offset_t>(loadedPaks.size() - 1, offset)});
+			if (fileMap.insert({filename, std::pair<uint32_t, offset_t>(loadedPaks.size() - 1, offset)}).second)
 #else
-			fileMap.emplace(filename, std::pair<uint32_t, offset_t>(loadedPaks.size() - 1, offset));
+			if (fileMap.emplace(filename, std::pair<uint32_t, offset_t>(loadedPaks.size() - 1, offset)).second)
 #endif
+				AddToExtensionMap(filename, loadedPaks.size() - 1);
 		}, err);
 		if (err)
 			return;
@@ -1193,6 +1275,7 @@ void LoadPakExplicit(const PakInfo& pak, uint32_t expectedChecksum, std::error_c
 void ClearPaks()
 {
 	fileMap.clear();
+	extensionMap.clear();
 	for (LoadedPakInfo& x: loadedPaks) {
 		if (x.fd != -1)
 			close(x.fd);
@@ -1348,6 +1431,16 @@ const LoadedPakInfo* LocateFile(Str::StringRef path)
 		return &loadedPaks[it->second.first];
 }
 
+const std::vector<std::pair<std::string, uint32_t>>& LocateExtensions(Str::StringRef basePath)
+{
+	static const std::vector<std::pair<std::string, uint32_t>> empty;
+	auto it = extensionMap.find(basePath);
+	if (it == extensionMap.end())
+		return empty;
+	else
+		return it->second;
+}
+
 std::chrono::system_clock::time_point FileTimestamp(Str::StringRef path, std::error_code& err)
 {
 	auto it = fileMap.find(path);
@@ -2051,6 +2144,10 @@ void Initialize()
 	}
 
 	VM::SendMsg<VM::FSInitializeMsg>(homePath, libPath, availablePaks, PakPath::loadedPaks, PakPath::fileMap);
+
+	PakPath::extensionMap.clear();
+	for (auto& x: PakPath::fileMap)
+		PakPath::AddToExtensionMap(x.first, x.second.first);
 }
 #else
 // Get an absolute path from a relative one. This may fail if the path does not
@@ -2351,6 +2448,33 @@ const PakInfo* FindPak(Str::StringRef name, Str::StringRef version, uint32_t che
 	return &*(iter - 1);
 }
 
+#ifndef BUILD_VM
+uint32_t ComputePakChecksum(Str::StringRef path, std::error_code& err)
+{
+	int fd = my_open(path, openMode_t::MODE_READ);
+	if (fd == -1) {
+		SetErrorCodeSystem(err);
+		return 0;
+	}
+
+	// Same files as LoadPak uses for a pak without a path prefix
+	uint32_t checksum = crc32(0, Z_NULL, 0);
+	{
+		ZipArchive zipFile = ZipArchive::Open(fd, err);
+		if (!err) {
+			zipFile.ForEachFile([&checksum](Str::StringRef filename, offset_t, uint32_t crc) {
+				if (Str::IsSuffix("/", filename) || !Path::IsValid(filename, false))
+					return;
+				checksum = crc32(checksum, reinterpret_cast<const Bytef*>(&crc), sizeof(crc));
+			}, err);
+		}
+	}
+
+	close(fd);
+	return checksum;
+}
+#endif // BUILD_VM
+
 bool ParsePakName(const char* begin, const char* end, std::string& name, std::string& version, Util::optional<uint32_t>& checksum)
 {
 	const char* nameStart = std::find(std::reverse_iterator<const char*>(end), std::reverse_iterator<const char*>(begin), '/').base();
@@ -133,6 +133,56 @@ private:
 	FILE* fd;
 };
 
+#ifndef BUILD_VM
+// Read-only view of the entire contents of a file mapped into memory. The
+// mapping stays valid after the File it was created from is closed.
+class MappedFile {
+public:
+	MappedFile()
+		: data(nullptr), size(0) {}
+
+	// Mappings are noncopyable but movable
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other)
+		: data(other.data), size(other.size)
+	{
+		other.data = nullptr;
+		other.size = 0;
+	}
+	MappedFile& operator=(MappedFile&& other)
+	{
+		std::swap(data, other.data);
+		std::swap(size, other.size);
+		return *this;
+	}
+
+	// Map the whole of an open file
+	static MappedFile Map(const File& file, std::error_code& err = throws());
+
+	// Unmap the file
+	void Close();
+	~MappedFile()
+	{
+		Close();
+	}
+
+	// Contents of the file, null if the file is empty
+	const void* Data() const
+	{
+		return data;
+	}
+	size_t Size() const
+	{
+		return size;
+	}
+
+private:
+	const void* data;
+	size_t size;
+};
+#endif // BUILD_VM
+
 // Path manipulation functions
 namespace Path {
 
@@ -309,6 +359,11 @@ namespace PakPath {
 	// Get the pak a file is in, or null if the file does not exist
 	const LoadedPakInfo* LocateFile(Str::StringRef path);
 
+	// Get the extensions (without the dot) that a file exists with, given its
+	// path without extension. Each extension comes with the offset of its pak
+	// in GetLoadedPaks() and the list is sorted by that offset, so pak priority.
+	const std::vector<std::pair<std::string, uint32_t>>& LocateExtensions(Str::StringRef basePath);
+
 	// Get the timestamp of a file
 	std::chrono::system_clock::time_point FileTimestamp(Str::StringRef path, std::error_code& err = throws());
 
@@ -491,6 +546,10 @@ bool IsInitialized();
 #ifndef BUILD_VM
 // Refresh the list of available paks
 void RefreshPaks();
+
+// Calculate the checksum of a pak file the way loading it does, to check a
+// file before it is added to the available paks
+uint32_t ComputePakChecksum(Str::StringRef path, std::error_code& err = throws());
 #endif
 
 // Find a pak by name, version or checksum. Note that the checksum may not match
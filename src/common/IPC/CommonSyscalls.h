@@ -178,6 +178,15 @@ namespace VM {
         IPC::Message<IPC::Id<MISC, CRASH_DUMP>, std::vector<uint8_t>>
     >;
 
+    enum VMMiscMessages {
+        SHARE_COLLISION_MODEL,
+    };
+
+    // ShareCollisionModelMsg, sent before the VM loads the map
+    using ShareCollisionModelMsg = IPC::SyncMessage<
+        IPC::Message<IPC::Id<MISC, SHARE_COLLISION_MODEL>, IPC::SharedMemory>
+    >;
+
     // Command-Related Syscall Definitions
 
     enum EngineCommandMessages {
@@ -35,14 +35,18 @@ Maryland 20850 USA.
 #include "cm_local.h"
 
 #include <common/FileSystem.h>
+#include <common/IPC/Primitives.h>
+
+#include <mutex>
+#include <random>
 
 // to allow boxes to be treated as brush models, we allocate
 // some extra indexes along with those needed by the map
 static const int BOX_LEAF_BRUSHES = 1; // ydnar
-static const int BOX_BRUSHES      = 1;
 static const int BOX_SIDES        = 6;
 static const int BOX_LEAFS        = 2;
 static const int BOX_PLANES       = 12;
+static const int BOX_EDGES        = 12;
 
 #define LL( x ) x = LittleLong( x )
 
@@ -53,6 +57,14 @@ int       c_traces, c_brush_traces, c_patch_traces, c_trisoup_traces;
 cmodel_t  box_model;
 cplane_t  *box_planes;
 cbrush_t  *box_brush;
+cBrushState_t box_brushState;
+
+// the box hull is changed by every CM_TempBoxModel, so it stays out of
+// the shared collision model
+static cplane_t     boxPlanes[ BOX_PLANES ];
+static cbrushside_t boxSides[ BOX_SIDES ];
+static cbrushedge_t boxEdges[ BOX_EDGES ];
+static cbrush_t     boxBrush;
 
 void      CM_InitBoxHull();
 void      CM_FloodAreaConnections();
@@ -60,23 +72,38 @@ void      CM_FloodAreaConnections();
 Cvar::Cvar<bool> cm_forceTriangles(VM_STRING_PREFIX "cm_forceTriangles", "Convert all patches into triangles?", Cvar::CHEAT | Cvar::ROM, false);
 Log::Logger cmLog(VM_STRING_PREFIX "common.cm");
 
+#ifndef BUILD_VM
+static Cvar::Cvar<bool> cm_shareModel("cm_shareModel", "share a copy of the collision model with the VMs instead of having them load it", Cvar::NONE, true);
+#else
+// the model the engine sent for the next CM_LoadMap
+static IPC::SharedMemory receivedModel;
+#endif
+
+// the copy of the model shared with the VMs; the VMs trace against it,
+// the engine only keeps it to hand it out
+static IPC::SharedMemory sharedModel;
+
 static std::vector<void*> allocations;
+static std::mutex allocationMutex;
 
 void* CM_Alloc( int size )
 {
     void* alloc = malloc(size);
 	memset(alloc, 0, size);
+    std::lock_guard<std::mutex> lock(allocationMutex);
     allocations.push_back(alloc);
     return alloc;
 }
 
 void CM_FreeAll()
 {
+    std::lock_guard<std::mutex> lock(allocationMutex);
     for (auto alloc : allocations)
     {
         free(alloc);
     }
     allocations.clear();
+    sharedModel = IPC::SharedMemory();
 }
 
 /*
@@ -278,7 +305,7 @@ void CMod_LoadBrushes(const byte *const cmod_base, lump_t *l)
 
 	count = l->filelen / sizeof( *in );
 
-	cm.brushes = ( cbrush_t * ) CM_Alloc( ( BOX_BRUSHES + count ) * sizeof( *cm.brushes ) );
+	cm.brushes = ( cbrush_t * ) CM_Alloc( count * sizeof( *cm.brushes ) );
 	cm.numBrushes = count;
 
 	out = cm.brushes;
@@ -351,9 +378,6 @@ void CMod_LoadLeafs(const byte *const cmod_base, lump_t *l)
 			cm.numAreas = out->area + 1;
 		}
 	}
-
-	cm.areas = ( cArea_t * ) CM_Alloc( cm.numAreas * sizeof( *cm.areas ) );
-	cm.areaPortals = ( int * ) CM_Alloc( cm.numAreas * cm.numAreas * sizeof( *cm.areaPortals ) );
 }
 
 /*
@@ -382,7 +406,7 @@ void CMod_LoadPlanes(const byte *const cmod_base, lump_t *l)
 		Sys::Drop( "Map with no planes" );
 	}
 
-	cm.planes = ( cplane_t * ) CM_Alloc( ( BOX_PLANES + count ) * sizeof( *cm.planes ) );
+	cm.planes = ( cplane_t * ) CM_Alloc( count * sizeof( *cm.planes ) );
 	cm.numPlanes = count;
 
 	out = cm.planes;
@@ -488,7 +512,7 @@ void CMod_LoadBrushSides(const byte *const cmod_base, lump_t *l)
 
 	count = l->filelen / sizeof( *in );
 
-	cm.brushsides = ( cbrushside_t * ) CM_Alloc( ( BOX_SIDES + count ) * sizeof( *cm.brushsides ) );
+	cm.brushsides = ( cbrushside_t * ) CM_Alloc( count * sizeof( *cm.brushsides ) );
 	cm.numBrushSides = count;
 
 	out = cm.brushsides;
@@ -576,11 +600,13 @@ static void CMod_CreateBrushSideWindings()
 	int          edgesAlloc;
 	int          totalEdgesAlloc = 0;
 	int          totalEdges = 0;
+	std::vector<winding_t *> windings;
 
 	for ( i = 0; i < cm.numBrushes; i++ )
 	{
 		brush = &cm.brushes[ i ];
 		numEdges = 0;
+		windings.assign( brush->numsides, nullptr );
 
 		// walk the list of brush sides
 		for ( j = 0; j < brush->numsides; j++ )
@@ -616,7 +642,7 @@ static void CMod_CreateBrushSideWindings()
 			}
 
 			// set side winding
-			side->winding = w;
+			windings[ j ] = w;
 		}
 
 		// Allocate a temporary buffer of the maximal size
@@ -626,22 +652,21 @@ static void CMod_CreateBrushSideWindings()
 		// compose the points into edges
 		for ( j = 0; j < brush->numsides; j++ )
 		{
-			side = &brush->sides[ j ];
+			w = windings[ j ];
 
-			if ( side->winding )
+			if ( w )
 			{
-				for ( k = 0; k < side->winding->numpoints - 1; k++ )
+				for ( k = 0; k < w->numpoints - 1; k++ )
 				{
 					if ( brush->numEdges == numEdges )
 					{
 						Sys::Error( "Insufficient memory allocated for collision map edges" );
 					}
 
-					CMod_AddEdgeToBrush( side->winding->p[ k ], side->winding->p[ k + 1 ], tempEdges, &brush->numEdges );
+					CMod_AddEdgeToBrush( w->p[ k ], w->p[ k + 1 ], tempEdges, &brush->numEdges );
 				}
 
-				FreeWinding( side->winding );
-				side->winding = nullptr;
+				FreeWinding( w );
 			}
 		}
 
@@ -782,6 +807,12 @@ void CMod_LoadSurfaces(const byte *const cmod_base, lump_t *surfs, lump_t *verts
 	int           *index;
 	int           *index_p;
 
+	// patches are collected and generated together at the end,
+	// their points are packed in patchPoints
+	std::vector<cPatchBuild_t> patches;
+	std::vector<int>           patchSurfaces;
+	std::vector<float>         patchPoints;
+
 	in = ( dsurface_t * )( cmod_base + surfs->fileofs );
 
 	if ( surfs->filelen % sizeof( *in ) )
@@ -790,7 +821,7 @@ void CMod_LoadSurfaces(const byte *const cmod_base, lump_t *surfs, lump_t *verts
 	}
 
 	cm.numSurfaces = count = surfs->filelen / sizeof( *in );
-	cm.surfaces = ( cSurface_t ** ) CM_Alloc( cm.numSurfaces * sizeof( cm.surfaces[ 0 ] ) );
+	cm.surfaces = ( cmPtr_t<cSurface_t> * ) CM_Alloc( cm.numSurfaces * sizeof( cm.surfaces[ 0 ] ) );
 
 	dv = ( drawVert_t * )( cmod_base + verts->fileofs );
 
@@ -831,17 +862,18 @@ void CMod_LoadSurfaces(const byte *const cmod_base, lump_t *surfs, lump_t *verts
 
 			for ( j = 0; j < numVertexes; j++, dv_p++ )
 			{
-				vertexes[ j ][ 0 ] = LittleFloat( dv_p->xyz[ 0 ] );
-				vertexes[ j ][ 1 ] = LittleFloat( dv_p->xyz[ 1 ] );
-				vertexes[ j ][ 2 ] = LittleFloat( dv_p->xyz[ 2 ] );
+				patchPoints.push_back( LittleFloat( dv_p->xyz[ 0 ] ) );
+				patchPoints.push_back( LittleFloat( dv_p->xyz[ 1 ] ) );
+				patchPoints.push_back( LittleFloat( dv_p->xyz[ 2 ] ) );
 			}
 
 			shaderNum = LittleLong( in->shaderNum );
 			surface->contents = cm.shaders[ shaderNum ].contentFlags;
 			surface->surfaceFlags = cm.shaders[ shaderNum ].surfaceFlags;
 
-			// create the internal facet structure
-			surface->sc = CM_GeneratePatchCollide( width, height, vertexes );
+			// the internal facet structure is created below
+			patches.push_back( { width, height, nullptr, nullptr } );
+			patchSurfaces.push_back( i );
 		}
 		else if ( LittleLong( in->surfaceType ) == mapSurfaceType_t::MST_TRIANGLE_SOUP && ( cm.perPolyCollision || cm_forceTriangles.Get() ) )
 		{
@@ -894,7 +926,505 @@ void CMod_LoadSurfaces(const byte *const cmod_base, lump_t *surfs, lump_t *verts
 			surface->sc = CM_GenerateTriangleSoupCollide( numVertexes, vertexes, numIndexes, indexes );
 		}
 	}
+
+	// create the internal facet structures of the patches
+	size_t offset = 0;
+
+	for ( cPatchBuild_t &patch : patches )
+	{
+		patch.points = reinterpret_cast<vec3_t *>( patchPoints.data() + offset );
+		offset += 3 * patch.width * patch.height;
+	}
+
+	CM_GeneratePatchCollides( patches.data(), patches.size() );
+
+	for ( size_t n = 0; n < patches.size(); n++ )
+	{
+		cm.surfaces[ patchSurfaces[ n ] ]->sc = patches[ n ].sc;
+	}
+}
+
+/*
+===============================================================================
+
+                                        SHARED MODEL
+
+The engine copies the collision model of the map it loaded into one
+block of shared memory and sends it to the VMs before they load the
+same map. Everything in the block is read only; the state that traces
+and area portals change is allocated by each process.
+
+===============================================================================
+*/
+
+static const char CM_SHARED_IDENT[ 4 ] = { 'D', 'C', 'M', 'S' };
+static const int  CM_SHARED_VERSION = 1;
+static const int  CM_SHARED_LAYOUT = 13;
+
+struct cmSharedHeader_t
+{
+	char     ident[ 4 ];
+	int      version;
+	int      layout[ CM_SHARED_LAYOUT ];
+	char     name[ MAX_QPATH ];
+	uint32_t size;
+
+	int      numShaders;
+	int      numBrushSides;
+	int      numPlanes;
+	int      numNodes;
+	int      numLeafs;
+	int      numLeafBrushes;
+	int      numLeafSurfaces;
+	int      numSubModels;
+	int      numBrushes;
+	int      numClusters;
+	int      clusterBytes;
+	int      vised;
+	int      numEntityChars;
+	int      numAreas;
+	int      numSurfaces;
+	int      perPolyCollision;
+
+	// offsets from the start of the header
+	uint32_t shaders;
+	uint32_t brushsides;
+	uint32_t planes;
+	uint32_t nodes;
+	uint32_t leafs;
+	uint32_t leafbrushes;
+	uint32_t leafsurfaces;
+	uint32_t cmodels;
+	uint32_t brushes;
+	uint32_t visibility;
+	uint32_t entityString;
+	uint32_t surfaces;
+};
+
+/*
+==================
+CM_SharedLayout
+
+The sizes of the shared structures, a VM built for another pointer size
+or with other structures can't use the model
+==================
+*/
+static void CM_SharedLayout( int layout[ CM_SHARED_LAYOUT ] )
+{
+	int n = 0;
+
+	layout[ n++ ] = sizeof( cmSharedHeader_t );
+	layout[ n++ ] = sizeof( dshader_t );
+	layout[ n++ ] = sizeof( cbrushside_t );
+	layout[ n++ ] = sizeof( cplane_t );
+	layout[ n++ ] = sizeof( cNode_t );
+	layout[ n++ ] = sizeof( cLeaf_t );
+	layout[ n++ ] = sizeof( cmodel_t );
+	layout[ n++ ] = sizeof( cbrush_t );
+	layout[ n++ ] = sizeof( cbrushedge_t );
+	layout[ n++ ] = sizeof( cSurface_t );
+	layout[ n++ ] = sizeof( cSurfaceCollide_t );
+	layout[ n++ ] = sizeof( cPlane_t );
+	layout[ n++ ] = sizeof( cFacet_t );
+}
+
+static size_t CM_SharedVisibilitySize()
+{
+	return cm.vised ? cm.numClusters * cm.clusterBytes : cm.clusterBytes;
+}
+
+/*
+==================
+CM_InitPrivateState
+
+Allocates what every process changes on its own, for a shared model as
+well as a loaded one
+==================
+*/
+static void CM_InitPrivateState()
+{
+	cm.brushStates = ( cBrushState_t * ) CM_Alloc( cm.numBrushes * sizeof( *cm.brushStates ) );
+	cm.surfaceCheckCounts = ( int * ) CM_Alloc( cm.numSurfaces * sizeof( *cm.surfaceCheckCounts ) );
+	cm.areas = ( cArea_t * ) CM_Alloc( cm.numAreas * sizeof( *cm.areas ) );
+	cm.areaPortals = ( int * ) CM_Alloc( cm.numAreas * cm.numAreas * sizeof( *cm.areaPortals ) );
+
+	CM_InitBoxHull();
+
+	CM_FloodAreaConnections();
+}
+
+/*
+==================
+CM_PointAtSharedModel
+
+Points the model arrays of cm at a shared model, returns false when it
+is not usable by this process or not the model of the map
+==================
+*/
+static bool CM_PointAtSharedModel( const IPC::SharedMemory &shm, Str::StringRef name )
+{
+	const byte *base = static_cast<const byte *>( shm.GetBase() );
+	const cmSharedHeader_t *header = reinterpret_cast<const cmSharedHeader_t *>( base );
+	int layout[ CM_SHARED_LAYOUT ];
+
+	CM_SharedLayout( layout );
+
+	if ( shm.GetSize() < sizeof( *header ) || memcmp( header->ident, CM_SHARED_IDENT, sizeof( header->ident ) )
+	     || header->version != CM_SHARED_VERSION || header->size > shm.GetSize() )
+	{
+		cmLog.Warn( "the shared collision model is invalid" );
+		return false;
+	}
+
+	// every array has to be inside the block
+	auto fits = [ header ]( uint32_t offset, int count, size_t elementSize )
+	{
+		return count >= 0 && offset <= header->size
+		       && static_cast<uint64_t>( count ) * elementSize <= header->size - offset;
+	};
+
+	if ( !fits( header->shaders, header->numShaders, sizeof( dshader_t ) )
+	     || !fits( header->brushsides, header->numBrushSides, sizeof( cbrushside_t ) )
+	     || !fits( header->planes, header->numPlanes, sizeof( cplane_t ) )
+	     || !fits( header->nodes, header->numNodes, sizeof( cNode_t ) )
+	     || !fits( header->leafs, header->numLeafs + BOX_LEAFS, sizeof( cLeaf_t ) )
+	     || !fits( header->leafbrushes, header->numLeafBrushes + BOX_LEAF_BRUSHES, sizeof( int ) )
+	     || !fits( header->leafsurfaces, header->numLeafSurfaces, sizeof( int ) )
+	     || !fits( header->cmodels, header->numSubModels, sizeof( cmodel_t ) )
+	     || !fits( header->brushes, header->numBrushes, sizeof( cbrush_t ) )
+	     || !fits( header->entityString, header->numEntityChars + 1, 1 )
+	     || !fits( header->surfaces, header->numSurfaces, sizeof( cmPtr_t<cSurface_t> ) ) )
+	{
+		cmLog.Warn( "the shared collision model is invalid" );
+		return false;
+	}
+
+	if ( memcmp( header->layout, layout, sizeof( layout ) ) )
+	{
+		cmLog.Notice( "the shared collision model was built for another architecture" );
+		return false;
+	}
+
+	if ( Q_stricmp( header->name, name.c_str() ) )
+	{
+		return false;
+	}
+
+	cm.numShaders = header->numShaders;
+	cm.numBrushSides = header->numBrushSides;
+	cm.numPlanes = header->numPlanes;
+	cm.numNodes = header->numNodes;
+	cm.numLeafs = header->numLeafs;
+	cm.numLeafBrushes = header->numLeafBrushes;
+	cm.numLeafSurfaces = header->numLeafSurfaces;
+	cm.numSubModels = header->numSubModels;
+	cm.numBrushes = header->numBrushes;
+	cm.numClusters = header->numClusters;
+	cm.clusterBytes = header->clusterBytes;
+	cm.vised = header->vised;
+	cm.numEntityChars = header->numEntityChars;
+	cm.numAreas = header->numAreas;
+	cm.numSurfaces = header->numSurfaces;
+	cm.perPolyCollision = header->perPolyCollision;
+
+	// nothing writes through these, the casts only drop the const of the mapping
+	byte *data = const_cast<byte *>( base );
+	cm.shaders = reinterpret_cast<dshader_t *>( data + header->shaders );
+	cm.brushsides = reinterpret_cast<cbrushside_t *>( data + header->brushsides );
+	cm.planes = reinterpret_cast<cplane_t *>( data + header->planes );
+	cm.nodes = reinterpret_cast<cNode_t *>( data + header->nodes );
+	cm.leafs = reinterpret_cast<cLeaf_t *>( data + header->leafs );
+	cm.leafbrushes = reinterpret_cast<int *>( data + header->leafbrushes );
+	cm.leafsurfaces = reinterpret_cast<int *>( data + header->leafsurfaces );
+	cm.cmodels = reinterpret_cast<cmodel_t *>( data + header->cmodels );
+	cm.brushes = reinterpret_cast<cbrush_t *>( data + header->brushes );
+	cm.visibility = data + header->visibility;
+	cm.entityString = reinterpret_cast<char *>( data + header->entityString );
+	cm.surfaces = reinterpret_cast<cmPtr_t<cSurface_t> *>( data + header->surfaces );
+
+	return true;
+}
+
+#ifndef BUILD_VM
+/*
+==================
+CM_ShareModel
+
+Copies the model that was just loaded into shared memory for the VMs.
+Every VM can write to the block, so the engine keeps tracing against
+its own copy.
+==================
+*/
+static void CM_ShareModel( Str::StringRef name )
+{
+	auto align = []( size_t size ) { return ( size + 7 ) & ~size_t( 7 ); };
+
+	// add up the size of everything
+	size_t size = align( sizeof( cmSharedHeader_t ) );
+	size += align( cm.numShaders * sizeof( *cm.shaders ) );
+	size += align( cm.numBrushSides * sizeof( *cm.brushsides ) );
+	size += align( cm.numPlanes * sizeof( *cm.planes ) );
+	size += align( cm.numNodes * sizeof( *cm.nodes ) );
+	size += align( ( cm.numLeafs + BOX_LEAFS ) * sizeof( *cm.leafs ) );
+	size += align( ( cm.numLeafBrushes + BOX_LEAF_BRUSHES ) * sizeof( *cm.leafbrushes ) );
+	size += align( cm.numLeafSurfaces * sizeof( *cm.leafsurfaces ) );
+	size += align( cm.numSubModels * sizeof( *cm.cmodels ) );
+	size += align( cm.numBrushes * sizeof( *cm.brushes ) );
+	size += align( CM_SharedVisibilitySize() );
+	size += align( cm.numEntityChars + 1 );
+	size += align( cm.numSurfaces * sizeof( *cm.surfaces ) );
+
+	for ( int i = 0; i < cm.numBrushes; i++ )
+	{
+		size += align( cm.brushes[ i ].numEdges * sizeof( cbrushedge_t ) );
+	}
+
+	for ( int i = 0; i < cm.numSurfaces; i++ )
+	{
+		const cSurface_t *surface = cm.surfaces[ i ];
+
+		if ( surface )
+		{
+			size += align( sizeof( cSurface_t ) ) + align( sizeof( cSurfaceCollide_t ) );
+			size += align( surface->sc->numPlanes * sizeof( cPlane_t ) );
+			size += align( surface->sc->numFacets * sizeof( cFacet_t ) );
+		}
+	}
+
+	if ( size > UINT32_MAX )
+	{
+		cmLog.Warn( "collision model too large to be shared" );
+		return;
+	}
+
+	IPC::SharedMemory shm = IPC::SharedMemory::Create( size );
+	byte *base = static_cast<byte *>( shm.GetBase() );
+	size_t used = 0;
+
+	// copies raw bytes, the pointers in the copy are fixed up below
+	auto copy = [ & ]( const void *data, size_t bytes ) -> uint32_t
+	{
+		uint32_t offset = used;
+		memcpy( base + offset, data, bytes );
+		used += align( bytes );
+		return offset;
+	};
+
+	cmSharedHeader_t *header = reinterpret_cast<cmSharedHeader_t *>( base );
+	used = align( sizeof( *header ) );
+
+	memcpy( header->ident, CM_SHARED_IDENT, sizeof( header->ident ) );
+	header->version = CM_SHARED_VERSION;
+	CM_SharedLayout( header->layout );
+	Q_strncpyz( header->name, name.c_str(), sizeof( header->name ) );
+	header->size = size;
+
+	header->numShaders = cm.numShaders;
+	header->numBrushSides = cm.numBrushSides;
+	header->numPlanes = cm.numPlanes;
+	header->numNodes = cm.numNodes;
+	header->numLeafs = cm.numLeafs;
+	header->numLeafBrushes = cm.numLeafBrushes;
+	header->numLeafSurfaces = cm.numLeafSurfaces;
+	header->numSubModels = cm.numSubModels;
+	header->numBrushes = cm.numBrushes;
+	header->numClusters = cm.numClusters;
+	header->clusterBytes = cm.clusterBytes;
+	header->vised = cm.vised;
+	header->numEntityChars = cm.numEntityChars;
+	header->numAreas = cm.numAreas;
+	header->numSurfaces = cm.numSurfaces;
+	header->perPolyCollision = cm.perPolyCollision;
+
+	header->shaders = copy( cm.shaders, cm.numShaders * sizeof( *cm.shaders ) );
+	header->planes = copy( cm.planes, cm.numPlanes * sizeof( *cm.planes ) );
+	header->brushsides = copy( cm.brushsides, cm.numBrushSides * sizeof( *cm.brushsides ) );
+	header->nodes = copy( cm.nodes, cm.numNodes * sizeof( *cm.nodes ) );
+	header->leafs = copy( cm.leafs, ( cm.numLeafs + BOX_LEAFS ) * sizeof( *cm.leafs ) );
+	header->leafbrushes = copy( cm.leafbrushes, ( cm.numLeafBrushes + BOX_LEAF_BRUSHES ) * sizeof( *cm.leafbrushes ) );
+	header->leafsurfaces = copy( cm.leafsurfaces, cm.numLeafSurfaces * sizeof( *cm.leafsurfaces ) );
+	header->cmodels = copy( cm.cmodels, cm.numSubModels * sizeof( *cm.cmodels ) );
+	header->brushes = copy( cm.brushes, cm.numBrushes * sizeof( *cm.brushes ) );
+	header->visibility = copy( cm.visibility, CM_SharedVisibilitySize() );
+	header->entityString = copy( cm.entityString, cm.numEntityChars + 1 );
+	header->surfaces = used;
+	used += align( cm.numSurfaces * sizeof( *cm.surfaces ) );
+
+	cplane_t *planes = reinterpret_cast<cplane_t *>( base + header->planes );
+	cbrushside_t *sides = reinterpret_cast<cbrushside_t *>( base + header->brushsides );
+	cNode_t *nodes = reinterpret_cast<cNode_t *>( base + header->nodes );
+	cbrush_t *brushes = reinterpret_cast<cbrush_t *>( base + header->brushes );
+	cmPtr_t<cSurface_t> *surfaces = reinterpret_cast<cmPtr_t<cSurface_t> *>( base + header->surfaces );
+
+	for ( int i = 0; i < cm.numBrushSides; i++ )
+	{
+		sides[ i ].plane = planes + ( cm.brushsides[ i ].plane - cm.planes );
+	}
+
+	for ( int i = 0; i < cm.numNodes; i++ )
+	{
+		nodes[ i ].plane = planes + ( cm.nodes[ i ].plane - cm.planes );
+	}
+
+	for ( int i = 0; i < cm.numBrushes; i++ )
+	{
+		const cbrush_t *brush = &cm.brushes[ i ];
+
+		brushes[ i ].sides = sides + ( brush->sides - cm.brushsides );
+		brushes[ i ].edges = reinterpret_cast<cbrushedge_t *>( base + copy( brush->edges, brush->numEdges * sizeof( cbrushedge_t ) ) );
+	}
+
+	for ( int i = 0; i < cm.numSurfaces; i++ )
+	{
+		const cSurface_t *surface = cm.surfaces[ i ];
+
+		surfaces[ i ] = nullptr;
+
+		if ( !surface )
+		{
+			continue;
+		}
+
+		const cSurfaceCollide_t *sc = surface->sc;
+		cSurface_t *sharedSurface = reinterpret_cast<cSurface_t *>( base + copy( surface, sizeof( *surface ) ) );
+		cSurfaceCollide_t *sharedSc = reinterpret_cast<cSurfaceCollide_t *>( base + copy( sc, sizeof( *sc ) ) );
+
+		sharedSc->planes = reinterpret_cast<cPlane_t *>( base + copy( sc->planes, sc->numPlanes * sizeof( cPlane_t ) ) );
+		sharedSc->facets = reinterpret_cast<cFacet_t *>( base + copy( sc->facets, sc->numFacets * sizeof( cFacet_t ) ) );
+		sharedSurface->sc = sharedSc;
+		surfaces[ i ] = sharedSurface;
+	}
+
+	ASSERT_EQ( used, size );
+	cmLog.Debug( "shared a collision model of %zu bytes", size );
+
+	sharedModel = std::move( shm );
+}
+
+/*
+==================
+CM_CompareSharedModel
+
+Traces random boxes through the world with the model of the engine and
+with the shared copy, returns how many traces came out different
+==================
+*/
+static int CM_CompareSharedModel( int numTraces )
+{
+	const cmSharedHeader_t *header = static_cast<const cmSharedHeader_t *>( sharedModel.GetBase() );
+	struct segment_t
+	{
+		vec3_t start, end;
+	};
+
+	std::vector<trace_t> results( numTraces );
+	std::vector<segment_t> segments( numTraces );
+	std::mt19937 generator( 0 );
+	int mismatches = 0;
+
+	for ( segment_t &segment : segments )
+	{
+		for ( int j = 0; j < 3; j++ )
+		{
+			std::uniform_real_distribution<float> coordinate( cm.cmodels[ 0 ].mins[ j ], cm.cmodels[ 0 ].maxs[ j ] );
+			segment.start[ j ] = coordinate( generator );
+			segment.end[ j ] = coordinate( generator );
+		}
+	}
+
+	// the odd traces are points, the even ones player sized boxes
+	auto trace = [ & ]( int i, trace_t *result )
+	{
+		vec3_t mins = { -15.0f, -15.0f, -24.0f };
+		vec3_t maxs = { 15.0f, 15.0f, 32.0f };
+		vec3_t zero = { 0.0f, 0.0f, 0.0f };
+
+		// against every content type
+		CM_BoxTrace( result, segments[ i ].start, segments[ i ].end, i & 1 ? zero : mins, i & 1 ? zero : maxs,
+		             0, -1, 0, traceType_t::TT_AABB );
+	};
+
+	for ( int i = 0; i < numTraces; i++ )
+	{
+		trace( i, &results[ i ] );
+	}
+
+	// the per-process state is the same size for both, only the model
+	// arrays are switched
+	clipMap_t engineModel = cm;
+
+	if ( !CM_PointAtSharedModel( sharedModel, header->name ) )
+	{
+		cm = engineModel;
+		return numTraces;
+	}
+
+	for ( int i = 0; i < numTraces; i++ )
+	{
+		trace_t result;
+		const trace_t &expected = results[ i ];
+
+		trace( i, &result );
+
+		if ( result.allsolid != expected.allsolid || result.startsolid != expected.startsolid
+		     || result.fraction != expected.fraction || !VectorCompare( result.endpos, expected.endpos )
+		     || !VectorCompare( result.plane.normal, expected.plane.normal ) || result.plane.dist != expected.plane.dist
+		     || result.surfaceFlags != expected.surfaceFlags || result.contents != expected.contents )
+		{
+			mismatches++;
+		}
+	}
+
+	cm = engineModel;
+	return mismatches;
+}
+
+class CompareSharedModelCmd: public Cmd::StaticCmd {
+	public:
+		CompareSharedModelCmd(): StaticCmd("cm_compareShared", Cmd::BASE, "checks that the shared collision model traces like the engine's") {
+		}
+
+		void Run(const Cmd::Args& args) const OVERRIDE {
+			int numTraces = 10000;
+
+			if ( args.Argc() > 2 || ( args.Argc() == 2 && ( !Str::ParseInt( numTraces, args.Argv( 1 ) ) || numTraces <= 0 ) ) )
+			{
+				PrintUsage( args, "[traces]", "checks that the shared collision model traces like the engine's" );
+				return;
+			}
+
+			if ( !sharedModel )
+			{
+				Print( "no collision model is shared" );
+				return;
+			}
+
+			int mismatches = CM_CompareSharedModel( numTraces );
+			Print( "%d of %d traces differ between the engine and the shared collision model", mismatches, numTraces );
+		}
+};
+static CompareSharedModelCmd CompareSharedModelCmdRegistration;
+
+/*
+==================
+CM_SharedModel
+==================
+*/
+const IPC::SharedMemory &CM_SharedModel()
+{
+	return sharedModel;
 }
+#else
+/*
+==================
+CM_ReceiveSharedModel
+==================
+*/
+void CM_ReceiveSharedModel( IPC::SharedMemory shm )
+{
+	receivedModel = std::move( shm );
+}
+#endif
 
 //==================================================================
 
@@ -911,6 +1441,24 @@ void CM_LoadMap(Str::StringRef name)
 
 	cmLog.Debug( "CM_LoadMap(%s)", name);
 
+	// free old stuff
+	CM_FreeAll();
+	memset( &cm, 0, sizeof( cm ) );
+	CM_ClearLevelPatches();
+
+#ifdef BUILD_VM
+	// use the model of the engine if it sent the right one
+	if ( receivedModel && CM_PointAtSharedModel( receivedModel, name ) )
+	{
+		cmLog.Debug( "using the collision model shared by the engine" );
+		sharedModel = std::move( receivedModel );
+		CM_InitPrivateState();
+		return;
+	}
+
+	receivedModel = IPC::SharedMemory();
+#endif
+
 	std::string mapFile = "maps/" + name + ".bsp";
 	std::string mapData;
 	try {
@@ -919,11 +1467,6 @@ void CM_LoadMap(Str::StringRef name)
 		Sys::Drop("Could not load %s", mapFile.c_str());
 	}
 
-	// free old stuff
-    CM_FreeAll();
-	memset( &cm, 0, sizeof( cm ) );
-	CM_ClearLevelPatches();
-
 	if ( !name[ 0 ] )
 	{
 		cm.numLeafs = 1;
@@ -965,9 +1508,18 @@ void CM_LoadMap(Str::StringRef name)
 
 	CMod_CreateBrushSideWindings();
 
-	CM_InitBoxHull();
+	// the leaf of the box model refers to the brush past the last one,
+	// see CM_Brush
+	cm.leafbrushes[ cm.numLeafBrushes ] = cm.numBrushes;
 
-	CM_FloodAreaConnections();
+#ifndef BUILD_VM
+	if ( cm_shareModel.Get() )
+	{
+		CM_ShareModel( name );
+	}
+#endif
+
+	CM_InitPrivateState();
 }
 
 /*
@@ -977,6 +1529,7 @@ CM_ClearMap
 */
 void CM_ClearMap()
 {
+	CM_FreeAll();
 	Com_Memset( &cm, 0, sizeof( cm ) );
 	CM_ClearLevelPatches();
 }
@@ -1070,27 +1623,27 @@ void CM_InitBoxHull()
 	cplane_t     *p;
 	cbrushside_t *s;
 
-	box_planes = &cm.planes[ cm.numPlanes ];
+	box_planes = boxPlanes;
+	box_brushState = {};
 
-	box_brush = &cm.brushes[ cm.numBrushes ];
-	box_brush->numsides = 6;
-	box_brush->sides = cm.brushsides + cm.numBrushSides;
+	box_brush = &boxBrush;
+	box_brush->numsides = BOX_SIDES;
+	box_brush->sides = boxSides;
 	box_brush->contents = CONTENTS_BODY;
-	box_brush->edges = ( cbrushedge_t * ) CM_Alloc( sizeof( cbrushedge_t ) * 12 );
-	box_brush->numEdges = 12;
+	box_brush->edges = boxEdges;
+	box_brush->numEdges = BOX_EDGES;
 
 	box_model.leaf.numLeafBrushes = 1;
 //  box_model.leaf.firstLeafBrush = cm.numBrushes;
 	box_model.leaf.firstLeafBrush = cm.numLeafBrushes;
-	cm.leafbrushes[ cm.numLeafBrushes ] = cm.numBrushes;
 
 	for ( i = 0; i < 6; i++ )
 	{
 		side = i & 1;
 
 		// brush sides
-		s = &cm.brushsides[ cm.numBrushSides + i ];
-		s->plane = cm.planes + ( cm.numPlanes + i * 2 + side );
+		s = &boxSides[ i ];
+		s->plane = &boxPlanes[ i * 2 + side ];
 		s->surfaceFlags = 0;
 
 		// planes
@@ -43,6 +43,40 @@ Maryland 20850 USA.
 #define CAPSULE_MODEL_HANDLE ( MAX_SUBMODELS )
 #define BOX_MODEL_HANDLE     ( MAX_SUBMODELS + 1)
 
+/*
+The collision model is built once by the engine and mapped by the VMs
+at another address, see CM_ShareModel. Pointers between its structures
+are stored as an offset from the pointer itself so they stay valid in
+every process, and everything in it has the same layout in 32 and 64
+bit code.
+*/
+template<typename T>
+class alignas( 8 ) cmPtr_t
+{
+public:
+	cmPtr_t() : offset( 0 ) {}
+	cmPtr_t( const cmPtr_t &other ) { Set( other.Get() ); }
+
+	cmPtr_t &operator=( const cmPtr_t &other ) { Set( other.Get() ); return *this; }
+	cmPtr_t &operator=( T *ptr ) { Set( ptr ); return *this; }
+
+	T *Get() const
+	{
+		return offset ? reinterpret_cast<T *>( reinterpret_cast<intptr_t>( this ) + offset ) : nullptr;
+	}
+
+	operator T *() const { return Get(); }
+	T *operator->() const { return Get(); }
+
+private:
+	void Set( T *ptr )
+	{
+		offset = ptr ? reinterpret_cast<intptr_t>( ptr ) - reinterpret_cast<intptr_t>( this ) : 0;
+	}
+
+	int64_t offset; // 0 is nullptr, nothing points to itself
+};
+
 struct cbrushedge_t
 {
 	vec3_t p0;
@@ -51,10 +85,9 @@ struct cbrushedge_t
 
 struct cNode_t
 {
-	cplane_t  *plane;
-	int       planeNum;
-	int       children[ 2 ]; // negative numbers are leafs
-	winding_t *winding;
+	cmPtr_t<cplane_t> plane;
+	int               planeNum;
+	int               children[ 2 ]; // negative numbers are leafs
 };
 
 struct cLeaf_t
@@ -77,29 +110,32 @@ struct cmodel_t
 
 struct cbrushside_t
 {
-	cplane_t  *plane;
-	int       planeNum;
-	int       surfaceFlags;
-	winding_t *winding;
+	cmPtr_t<cplane_t> plane;
+	int               planeNum;
+	int               surfaceFlags;
 };
 
 struct cbrush_t
 {
-	int          contents;
-	vec3_t       bounds[ 2 ];
-	int          numsides;
-	cbrushside_t *sides;
-	int          checkcount; // to avoid repeated testings
-	bool     collided; // marker for optimisation
-	cbrushedge_t *edges;
-	int          numEdges;
+	int                   contents;
+	vec3_t                bounds[ 2 ];
+	int                   numsides;
+	cmPtr_t<cbrushside_t> sides;
+	cmPtr_t<cbrushedge_t> edges;
+	int                   numEdges;
+};
+
+// trace state of a brush, kept out of the shared collision model
+struct cBrushState_t
+{
+	int  checkcount; // to avoid repeated testings
+	bool collided; // marker for optimisation
 };
 
 struct cPlane_t
 {
 	float           plane[ 4 ];
 	int             signbits; // signx + (signy<<1) + (signz<<2), used as lookup during collision
-	cPlane_t *hashChain;
 };
 
 // 3 or four + 6 axial bevels + 4 or 3 * 4 edge bevels
@@ -117,21 +153,20 @@ struct cFacet_t
 
 struct cSurfaceCollide_t
 {
-	vec3_t   bounds[ 2 ];
-	int      numPlanes; // surface planes plus edge planes
-	cPlane_t *planes;
+	vec3_t            bounds[ 2 ];
+	int               numPlanes; // surface planes plus edge planes
+	cmPtr_t<cPlane_t> planes;
 
-	int      numFacets;
-	cFacet_t *facets;
+	int               numFacets;
+	cmPtr_t<cFacet_t> facets;
 };
 
 struct cSurface_t
 {
-	int               checkcount; // to avoid repeated testings
-	int               surfaceFlags;
-	int               contents;
-	cSurfaceCollide_t *sc;
-	mapSurfaceType_t type;
+	int                        surfaceFlags;
+	int                        contents;
+	cmPtr_t<cSurfaceCollide_t> sc;
+	mapSurfaceType_t           type;
 };
 
 struct cArea_t
@@ -182,7 +217,11 @@ struct clipMap_t
 	int          *areaPortals; // [ numAreas*numAreas ] reference counts
 
 	int          numSurfaces;
-	cSurface_t   **surfaces; // non-patches will be nullptr
+	cmPtr_t<cSurface_t> *surfaces; // non-patches will be nullptr
+
+	// private to each process, the rest may be shared
+	cBrushState_t *brushStates;
+	int          *surfaceCheckCounts;
 
 	int          floodvalid;
 	int          checkcount; // incremented on each trace
@@ -194,6 +233,8 @@ struct clipMap_t
 #define SURFACE_CLIP_EPSILON ( 0.125 )
 
 extern clipMap_t cm;
+extern cbrush_t  *box_brush;
+extern cBrushState_t box_brushState;
 extern int       c_pointcontents;
 extern int       c_traces, c_brush_traces, c_patch_traces, c_trisoup_traces;
 extern Cvar::Cvar<bool> cm_forceTriangles;
@@ -251,6 +292,15 @@ struct leafList_t
 #define WRAP_POINT_EPSILON 0.1
 
 cSurfaceCollide_t *CM_GeneratePatchCollide( int width, int height, vec3_t *points );
+
+struct cPatchBuild_t
+{
+	int               width, height;
+	vec3_t            *points;
+	cSurfaceCollide_t *sc;
+};
+
+void              CM_GeneratePatchCollides( cPatchBuild_t *patches, int count );
 void              CM_ClearLevelPatches();
 
 // cm_trisoup.c
@@ -272,12 +322,24 @@ void* CM_Alloc( int size );
 
 // cm_plane.c
 
-extern int numPlanes;
-extern cPlane_t planes[];
+static const int PLANE_HASHES = 8192;
+
+// the planes and facets of the surface that is being built; every thread
+// that generates surface collision works in its own copy
+struct cSurfaceWork_t
+{
+	int      planeHashTable[ PLANE_HASHES ]; // -1 terminated chains
+	int      planeHashChain[ SHADER_MAX_TRIANGLES ];
+
+	int      numPlanes;
+	cPlane_t planes[ SHADER_MAX_TRIANGLES ];
 
-extern int numFacets;
-extern cFacet_t facets[];
+	int      numFacets;
+	cFacet_t facets[ SHADER_MAX_TRIANGLES ];
+};
 
+cSurfaceWork_t *CM_SurfaceWork();
+void     CM_SetSurfaceWork( cSurfaceWork_t *work );
 void     CM_ResetPlaneCounts();
 int      CM_FindPlane2( float plane[ 4 ], bool *flipped );
 int      CM_FindPlane( const float *p1, const float *p2, const float *p3 );
@@ -288,6 +350,17 @@ bool CM_GenerateFacetFor3Points( cFacet_t *facet, const vec3_t p1, const vec3_t
 bool CM_GenerateFacetFor4Points( cFacet_t *facet, const vec3_t p1, const vec3_t p2, const vec3_t p3, const vec3_t p4 );
 
 
+// the box brush is private to each process, see CM_InitBoxHull
+inline cbrush_t *CM_Brush( int brushnum )
+{
+	return brushnum == cm.numBrushes ? box_brush : &cm.brushes[ brushnum ];
+}
+
+inline cBrushState_t *CM_BrushState( const cbrush_t *brush )
+{
+	return brush == box_brush ? &box_brushState : &cm.brushStates[ brush - cm.brushes ];
+}
+
 // cm_test.c
 extern const cSurfaceCollide_t *debugSurfaceCollide;
 extern const cFacet_t          *debugFacet;
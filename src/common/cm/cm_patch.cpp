@@ -36,7 +36,15 @@ Maryland 20850 USA.
 
 #include "cm_patch.h"
 
-int                     c_totalPatchBlocks;
+#include <atomic>
+#include <memory>
+
+#ifndef BUILD_VM
+#include <mutex>
+#include <thread>
+#endif
+
+std::atomic<int>        c_totalPatchBlocks;
 
 const cSurfaceCollide_t *debugSurfaceCollide;
 const cFacet_t          *debugFacet;
@@ -422,6 +430,7 @@ CM_EdgePlaneNum
 */
 static int CM_EdgePlaneNum( cGrid_t *grid, int gridPlanes[ MAX_GRID_SIZE ][ MAX_GRID_SIZE ][ 2 ], int i, int j, int k )
 {
+	cSurfaceWork_t *work = CM_SurfaceWork();
 	float  *p1, *p2;
 	vec3_t up;
 	int    p;
@@ -432,42 +441,42 @@ static int CM_EdgePlaneNum( cGrid_t *grid, int gridPlanes[ MAX_GRID_SIZE ][ MAX_
 			p1 = grid->points[ i ][ j ];
 			p2 = grid->points[ i + 1 ][ j ];
 			p = CM_GridPlane( gridPlanes, i, j, 0 );
-			VectorMA( p1, 4, planes[ p ].plane, up );
+			VectorMA( p1, 4, work->planes[ p ].plane, up );
 			return CM_FindPlane( p1, p2, up );
 
 		case 2: // bottom border
 			p1 = grid->points[ i ][ j + 1 ];
 			p2 = grid->points[ i + 1 ][ j + 1 ];
 			p = CM_GridPlane( gridPlanes, i, j, 1 );
-			VectorMA( p1, 4, planes[ p ].plane, up );
+			VectorMA( p1, 4, work->planes[ p ].plane, up );
 			return CM_FindPlane( p2, p1, up );
 
 		case 3: // left border
 			p1 = grid->points[ i ][ j ];
 			p2 = grid->points[ i ][ j + 1 ];
 			p = CM_GridPlane( gridPlanes, i, j, 1 );
-			VectorMA( p1, 4, planes[ p ].plane, up );
+			VectorMA( p1, 4, work->planes[ p ].plane, up );
 			return CM_FindPlane( p2, p1, up );
 
 		case 1: // right border
 			p1 = grid->points[ i + 1 ][ j ];
 			p2 = grid->points[ i + 1 ][ j + 1 ];
 			p = CM_GridPlane( gridPlanes, i, j, 0 );
-			VectorMA( p1, 4, planes[ p ].plane, up );
+			VectorMA( p1, 4, work->planes[ p ].plane, up );
 			return CM_FindPlane( p1, p2, up );
 
 		case 4: // diagonal out of triangle 0
 			p1 = grid->points[ i + 1 ][ j + 1 ];
 			p2 = grid->points[ i ][ j ];
 			p = CM_GridPlane( gridPlanes, i, j, 0 );
-			VectorMA( p1, 4, planes[ p ].plane, up );
+			VectorMA( p1, 4, work->planes[ p ].plane, up );
 			return CM_FindPlane( p1, p2, up );
 
 		case 5: // diagonal out of triangle 1
 			p1 = grid->points[ i ][ j ];
 			p2 = grid->points[ i + 1 ][ j + 1 ];
 			p = CM_GridPlane( gridPlanes, i, j, 1 );
-			VectorMA( p1, 4, planes[ p ].plane, up );
+			VectorMA( p1, 4, work->planes[ p ].plane, up );
 			return CM_FindPlane( p1, p2, up );
 	}
 
@@ -578,17 +587,23 @@ enum edgeName_e
 /*
 ==================
 CM_PatchCollideFromGrid
+
+Returns false when the grid has too many facets
 ==================
 */
-static void CM_SurfaceCollideFromGrid( cGrid_t *grid, cSurfaceCollide_t *sc )
+static bool CM_SurfaceCollideFromGrid( cGrid_t *grid, cSurfaceCollide_t *sc )
 {
+	cSurfaceWork_t *work = CM_SurfaceWork();
 	int             i, j;
 	float          *p1, *p2, *p3;
-	int             gridPlanes[ MAX_GRID_SIZE ][ MAX_GRID_SIZE ][ 2 ];
 	cFacet_t       *facet;
 	int             borders[ 4 ];
 	int             noAdjust[ 4 ];
 
+	// too large for the stack of a loading thread
+	std::unique_ptr<int[][ MAX_GRID_SIZE ][ 2 ]> gridPlaneStorage( new int[ MAX_GRID_SIZE ][ MAX_GRID_SIZE ][ 2 ] );
+	auto gridPlanes = gridPlaneStorage.get();
+
 	CM_ResetPlaneCounts();
 
 	// find the planes for each triangle of the grid
@@ -685,12 +700,12 @@ static void CM_SurfaceCollideFromGrid( cGrid_t *grid, cSurfaceCollide_t *sc )
 				borders[ EN_RIGHT ] = CM_EdgePlaneNum( grid, gridPlanes, i, j, 1 );
 			}
 
-			if ( numFacets == SHADER_MAX_TRIANGLES )
+			if ( work->numFacets == SHADER_MAX_TRIANGLES )
 			{
-				Sys::Drop( "MAX_FACETS" );
+				return false;
 			}
 
-			facet = &facets[ numFacets ];
+			facet = &work->facets[ work->numFacets ];
 			Com_Memset( facet, 0, sizeof( *facet ) );
 
 			if ( gridPlanes[ i ][ j ][ 0 ] == gridPlanes[ i ][ j ][ 1 ] )
@@ -715,7 +730,7 @@ static void CM_SurfaceCollideFromGrid( cGrid_t *grid, cSurfaceCollide_t *sc )
 				if ( CM_ValidateFacet( facet ) )
 				{
 					CM_AddFacetBevels( facet );
-					numFacets++;
+					work->numFacets++;
 				}
 			}
 			else
@@ -744,15 +759,15 @@ static void CM_SurfaceCollideFromGrid( cGrid_t *grid, cSurfaceCollide_t *sc )
 				if ( CM_ValidateFacet( facet ) )
 				{
 					CM_AddFacetBevels( facet );
-					numFacets++;
+					work->numFacets++;
 				}
 
-				if ( numFacets == SHADER_MAX_TRIANGLES )
+				if ( work->numFacets == SHADER_MAX_TRIANGLES )
 				{
-					Sys::Drop( "MAX_FACETS" );
+					return false;
 				}
 
-				facet = &facets[ numFacets ];
+				facet = &work->facets[ work->numFacets ];
 				Com_Memset( facet, 0, sizeof( *facet ) );
 
 				facet->surfacePlane = gridPlanes[ i ][ j ][ 1 ];
@@ -778,53 +793,58 @@ static void CM_SurfaceCollideFromGrid( cGrid_t *grid, cSurfaceCollide_t *sc )
 				if ( CM_ValidateFacet( facet ) )
 				{
 					CM_AddFacetBevels( facet );
-					numFacets++;
+					work->numFacets++;
 				}
 			}
 		}
 	}
 
 	// copy the results out
-	sc->numPlanes = numPlanes;
-	sc->numFacets = numFacets;
-	sc->facets = ( cFacet_t * ) CM_Alloc( numFacets * sizeof( *sc->facets ) );
-	Com_Memcpy( sc->facets, facets, numFacets * sizeof( *sc->facets ) );
-	sc->planes = ( cPlane_t * ) CM_Alloc( numPlanes * sizeof( *sc->planes ) );
-	Com_Memcpy( sc->planes, planes, numPlanes * sizeof( *sc->planes ) );
+	sc->numPlanes = work->numPlanes;
+	sc->numFacets = work->numFacets;
+	sc->facets = ( cFacet_t * ) CM_Alloc( work->numFacets * sizeof( *sc->facets ) );
+	Com_Memcpy( sc->facets, work->facets, work->numFacets * sizeof( *sc->facets ) );
+	sc->planes = ( cPlane_t * ) CM_Alloc( work->numPlanes * sizeof( *sc->planes ) );
+	Com_Memcpy( sc->planes, work->planes, work->numPlanes * sizeof( *sc->planes ) );
+
+	return true;
 }
 
 /*
 ===================
-CM_GeneratePatchCollide
+CM_TryGeneratePatchCollide
 
-Creates an internal structure that will be used to perform
-collision detection with a patch mesh.
-
-Points is packed as concatenated rows.
+CM_GeneratePatchCollide for the worker threads, which must not drop:
+returns nullptr and the message on a broken patch.
 ===================
 */
-cSurfaceCollide_t *CM_GeneratePatchCollide( int width, int height, vec3_t *points )
+static cSurfaceCollide_t *CM_TryGeneratePatchCollide( int width, int height, vec3_t *points, std::string &error )
 {
 	cSurfaceCollide_t *sc;
-	cGrid_t         grid;
 	int             i, j;
 
 	if ( width <= 2 || height <= 2 || !points )
 	{
-		Sys::Drop( "CM_GeneratePatchFacets: bad parameters: (%i, %i, %p)", width, height, ( void * ) points );
+		error = Str::Format( "CM_GeneratePatchFacets: bad parameters: (%i, %i, %p)", width, height, ( void * ) points );
+		return nullptr;
 	}
 
 	if ( !( width & 1 ) || !( height & 1 ) )
 	{
-		Sys::Drop( "CM_GeneratePatchFacets: even sizes are invalid for quadratic meshes" );
+		error = "CM_GeneratePatchFacets: even sizes are invalid for quadratic meshes";
+		return nullptr;
 	}
 
 	if ( width > MAX_GRID_SIZE || height > MAX_GRID_SIZE )
 	{
-		Sys::Drop( "CM_GeneratePatchFacets: source is > MAX_GRID_SIZE" );
+		error = "CM_GeneratePatchFacets: source is > MAX_GRID_SIZE";
+		return nullptr;
 	}
 
-	// build a grid
+	// build a grid, on the heap for the same reason as gridPlanes
+	std::unique_ptr<cGrid_t> gridStorage( new cGrid_t );
+	cGrid_t &grid = *gridStorage;
+
 	grid.width = width;
 	grid.height = height;
 	grid.wrapWidth = false;
@@ -866,7 +886,11 @@ cSurfaceCollide_t *CM_GeneratePatchCollide( int width, int height, vec3_t *point
 	c_totalPatchBlocks += ( grid.width - 1 ) * ( grid.height - 1 );
 
 	// generate a bsp tree for the surface
-	CM_SurfaceCollideFromGrid( &grid, sc );
+	if ( !CM_SurfaceCollideFromGrid( &grid, sc ) )
+	{
+		error = "MAX_FACETS";
+		return nullptr;
+	}
 
 	// expand by one unit for epsilon purposes
 	sc->bounds[ 0 ][ 0 ] -= 1;
@@ -879,3 +903,130 @@ cSurfaceCollide_t *CM_GeneratePatchCollide( int width, int height, vec3_t *point
 
 	return sc;
 }
+
+/*
+===================
+CM_GeneratePatchCollide
+
+Creates an internal structure that will be used to perform
+collision detection with a patch mesh.
+
+Points is packed as concatenated rows.
+===================
+*/
+cSurfaceCollide_t *CM_GeneratePatchCollide( int width, int height, vec3_t *points )
+{
+	std::string       error;
+	cSurfaceCollide_t *sc = CM_TryGeneratePatchCollide( width, height, points, error );
+
+	if ( !sc )
+	{
+		Sys::Drop( error );
+	}
+
+	return sc;
+}
+
+/*
+===================
+CM_GeneratePatchCollides
+
+Generates the collision of every patch in the list. Each patch is
+independent of the others, so big batches are spread over a few
+threads that each use their own plane and facet scratch space.
+===================
+*/
+static const int PATCHES_PER_THREAD = 16;
+
+void CM_GeneratePatchCollides( cPatchBuild_t *patches, int count )
+{
+#ifndef BUILD_VM
+	int numThreads = std::min( static_cast<int>( std::thread::hardware_concurrency() ), 8 );
+	numThreads = std::min( numThreads, count / PATCHES_PER_THREAD );
+
+	if ( numThreads > 1 )
+	{
+		std::atomic<int>   next( 0 );
+		std::mutex         errorMutex;
+		std::string        error; // of the first broken patch
+		std::exception_ptr exception;
+
+		auto worker = [ & ]
+		{
+			std::unique_ptr<cSurfaceWork_t> work( new cSurfaceWork_t );
+			int i;
+
+			CM_SetSurfaceWork( work.get() );
+
+			while ( ( i = next.fetch_add( 1 ) ) < count )
+			{
+				std::string patchError;
+
+				// broken patches are reported without dropping, Sys::Drop
+				// is not thread safe; only an internal error can throw
+				try
+				{
+					patches[ i ].sc = CM_TryGeneratePatchCollide( patches[ i ].width, patches[ i ].height, patches[ i ].points, patchError );
+				}
+				catch ( ... )
+				{
+					std::lock_guard<std::mutex> lock( errorMutex );
+
+					if ( !exception )
+					{
+						exception = std::current_exception();
+					}
+
+					next = count;
+				}
+
+				if ( !patches[ i ].sc && !patchError.empty() )
+				{
+					// stop handing out patches and drop on the calling thread
+					std::lock_guard<std::mutex> lock( errorMutex );
+
+					if ( error.empty() )
+					{
+						error = patchError;
+					}
+
+					next = count;
+				}
+			}
+
+			CM_SetSurfaceWork( nullptr );
+		};
+
+		std::vector<std::thread> threads;
+
+		for ( int i = 1; i < numThreads; i++ )
+		{
+			threads.emplace_back( worker );
+		}
+
+		worker();
+
+		for ( std::thread &thread : threads )
+		{
+			thread.join();
+		}
+
+		if ( !error.empty() )
+		{
+			Sys::Drop( error );
+		}
+
+		if ( exception )
+		{
+			std::rethrow_exception( exception );
+		}
+
+		return;
+	}
+#endif
+
+	for ( int i = 0; i < count; i++ )
+	{
+		patches[ i ].sc = CM_GeneratePatchCollide( patches[ i ].width, patches[ i ].height, patches[ i ].points );
+	}
+}
@@ -34,14 +34,48 @@ Maryland 20850 USA.
 
 #include "cm_local.h"
 
-static const int PLANE_HASHES = 8192;
-static cPlane_t *planeHashTable[ PLANE_HASHES ];
+static cSurfaceWork_t mainSurfaceWork;
 
-int      numPlanes;
-cPlane_t planes[ SHADER_MAX_TRIANGLES ];
+#ifndef BUILD_VM
+static thread_local cSurfaceWork_t *threadSurfaceWork;
+#endif
 
-int      numFacets;
-cFacet_t facets[ SHADER_MAX_TRIANGLES ];
+/*
+=================
+CM_SurfaceWork
+
+Returns the scratch planes and facets of the calling thread
+=================
+*/
+cSurfaceWork_t *CM_SurfaceWork()
+{
+#ifndef BUILD_VM
+	if ( threadSurfaceWork )
+	{
+		return threadSurfaceWork;
+	}
+#endif
+
+	return &mainSurfaceWork;
+}
+
+/*
+=================
+CM_SetSurfaceWork
+
+Gives the calling thread its own scratch space, nullptr goes back to
+the shared one
+=================
+*/
+void CM_SetSurfaceWork( cSurfaceWork_t *work )
+{
+#ifndef BUILD_VM
+	threadSurfaceWork = work;
+#else
+	ASSERT( !work );
+	Q_UNUSED( work );
+#endif
+}
 
 /*
 =================
@@ -51,9 +85,11 @@ CM_ResetPlaneCounts
 
 void CM_ResetPlaneCounts()
 {
-	memset( planeHashTable, 0, sizeof( planeHashTable ) );
-	numPlanes = 0;
-	numFacets = 0;
+	cSurfaceWork_t *work = CM_SurfaceWork();
+
+	memset( work->planeHashTable, -1, sizeof( work->planeHashTable ) );
+	work->numPlanes = 0;
+	work->numFacets = 0;
 }
 /*
 =================
@@ -185,14 +221,15 @@ static long CM_GenerateHashValue( vec4_t plane )
 CM_AddPlaneToHash
 ================
 */
-static void CM_AddPlaneToHash( cPlane_t *p )
+static void CM_AddPlaneToHash( int planeNum )
 {
+	cSurfaceWork_t *work = CM_SurfaceWork();
 	long hash;
 
-	hash = CM_GenerateHashValue( p->plane );
+	hash = CM_GenerateHashValue( work->planes[ planeNum ].plane );
 
-	p->hashChain = planeHashTable[ hash ];
-	planeHashTable[ hash ] = p;
+	work->planeHashChain[ planeNum ] = work->planeHashTable[ hash ];
+	work->planeHashTable[ hash ] = planeNum;
 }
 
 /*
@@ -202,23 +239,24 @@ CM_CreateNewFloatPlane
 */
 static int CM_CreateNewFloatPlane( vec4_t plane )
 {
+	cSurfaceWork_t *work = CM_SurfaceWork();
 	cPlane_t *p; //, temp;
 
 	// create a new plane
-	if ( numPlanes == SHADER_MAX_TRIANGLES )
+	if ( work->numPlanes == SHADER_MAX_TRIANGLES )
 	{
 		Sys::Drop( "CM_FindPlane: SHADER_MAX_TRIANGLES" );
 	}
 
-	p = &planes[ numPlanes ];
+	p = &work->planes[ work->numPlanes ];
 	Vector4Copy( plane, p->plane );
 
 	p->signbits = CM_SignbitsForNormal( plane );
 
-	numPlanes++;
+	work->numPlanes++;
 
-	CM_AddPlaneToHash( p );
-	return numPlanes - 1;
+	CM_AddPlaneToHash( work->numPlanes - 1 );
+	return work->numPlanes - 1;
 }
 
 /*
@@ -228,6 +266,7 @@ CM_FindPlane2
 */
 int CM_FindPlane2( float plane[ 4 ], bool *flipped )
 {
+	cSurfaceWork_t *work = CM_SurfaceWork();
 	int      i;
 	cPlane_t *p;
 	int      hash, h;
@@ -240,11 +279,13 @@ int CM_FindPlane2( float plane[ 4 ], bool *flipped )
 	{
 		h = ( hash + i ) & ( PLANE_HASHES - 1 );
 
-		for ( p = planeHashTable[ h ]; p; p = p->hashChain )
+		for ( int n = work->planeHashTable[ h ]; n != -1; n = work->planeHashChain[ n ] )
 		{
+			p = &work->planes[ n ];
+
 			if ( CM_PlaneEqual( p, plane, flipped ) )
 			{
-				return p - planes;
+				return p - work->planes;
 			}
 		}
 	}
@@ -260,6 +301,7 @@ CM_FindPlane
 */
 int CM_FindPlane( const float *p1, const float *p2, const float *p3 )
 {
+	cSurfaceWork_t *work = CM_SurfaceWork();
 	float      plane[ 4 ];
 	int        i;
 	float      d;
@@ -278,8 +320,10 @@ int CM_FindPlane( const float *p1, const float *p2, const float *p3 )
 	{
 		h = ( hash + i ) & ( PLANE_HASHES - 1 );
 
-		for ( p = planeHashTable[ h ]; p; p = p->hashChain )
+		for ( int n = work->planeHashTable[ h ]; n != -1; n = work->planeHashChain[ n ] )
 		{
+			p = &work->planes[ n ];
+
 			//check points on the plane
 			if ( DotProduct( plane, p->plane ) < 0 )
 			{
@@ -307,7 +351,7 @@ int CM_FindPlane( const float *p1, const float *p2, const float *p3 )
 				continue;
 			}
 
-			return p - planes;
+			return p - work->planes;
 		}
 	}
 
@@ -321,6 +365,7 @@ CM_PointOnPlaneSide
 */
 planeSide_t CM_PointOnPlaneSide( float *p, int planeNum )
 {
+	cSurfaceWork_t *work = CM_SurfaceWork();
 	float *plane;
 	float d;
 
@@ -329,7 +374,7 @@ planeSide_t CM_PointOnPlaneSide( float *p, int planeNum )
 		return planeSide_t::SIDE_ON;
 	}
 
-	plane = planes[ planeNum ].plane;
+	plane = work->planes[ planeNum ].plane;
 
 	d = DotProduct( p, plane ) - plane[ 3 ];
 
@@ -355,6 +400,7 @@ If the facet isn't bounded by its borders, we screwed up.
 */
 bool CM_ValidateFacet( cFacet_t *facet )
 {
+	cSurfaceWork_t *work = CM_SurfaceWork();
 	float     plane[ 4 ];
 	int       j;
 	winding_t *w;
@@ -365,7 +411,7 @@ bool CM_ValidateFacet( cFacet_t *facet )
 		return false;
 	}
 
-	Vector4Copy( planes[ facet->surfacePlane ].plane, plane );
+	Vector4Copy( work->planes[ facet->surfacePlane ].plane, plane );
 	w = BaseWindingForPlane( plane, plane[ 3 ] );
 
 	for ( j = 0; j < facet->numBorders && w; j++ )
@@ -376,7 +422,7 @@ bool CM_ValidateFacet( cFacet_t *facet )
 			return false;
 		}
 
-		Vector4Copy( planes[ facet->borderPlanes[ j ] ].plane, plane );
+		Vector4Copy( work->planes[ facet->borderPlanes[ j ] ].plane, plane );
 
 		if ( !facet->borderInward[ j ] )
 		{
@@ -424,6 +470,7 @@ CM_AddFacetBevels
 */
 void CM_AddFacetBevels( cFacet_t *facet )
 {
+	cSurfaceWork_t *work = CM_SurfaceWork();
 	int       i, j, k, l;
 	int       axis, dir, order;
 	bool  flipped;
@@ -431,7 +478,7 @@ void CM_AddFacetBevels( cFacet_t *facet )
 	winding_t *w, *w2;
 	vec3_t    mins, maxs, vec, vec2;
 
-	Vector4Copy( planes[ facet->surfacePlane ].plane, plane );
+	Vector4Copy( work->planes[ facet->surfacePlane ].plane, plane );
 
 	w = BaseWindingForPlane( plane, plane[ 3 ] );
 
@@ -442,7 +489,7 @@ void CM_AddFacetBevels( cFacet_t *facet )
 			continue;
 		}
 
-		Vector4Copy( planes[ facet->borderPlanes[ j ] ].plane, plane );
+		Vector4Copy( work->planes[ facet->borderPlanes[ j ] ].plane, plane );
 
 		if ( !facet->borderInward[ j ] )
 		{
@@ -480,7 +527,7 @@ void CM_AddFacetBevels( cFacet_t *facet )
 			}
 
 			//if it's the surface plane
-			if ( CM_PlaneEqual( &planes[ facet->surfacePlane ], plane, &flipped ) )
+			if ( CM_PlaneEqual( &work->planes[ facet->surfacePlane ], plane, &flipped ) )
 			{
 				continue;
 			}
@@ -488,7 +535,7 @@ void CM_AddFacetBevels( cFacet_t *facet )
 			// see if the plane is already present
 			for ( i = 0; i < facet->numBorders; i++ )
 			{
-				if ( CM_PlaneEqual( &planes[ facet->borderPlanes[ i ] ], plane, &flipped ) )
+				if ( CM_PlaneEqual( &work->planes[ facet->borderPlanes[ i ] ], plane, &flipped ) )
 				{
 					break;
 				}
@@ -574,7 +621,7 @@ void CM_AddFacetBevels( cFacet_t *facet )
 				}
 
 				//if it's the surface plane
-				if ( CM_PlaneEqual( &planes[ facet->surfacePlane ], plane, &flipped ) )
+				if ( CM_PlaneEqual( &work->planes[ facet->surfacePlane ], plane, &flipped ) )
 				{
 					continue;
 				}
@@ -582,7 +629,7 @@ void CM_AddFacetBevels( cFacet_t *facet )
 				// see if the plane is already present
 				for ( i = 0; i < facet->numBorders; i++ )
 				{
-					if ( CM_PlaneEqual( &planes[ facet->borderPlanes[ i ] ], plane, &flipped ) )
+					if ( CM_PlaneEqual( &work->planes[ facet->borderPlanes[ i ] ], plane, &flipped ) )
 					{
 						break;
 					}
@@ -609,7 +656,7 @@ void CM_AddFacetBevels( cFacet_t *facet )
 					facet->borderInward[ facet->numBorders ] = flipped;
 					//
 					w2 = CopyWinding( w );
-					Vector4Copy( planes[ facet->borderPlanes[ facet->numBorders ] ].plane, newplane );
+					Vector4Copy( work->planes[ facet->borderPlanes[ facet->numBorders ] ].plane, newplane );
 
 					if ( !facet->borderInward[ facet->numBorders ] )
 					{
@@ -668,6 +715,7 @@ CM_GenerateFacetFor3Points
 */
 bool CM_GenerateFacetFor3Points( cFacet_t *facet, const vec3_t p1, const vec3_t p2, const vec3_t p3 )
 {
+	cSurfaceWork_t *work = CM_SurfaceWork();
 	vec4_t          plane;
 
 	// if we can't generate a valid plane for the points, ignore the facet
@@ -678,7 +726,7 @@ bool CM_GenerateFacetFor3Points( cFacet_t *facet, const vec3_t p1, const vec3_t
 		return false;
 	}
 
-	Vector4Copy( planes[ facet->surfacePlane ].plane, plane );
+	Vector4Copy( work->planes[ facet->surfacePlane ].plane, plane );
 
 	facet->numBorders = 3;
 
@@ -36,12 +36,13 @@ Maryland 20850 USA.
 
 #include "cm_local.h"
 
-// counters are only bumped when running single threaded,
-// because they are an awefull coherence problem
-int c_active_windings;
-int c_peak_windings;
-int c_winding_allocs;
-int c_winding_points;
+#include <atomic>
+
+// patch collision is generated on several threads at load time
+std::atomic<int> c_active_windings;
+std::atomic<int> c_peak_windings;
+std::atomic<int> c_winding_allocs;
+std::atomic<int> c_winding_points;
 
 /*
 =============
@@ -55,11 +56,12 @@ winding_t      *AllocWinding( int points )
 
 	c_winding_allocs++;
 	c_winding_points += points;
-	c_active_windings++;
 
-	if ( c_active_windings > c_peak_windings )
+	int active = ++c_active_windings;
+
+	if ( active > c_peak_windings )
 	{
-		c_peak_windings = c_active_windings;
+		c_peak_windings = active;
 	}
 
 	s = sizeof( vec_t ) * 3 * points + sizeof( int );
@@ -213,7 +215,7 @@ void ChopWindingInPlace( winding_t **inout, vec3_t normal, vec_t dist, vec_t eps
 	vec_t        dists[ MAX_POINTS_ON_WINDING + 4 ];
 	planeSide_t  sides[ MAX_POINTS_ON_WINDING + 4 ];
 	int          counts[ 3 ];
-	static vec_t dot; // VC 4.2 optimizer bug if not static
+	vec_t        dot;
 	int          i, j;
 	vec_t        *p1, *p2;
 	vec3_t       mid;
@@ -39,6 +39,16 @@ Maryland 20850 USA.
 void         CM_LoadMap(Str::StringRef name);
 void         CM_ClearMap();
 
+namespace IPC { class SharedMemory; }
+
+#ifndef BUILD_VM
+// a copy of the model of the loaded map for the VMs, empty when not shared
+const IPC::SharedMemory &CM_SharedModel();
+#else
+// model the engine shares with the VM, used by the next CM_LoadMap
+void         CM_ReceiveSharedModel( IPC::SharedMemory shm );
+#endif
+
 clipHandle_t CM_InlineModel( int index );  // 0 = world, 1 + are bmodels
 clipHandle_t CM_TempBoxModel( const vec3_t mins, const vec3_t maxs, int capsule );
 
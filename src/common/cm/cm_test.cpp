@@ -236,7 +236,7 @@ int CM_PointContents( const vec3_t p, clipHandle_t model )
 	for ( k = 0; k < leaf->numLeafBrushes; k++ )
 	{
 		brushnum = cm.leafbrushes[ leaf->firstLeafBrush + k ];
-		b = &cm.brushes[ brushnum ];
+		b = CM_Brush( brushnum );
 
 		// XreaL BEGIN
 		if ( !CM_BoundsIntersectPoint( b->bounds[ 0 ], b->bounds[ 1 ], p ) )
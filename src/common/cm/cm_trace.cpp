@@ -383,14 +383,16 @@ void CM_TestInLeaf( traceWork_t *tw, cLeaf_t *leaf )
 	for ( k = 0; k < leaf->numLeafBrushes; k++ )
 	{
 		brushnum = cm.leafbrushes[ leaf->firstLeafBrush + k ];
-		b = &cm.brushes[ brushnum ];
+		b = CM_Brush( brushnum );
 
-		if ( b->checkcount == cm.checkcount )
+		cBrushState_t *state = CM_BrushState( b );
+
+		if ( state->checkcount == cm.checkcount )
 		{
 			continue; // already checked this brush in another leaf
 		}
 
-		b->checkcount = cm.checkcount;
+		state->checkcount = cm.checkcount;
 
 		if ( !( b->contents & tw->contents ) )
 		{
@@ -413,19 +415,20 @@ void CM_TestInLeaf( traceWork_t *tw, cLeaf_t *leaf )
 	// test against all surfaces
 	for ( k = 0; k < leaf->numLeafSurfaces; k++ )
 	{
-		surface = cm.surfaces[ cm.leafsurfaces[ leaf->firstLeafSurface + k ] ];
+		int surfaceNum = cm.leafsurfaces[ leaf->firstLeafSurface + k ];
+		surface = cm.surfaces[ surfaceNum ];
 
 		if ( !surface )
 		{
 			continue;
 		}
 
-		if ( surface->checkcount == cm.checkcount )
+		if ( cm.surfaceCheckCounts[ surfaceNum ] == cm.checkcount )
 		{
 			continue; // already checked this surface in another leaf
 		}
 
-		surface->checkcount = cm.checkcount;
+		cm.surfaceCheckCounts[ surfaceNum ] = cm.checkcount;
 
 		if ( !( surface->contents & tw->contents ) )
 		{
@@ -1088,7 +1091,7 @@ void CM_TraceThroughBrush( traceWork_t *tw, cbrush_t *brush )
 				continue;
 			}
 
-			brush->collided = true;
+			CM_BrushState( brush )->collided = true;
 
 			// crosses face
 			if ( d1 > d2 )
@@ -1179,7 +1182,7 @@ void CM_TraceThroughBrush( traceWork_t *tw, cbrush_t *brush )
 				continue;
 			}
 
-			brush->collided = true;
+			CM_BrushState( brush )->collided = true;
 
 			// crosses face
 			if ( d1 > d2 )
@@ -1256,7 +1259,7 @@ void CM_TraceThroughBrush( traceWork_t *tw, cbrush_t *brush )
 				continue;
 			}
 
-			brush->collided = true;
+			CM_BrushState( brush )->collided = true;
 
 			// crosses face
 			if ( d1 > d2 )
@@ -1446,14 +1449,16 @@ void CM_TraceThroughLeaf( traceWork_t *tw, cLeaf_t *leaf )
 	{
 		brushnum = cm.leafbrushes[ leaf->firstLeafBrush + k ];
 
-		b = &cm.brushes[ brushnum ];
+		b = CM_Brush( brushnum );
+
+		cBrushState_t *state = CM_BrushState( b );
 
-		if ( b->checkcount == cm.checkcount )
+		if ( state->checkcount == cm.checkcount )
 		{
 			continue; // already checked this brush in another leaf
 		}
 
-		b->checkcount = cm.checkcount;
+		state->checkcount = cm.checkcount;
 
 		if ( !( b->contents & tw->contents ) )
 		{
@@ -1465,7 +1470,7 @@ void CM_TraceThroughLeaf( traceWork_t *tw, cLeaf_t *leaf )
 			continue;
 		}
 
-		b->collided = false;
+		state->collided = false;
 
 		if ( !CM_BoundsIntersect( tw->bounds[ 0 ], tw->bounds[ 1 ], b->bounds[ 0 ], b->bounds[ 1 ] ) )
 		{
@@ -1484,19 +1489,20 @@ void CM_TraceThroughLeaf( traceWork_t *tw, cLeaf_t *leaf )
 	// trace line against all surfaces in the leaf
 	for ( k = 0; k < leaf->numLeafSurfaces; k++ )
 	{
-		surface = cm.surfaces[ cm.leafsurfaces[ leaf->firstLeafSurface + k ] ];
+		int surfaceNum = cm.leafsurfaces[ leaf->firstLeafSurface + k ];
+		surface = cm.surfaces[ surfaceNum ];
 
 		if ( !surface )
 		{
 			continue;
 		}
 
-		if ( surface->checkcount == cm.checkcount )
+		if ( cm.surfaceCheckCounts[ surfaceNum ] == cm.checkcount )
 		{
 			continue; // already checked this surface in another leaf
 		}
 
-		surface->checkcount = cm.checkcount;
+		cm.surfaceCheckCounts[ surfaceNum ] = cm.checkcount;
 
 		if ( !( surface->contents & tw->contents ) )
 		{
@@ -1528,10 +1534,10 @@ void CM_TraceThroughLeaf( traceWork_t *tw, cLeaf_t *leaf )
 		{
 			brushnum = cm.leafbrushes[ leaf->firstLeafBrush + k ];
 
-			b = &cm.brushes[ brushnum ];
+			b = CM_Brush( brushnum );
 
 			// This brush never collided, so don't bother
-			if ( !b->collided )
+			if ( !CM_BrushState( b )->collided )
 			{
 				continue;
 			}
@@ -2607,7 +2613,7 @@ float CM_DistanceToModel( const vec3_t loc, clipHandle_t model ) {
 	for ( k = 0; k < cmod->leaf.numLeafBrushes; k++ )
 	{
 		brushnum = cm.leafbrushes[ cmod->leaf.firstLeafBrush + k ];
-		b = &cm.brushes[ brushnum ];
+		b = CM_Brush( brushnum );
 
 		d1 = CM_DistanceToBrush( loc, b );
 		if( d1 < dist )
@@ -188,6 +188,7 @@ CM_SurfaceCollideFromTriangleSoup
 */
 static void CM_SurfaceCollideFromTriangleSoup( cTriangleSoup_t *triSoup, cSurfaceCollide_t *sc )
 {
+	cSurfaceWork_t *work = CM_SurfaceWork();
 	int             i;
 	float          *p1, *p2, *p3;
 //	int             i1, i2, i3;
@@ -211,7 +212,7 @@ static void CM_SurfaceCollideFromTriangleSoup( cTriangleSoup_t *triSoup, cSurfac
 	// create the borders for each triangle
 	for ( i = 0; i < triSoup->numTriangles; i++ )
 	{
-		facet = &facets[ numFacets ];
+		facet = &work->facets[ work->numFacets ];
 		Com_Memset( facet, 0, sizeof( *facet ) );
 
 		p1 = triSoup->points[ i ][ 0 ];
@@ -243,7 +244,7 @@ static void CM_SurfaceCollideFromTriangleSoup( cTriangleSoup_t *triSoup, cSurfac
 					if ( CM_ValidateFacet( facet ) )
 					{
 						CM_AddFacetBevels( facet );
-						numFacets++;
+						work->numFacets++;
 
 						i++; // skip next tri
 						continue;
@@ -261,19 +262,19 @@ static void CM_SurfaceCollideFromTriangleSoup( cTriangleSoup_t *triSoup, cSurfac
 			if ( CM_ValidateFacet( facet ) )
 			{
 				CM_AddFacetBevels( facet );
-				numFacets++;
+				work->numFacets++;
 			}
 		}
 	}
 
 	// copy the results out
-	sc->numPlanes = numPlanes;
-	sc->planes = ( cPlane_t * ) CM_Alloc( numPlanes * sizeof( *sc->planes ) );
-	Com_Memcpy( sc->planes, planes, numPlanes * sizeof( *sc->planes ) );
+	sc->numPlanes = work->numPlanes;
+	sc->planes = ( cPlane_t * ) CM_Alloc( work->numPlanes * sizeof( *sc->planes ) );
+	Com_Memcpy( sc->planes, work->planes, work->numPlanes * sizeof( *sc->planes ) );
 
-	sc->numFacets = numFacets;
-	sc->facets = ( cFacet_t * ) CM_Alloc( numFacets * sizeof( *sc->facets ) );
-	Com_Memcpy( sc->facets, facets, numFacets * sizeof( *sc->facets ) );
+	sc->numFacets = work->numFacets;
+	sc->facets = ( cFacet_t * ) CM_Alloc( work->numFacets * sizeof( *sc->facets ) );
+	Com_Memcpy( sc->facets, work->facets, work->numFacets * sizeof( *sc->facets ) );
 }
 
 /*
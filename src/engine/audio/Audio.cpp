@@ -31,6 +31,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <common/FileSystem.h>
 #include "AudioPrivate.h"
 #include "AudioData.h"
+#include "SoundCodec.h"
 
 namespace Audio {
 
@@ -41,6 +42,8 @@ namespace Audio {
     static Cvar::Cvar<bool> muteWhenMinimized("audio.muteWhenMinimized", "should the game be muted when minimized", Cvar::NONE, false);
     static Cvar::Cvar<bool> muteWhenUnfocused("audio.muteWhenUnfocused", "should the game be muted when not focused", Cvar::NONE, false);
 
+    static Cvar::Cvar<bool> streamMusic("audio.streamMusic", "should music be decoded while it plays instead of all at once", Cvar::NONE, true);
+
     //TODO make them the equivalent of LATCH and ROM for available*
     static Cvar::Cvar<std::string> deviceString("audio.al.device", "the OpenAL device to use", Cvar::ARCHIVE, "");
     static Cvar::Cvar<std::string> availableDevices("audio.al.availableDevices", "the available OpenAL devices", Cvar::NONE, "");
@@ -70,7 +73,7 @@ namespace Audio {
     void CaptureTestUpdate();
 
     // Like in the previous sound system, we only have a single music
-    std::shared_ptr<LoopingSound> music;
+    std::shared_ptr<Sound> music;
 
     bool IsValidEntity(int entityNum) {
         return entityNum >= 0 and entityNum < MAX_GENTITIES;
@@ -314,6 +317,30 @@ namespace Audio {
             return;
         }
 
+        if (streamMusic.Get()) {
+            std::unique_ptr<StreamingCodec> leadingCodec;
+            std::unique_ptr<StreamingCodec> loopingCodec;
+            if (not leadingSound.empty()) {
+                leadingCodec = OpenStreamingCodec(leadingSound);
+            }
+            if (not loopSound.empty()) {
+                loopingCodec = OpenStreamingCodec(loopSound);
+            }
+
+            // Formats that can't be streamed (wav) are loaded as samples like before
+            if ((leadingSound.empty() or leadingCodec) and (loopSound.empty() or loopingCodec)) {
+                // Like LoopingSound, a leading sound without a loop is repeated
+                if (not loopingCodec) {
+                    loopingCodec = std::move(leadingCodec);
+                }
+
+                StopMusic();
+                music = std::make_shared<StreamingMusic>(std::move(loopingCodec), std::move(leadingCodec));
+                AddSound(GetLocalEmitter(), music, 1);
+                return;
+            }
+        }
+
         std::shared_ptr<Sample> leadingSample = nullptr;
         std::shared_ptr<Sample> loopingSample = nullptr;
         if (not leadingSound.empty()) {
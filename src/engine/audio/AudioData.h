@@ -48,7 +48,16 @@ struct AudioData {
 	    , byteDepth{byteDepth}
 	    , numberOfChannels{numberOfChannels}
 	    , size{size}
-	    , rawSamples{rawSamples}
+	    , rawSamples{rawSamples, std::default_delete<const char[]>()}
+	{}
+
+	// The samples can also be kept alive by something else, like a mapped file
+	AudioData(int sampleRate, int byteDepth, int numberOfChannels, int size, std::shared_ptr<const char> rawSamples)
+	    : sampleRate{sampleRate}
+	    , byteDepth{byteDepth}
+	    , numberOfChannels{numberOfChannels}
+	    , size{size}
+	    , rawSamples{std::move(rawSamples)}
 	{}
 
 	AudioData(AudioData&& that)
@@ -65,7 +74,7 @@ struct AudioData {
 	const int byteDepth;
 	const int numberOfChannels;
 	const int size;
-	std::unique_ptr<const char[]> rawSamples;
+	std::shared_ptr<const char> rawSamples;
 };
 } // namespace Audio
 #endif
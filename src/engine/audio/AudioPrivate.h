@@ -38,7 +38,8 @@ namespace Audio {
 
     /**
      * The audio system is split in several parts:
-     * - Audio codecs, one for each supported format that allow to load an entire file.
+     * - Audio codecs, one for each supported format that allow to load an entire file or to stream it.
+     * - SampleCache that keeps the decoded samples of compressed files on disk to skip decoding them again.
      * - ALObjects that provide OO wrappers around OpenAL (OpenAL headers are only included in ALObjects.cpp)
      * - Audio the external interface, mostly using Sound and Emitter to create new sounds.
      * - Emitters that control the positional effects for the sound sources
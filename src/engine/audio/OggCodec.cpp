@@ -111,60 +111,125 @@ size_t OggCallbackRead(void* ptr, size_t size, size_t count, void* datasource)
 
 const ov_callbacks Ogg_Callbacks = {&OggCallbackRead, nullptr, nullptr, nullptr};
 
-AudioData LoadOggCodec(std::string filename)
-{
-	std::string audioFile;
-	try
+class OggStream : public StreamingCodec {
+public:
+	OggStream(std::string filename, std::string audioFile)
+		: filename(std::move(filename)), audioFile(std::move(audioFile)), opened(false), sampleRate(0), numberOfChannels(0)
 	{
-		audioFile = FS::PakPath::ReadFile(filename);
+		dataSource = {&this->audioFile, 0};
 	}
-	catch (std::system_error& err)
+
+	~OggStream()
 	{
-		audioLogs.Warn("Failed to open %s: %s", filename, err.what());
-		return AudioData();
+		Close();
 	}
-	OggDataSource dataSource = {&audioFile, 0};
-	std::unique_ptr<OggVorbis_File> vorbisFile(new OggVorbis_File);
 
-	if (ov_open_callbacks(&dataSource, vorbisFile.get(), nullptr, 0, Ogg_Callbacks) != 0) {
-        audioLogs.Warn("Error while reading %s", filename);
-		ov_clear(vorbisFile.get());
-		return AudioData();
+	bool Open()
+	{
+		if (ov_open_callbacks(&dataSource, &vorbisFile, nullptr, 0, Ogg_Callbacks) != 0) {
+			audioLogs.Warn("Error while reading %s", filename);
+			ov_clear(&vorbisFile);
+			return false;
+		}
+		opened = true;
+
+		if (ov_streams(&vorbisFile) != 1) {
+			audioLogs.Warn("Unsupported number of streams in %s.", filename);
+			Close();
+			return false;
+		}
+
+		vorbis_info* oggInfo = ov_info(&vorbisFile, 0);
+
+		if (!oggInfo) {
+			audioLogs.Warn("Could not read vorbis_info in %s.", filename);
+			Close();
+			return false;
+		}
+
+		sampleRate = oggInfo->rate;
+		numberOfChannels = oggInfo->channels;
+		return true;
 	}
 
-	if (ov_streams(vorbisFile.get()) != 1) {
-		audioLogs.Warn("Unsupported number of streams in %s.", filename);
-		ov_clear(vorbisFile.get());
-		return AudioData();
+	AudioData Decode(int maxBytes) OVERRIDE
+	{
+		const int sampleWidth = 2;
+
+		if (!opened) {
+			return AudioData(sampleRate, sampleWidth, numberOfChannels, 0, nullptr);
+		}
+
+		char* rawSamples = new char[maxBytes];
+		int size = 0;
+		int bytesRead = 0;
+		int bitStream = 0;
+
+		while (size < maxBytes &&
+		       (bytesRead = ov_read(&vorbisFile, rawSamples + size, maxBytes - size, 0, sampleWidth, 1, &bitStream)) > 0) {
+			size += bytesRead;
+		}
+
+		return AudioData(sampleRate, sampleWidth, numberOfChannels, size, rawSamples);
 	}
 
-	vorbis_info* oggInfo = ov_info(vorbisFile.get(), 0);
+	// The callbacks can't seek so reopen the file instead
+	bool Rewind() OVERRIDE
+	{
+		Close();
+		dataSource.position = 0;
+		return Open();
+	}
 
-	if (!oggInfo) {
-        audioLogs.Warn("Could not read vorbis_info in %s.", filename);
-		ov_clear(vorbisFile.get());
-		return AudioData();
+private:
+	void Close()
+	{
+		if (opened) {
+			ov_clear(&vorbisFile);
+			opened = false;
+		}
+	}
+
+	std::string filename;
+	std::string audioFile;
+	OggDataSource dataSource;
+	OggVorbis_File vorbisFile;
+	bool opened;
+	int sampleRate;
+	int numberOfChannels;
+};
+
+std::unique_ptr<StreamingCodec> OpenOggStream(std::string filename)
+{
+	std::string audioFile;
+	try
+	{
+		audioFile = FS::PakPath::ReadFile(filename);
+	}
+	catch (std::system_error& err)
+	{
+		audioLogs.Warn("Failed to open %s: %s", filename, err.what());
+		return nullptr;
 	}
 
-	const int sampleWidth = 2;
+	std::unique_ptr<OggStream> stream(new OggStream(std::move(filename), std::move(audioFile)));
 
-	int sampleRate = oggInfo->rate;
-	int numberOfChannels = oggInfo->channels;
+	if (!stream->Open()) {
+		return nullptr;
+	}
 
-	char buffer[4096];
-	int bytesRead = 0;
-	int bitStream = 0;
+	return std::unique_ptr<StreamingCodec>(std::move(stream));
+}
 
-	std::vector<char> samples;
+AudioData LoadOggCodec(std::string filename)
+{
+	std::unique_ptr<StreamingCodec> stream = OpenOggStream(std::move(filename));
 
-	while ((bytesRead = ov_read(vorbisFile.get(), buffer, 4096, 0, sampleWidth, 1, &bitStream)) > 0) {
-		std::copy_n(buffer, bytesRead, std::back_inserter(samples));
+	if (!stream) {
+		return AudioData();
 	}
-	ov_clear(vorbisFile.get());
 
-	char* rawSamples = new char[samples.size()];
-	std::copy_n(samples.data(), samples.size(), rawSamples);
-	return AudioData(sampleRate, sampleWidth, numberOfChannels, samples.size(), rawSamples);
+	return DecodeWholeStream(*stream);
 }
 
 } //namespace Audio
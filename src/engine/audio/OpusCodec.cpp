@@ -99,70 +99,131 @@ int OpusCallbackRead(void* dataSource, unsigned char* ptr, int nBytes)
 
 const OpusFileCallbacks Opus_Callbacks = {&OpusCallbackRead, nullptr, nullptr, nullptr};
 
-AudioData LoadOpusCodec(std::string filename)
-{
-	std::string audioFile;
-	try
+class OpusStream : public StreamingCodec {
+public:
+	OpusStream(std::string filename, std::string audioFile)
+		: filename(std::move(filename)), audioFile(std::move(audioFile)), opusFile(nullptr), numberOfChannels(0)
 	{
-		audioFile = FS::PakPath::ReadFile(filename);
+		dataSource = {&this->audioFile, 0};
 	}
-	catch (std::system_error& err)
+
+	~OpusStream()
 	{
-		audioLogs.Warn("Failed to open %s: %s", filename, err.what());
-		return AudioData();
+		Close();
 	}
 
-	OpusDataSource dataSource = {&audioFile, 0};
-	OggOpusFile* opusFile = op_open_callbacks(&dataSource, &Opus_Callbacks, nullptr, 0, nullptr);
-
-	if (!opusFile) {
-		audioLogs.Warn("Error while reading %s", filename);
-		return AudioData();
+	bool Open()
+	{
+		opusFile = op_open_callbacks(&dataSource, &Opus_Callbacks, nullptr, 0, nullptr);
+
+		if (!opusFile) {
+			audioLogs.Warn("Error while reading %s", filename);
+			return false;
+		}
+
+		const OpusHead* opusInfo = op_head(opusFile, -1);
+
+		if (!opusInfo) {
+			Close();
+			audioLogs.Warn("Could not read OpusHead in %s", filename);
+			return false;
+		}
+
+		if (opusInfo->stream_count != 1) {
+			Close();
+			audioLogs.Warn("Only one stream is supported in Opus files: %s", filename);
+			return false;
+		}
+
+		if (opusInfo->channel_count != 1 && opusInfo->channel_count != 2) {
+			Close();
+			audioLogs.Warn("Only mono and stereo Opus files are supported: %s", filename);
+			return false;
+		}
+
+		numberOfChannels = opusInfo->channel_count;
+		return true;
 	}
 
-	const OpusHead* opusInfo = op_head(opusFile, -1);
-
-	if (!opusInfo) {
-		op_free(opusFile);
-		audioLogs.Warn("Could not read OpusHead in %s", filename);
-		return AudioData();
+	AudioData Decode(int maxBytes) OVERRIDE
+	{
+		const int sampleWidth = 2;
+		const int sampleRate = 48000;
+
+		if (!opusFile) {
+			return AudioData(sampleRate, sampleWidth, numberOfChannels, 0, nullptr);
+		}
+
+		int maxSamples = maxBytes / sampleWidth / numberOfChannels * numberOfChannels;
+		char* rawSamples = new char[maxSamples * sampleWidth];
+		opus_int16* buffer = reinterpret_cast<opus_int16*>(rawSamples);
+		int samples = 0;
+		int samplesPerChannelRead = 0;
+
+		// opusfile keeps the rest of a packet that doesn't fit in the buffer for the next read
+		while (samples < maxSamples &&
+		       (samplesPerChannelRead = op_read(opusFile, buffer + samples, maxSamples - samples, nullptr)) > 0) {
+			samples += samplesPerChannelRead * numberOfChannels;
+		}
+
+		return AudioData(sampleRate, sampleWidth, numberOfChannels, samples * sampleWidth, rawSamples);
 	}
 
-	if (opusInfo->stream_count != 1) {
-		op_free(opusFile);
-		audioLogs.Warn("Only one stream is supported in Opus files: %s", filename);
-		return AudioData();
+	// The callbacks can't seek so reopen the file instead
+	bool Rewind() OVERRIDE
+	{
+		Close();
+		dataSource.position = 0;
+		return Open();
 	}
 
-	if (opusInfo->channel_count != 1 && opusInfo->channel_count != 2) {
-		op_free(opusFile);
-		audioLogs.Warn("Only mono and stereo Opus files are supported: %s", filename);
-		return AudioData();
+private:
+	void Close()
+	{
+		if (opusFile) {
+			op_free(opusFile);
+			opusFile = nullptr;
+		}
 	}
 
-	const int sampleWidth = 2;
-
-	int sampleRate = 48000;
-	int numberOfChannels = opusInfo->channel_count;
+	std::string filename;
+	std::string audioFile;
+	OpusDataSource dataSource;
+	OggOpusFile* opusFile;
+	int numberOfChannels;
+};
 
-	// The buffer is big enough to hold 120ms worth of samples per channel
-	opus_int16* buffer = new opus_int16[numberOfChannels * 5760];
-	int samplesPerChannelRead = 0;
+std::unique_ptr<StreamingCodec> OpenOpusStream(std::string filename)
+{
+	std::string audioFile;
+	try
+	{
+		audioFile = FS::PakPath::ReadFile(filename);
+	}
+	catch (std::system_error& err)
+	{
+		audioLogs.Warn("Failed to open %s: %s", filename, err.what());
+		return nullptr;
+	}
 
-	std::vector<opus_int16> samples;
+	std::unique_ptr<OpusStream> stream(new OpusStream(std::move(filename), std::move(audioFile)));
 
-	while ((samplesPerChannelRead =
-	            op_read(opusFile, buffer, sampleWidth * numberOfChannels * 5760, nullptr)) > 0) {
-		std::copy_n(buffer, samplesPerChannelRead * numberOfChannels, std::back_inserter(samples));
+	if (!stream->Open()) {
+		return nullptr;
 	}
 
-	op_free(opusFile);
+	return std::unique_ptr<StreamingCodec>(std::move(stream));
+}
 
-	char* rawSamples = new char[sampleWidth * samples.size()];
-	std::copy_n(reinterpret_cast<char*>(samples.data()), sampleWidth * samples.size(), rawSamples);
+AudioData LoadOpusCodec(std::string filename)
+{
+	std::unique_ptr<StreamingCodec> stream = OpenOpusStream(std::move(filename));
+
+	if (!stream) {
+		return AudioData();
+	}
 
-	return AudioData(sampleRate, sampleWidth, numberOfChannels, samples.size() * sampleWidth,
-	                 rawSamples);
+	return DecodeWholeStream(*stream);
 }
 
 } //namespace Audio
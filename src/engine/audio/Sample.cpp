@@ -30,6 +30,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "AudioPrivate.h"
 #include "SoundCodec.h"
+#include "SampleCache.h"
 
 namespace Audio {
 
@@ -98,6 +99,8 @@ namespace Audio {
         delete sampleManager;
         sampleManager = nullptr;
 
+        ShutdownSampleCache();
+
         initialized = false;
     }
 
@@ -128,5 +131,6 @@ namespace Audio {
 
     void EndSampleRegistration() {
         sampleManager->EndRegistration();
+        FlushSampleCache();
     }
 }
@@ -0,0 +1,361 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2013-2016, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#include "AudioPrivate.h"
+#include "SampleCache.h"
+#include <common/FileSystem.h>
+
+namespace Audio {
+
+    static Cvar::Cvar<bool> useSampleCache("audio.sampleCache", "should decoded sounds be cached on disk", Cvar::NONE, true);
+    static Cvar::Range<Cvar::Cvar<int>> sampleCacheSize("audio.sampleCache.maxSize", "the maximum size of the sound cache in MB", Cvar::NONE, 256, 1, 4096);
+
+    static const char cacheDir[] = "cache/sound/";
+    static const char cacheIndexName[] = "index.txt";
+    static const char cacheExt[] = ".pcm";
+    static const char cacheMagic[4] = {'D', 'P', 'C', 'M'};
+    static const int cacheVersion = 1;
+
+    // Followed by the key of the entry then by the samples at samplesOffset
+    struct cachedSampleHeader_t {
+        char magic[4];
+        int version;
+        int sampleRate;
+        int byteDepth;
+        int numberOfChannels;
+        int size;
+        int keyLength;
+        int samplesOffset;
+    };
+
+    struct cacheEntry_t {
+        uint64_t size;
+        uint64_t lastUse;
+    };
+
+    // Cache entries by file name, lastUse is a counter that increases with each use
+    static std::unordered_map<std::string, cacheEntry_t> cacheEntries;
+    static uint64_t cacheTotalSize = 0;
+    static uint64_t cacheUseCounter = 0;
+    static bool cacheLoaded = false;
+    static bool cacheDirty = false;
+
+    static uint64_t MaxCacheSize() {
+        return uint64_t(sampleCacheSize.Get()) * 1024 * 1024;
+    }
+
+    // Identifies the exact version of the file the samples were decoded from.
+    static std::string CacheKey(Str::StringRef filename) {
+        const FS::LoadedPakInfo* pak = FS::PakPath::LocateFile(filename);
+
+        if (not pak) {
+            return "";
+        }
+
+        if (pak->realChecksum) {
+            return Str::Format("%s_%s %08x %s", pak->name, pak->version, *pak->realChecksum, filename);
+        }
+
+        // Directory paks don't have a checksum, use the time the file was modified instead
+        std::error_code err;
+        auto timestamp = FS::PakPath::FileTimestamp(filename, err);
+
+        if (err) {
+            return "";
+        }
+
+        return Str::Format("%s_%s @%d %s", pak->name, pak->version, std::chrono::system_clock::to_time_t(timestamp), filename);
+    }
+
+    static std::string CacheFileName(const std::string& key) {
+        return Str::Format("%08x%s", Com_BlockChecksum(key.data(), key.size()), cacheExt);
+    }
+
+    static void RemoveCacheEntry(const std::string& name) {
+        auto it = cacheEntries.find(name);
+
+        if (it == cacheEntries.end()) {
+            return;
+        }
+
+        std::error_code err;
+        FS::HomePath::DeleteFile(cacheDir + name, err);
+
+        cacheTotalSize -= it->second.size;
+        cacheEntries.erase(it);
+        cacheDirty = true;
+    }
+
+    // Removes the least recently used entries until the cache fits in its maximum size.
+    static void EvictCacheEntries() {
+        uint64_t maxSize = MaxCacheSize();
+
+        if (cacheTotalSize <= maxSize) {
+            return;
+        }
+
+        std::vector<std::pair<uint64_t, std::string>> byAge;
+        for (const auto& entry : cacheEntries) {
+            byAge.emplace_back(entry.second.lastUse, entry.first);
+        }
+        std::sort(byAge.begin(), byAge.end());
+
+        int numEvicted = 0;
+        for (const auto& entry : byAge) {
+            if (cacheTotalSize <= maxSize) {
+                break;
+            }
+
+            RemoveCacheEntry(entry.second);
+            numEvicted++;
+        }
+
+        audioLogs.Verbose("Evicted %d sounds from the sample cache", numEvicted);
+    }
+
+    // Reads the index lazily so that nothing is done when the cache is disabled.
+    static void LoadCacheIndex() {
+        if (cacheLoaded) {
+            return;
+        }
+
+        cacheLoaded = true;
+
+        std::unordered_map<std::string, cacheEntry_t> indexEntries;
+        std::error_code err;
+        FS::File index = FS::HomePath::OpenRead(Str::Format("%s%s", cacheDir, cacheIndexName), err);
+
+        if (not err) {
+            std::istringstream stream(index.ReadAll(err));
+            std::string name;
+            cacheEntry_t entry;
+
+            while (stream >> name >> entry.size >> entry.lastUse) {
+                indexEntries[name] = entry;
+                cacheUseCounter = std::max(cacheUseCounter, entry.lastUse);
+            }
+        }
+
+        // The index is only a hint, the files that are actually there are authoritative
+        try {
+            for (const std::string& name : FS::HomePath::ListFiles(cacheDir)) {
+                if (not Str::IsSuffix(cacheExt, name)) {
+                    continue;
+                }
+
+                auto it = indexEntries.find(name);
+                cacheEntry_t entry;
+
+                if (it != indexEntries.end()) {
+                    entry = it->second;
+                } else {
+                    // Written by a session that didn't save the index, consider it the oldest entry
+                    FS::File file = FS::HomePath::OpenRead(cacheDir + name, err);
+                    if (err) {
+                        continue;
+                    }
+                    entry.size = file.Length(err);
+                    entry.lastUse = 0;
+                    cacheDirty = true;
+                }
+
+                cacheEntries[name] = entry;
+                cacheTotalSize += entry.size;
+            }
+        } catch (std::system_error&) {}
+
+        if (cacheEntries.size() != indexEntries.size()) {
+            cacheDirty = true;
+        }
+
+        audioLogs.Verbose("Sample cache contains %d sounds using %d KB", cacheEntries.size(), cacheTotalSize / 1024);
+
+        EvictCacheEntries();
+    }
+
+    AudioData LoadCachedSample(Str::StringRef filename) {
+        if (not useSampleCache.Get()) {
+            return AudioData();
+        }
+
+        LoadCacheIndex();
+
+        std::string key = CacheKey(filename);
+        if (key.empty()) {
+            return AudioData();
+        }
+
+        std::string name = CacheFileName(key);
+        auto it = cacheEntries.find(name);
+        if (it == cacheEntries.end()) {
+            return AudioData();
+        }
+
+        // The mapping is shared with the AudioData so that the samples are never copied
+        std::error_code err;
+        FS::File file = FS::HomePath::OpenRead(cacheDir + name, err);
+        if (err) {
+            RemoveCacheEntry(name);
+            return AudioData();
+        }
+
+        auto mapping = std::make_shared<FS::MappedFile>(FS::MappedFile::Map(file, err));
+        if (err) {
+            audioLogs.Warn("Couldn't map the cached samples of %s: %s", filename, err.message());
+            return AudioData();
+        }
+
+        const char* data = static_cast<const char*>(mapping->Data());
+        uint64_t fileSize = mapping->Size();
+        cachedSampleHeader_t header;
+
+        if (fileSize < sizeof(header)) {
+            RemoveCacheEntry(name);
+            return AudioData();
+        }
+
+        memcpy(&header, data, sizeof(header));
+
+        if (memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0 or header.version != cacheVersion) {
+            RemoveCacheEntry(name);
+            return AudioData();
+        }
+
+        if (header.size <= 0 or header.keyLength < 0 or header.samplesOffset < 0 or
+            uint64_t(header.keyLength) + sizeof(header) > uint64_t(header.samplesOffset) or
+            uint64_t(header.samplesOffset) + uint64_t(header.size) > fileSize) {
+            audioLogs.Warn("The cached samples of %s are corrupted", filename);
+            RemoveCacheEntry(name);
+            return AudioData();
+        }
+
+        // Another file with the same hash, it will be replaced when this one is stored
+        if (std::string(data + sizeof(header), header.keyLength) != key) {
+            return AudioData();
+        }
+
+        it->second.lastUse = ++cacheUseCounter;
+        cacheDirty = true;
+
+        audioLogs.Debug("Loaded the samples of %s from the cache", filename);
+
+        std::shared_ptr<const char> samples(mapping, data + header.samplesOffset);
+        return AudioData(header.sampleRate, header.byteDepth, header.numberOfChannels, header.size, std::move(samples));
+    }
+
+    void StoreCachedSample(Str::StringRef filename, const AudioData& audioData) {
+        if (not useSampleCache.Get() or audioData.size == 0) {
+            return;
+        }
+
+        LoadCacheIndex();
+
+        std::string key = CacheKey(filename);
+        if (key.empty()) {
+            return;
+        }
+
+        cachedSampleHeader_t header;
+        memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+        header.version = cacheVersion;
+        header.sampleRate = audioData.sampleRate;
+        header.byteDepth = audioData.byteDepth;
+        header.numberOfChannels = audioData.numberOfChannels;
+        header.size = audioData.size;
+        header.keyLength = key.size();
+        header.samplesOffset = PAD(sizeof(header) + key.size(), 16);
+
+        uint64_t fileSize = uint64_t(header.samplesOffset) + audioData.size;
+        if (fileSize > MaxCacheSize()) {
+            return;
+        }
+
+        std::string name = CacheFileName(key);
+        std::string path = cacheDir + name;
+        std::string tempPath = path + ".tmp";
+
+        // Write to a temporary file so that an interrupted write never leaves a truncated entry
+        try {
+            static const char padding[16] = {};
+            FS::File file = FS::HomePath::OpenWrite(tempPath);
+            file.Write(&header, sizeof(header));
+            file.Write(key.data(), key.size());
+            file.Write(padding, header.samplesOffset - sizeof(header) - key.size());
+            file.Write(audioData.rawSamples.get(), audioData.size);
+            file.Close();
+            FS::HomePath::MoveFile(path, tempPath);
+        } catch (std::system_error& err) {
+            audioLogs.Warn("Couldn't write the cached samples of %s: %s", filename, err.what());
+            std::error_code ignored;
+            FS::HomePath::DeleteFile(tempPath, ignored);
+            return;
+        }
+
+        auto it = cacheEntries.find(name);
+        if (it != cacheEntries.end()) {
+            cacheTotalSize -= it->second.size;
+        }
+
+        cacheEntries[name] = {fileSize, ++cacheUseCounter};
+        cacheTotalSize += fileSize;
+        cacheDirty = true;
+
+        EvictCacheEntries();
+    }
+
+    void FlushSampleCache() {
+        if (not cacheDirty) {
+            return;
+        }
+
+        try {
+            FS::File index = FS::HomePath::OpenWrite(Str::Format("%s%s", cacheDir, cacheIndexName));
+            for (const auto& entry : cacheEntries) {
+                index.Printf("%s %d %d\n", entry.first, entry.second.size, entry.second.lastUse);
+            }
+            index.Close();
+        } catch (std::system_error& err) {
+            audioLogs.Warn("Couldn't save the sample cache index: %s", err.what());
+            return;
+        }
+
+        cacheDirty = false;
+    }
+
+    void ShutdownSampleCache() {
+        FlushSampleCache();
+
+        cacheEntries.clear();
+        cacheTotalSize = 0;
+        cacheUseCounter = 0;
+        cacheLoaded = false;
+        cacheDirty = false;
+    }
+}
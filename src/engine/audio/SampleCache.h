@@ -0,0 +1,54 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2013-2016, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#ifndef AUDIO_SAMPLE_CACHE_H_
+#define AUDIO_SAMPLE_CACHE_H_
+
+#include "AudioData.h"
+
+namespace Audio {
+
+    /**
+     * Keeps the decoded samples of compressed sound files in the homepath so that they
+     * are mapped from disk instead of decoded again the next time they are loaded.
+     * Entries are keyed by the pak and file they come from and the least recently used
+     * ones are evicted when the cache grows over audio.sampleCache.maxSize.
+     */
+
+    // Returns an empty AudioData if the samples of filename are not in the cache.
+    AudioData LoadCachedSample(Str::StringRef filename);
+    void StoreCachedSample(Str::StringRef filename, const AudioData& audioData);
+
+    // Saves which entries have been used recently.
+    void FlushSampleCache();
+    void ShutdownSampleCache();
+}
+
+#endif //AUDIO_SAMPLE_CACHE_H_
@@ -29,6 +29,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "AudioPrivate.h"
+#include "SoundCodec.h"
 
 namespace Audio {
 
@@ -47,6 +48,12 @@ namespace Audio {
     static sourceRecord_t* sources = nullptr;
     static CONSTEXPR int nSources = 128; //TODO see what's the limit for OpenAL soft
 
+    // Streaming music keeps at most (queued + decoded) buffers of that many bytes in memory,
+    // at 44.1kHz stereo that is about 3 seconds of music.
+    static CONSTEXPR int MUSIC_BUFFER_SIZE = 64 * 1024;
+    static CONSTEXPR int MUSIC_QUEUED_BUFFERS = 4;
+    static CONSTEXPR size_t MUSIC_DECODED_BUFFERS = 4;
+
     sourceRecord_t* GetSource(int priority);
 
     static bool initialized = false;
@@ -344,4 +351,104 @@ namespace Audio {
     void StreamingSound::SetGain(float gain) {
         SetSoundGain(gain);
     }
+
+    // Implementation of StreamingMusic
+
+    StreamingMusic::StreamingMusic(std::unique_ptr<StreamingCodec> loopingCodec, std::unique_ptr<StreamingCodec> leadingCodec)
+        : loopingCodec(std::move(loopingCodec)),
+          leadingCodec(std::move(leadingCodec)),
+          decodingDone(false),
+          quit(false) {
+        thread = std::thread(&StreamingMusic::DecodeThread, this);
+    }
+
+    StreamingMusic::~StreamingMusic() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        condition.notify_all();
+        thread.join();
+    }
+
+    void StreamingMusic::SetupSource(AL::Source&) {
+        SetSoundGain(effectsVolume.Get());
+    }
+
+    void StreamingMusic::InternalUpdate() {
+        AL::Source& source = GetSource();
+
+        while (source.GetNumProcessedBuffers() > 0) {
+            source.PopBuffer();
+        }
+
+        // Take what the decoder produced so that it can start on the next buffers
+        // while we give these ones to OpenAL.
+        std::vector<AudioData> chunks;
+        bool done;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            int toQueue = MUSIC_QUEUED_BUFFERS - source.GetNumQueuedBuffers();
+
+            while (toQueue-- > 0 and not decoded.empty()) {
+                chunks.push_back(std::move(decoded.front()));
+                decoded.pop_front();
+            }
+
+            done = decodingDone and decoded.empty();
+        }
+        condition.notify_one();
+
+        for (const AudioData& chunk : chunks) {
+            AL::Buffer buffer;
+
+            if (not buffer.Feed(chunk)) {
+                AppendBuffer(std::move(buffer));
+            }
+        }
+
+        if (done and source.GetNumQueuedBuffers() == 0) {
+            Stop();
+            return;
+        }
+
+        SetSoundGain(effectsVolume.Get());
+    }
+
+    void StreamingMusic::DecodeThread() {
+        StreamingCodec* codec = leadingCodec ? leadingCodec.get() : loopingCodec.get();
+        bool decodedSinceRewind = false;
+
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (not quit and codec) {
+            if (decoded.size() >= MUSIC_DECODED_BUFFERS) {
+                condition.wait(lock);
+                continue;
+            }
+
+            lock.unlock();
+            AudioData chunk = codec->Decode(MUSIC_BUFFER_SIZE);
+            bool endOfFile = chunk.size == 0;
+
+            if (endOfFile and codec == leadingCodec.get()) {
+                codec = loopingCodec.get();
+                decodedSinceRewind = false;
+            } else if (endOfFile) {
+                // Stop instead of spinning if the looping part has no samples
+                if (not decodedSinceRewind or not codec->Rewind()) {
+                    codec = nullptr;
+                }
+                decodedSinceRewind = false;
+            }
+            lock.lock();
+
+            if (not endOfFile) {
+                decoded.push_back(std::move(chunk));
+                decodedSinceRewind = true;
+            }
+        }
+
+        decodingDone = true;
+    }
 }
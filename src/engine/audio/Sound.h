@@ -46,6 +46,7 @@ namespace Audio {
     void AddSound(std::shared_ptr<Emitter> emitter, std::shared_ptr<Sound> sound, int priority);
 
     class Sample;
+    class StreamingCodec;
 
     namespace AL {
         class Source;
@@ -137,6 +138,33 @@ namespace Audio {
             void SetGain(float gain);
     };
 
+    // A long sound such as a music that is decoded on a background thread while it plays,
+    // only a few buffers of samples are in memory at any time. The leading part is played
+    // once, then the looping part is repeated.
+    class StreamingMusic : public StreamingSound {
+        public:
+            StreamingMusic(std::unique_ptr<StreamingCodec> loopingCodec, std::unique_ptr<StreamingCodec> leadingCodec = nullptr);
+            virtual ~StreamingMusic();
+
+            virtual void SetupSource(AL::Source& source) OVERRIDE;
+            virtual void InternalUpdate() OVERRIDE;
+
+        private:
+            void DecodeThread();
+
+            std::unique_ptr<StreamingCodec> loopingCodec;
+            std::unique_ptr<StreamingCodec> leadingCodec;
+
+            // Protects everything below, the codecs are only used by the decoding thread
+            std::mutex mutex;
+            std::condition_variable condition;
+            std::deque<AudioData> decoded;
+            bool decodingDone;
+            bool quit;
+
+            std::thread thread;
+    };
+
 }
 
 #endif //AUDIO_SOUND_H_
@@ -29,6 +29,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 #include "SoundCodec.h"
 #include "AudioPrivate.h"
+#include "SampleCache.h"
 #include <common/FileSystem.h>
 
 namespace Audio {
@@ -37,20 +38,25 @@ struct soundExtToLoaderMap_t
 {
 	const char *ext;
 	AudioData (*SoundLoader) (std::string);
+	std::unique_ptr<StreamingCodec> (*StreamLoader) (std::string);
+	// Whether decoding is slow enough for the samples to be worth caching
+	bool cached;
 };
 
 // Note that the ordering indicates the order of preference used
 // when there are multiple sound files of different formats available
 static const soundExtToLoaderMap_t soundLoaders[] =
 {
-	{ ".wav",	LoadWavCodec },
-	{ ".opus",	LoadOpusCodec  },
-	{ ".ogg",	LoadOggCodec  },
+	{ ".wav",	LoadWavCodec, nullptr, false },
+	{ ".opus",	LoadOpusCodec, OpenOpusStream, true },
+	{ ".ogg",	LoadOggCodec, OpenOggStream, true },
 };
 
 static int numSoundLoaders = ARRAY_LEN(soundLoaders);
 
-AudioData LoadSoundCodec(std::string filename)
+// Returns the index of the loader to use for filename, which is changed to the
+// file that has been found, or -1 with a warning if no file can be loaded
+static int FindSoundLoader(std::string& filename)
 {
 
 	std::string ext = FS::Path::Extension(filename);
@@ -62,7 +68,7 @@ AudioData LoadSoundCodec(std::string filename)
 			if (ext == soundLoaders[i].ext) {
 				// if file exists, load it
 				if (FS::PakPath::FileExists(filename)) {
-					return soundLoaders[i].SoundLoader(filename);
+					return i;
 				}
 			}
 		}
@@ -73,37 +79,92 @@ AudioData LoadSoundCodec(std::string filename)
 	// try and find a suitable match using all the sound file formats supported
 	// prioritize with the pak priority
 	int bestLoader = -1;
-	const FS::PakInfo* bestPak = nullptr;
+	uint32_t bestPak = 0;
 	std::string strippedname = FS::Path::StripExtension(filename);
-	
-	for (int i = 0; i < numSoundLoaders; i++)
-	{
-		std::string altName = Str::Format("%s%s", strippedname, soundLoaders[i].ext);
-		const FS::PakInfo* pak = FS::PakPath::LocateFile(altName);
-
-		// We found a file and its pak is better than the best pak we have
-		// this relies on how the filesystem works internally and should be moved
-		// to a more explicit interface once there is one. (FIXME)
-		if (pak != nullptr && (bestPak == nullptr || pak < bestPak ))
-		{
-			bestPak = pak;
-			bestLoader = i;
+
+	// The extensions are sorted by pak priority, so only the formats in the
+	// first pak that has a loadable one need to be compared
+	for (const auto& entry: FS::PakPath::LocateExtensions(strippedname)) {
+		if (bestLoader >= 0 && entry.second != bestPak) {
+			break;
+		}
+
+		for (int i = 0; i < numSoundLoaders; i++) {
+			if (entry.first == soundLoaders[i].ext + 1 and (bestLoader < 0 or i < bestLoader)) {
+				bestPak = entry.second;
+				bestLoader = i;
+			}
 		}
 	}
 
 	if (bestLoader >= 0)
 	{
-		std::string altName = Str::Format("%s%s", strippedname, soundLoaders[bestLoader].ext );
-		return soundLoaders[bestLoader].SoundLoader(altName);
+		filename = Str::Format("%s%s", strippedname, soundLoaders[bestLoader].ext );
+		return bestLoader;
 	}
 
 	if (FS::PakPath::FileExists(filename)) {
 		audioLogs.Warn("No codec available for opening %s.", filename);
-		return AudioData();
+		return -1;
 	}
 
 	audioLogs.Warn("Sound file %s not found.", filename);
-	return AudioData();
+	return -1;
+
+}
+
+AudioData LoadSoundCodec(std::string filename)
+{
+	int loader = FindSoundLoader(filename);
+
+	if (loader < 0) {
+		return AudioData();
+	}
+
+	if (!soundLoaders[loader].cached) {
+		return soundLoaders[loader].SoundLoader(filename);
+	}
+
+	AudioData cachedData = LoadCachedSample(filename);
 
+	if (cachedData.size != 0) {
+		return cachedData;
+	}
+
+	AudioData audioData = soundLoaders[loader].SoundLoader(filename);
+	StoreCachedSample(filename, audioData);
+	return audioData;
+}
+
+std::unique_ptr<StreamingCodec> OpenStreamingCodec(std::string filename)
+{
+	int loader = FindSoundLoader(filename);
+
+	if (loader < 0 || !soundLoaders[loader].StreamLoader) {
+		return nullptr;
+	}
+
+	return soundLoaders[loader].StreamLoader(filename);
+}
+
+AudioData DecodeWholeStream(StreamingCodec& codec)
+{
+	std::vector<char> samples;
+
+	while (true) {
+		AudioData chunk = codec.Decode(65536);
+
+		if (chunk.size == 0) {
+			if (samples.empty()) {
+				return chunk;
+			}
+
+			char* rawSamples = new char[samples.size()];
+			std::copy_n(samples.data(), samples.size(), rawSamples);
+			return AudioData(chunk.sampleRate, chunk.byteDepth, chunk.numberOfChannels, samples.size(), rawSamples);
+		}
+
+		std::copy_n(chunk.rawSamples.get(), chunk.size, std::back_inserter(samples));
+	}
 }
 } // namespace Audio
@@ -36,13 +36,37 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 namespace Audio {
 
+    /**
+     * Decodes a sound file a chunk at a time, used for long sounds such as music where
+     * decoding the whole file upfront would take a lot of time and memory.
+     * Only the compressed file is kept in memory.
+     */
+    class StreamingCodec {
+        public:
+            virtual ~StreamingCodec() {}
+
+            // Decodes at most maxBytes bytes of samples, returns an empty AudioData at the end of the file or on error.
+            virtual AudioData Decode(int maxBytes) = 0;
+
+            // Goes back to the start of the file, returns false on error.
+            virtual bool Rewind() = 0;
+    };
+
     AudioData LoadSoundCodec(std::string filename);
 
+    // Returns nullptr if the file doesn't exist or its format can't be streamed.
+    std::unique_ptr<StreamingCodec> OpenStreamingCodec(std::string filename);
+
     AudioData LoadWavCodec(std::string filename);
 
     AudioData LoadOggCodec(std::string filename);
+    std::unique_ptr<StreamingCodec> OpenOggStream(std::string filename);
 
     AudioData LoadOpusCodec(std::string filename);
+    std::unique_ptr<StreamingCodec> OpenOpusStream(std::string filename);
+
+    // Decodes all the remaining samples of a stream in a single AudioData
+    AudioData DecodeWholeStream(StreamingCodec& codec);
 
 } // namespace Audio
 #endif
@@ -32,6 +32,7 @@ Maryland 20850 USA.
 ===========================================================================
 */
 
+#include <common/FileSystem.h>
 #include "bot_local.h"
 #include "nav.h"
 
@@ -41,6 +42,8 @@ NavData_t BotNavData[ MAX_NAV_DATA ];
 LinearAllocator alloc( 1024 * 1024 * 16 );
 FastLZCompressor comp;
 
+static Cvar::Cvar<bool> bot_bakeNavMesh( "bot_bakeNavMesh", "load navmeshes from (and save them to) a baked cache which skips tile decompression", Cvar::NONE, true );
+
 void BotSaveOffMeshConnections( NavData_t *nav )
 {
 	char mapname[ MAX_QPATH ];
@@ -151,20 +154,10 @@ void BotLoadOffMeshConnections( const char *filename, NavData_t *nav )
 	FS_FCloseFile( f );
 }
 
-bool BotLoadNavMesh( const char *filename, NavData_t &nav )
+static bool BotLoadNavMeshFile( const char *filePath, NavData_t &nav )
 {
-	char mapname[ MAX_QPATH ];
-	char filePath[ MAX_QPATH ];
-	char gameName[ MAX_STRING_CHARS ];
 	fileHandle_t f = 0;
 
-	BotLoadOffMeshConnections( filename, &nav );
-
-	Cvar_VariableStringBuffer( "mapname", mapname, sizeof( mapname ) );
-	Cvar_VariableStringBuffer( "fs_game", gameName, sizeof( gameName ) );
-	Com_sprintf( filePath, sizeof( filePath ), "maps/%s-%s.navMesh", mapname, filename );
-	Log::Notice( " loading navigation mesh file '%s'...", filePath );
-
 	int len = FS_FOpenFileRead( filePath, &f, true );
 
 	if ( !f )
@@ -309,6 +302,293 @@ bool BotLoadNavMesh( const char *filename, NavData_t &nav )
 	return true;
 }
 
+static void BotFreeNavMesh( NavData_t &nav )
+{
+	if ( nav.cache )
+	{
+		dtFreeTileCache( nav.cache );
+		nav.cache = nullptr;
+	}
+
+	if ( nav.mesh )
+	{
+		dtFreeNavMesh( nav.mesh );
+		nav.mesh = nullptr;
+	}
+
+	// the tiles of a baked navmesh point into this, so it goes last
+	std::string().swap( nav.baked );
+}
+
+/*
+====================
+BotNavMeshSourceKey
+
+Identifies the navmesh file and off-mesh connections a baked navmesh was
+built from, returns 0 if the source can't be identified
+====================
+*/
+static unsigned int BotNavMeshSourceKey( const char *filePath, const NavData_t &nav )
+{
+	std::error_code err;
+	std::chrono::system_clock::time_point timestamp;
+	uint32_t pakChecksum = 0;
+	const FS::LoadedPakInfo *pak = FS::PakPath::LocateFile( filePath );
+
+	if ( pak )
+	{
+		timestamp = FS::PakPath::FileTimestamp( filePath, err );
+		pakChecksum = pak->realChecksum ? *pak->realChecksum : 0;
+	}
+	else
+	{
+		timestamp = FS::HomePath::FileTimestamp( filePath, err );
+	}
+
+	if ( err )
+	{
+		return 0;
+	}
+
+	const OffMeshConnections &con = nav.process.con;
+	int64_t time = timestamp.time_since_epoch().count();
+	std::string key;
+	key.append( filePath );
+	key.append( reinterpret_cast<const char *>( &time ), sizeof( time ) );
+	key.append( reinterpret_cast<const char *>( &pakChecksum ), sizeof( pakChecksum ) );
+	key.append( reinterpret_cast<const char *>( con.verts ), sizeof( float ) * 6 * con.offMeshConCount );
+	key.append( reinterpret_cast<const char *>( con.rad ), sizeof( float ) * con.offMeshConCount );
+	key.append( reinterpret_cast<const char *>( con.flags ), sizeof( unsigned short ) * con.offMeshConCount );
+	key.append( reinterpret_cast<const char *>( con.areas ), sizeof( unsigned char ) * con.offMeshConCount );
+	key.append( reinterpret_cast<const char *>( con.dirs ), sizeof( unsigned char ) * con.offMeshConCount );
+	key.append( reinterpret_cast<const char *>( con.userids ), sizeof( unsigned int ) * con.offMeshConCount );
+
+	unsigned int sum = Com_BlockChecksum( key.data(), key.size() );
+	return sum ? sum : 1;
+}
+
+static bool BotLoadBakedNavMesh( const char *filePath, unsigned int sourceKey, NavData_t &nav )
+{
+	std::error_code err;
+
+	if ( FS::PakPath::FileExists( filePath ) )
+	{
+		nav.baked = FS::PakPath::ReadFile( filePath, err );
+	}
+	else
+	{
+		FS::File f = FS::HomePath::OpenRead( filePath, err );
+
+		if ( !err )
+		{
+			nav.baked = f.ReadAll( err );
+		}
+	}
+
+	if ( err )
+	{
+		BotFreeNavMesh( nav );
+		return false;
+	}
+
+	NavMeshBakedHeader header;
+
+	if ( nav.baked.size() < sizeof( header ) )
+	{
+		Log::Warn( "Baked navigation mesh '%s' is truncated", filePath );
+		BotFreeNavMesh( nav );
+		return false;
+	}
+
+	memcpy( &header, nav.baked.data(), sizeof( header ) );
+
+	if ( header.magic != NAVMESHBAKED_MAGIC || header.version != NAVMESHBAKED_VERSION
+	     || header.endian != NAVMESHBAKED_ENDIAN || header.sourceKey != sourceKey )
+	{
+		Log::Verbose( "Baked navigation mesh '%s' is out of date", filePath );
+		BotFreeNavMesh( nav );
+		return false;
+	}
+
+	size_t size = nav.baked.size();
+	size_t tableSize = sizeof( NavMeshBakedTile ) * header.numTiles;
+
+	if ( header.numTiles < 0 || sizeof( header ) + tableSize > size )
+	{
+		Log::Warn( "Baked navigation mesh '%s' is truncated", filePath );
+		BotFreeNavMesh( nav );
+		return false;
+	}
+
+	unsigned char *base = reinterpret_cast<unsigned char *>( &nav.baked[ 0 ] );
+	const NavMeshBakedTile *tiles = reinterpret_cast<const NavMeshBakedTile *>( base + sizeof( header ) );
+
+	// check every range up front so detour never sees data outside the file
+	for ( int i = 0; i < header.numTiles; i++ )
+	{
+		const NavMeshBakedTile &tile = tiles[ i ];
+
+		if ( tile.compressedOffset < 0 || tile.compressedSize <= 0 || tile.meshOffset < 0 || tile.meshSize < 0
+		     || ( tile.compressedOffset & 3 ) || ( tile.meshOffset & 3 )
+		     || ( size_t ) tile.compressedOffset + tile.compressedSize > size
+		     || ( size_t ) tile.meshOffset + tile.meshSize > size )
+		{
+			Log::Warn( "Baked navigation mesh '%s' has a bad tile", filePath );
+			BotFreeNavMesh( nav );
+			return false;
+		}
+	}
+
+	nav.mesh = dtAllocNavMesh();
+	nav.cache = dtAllocTileCache();
+
+	if ( !nav.mesh || !nav.cache )
+	{
+		Log::Warn( "Unable to allocate nav mesh" );
+		BotFreeNavMesh( nav );
+		return false;
+	}
+
+	if ( dtStatusFailed( nav.mesh->init( &header.params ) )
+	     || dtStatusFailed( nav.cache->init( &header.cacheParams, &alloc, &comp, &nav.process ) ) )
+	{
+		Log::Warn( "Could not init navmesh" );
+		BotFreeNavMesh( nav );
+		return false;
+	}
+
+	// Tiles are used in place: neither detour nor the tile cache owns the
+	// memory, it stays alive in nav.baked until BotShutdownNav
+	for ( int i = 0; i < header.numTiles; i++ )
+	{
+		const NavMeshBakedTile &tile = tiles[ i ];
+		dtCompressedTileRef compressedRef = 0;
+		dtTileRef meshRef = 0;
+
+		if ( dtStatusFailed( nav.cache->addTile( base + tile.compressedOffset, tile.compressedSize, 0, &compressedRef ) ) )
+		{
+			Log::Warn( "Failed to add tile to navmesh" );
+			BotFreeNavMesh( nav );
+			return false;
+		}
+
+		// layers without any walkable polygons have no detour tile
+		if ( tile.meshSize && dtStatusFailed( nav.mesh->addTile( base + tile.meshOffset, tile.meshSize, 0, 0, &meshRef ) ) )
+		{
+			Log::Warn( "Failed to add tile to navmesh" );
+			BotFreeNavMesh( nav );
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void BotAppendBakedData( std::string &out, const void *data, int size )
+{
+	out.append( reinterpret_cast<const char *>( data ), size );
+	out.resize( ( out.size() + 15 ) & ~15 );
+}
+
+static void BotSaveBakedNavMesh( const char *filePath, unsigned int sourceKey, const NavData_t &nav )
+{
+	const dtTileCache *cache = nav.cache;
+	const dtNavMesh *mesh = nav.mesh;
+	std::vector<const dtCompressedTile *> compressed;
+
+	for ( int i = 0; i < cache->getTileCount(); i++ )
+	{
+		const dtCompressedTile *tile = cache->getTile( i );
+
+		if ( tile->header && tile->data )
+		{
+			compressed.push_back( tile );
+		}
+	}
+
+	NavMeshBakedHeader header;
+	header.magic = NAVMESHBAKED_MAGIC;
+	header.version = NAVMESHBAKED_VERSION;
+	header.endian = NAVMESHBAKED_ENDIAN;
+	header.sourceKey = sourceKey;
+	header.numTiles = compressed.size();
+	header.params = *mesh->getParams();
+	header.cacheParams = *cache->getParams();
+
+	std::vector<NavMeshBakedTile> tiles( compressed.size() );
+	std::string data;
+	BotAppendBakedData( data, &header, sizeof( header ) );
+	BotAppendBakedData( data, tiles.data(), sizeof( NavMeshBakedTile ) * tiles.size() );
+
+	for ( size_t i = 0; i < compressed.size(); i++ )
+	{
+		const dtTileCacheLayerHeader *layer = compressed[ i ]->header;
+		const dtMeshTile *meshTile = mesh->getTileAt( layer->tx, layer->ty, layer->tlayer );
+
+		tiles[ i ].compressedOffset = data.size();
+		tiles[ i ].compressedSize = compressed[ i ]->dataSize;
+		BotAppendBakedData( data, compressed[ i ]->data, compressed[ i ]->dataSize );
+
+		tiles[ i ].meshOffset = data.size();
+		tiles[ i ].meshSize = 0;
+
+		if ( meshTile && meshTile->header && meshTile->data )
+		{
+			tiles[ i ].meshSize = meshTile->dataSize;
+			BotAppendBakedData( data, meshTile->data, meshTile->dataSize );
+		}
+	}
+
+	memcpy( &data[ sizeof( header ) ], tiles.data(), sizeof( NavMeshBakedTile ) * tiles.size() );
+
+	fileHandle_t f = FS_FOpenFileWriteViaTemporary( filePath );
+
+	if ( !f )
+	{
+		return;
+	}
+
+	FS_Write( data.data(), data.size(), f );
+	FS_FCloseFile( f );
+}
+
+bool BotLoadNavMesh( const char *filename, NavData_t &nav )
+{
+	char mapname[ MAX_QPATH ];
+	char filePath[ MAX_QPATH ];
+	char bakedPath[ MAX_QPATH ];
+
+	BotLoadOffMeshConnections( filename, &nav );
+
+	Cvar_VariableStringBuffer( "mapname", mapname, sizeof( mapname ) );
+	Com_sprintf( filePath, sizeof( filePath ), "maps/%s-%s.navMesh", mapname, filename );
+	Com_sprintf( bakedPath, sizeof( bakedPath ), "maps/%s-%s.navMeshBaked", mapname, filename );
+
+	int startTime = Sys_Milliseconds();
+	unsigned int sourceKey = bot_bakeNavMesh.Get() ? BotNavMeshSourceKey( filePath, nav ) : 0;
+
+	if ( sourceKey && BotLoadBakedNavMesh( bakedPath, sourceKey, nav ) )
+	{
+		Log::Notice( " loaded baked navigation mesh file '%s' in %d ms", bakedPath, Sys_Milliseconds() - startTime );
+		return true;
+	}
+
+	Log::Notice( " loading navigation mesh file '%s'...", filePath );
+
+	if ( !BotLoadNavMeshFile( filePath, nav ) )
+	{
+		return false;
+	}
+
+	if ( sourceKey )
+	{
+		BotSaveBakedNavMesh( bakedPath, sourceKey, nav );
+	}
+
+	Log::Verbose( "loaded navigation mesh file '%s' in %d ms", filePath, Sys_Milliseconds() - startTime );
+	return true;
+}
+
 inline void *dtAllocCustom( size_t size, dtAllocHint )
 {
 	return Z_TagMalloc( size, memtag_t::TAG_BOTLIB );
@@ -343,6 +623,8 @@ void BotShutdownNav()
 			nav->query = 0;
 		}
 
+		std::string().swap( nav->baked );
+
 		nav->process.con.reset();
 		memset( nav->name, 0, sizeof( nav->name ) );
 	}
@@ -424,3 +706,70 @@ bool BotSetupNav( const botClass_t *botClass, qhandle_t *navHandle )
 	numNavData++;
 	return true;
 }
+
+class NavMeshBenchCmd: public Cmd::StaticCmd
+{
+public:
+	NavMeshBenchCmd():
+		StaticCmd( "navMeshBench", Cmd::SYSTEM, "times loading the current map's navigation meshes from source and baked files" )
+	{}
+
+	void Run( const Cmd::Args &args ) const OVERRIDE
+	{
+		int iterations = 1;
+
+		if ( args.Argc() > 2 || ( args.Argc() == 2 && ( !Str::ParseInt( iterations, args.Argv( 1 ) ) || iterations < 1 ) ) )
+		{
+			PrintUsage( args, "[iterations]", "" );
+			return;
+		}
+
+		if ( !numNavData )
+		{
+			Print( "No navigation meshes are loaded" );
+			return;
+		}
+
+		char mapname[ MAX_QPATH ];
+		Cvar_VariableStringBuffer( "mapname", mapname, sizeof( mapname ) );
+
+		// the scratch copy is too large for the stack because of the off-mesh connections
+		std::unique_ptr<NavData_t> test( new NavData_t() );
+
+		for ( int i = 0; i < numNavData; i++ )
+		{
+			char filePath[ MAX_QPATH ];
+			char bakedPath[ MAX_QPATH ];
+			Com_sprintf( filePath, sizeof( filePath ), "maps/%s-%s.navMesh", mapname, BotNavData[ i ].name );
+			Com_sprintf( bakedPath, sizeof( bakedPath ), "maps/%s-%s.navMeshBaked", mapname, BotNavData[ i ].name );
+
+			test->process.con = BotNavData[ i ].process.con;
+			unsigned int sourceKey = BotNavMeshSourceKey( filePath, *test );
+
+			std::chrono::nanoseconds sourceTime( 0 ), bakedTime( 0 );
+			bool sourceOk = true, bakedOk = sourceKey != 0;
+
+			for ( int j = 0; j < iterations && sourceOk; j++ )
+			{
+				auto start = Sys::SteadyClock::now();
+				sourceOk = BotLoadNavMeshFile( filePath, *test );
+				sourceTime += Sys::SteadyClock::now() - start;
+				BotFreeNavMesh( *test );
+			}
+
+			for ( int j = 0; j < iterations && bakedOk; j++ )
+			{
+				auto start = Sys::SteadyClock::now();
+				bakedOk = BotLoadBakedNavMesh( bakedPath, sourceKey, *test );
+				bakedTime += Sys::SteadyClock::now() - start;
+				BotFreeNavMesh( *test );
+			}
+
+			auto toMs = []( std::chrono::nanoseconds time, int n ) { return time.count() / 1e6 / n; };
+			Print( "%s-%s: source %s, baked %s", mapname, BotNavData[ i ].name,
+			       sourceOk ? Str::Format( "%.2f ms", toMs( sourceTime, iterations ) ) : "failed",
+			       bakedOk ? Str::Format( "%.2f ms", toMs( bakedTime, iterations ) ) : "unavailable" );
+		}
+	}
+};
+static NavMeshBenchCmd NavMeshBenchCmdRegistration;
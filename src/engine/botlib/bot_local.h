@@ -74,6 +74,7 @@ struct NavData_t
 	dtNavMeshQuery   *query;
 	dtQueryFilter    filter;
 	MeshProcess      process;
+	std::string      baked; // backing storage for tiles loaded from a baked navmesh
 	char             name[ 64 ];
 };
 
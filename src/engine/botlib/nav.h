@@ -49,6 +49,33 @@ struct NavMeshTileHeader
 	int dataSize;
 };
 
+// Baked navmesh: the compressed tile cache layers together with the already
+// built detour tiles, stored in native byte order so that the whole file can be
+// read in one go and the tiles used in place without being decompressed again.
+static const int NAVMESHBAKED_MAGIC = 'N'<<24 | 'B'<<16 | 'A'<<8 | 'K'; //'NBAK';
+static const int NAVMESHBAKED_VERSION = 1;
+static const int NAVMESHBAKED_ENDIAN = 0x01020304;
+
+struct NavMeshBakedHeader
+{
+	int magic;
+	int version;
+	int endian;
+	unsigned int sourceKey;
+	int numTiles;
+	dtNavMeshParams params;
+	dtTileCacheParams cacheParams;
+};
+
+// offsets are relative to the start of the file and 16 byte aligned
+struct NavMeshBakedTile
+{
+	int compressedOffset;
+	int compressedSize;
+	int meshOffset;
+	int meshSize;
+};
+
 template<class T> static inline void SwapArray( T block[], size_t len )
 {
 	if ( LittleLong( 1 ) != 1 )
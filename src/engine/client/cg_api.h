@@ -241,6 +241,7 @@ int             trap_R_LightForPoint( vec3_t point, vec3_t ambientLight, vec3_t
 qhandle_t       trap_R_RegisterAnimation( const char *name );
 int             trap_R_BuildSkeleton( refSkeleton_t *skel, qhandle_t anim, int startFrame, int endFrame, float frac, bool clearOrigin );
 int             trap_R_BlendSkeleton( refSkeleton_t *skel, const refSkeleton_t *blend, float frac );
+void            trap_R_BuildSkeletons( const refSkeletonJob_t *jobs, int numJobs, refSkeleton_t *skels, int *results );
 int             trap_R_BoneIndex( qhandle_t hModel, const char *boneName );
 int             trap_R_AnimNumFrames( qhandle_t hAnim );
 int             trap_R_AnimFrameRate( qhandle_t hAnim );
@@ -88,6 +88,25 @@ namespace Util {
 		}
 	};
 
+	// And for batches of skeletons
+	template<> struct SerializeTraits<std::vector<refSkeleton_t>> {
+		static void Write(Writer& stream, const std::vector<refSkeleton_t>& skels)
+		{
+			stream.WriteSize(skels.size());
+			for (const refSkeleton_t& skel : skels) {
+				stream.Write<refSkeleton_t>(skel);
+			}
+		}
+		static std::vector<refSkeleton_t> Read(Reader& stream)
+		{
+			std::vector<refSkeleton_t> skels(stream.ReadSize<refSkeleton_t>());
+			for (refSkeleton_t& skel : skels) {
+				skel = stream.Read<refSkeleton_t>();
+			}
+			return skels;
+		}
+	};
+
 	// Use that bone optimization for refEntity_t
 	template<> struct SerializeTraits<refEntity_t> {
 		static void Write(Writer& stream, const refEntity_t& ent)
@@ -198,6 +217,7 @@ enum cgameImport_t
   CG_SETCOLORGRADING,
   CG_R_GETTEXTURESIZE,
   CG_R_GENERATETEXTURE,
+  CG_R_BUILDSKELETONS,
 
   // Keys
   CG_KEY_GETCATCHER,
@@ -421,6 +441,10 @@ namespace Render {
 		IPC::Message<IPC::Id<VM::QVM, CG_R_BUILDSKELETON>, int, int, int, float, bool>,
 		IPC::Reply<refSkeleton_t, int>
 	>;
+	using BuildSkeletonsMsg = IPC::SyncMessage<
+		IPC::Message<IPC::Id<VM::QVM, CG_R_BUILDSKELETONS>, std::vector<refSkeletonJob_t>>,
+		IPC::Reply<std::vector<refSkeleton_t>, std::vector<int>>
+	>;
 	using BoneIndexMsg = IPC::SyncMessage<
 		IPC::Message<IPC::Id<VM::QVM, CG_R_BONEINDEX>, int, std::string>,
 		IPC::Reply<int>
@@ -21,6 +21,11 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 */
 
 #include "client.h"
+#include "framework/Profiler.h"
+
+#include <condition_variable>
+#include <deque>
+#include <thread>
 
 #define INDEX_FILE_EXTENSION ".index.dat"
 
@@ -40,13 +45,11 @@ struct audioFormat_t
 struct aviFileData_t
 {
 	bool      fileOpen;
-	fileHandle_t  f;
 	char          fileName[ MAX_QPATH ];
 	int           fileSize;
 	int           moviOffset;
 	int           moviSize;
 
-	fileHandle_t  idxF;
 	int           numIndices;
 
 	int           frameRate;
@@ -62,27 +65,40 @@ struct aviFileData_t
 
 	int           chunkStack[ MAX_RIFF_CHUNKS ];
 	int           chunkStackTop;
-
-	byte          *cBuffer, *eBuffer;
 };
 
 static aviFileData_t afd;
 
+// only the encoder thread touches the files while recording
+static FS::File aviFile;
+static FS::File aviIndexFile;
+static std::atomic<bool> aviWriteFailed;
+
 static const int MAX_AVI_BUFFER = 2048;
 
+// stdio buffer of the avi file, so frames go to the disk in large writes
+static const int AVI_WRITE_BUFFER = 1 << 20;
+
 static byte buffer[ MAX_AVI_BUFFER ];
 static int  bufIndex;
 
 /*
 ===============
 SafeFS_Write
+
+Errors can happen on the encoder thread, they stop the recording on the
+next frame
 ===============
 */
-static INLINE void SafeFS_Write( const void *buffer, int len, fileHandle_t f )
+static INLINE void SafeFS_Write( const void *buffer, int len, const FS::File &f )
 {
-	if ( FS_Write( buffer, len, f ) < len )
+	std::error_code err;
+
+	f.Write( buffer, len, err );
+
+	if ( err )
 	{
-		Com_Error( errorParm_t::ERR_DROP, "Failed to write avi file" );
+		aviWriteFailed = true;
 	}
 }
 
@@ -317,120 +333,173 @@ void CL_WriteAVIHeader()
 	}
 }
 
+/*
+============================================================================
+
+CAPTURE RING
+
+CL_TakeVideoFrame hands a free frame of the ring to the renderer, which
+reads the screen back into it and queues it with CL_QueueAVIVideoFrame.
+The encoder thread converts the queued frames to the AVI format and
+writes them in capture order, so neither the compression nor the file
+writes hold up the main thread.
+
+============================================================================
+*/
+
+static Cvar::Range<Cvar::Cvar<int>> cl_aviBuffers( "cl_aviBuffers", "frames of video capture that can wait for the encoder", Cvar::NONE, 4, 2, 16 );
+static Cvar::Cvar<bool> cl_aviDropFrames( "cl_aviDropFrames", "drop frames instead of waiting when the video encoder falls behind", Cvar::NONE, false );
+
+enum class aviFrameState_t
+{
+	FREE,
+	CAPTURING, // handed to the renderer
+	QUEUED
+};
+
+struct aviFrame_t
+{
+	aviFrameState_t state;
+	byte            *captureBuffer;
+	byte            *encodeBuffer;
+	const byte      *pixels; // where the renderer put them in captureBuffer
+	int             lineLen;
+};
+
+static std::mutex              aviMutex;
+static std::condition_variable aviQueued; // a frame was queued, or the encoder has to stop
+static std::condition_variable aviFreed;
+static std::vector<aviFrame_t> aviFrames;
+static std::deque<int>         aviQueue;
+static std::thread             aviEncoder;
+static bool                    aviStop;
+static int                     aviDroppedFrames;
+static int                     aviMaxQueuedFrames;
+
 /*
 ===============
-CL_OpenAVIForWriting
+CL_OpenAVIFile
 
 Creates an AVI file and gets it into a state where
 writing the actual data can begin
 ===============
 */
-bool CL_OpenAVIForWriting( const char *fileName )
+static bool CL_OpenAVIFile( const char *fileName )
 {
-	if ( afd.fileOpen )
-	{
-		return false;
-	}
+	std::error_code err;
 
-	Com_Memset( &afd, 0, sizeof( aviFileData_t ) );
+	aviFile = FS::HomePath::OpenWrite( fileName, err );
 
-	// Don't start if a framerate has not been chosen
-	if ( cl_aviFrameRate->integer <= 0 )
+	if ( err )
 	{
-		Log::Warn("cl_aviFrameRate must be ≥ 1" );
 		return false;
 	}
 
-	if ( ( afd.f = FS_FOpenFileWrite( fileName ) ) <= 0 )
-	{
-		return false;
-	}
+	aviIndexFile = FS::HomePath::OpenWrite( std::string( fileName ) + INDEX_FILE_EXTENSION, err );
 
-	if ( ( afd.idxF = FS_FOpenFileWrite( va( "%s" INDEX_FILE_EXTENSION, fileName ) ) ) <= 0 )
+	if ( err )
 	{
-		FS_FCloseFile( afd.f );
+		aviFile.Close( err );
 		return false;
 	}
 
+	setvbuf( aviFile.GetHandle(), nullptr, _IOFBF, AVI_WRITE_BUFFER );
+
 	Q_strncpyz( afd.fileName, fileName, MAX_QPATH );
 
-	afd.frameRate = cl_aviFrameRate->integer;
-	afd.framePeriod = ( int )( 1000000.0f / afd.frameRate );
-	afd.width = cls.glconfig.vidWidth;
-	afd.height = cls.glconfig.vidHeight;
+	afd.numIndices = 0;
+	afd.numVideoFrames = 0;
+	afd.numAudioFrames = 0;
+	afd.maxRecordSize = 0;
 
-	if ( cl_aviMotionJpeg->integer )
-	{
-		afd.motionJpeg = true;
-	}
-	else
-	{
-		afd.motionJpeg = false;
-	}
+	// This doesn't write a real header, but allocates the
+	// correct amount of space at the beginning of the file
+	CL_WriteAVIHeader();
 
-	// Buffers only need to store RGB pixels.
-	// Allocate a bit more space for the capture buffer to account for possible
-	// padding at the end of pixel lines, and padding for alignment
-	const int MAX_PACK_LEN = 16;
-	afd.cBuffer = (byte*) Z_Malloc( ( afd.width * 3 + MAX_PACK_LEN - 1 ) * afd.height + MAX_PACK_LEN - 1 );
-	// raw avi files have pixel lines start on 4-byte boundaries
-	afd.eBuffer = (byte*) Z_Malloc( PAD( afd.width * 3, AVI_LINE_PADDING ) * afd.height );
+	SafeFS_Write( buffer, bufIndex, aviFile );
+	afd.fileSize = bufIndex;
 
-	/*
- 	 * TODO
-	afd.a.rate = dma.speed;
-	afd.a.format = WAV_FORMAT_PCM;
-	afd.a.channels = dma.channels;
-	afd.a.bits = dma.samplebits;
-	afd.a.sampleSize = ( afd.a.bits / 8 ) * afd.a.channels;
-	*/
+	bufIndex = 0;
+	START_CHUNK( "idx1" );
+	SafeFS_Write( buffer, bufIndex, aviIndexFile );
 
-	if ( afd.a.rate % afd.frameRate )
-	{
-		int suggestRate = afd.frameRate;
+	afd.moviSize = 4; // For the "movi"
 
-		while ( ( afd.a.rate % suggestRate ) && suggestRate >= 1 )
-		{
-			suggestRate--;
-		}
+	return true;
+}
 
-		Log::Warn( "cl_aviFrameRate is not a divisor of the audio rate, suggest %d", suggestRate );
-	}
+/*
+===============
+CL_CloseAVIFile
 
-	if ( !Cvar_VariableIntegerValue( "s_initsound" ) )
+Closes the AVI file and writes an index chunk
+===============
+*/
+static bool CL_CloseAVIFile()
+{
+	std::error_code err;
+	int             indexRemainder;
+	int             indexSize = afd.numIndices * 16;
+	std::string     idxFileName = std::string( afd.fileName ) + INDEX_FILE_EXTENSION;
+
+	if ( !aviFile )
 	{
-		afd.audio = false;
+		return false;
 	}
-	else if ( Q_stricmp( Cvar_VariableString( "s_backend" ), "OpenAL" ) )
+
+	aviIndexFile.SeekSet( 4, err );
+	bufIndex = 0;
+	WRITE_4BYTES( indexSize );
+	SafeFS_Write( buffer, bufIndex, aviIndexFile );
+	aviIndexFile.Close( err );
+
+	// Write index
+
+	// Open the temp index file
+	FS::File index = FS::HomePath::OpenRead( idxFileName, err );
+
+	if ( err )
 	{
-		if ( afd.a.bits == 16 && afd.a.channels == 2 )
-		{
-			afd.audio = true;
-		}
-		else
-		{
-			afd.audio = false; //FIXME: audio not implemented for this case
-		}
+		aviFile.Close( err );
+		return false;
 	}
-	else
+
+	indexRemainder = index.Length( err );
+
+	// Append index to end of avi file
+	while ( indexRemainder > MAX_AVI_BUFFER )
 	{
-		afd.audio = false;
-		Log::Warn( "Audio capture is not supported with OpenAL. Set s_useOpenAL to 0 for audio capture" );
+		index.Read( buffer, MAX_AVI_BUFFER, err );
+		SafeFS_Write( buffer, MAX_AVI_BUFFER, aviFile );
+		afd.fileSize += MAX_AVI_BUFFER;
+		indexRemainder -= MAX_AVI_BUFFER;
 	}
 
-	// This doesn't write a real header, but allocates the
-	// correct amount of space at the beginning of the file
+	index.Read( buffer, indexRemainder, err );
+	SafeFS_Write( buffer, indexRemainder, aviFile );
+	afd.fileSize += indexRemainder;
+	index.Close( err );
+
+	// Remove temp index file
+	FS::HomePath::DeleteFile( idxFileName, err );
+
+	// Write the real header
+	aviFile.SeekSet( 0, err );
 	CL_WriteAVIHeader();
 
-	SafeFS_Write( buffer, bufIndex, afd.f );
-	afd.fileSize = bufIndex;
+	bufIndex = 4;
+	WRITE_4BYTES( afd.fileSize - 8 );  // "RIFF" size
 
-	bufIndex = 0;
-	START_CHUNK( "idx1" );
-	SafeFS_Write( buffer, bufIndex, afd.idxF );
+	bufIndex = afd.moviOffset + 4; // Skip "LIST"
+	WRITE_4BYTES( afd.moviSize );
 
-	afd.moviSize = 4; // For the "movi"
-	afd.fileOpen = true;
+	SafeFS_Write( buffer, bufIndex, aviFile );
+	aviFile.Close( err );
+
+	if ( err )
+	{
+		aviWriteFailed = true;
+	}
 
 	return true;
 }
@@ -453,11 +522,16 @@ static bool CL_CheckFileSize( int bytesToAdd )
 	// we target can handle a 2Gb file
 	if ( newFileSize > INT_MAX )
 	{
+		std::string fileName = std::string( afd.fileName ) + "_";
+
 		// Close the current file...
-		CL_CloseAVI();
+		CL_CloseAVIFile();
 
 		// ...And open a new one
-		CL_OpenAVIForWriting( va( "%s_", afd.fileName ) );
+		if ( !CL_OpenAVIFile( fileName.c_str() ) )
+		{
+			aviWriteFailed = true;
+		}
 
 		return true;
 	}
@@ -470,14 +544,14 @@ static bool CL_CheckFileSize( int bytesToAdd )
 CL_WriteAVIVideoFrame
 ===============
 */
-void CL_WriteAVIVideoFrame( const byte *imageBuffer, int size )
+static void CL_WriteAVIVideoFrame( const byte *imageBuffer, int size )
 {
 	int  chunkOffset = afd.fileSize - afd.moviOffset - 8;
 	int  chunkSize = 8 + size;
 	int  paddingSize = PAD( size, 2 ) - size;
 	byte padding[ 4 ] = { 0 };
 
-	if ( !afd.fileOpen )
+	if ( !aviFile )
 	{
 		return;
 	}
@@ -492,9 +566,9 @@ void CL_WriteAVIVideoFrame( const byte *imageBuffer, int size )
 	WRITE_STRING( "00dc" );
 	WRITE_4BYTES( size );
 
-	SafeFS_Write( buffer, 8, afd.f );
-	SafeFS_Write( imageBuffer, size, afd.f );
-	SafeFS_Write( padding, paddingSize, afd.f );
+	SafeFS_Write( buffer, 8, aviFile );
+	SafeFS_Write( imageBuffer, size, aviFile );
+	SafeFS_Write( padding, paddingSize, aviFile );
 	afd.fileSize += ( chunkSize + paddingSize );
 
 	afd.numVideoFrames++;
@@ -511,11 +585,221 @@ void CL_WriteAVIVideoFrame( const byte *imageBuffer, int size )
 	WRITE_4BYTES( 0x00000010 );  //dwFlags (all frames are KeyFrames)
 	WRITE_4BYTES( chunkOffset );  //dwOffset
 	WRITE_4BYTES( size );  //dwLength
-	SafeFS_Write( buffer, 16, afd.idxF );
+	SafeFS_Write( buffer, 16, aviIndexFile );
 
 	afd.numIndices++;
 }
 
+/*
+===============
+CL_EncodeAVIVideoFrame
+===============
+*/
+static void CL_EncodeAVIVideoFrame( aviFrame_t &frame )
+{
+	PROFILE_ZONE( "CL_EncodeAVIVideoFrame" );
+
+	int lineLen = afd.width * 3;
+
+	if ( afd.motionJpeg )
+	{
+		// Drop alignment and line padding bytes
+		for ( int i = 0; i < afd.height; ++i )
+		{
+			memmove( frame.captureBuffer + i * lineLen, frame.pixels + i * frame.lineLen, lineLen );
+		}
+
+		int size = re.SaveJPGToBuffer( frame.encodeBuffer, lineLen * afd.height, 90, afd.width, afd.height, frame.captureBuffer );
+
+		if ( size <= 0 )
+		{
+			// stops the recording on the next frame
+			aviWriteFailed = true;
+			return;
+		}
+
+		CL_WriteAVIVideoFrame( frame.encodeBuffer, size );
+	}
+	else
+	{
+		int aviLineLen = PAD( lineLen, AVI_LINE_PADDING );
+
+		for ( int i = 0; i < afd.height; ++i )
+		{
+			const byte *in = frame.pixels + i * frame.lineLen;
+			byte       *out = frame.encodeBuffer + i * aviLineLen;
+			int        j;
+
+			for ( j = 0; j < lineLen; j += 3 )
+			{
+				out[ j + 0 ] = in[ j + 2 ];
+				out[ j + 1 ] = in[ j + 1 ];
+				out[ j + 2 ] = in[ j + 0 ];
+			}
+
+			while ( j < aviLineLen )
+			{
+				out[ j++ ] = 0;
+			}
+		}
+
+		CL_WriteAVIVideoFrame( frame.encodeBuffer, aviLineLen * afd.height );
+	}
+}
+
+/*
+===============
+CL_AVIEncoder
+===============
+*/
+static void CL_AVIEncoder()
+{
+	PROFILE_THREAD( "video encoder" );
+
+	std::unique_lock<std::mutex> lock( aviMutex );
+
+	while ( true )
+	{
+		aviQueued.wait( lock, [] { return aviStop || !aviQueue.empty(); } );
+
+		// everything queued is written before stopping
+		if ( aviQueue.empty() )
+		{
+			return;
+		}
+
+		aviFrame_t &frame = aviFrames[ aviQueue.front() ];
+		aviQueue.pop_front();
+		lock.unlock();
+
+		// an error must not escape the thread, the main thread
+		// stops the recording when it sees aviWriteFailed
+		try
+		{
+			CL_EncodeAVIVideoFrame( frame );
+		}
+		catch ( Sys::DropErr &err )
+		{
+			Log::Warn( "Failed to encode video frame: %s", err.what() );
+			aviWriteFailed = true;
+		}
+
+		lock.lock();
+		frame.state = aviFrameState_t::FREE;
+		aviFreed.notify_all();
+	}
+}
+
+/*
+===============
+CL_OpenAVIForWriting
+===============
+*/
+bool CL_OpenAVIForWriting( const char *fileName )
+{
+	if ( afd.fileOpen )
+	{
+		return false;
+	}
+
+	Com_Memset( &afd, 0, sizeof( aviFileData_t ) );
+
+	// Don't start if a framerate has not been chosen
+	if ( cl_aviFrameRate->integer <= 0 )
+	{
+		Log::Warn("cl_aviFrameRate must be ≥ 1" );
+		return false;
+	}
+
+	afd.frameRate = cl_aviFrameRate->integer;
+	afd.framePeriod = ( int )( 1000000.0f / afd.frameRate );
+	afd.width = cls.glconfig.vidWidth;
+	afd.height = cls.glconfig.vidHeight;
+
+	if ( cl_aviMotionJpeg->integer )
+	{
+		afd.motionJpeg = true;
+	}
+	else
+	{
+		afd.motionJpeg = false;
+	}
+
+	/*
+ 	 * TODO
+	afd.a.rate = dma.speed;
+	afd.a.format = WAV_FORMAT_PCM;
+	afd.a.channels = dma.channels;
+	afd.a.bits = dma.samplebits;
+	afd.a.sampleSize = ( afd.a.bits / 8 ) * afd.a.channels;
+	*/
+
+	if ( afd.a.rate % afd.frameRate )
+	{
+		int suggestRate = afd.frameRate;
+
+		while ( ( afd.a.rate % suggestRate ) && suggestRate >= 1 )
+		{
+			suggestRate--;
+		}
+
+		Log::Warn( "cl_aviFrameRate is not a divisor of the audio rate, suggest %d", suggestRate );
+	}
+
+	if ( !Cvar_VariableIntegerValue( "s_initsound" ) )
+	{
+		afd.audio = false;
+	}
+	else if ( Q_stricmp( Cvar_VariableString( "s_backend" ), "OpenAL" ) )
+	{
+		if ( afd.a.bits == 16 && afd.a.channels == 2 )
+		{
+			afd.audio = true;
+		}
+		else
+		{
+			afd.audio = false; //FIXME: audio not implemented for this case
+		}
+	}
+	else
+	{
+		afd.audio = false;
+		Log::Warn( "Audio capture is not supported with OpenAL. Set s_useOpenAL to 0 for audio capture" );
+	}
+
+	aviWriteFailed = false;
+
+	if ( !CL_OpenAVIFile( fileName ) )
+	{
+		return false;
+	}
+
+	// Buffers only need to store RGB pixels.
+	// Allocate a bit more space for the capture buffer to account for possible
+	// padding at the end of pixel lines, and padding for alignment
+	const int MAX_PACK_LEN = 16;
+
+	aviFrames.resize( cl_aviBuffers.Get() );
+
+	for ( aviFrame_t &frame : aviFrames )
+	{
+		frame.state = aviFrameState_t::FREE;
+		frame.captureBuffer = (byte*) Z_Malloc( ( afd.width * 3 + MAX_PACK_LEN - 1 ) * afd.height + MAX_PACK_LEN - 1 );
+		// raw avi files have pixel lines start on 4-byte boundaries
+		frame.encodeBuffer = (byte*) Z_Malloc( PAD( afd.width * 3, AVI_LINE_PADDING ) * afd.height );
+	}
+
+	aviQueue.clear();
+	aviStop = false;
+	aviDroppedFrames = 0;
+	aviMaxQueuedFrames = 0;
+
+	afd.fileOpen = true;
+	aviEncoder = std::thread( CL_AVIEncoder );
+
+	return true;
+}
+
 /*
 ===============
 CL_TakeVideoFrame
@@ -529,83 +813,121 @@ void CL_TakeVideoFrame()
 		return;
 	}
 
-	re.TakeVideoFrame( afd.width, afd.height, afd.cBuffer, afd.eBuffer, afd.motionJpeg );
+	if ( aviWriteFailed )
+	{
+		CL_CloseAVI();
+		Com_Error( errorParm_t::ERR_DROP, "Failed to write avi file" );
+	}
+
+	std::unique_lock<std::mutex> lock( aviMutex );
+	int index;
+
+	while ( true )
+	{
+		for ( index = 0; index < (int) aviFrames.size(); index++ )
+		{
+			if ( aviFrames[ index ].state == aviFrameState_t::FREE )
+			{
+				break;
+			}
+		}
+
+		// wait for the encoder rather than leave a gap in the video, unless
+		// the frames are all still with the renderer
+		if ( index < (int) aviFrames.size() || cl_aviDropFrames.Get() || aviQueue.empty() )
+		{
+			break;
+		}
+
+		aviFreed.wait( lock );
+	}
+
+	if ( index == (int) aviFrames.size() )
+	{
+		aviDroppedFrames++;
+		Log::Debug( "dropped a video frame, %d queued for the encoder", (int) aviQueue.size() );
+		return;
+	}
+
+	aviFrames[ index ].state = aviFrameState_t::CAPTURING;
+	lock.unlock();
+
+	if ( !re.TakeVideoFrame( afd.width, afd.height, aviFrames[ index ].captureBuffer, index ) )
+	{
+		lock.lock();
+		aviFrames[ index ].state = aviFrameState_t::FREE;
+	}
 }
 
 /*
 ===============
-CL_CloseAVI
+CL_QueueAVIVideoFrame
 
-Closes the AVI file and writes an index chunk
+Called by the renderer once a frame is read back
 ===============
 */
-bool CL_CloseAVI()
+void CL_QueueAVIVideoFrame( int frame, const byte *pixels, int lineLen )
 {
-	int        indexRemainder;
-	int        indexSize = afd.numIndices * 16;
-	const char *idxFileName = va( "%s" INDEX_FILE_EXTENSION, afd.fileName );
+	std::lock_guard<std::mutex> lock( aviMutex );
 
-	// AVI file isn't open
-	if ( !afd.fileOpen )
+	if ( !afd.fileOpen || frame < 0 || frame >= (int) aviFrames.size() || aviFrames[ frame ].state != aviFrameState_t::CAPTURING )
 	{
-		return false;
+		return;
 	}
 
-	afd.fileOpen = false;
+	aviFrames[ frame ].pixels = pixels;
+	aviFrames[ frame ].lineLen = lineLen;
+	aviFrames[ frame ].state = aviFrameState_t::QUEUED;
+	aviQueue.push_back( frame );
 
-	FS_Seek( afd.idxF, 4, fsOrigin_t::FS_SEEK_SET );
-	bufIndex = 0;
-	WRITE_4BYTES( indexSize );
-	SafeFS_Write( buffer, bufIndex, afd.idxF );
-	FS_FCloseFile( afd.idxF );
+	aviMaxQueuedFrames = std::max( aviMaxQueuedFrames, (int) aviQueue.size() );
+	aviQueued.notify_one();
+}
 
-	// Write index
+/*
+===============
+CL_CloseAVI
 
-	// Open the temp index file
-	if ( ( indexSize = FS_FOpenFileRead( idxFileName, &afd.idxF, true ) ) <= 0 )
+Writes the frames still queued and closes the AVI file
+===============
+*/
+bool CL_CloseAVI()
+{
+	// AVI file isn't open
+	if ( !afd.fileOpen )
 	{
-		FS_FCloseFile( afd.f );
 		return false;
 	}
 
-	indexRemainder = indexSize;
-
-	// Append index to end of avi file
-	while ( indexRemainder > MAX_AVI_BUFFER )
 	{
-		FS_Read( buffer, MAX_AVI_BUFFER, afd.idxF );
-		SafeFS_Write( buffer, MAX_AVI_BUFFER, afd.f );
-		afd.fileSize += MAX_AVI_BUFFER;
-		indexRemainder -= MAX_AVI_BUFFER;
+		std::lock_guard<std::mutex> lock( aviMutex );
+		afd.fileOpen = false;
+		aviStop = true;
+		aviQueued.notify_one();
 	}
 
-	FS_Read( buffer, indexRemainder, afd.idxF );
-	SafeFS_Write( buffer, indexRemainder, afd.f );
-	afd.fileSize += indexRemainder;
-	FS_FCloseFile( afd.idxF );
-
-	// Remove temp index file
-	FS_Delete( idxFileName );
-
-	// Write the real header
-	FS_Seek( afd.f, 0, fsOrigin_t::FS_SEEK_SET );
-	CL_WriteAVIHeader();
+	aviEncoder.join();
 
-	bufIndex = 4;
-	WRITE_4BYTES( afd.fileSize - 8 );  // "RIFF" size
+	bool closed = CL_CloseAVIFile();
 
-	bufIndex = afd.moviOffset + 4; // Skip "LIST"
-	WRITE_4BYTES( afd.moviSize );
+	for ( aviFrame_t &frame : aviFrames )
+	{
+		Z_Free( frame.captureBuffer );
+		Z_Free( frame.encodeBuffer );
+	}
 
-	SafeFS_Write( buffer, bufIndex, afd.f );
+	aviFrames.clear();
+	aviQueue.clear();
 
-	Z_Free( afd.cBuffer );
-	Z_Free( afd.eBuffer );
-	FS_FCloseFile( afd.f );
+	if ( aviWriteFailed )
+	{
+		Log::Warn( "Failed to write avi file %s", afd.fileName );
+	}
 
-	Log::Notice( "Wrote %d:%d frames to %s\n", afd.numVideoFrames, afd.numAudioFrames, afd.fileName );
+	Log::Notice( "Wrote %d:%d frames to %s, dropped %d, at most %d waited for the encoder\n",
+	             afd.numVideoFrames, afd.numAudioFrames, afd.fileName, aviDroppedFrames, aviMaxQueuedFrames );
 
-	return true;
+	return closed;
 }
 
 /*
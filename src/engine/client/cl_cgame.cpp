@@ -43,6 +43,7 @@ Maryland 20850 USA.
 #include "framework/CommonVMServices.h"
 #include "framework/CommandSystem.h"
 #include "framework/CvarSystem.h"
+#include "framework/Profiler.h"
 
 #define __(x) Trans_GettextGame(x)
 #define C__(x, y) Trans_PgettextGame(x, y)
@@ -705,6 +706,12 @@ void CL_InitCGame()
 
 	cls.state = connstate_t::CA_LOADING;
 
+	// a local server has the collision model of this map loaded already
+	if ( com_sv_running->integer && CM_SharedModel() )
+	{
+		cgvm.SendMsg<VM::ShareCollisionModelMsg>( CM_SharedModel() );
+	}
+
 	// init for this gamestate
 	cgvm.CGameInit(clc.serverMessageSequence, clc.clientNum);
 
@@ -1185,6 +1192,7 @@ void CGameVM::CGameConsoleLine(const std::string& str)
 
 void CGameVM::Syscall(uint32_t id, Util::Reader reader, IPC::Channel& channel)
 {
+	PROFILE_ZONE("CGameVM::Syscall");
 	int major = id >> 16;
 	int minor = id & 0xffff;
 	if (major == VM::QVM) {
@@ -1435,6 +1443,17 @@ void CGameVM::QVMSyscall(int index, Util::Reader& reader, IPC::Channel& channel)
 			});
 			break;
 
+		case CG_R_BUILDSKELETONS:
+			IPC::HandleMsg<Render::BuildSkeletonsMsg>(channel, std::move(reader), [this] (std::vector<refSkeletonJob_t> jobs, std::vector<refSkeleton_t>& skels, std::vector<int>& res) {
+				if (jobs.size() > MAX_REF_ENTITIES) {
+					Sys::Drop("trap_R_BuildSkeletons: too many skeletons (%d)", jobs.size());
+				}
+				skels.resize(jobs.size());
+				res.resize(jobs.size());
+				re.BuildSkeletons(jobs.data(), jobs.size(), skels.data(), res.data());
+			});
+			break;
+
 		case CG_R_BONEINDEX:
 			IPC::HandleMsg<Render::BoneIndexMsg>(channel, std::move(reader), [this] (int model, const std::string& boneName, int& index) {
 				index = re.BoneIndex(model, boneName.c_str());
@@ -49,6 +49,7 @@ Maryland 20850 USA.
 #include "framework/Rcon.h"
 #include "framework/Crypto.h"
 #include "framework/Network.h"
+#include "framework/Profiler.h"
 
 #ifndef _WIN32
 #include <sys/stat.h>
@@ -1877,6 +1878,7 @@ void CL_BeginDownload( const char *localName, const char *remoteName )
 
 	Q_strncpyz( cls.downloadName, localName, sizeof( cls.downloadName ) );
 	Com_sprintf( cls.downloadTempName, sizeof( cls.downloadTempName ), "%s.tmp", localName );
+	Q_strncpyz( cls.downloadPakName, remoteName, sizeof( cls.downloadPakName ) );
 
 	// Set so UI gets access to it
 	Cvar_Set( "cl_downloadName", remoteName );
@@ -1886,6 +1888,12 @@ void CL_BeginDownload( const char *localName, const char *remoteName )
 
 	clc.downloadBlock = 0; // Starting new file
 	clc.downloadCount = 0;
+	clc.downloadSelectiveAck = atoi( Info_ValueForKey( cl.gameState[ CS_SYSTEMINFO ].c_str(), "sv_dl_selectiveAck" ) ) != 0;
+
+	for ( int &size : clc.downloadPendingSize )
+	{
+		size = -1;
+	}
 
 	CL_AddReliableCommand( va( "download %s", Cmd_QuoteString( remoteName ) ) );
 }
@@ -2168,6 +2176,8 @@ void CL_InitServerInfo( serverInfo_t *server, netadr_t *address )
 	server->ping = -1;
 	server->game[ 0 ] = '\0';
 	server->netType = netadrtype_t::NA_BOT;
+
+	CL_ServerListChanged();
 }
 
 /*
@@ -2916,6 +2926,67 @@ void CL_WWWDownload()
 	CL_NextDownload();
 }
 
+/*
+==================
+CL_QueueWWWDownloads
+
+The server redirects one pak at a time, but they all come from the same
+place, so the other missing paks can be fetched from there already
+==================
+*/
+void CL_QueueWWWDownloads()
+{
+	const char               *slash = strrchr( cls.downloadName, '/' );
+	std::vector<std::string> fields;
+
+	if ( !slash )
+	{
+		return;
+	}
+
+	std::string baseURL( cls.downloadName, slash - cls.downloadName );
+
+	// format is:
+	//  @remotename@localname@remotename@localname, etc.
+	for ( const char *s = clc.downloadList; *s; )
+	{
+		const char *end = strchr( s, '@' );
+
+		if ( !end )
+		{
+			end = s + strlen( s );
+		}
+
+		if ( end > s )
+		{
+			fields.emplace_back( s, end );
+		}
+
+		s = *end ? end + 1 : end;
+	}
+
+	for ( size_t i = 0; i + 1 < fields.size(); i += 2 )
+	{
+		const std::string        &remoteName = fields[ i ];
+		const std::string        &localName = fields[ i + 1 ];
+		std::string              name, version;
+		Util::optional<uint32_t> checksum;
+
+		// the server won't redirect us to it
+		if ( strstr( clc.badChecksumList, va( "@%s", localName.c_str() ) ) )
+		{
+			continue;
+		}
+
+		if ( FS::ParsePakName( remoteName.data(), remoteName.data() + remoteName.size(), name, version, checksum ) )
+		{
+			// the same URL the server redirects to
+			DL_QueueDownload( ( localName + ".tmp" ).c_str(), Str::Format( "%s/%s_%s.pk3", baseURL, name, version ).c_str(),
+			                  remoteName.c_str() );
+		}
+	}
+}
+
 /*
 ==================
 CL_WWWBadChecksum
@@ -2955,6 +3026,8 @@ CL_Frame
 */
 void CL_Frame( int msec )
 {
+	PROFILE_ZONE( "CL_Frame" );
+
 	if ( !com_cl_running->integer )
 	{
 		return;
@@ -3184,6 +3257,8 @@ bool CL_InitRef( )
 	ri.Tag_Free = CL_RefTagFree;
 	ri.Hunk_Clear = Hunk_ClearToMark;
 	ri.Hunk_Alloc = Hunk_Alloc;
+	ri.Hunk_InitSubArena = Hunk_InitSubArena;
+	ri.Hunk_SubArenaAlloc = Hunk_SubArenaAlloc;
 	ri.Hunk_AllocateTempMemory = Hunk_AllocateTempMemory;
 	ri.Hunk_FreeTempMemory = Hunk_FreeTempMemory;
 
@@ -3213,11 +3288,9 @@ bool CL_InitRef( )
 	ri.CIN_PlayCinematic = CIN_PlayCinematic;
 	ri.CIN_RunCinematic = CIN_RunCinematic;
 
-	ri.CL_WriteAVIVideoFrame = CL_WriteAVIVideoFrame;
-
 	// XreaL BEGIN
 	ri.CL_VideoRecording = CL_VideoRecording;
-	ri.CL_WriteAVIVideoFrame = CL_WriteAVIVideoFrame;
+	ri.CL_QueueAVIVideoFrame = CL_QueueAVIVideoFrame;
 	// XreaL END
 
 	ri.IN_Init = IN_Init;
@@ -3511,7 +3584,7 @@ void CL_Shutdown()
 
 }
 
-static void CL_SetServerInfo( serverInfo_t *server, const char *info, int ping )
+void CL_SetServerInfo( serverInfo_t *server, const char *info, int ping )
 {
 	if ( server )
 	{
@@ -3536,32 +3609,29 @@ static void CL_SetServerInfo( serverInfo_t *server, const char *info, int ping )
 	}
 }
 
-static void CL_SetServerInfoByAddress( netadr_t from, const char *info, int ping )
-{
-	int i;
+/*
+===================
+CL_ServerNetType
 
-	for ( i = 0; i < MAX_OTHER_SERVERS; i++ )
+The "nettype" value of a server info string
+NOTE: make sure these types are in sync with the netnames strings in the UI
+===================
+*/
+int CL_ServerNetType( netadrtype_t type )
+{
+	switch ( type )
 	{
-		if ( NET_CompareAdr( from, cls.localServers[ i ].adr ) )
-		{
-			CL_SetServerInfo( &cls.localServers[ i ], info, ping );
-		}
-	}
+		case netadrtype_t::NA_BROADCAST:
+		case netadrtype_t::NA_IP:
+			//str = "udp";
+			return 1;
 
-	for ( i = 0; i < MAX_GLOBAL_SERVERS; i++ )
-	{
-		if ( NET_CompareAdr( from, cls.globalServers[ i ].adr ) )
-		{
-			CL_SetServerInfo( &cls.globalServers[ i ], info, ping );
-		}
-	}
+		case netadrtype_t::NA_IP6:
+			return 2;
 
-	for ( i = 0; i < MAX_OTHER_SERVERS; i++ )
-	{
-		if ( NET_CompareAdr( from, cls.favoriteServers[ i ].adr ) )
-		{
-			CL_SetServerInfo( &cls.favoriteServers[ i ], info, ping );
-		}
+		default:
+			//str = "???";
+			return 0;
 	}
 }
 
@@ -3572,7 +3642,7 @@ CL_ServerInfoPacket
 */
 void CL_ServerInfoPacket( netadr_t from, msg_t *msg )
 {
-	int  i, type;
+	int  i;
 	char info[ MAX_INFO_STRING ];
 //	char*   str;
 	char *infoString;
@@ -3599,6 +3669,11 @@ void CL_ServerInfoPacket( netadr_t from, msg_t *msg )
 		return;
 	}
 
+	if ( CL_ServerQueryResponse( from, infoString ) )
+	{
+		return;
+	}
+
 	// iterate servers waiting for ping response
 	for ( i = 0; i < MAX_PINGREQUESTS; i++ )
 	{
@@ -3613,26 +3688,7 @@ void CL_ServerInfoPacket( netadr_t from, msg_t *msg )
 			Q_strncpyz( cl_pinglist[ i ].info, infoString, sizeof( cl_pinglist[ i ].info ) );
 
 			// tack on the net type
-			// NOTE: make sure these types are in sync with the netnames strings in the UI
-			switch ( from.type )
-			{
-				case netadrtype_t::NA_BROADCAST:
-				case netadrtype_t::NA_IP:
-					//str = "udp";
-					type = 1;
-					break;
-
-				case netadrtype_t::NA_IP6:
-					type = 2;
-					break;
-
-				default:
-					//str = "???";
-					type = 0;
-					break;
-			}
-
-			Info_SetValueForKey( cl_pinglist[ i ].info, "nettype", va( "%d", type ), false );
+			Info_SetValueForKey( cl_pinglist[ i ].info, "nettype", va( "%d", CL_ServerNetType( from.type ) ), false );
 			CL_SetServerInfoByAddress( from, infoString, cl_pinglist[ i ].time );
 
 			return;
@@ -3683,6 +3739,8 @@ void CL_ServerInfoPacket( netadr_t from, msg_t *msg )
 	cls.localServers[ i ].needpass = 0;
 	cls.localServers[ i ].gameName[ 0 ] = '\0'; // Arnout
 
+	CL_ServerListChanged();
+
 	Q_strncpyz( info, MSG_ReadString( msg ), MAX_INFO_STRING );
 
 	if ( info[ 0 ] )
@@ -3976,6 +4034,8 @@ void CL_LocalServers_f()
 		cls.localServers[ i ].visible = b;
 	}
 
+	CL_ServerListChanged();
+
 	Com_Memset( &to, 0, sizeof( to ) );
 
 	// The 'xxx' in the message is a challenge that will be echoed back
@@ -4283,11 +4343,12 @@ CL_UpdateVisiblePings_f
 */
 bool CL_UpdateVisiblePings_f( int source )
 {
-	int      slots, i;
-	char     buff[ MAX_STRING_CHARS ];
-	int      pingTime;
-	int      max;
-	bool status = false;
+	int          i;
+	char         buff[ MAX_STRING_CHARS ];
+	int          pingTime;
+	int          max = 0;
+	serverInfo_t *server = nullptr;
+	bool         status = false;
 
 	if ( source < 0 || source > AS_FAVORITES )
 	{
@@ -4296,101 +4357,60 @@ bool CL_UpdateVisiblePings_f( int source )
 
 	cls.pingUpdateSource = source;
 
-	slots = CL_GetPingQueueCount();
-
-	if ( slots < MAX_PINGREQUESTS )
+	switch ( source )
 	{
-		serverInfo_t *server = nullptr;
-
-		max = ( source == AS_GLOBAL ) ? MAX_GLOBAL_SERVERS : MAX_OTHER_SERVERS;
+		case AS_LOCAL:
+			server = &cls.localServers[ 0 ];
+			max = cls.numlocalservers;
+			break;
 
-		switch ( source )
-		{
-			case AS_LOCAL:
-				server = &cls.localServers[ 0 ];
-				max = cls.numlocalservers;
-				break;
+		case AS_GLOBAL:
+			server = &cls.globalServers[ 0 ];
+			max = cls.numglobalservers;
+			break;
 
-			case AS_GLOBAL:
-				server = &cls.globalServers[ 0 ];
-				max = cls.numglobalservers;
-				break;
+		case AS_FAVORITES:
+			server = &cls.favoriteServers[ 0 ];
+			max = cls.numfavoriteservers;
+			break;
+	}
 
-			case AS_FAVORITES:
-				server = &cls.favoriteServers[ 0 ];
-				max = cls.numfavoriteservers;
-				break;
+	for ( i = 0; i < max; i++ )
+	{
+		if ( !server[ i ].visible )
+		{
+			continue;
 		}
 
-		for ( i = 0; i < max; i++ )
+		if ( server[ i ].ping == -1 )
+		{
+			// does nothing if it is already queued or waiting for a reply
+			CL_QueueServerQuery( server[ i ].adr );
+		}
+		// if the server has a ping higher than cl_maxPing or
+		// the ping packet got lost
+		else if ( server[ i ].ping == 0 )
 		{
-			if ( server[ i ].visible )
+			// if we are updating global servers
+			if ( source == AS_GLOBAL && cls.numGlobalServerAddresses > 0 )
 			{
-				if ( server[ i ].ping == -1 )
-				{
-					int j;
-
-					if ( slots >= MAX_PINGREQUESTS )
-					{
-						break;
-					}
-
-					for ( j = 0; j < MAX_PINGREQUESTS; j++ )
-					{
-						if ( !cl_pinglist[ j ].adr.port )
-						{
-							continue;
-						}
-
-						if ( NET_CompareAdr( cl_pinglist[ j ].adr, server[ i ].adr ) )
-						{
-							// already on the list
-							break;
-						}
-					}
-
-					// Not in the list, so find and use a free slot.
-					// If all slots are full, the server won't be pinged.
-					if ( j >= MAX_PINGREQUESTS )
-					{
-						status = true;
-
-						for ( j = 0; j < MAX_PINGREQUESTS; j++ )
-						{
-							if ( !cl_pinglist[ j ].adr.port )
-							{
-								memcpy( &cl_pinglist[ j ].adr, &server[ i ].adr, sizeof( netadr_t ) );
-								cl_pinglist[ j ].start = Sys_Milliseconds();
-								cl_pinglist[ j ].time = 0;
-								Net::OutOfBandPrint( netsrc_t::NS_CLIENT, cl_pinglist[ j ].adr, "getinfo xxx" );
-								slots++;
-								break;
-							}
-						}
-					}
-				}
-				// if the server has a ping higher than cl_maxPing or
-				// the ping packet got lost
-				else if ( server[ i ].ping == 0 )
-				{
-					// if we are updating global servers
-					if ( source == AS_GLOBAL )
-					{
-						//
-						if ( cls.numGlobalServerAddresses > 0 )
-						{
-							// overwrite this server with one from the additional global servers
-							cls.numGlobalServerAddresses--;
-							CL_InitServerInfo( &server[ i ], &cls.globalServerAddresses[ cls.numGlobalServerAddresses ] );
-							// NOTE: the server[i].visible flag stays untouched
-						}
-					}
-				}
+				// overwrite this server with one from the additional global servers
+				cls.numGlobalServerAddresses--;
+				CL_InitServerInfo( &server[ i ], &cls.globalServerAddresses[ cls.numGlobalServerAddresses ] );
+				// NOTE: the server[i].visible flag stays untouched
 			}
 		}
 	}
 
-	if ( slots )
+	CL_SendServerQueries();
+
+	if ( CL_PendingServerQueries() )
+	{
+		status = true;
+	}
+
+	// pings sent by the ping command
+	if ( CL_GetPingQueueCount() )
 	{
 		status = true;
 	}
@@ -472,6 +472,101 @@ void CL_ParseGamestate( msg_t *msg )
 
 //=====================================================================
 
+/*
+=====================
+CL_AckDownload
+
+Tells the server the last block we have with all the blocks before it,
+and which of the blocks after it arrived early
+=====================
+*/
+static void CL_AckDownload()
+{
+	if ( !clc.downloadSelectiveAck )
+	{
+		return;
+	}
+
+	unsigned selective = 0;
+
+	for ( int i = 0; i < MAX_DOWNLOAD_WINDOW; i++ )
+	{
+		if ( clc.downloadPendingSize[ ( clc.downloadBlock + i + 1 ) % MAX_DOWNLOAD_WINDOW ] >= 0 )
+		{
+			selective |= 1u << i;
+		}
+	}
+
+	CL_AddReliableCommand( va( "nextdl %d %d", clc.downloadBlock - 1, int( selective ) ) );
+}
+
+/*
+=====================
+CL_WriteDownloadBlock
+
+Writes the block the download is at, returns false once the download
+is over
+=====================
+*/
+static bool CL_WriteDownloadBlock( const byte *data, int size )
+{
+	if ( size )
+	{
+		FS_Write( data, size, clc.download );
+	}
+
+	// servers without selective acknowledgement want every block acknowledged
+	if ( !clc.downloadSelectiveAck )
+	{
+		CL_AddReliableCommand( va( "nextdl %d", clc.downloadBlock ) );
+	}
+
+	clc.downloadBlock++;
+
+	clc.downloadCount += size;
+
+	// So UI gets access to it
+	Cvar_SetValue( "cl_downloadCount", clc.downloadCount );
+
+	if ( size )
+	{
+		return true;
+	}
+
+	downloadLogger.Debug("Received EOF, closing '%s'", cls.downloadTempName);
+
+	// A zero length block means EOF
+	if ( clc.download )
+	{
+		FS_FCloseFile( clc.download );
+		clc.download = 0;
+
+		// rename the file
+		FS_SV_Rename( cls.downloadTempName, cls.downloadName );
+	}
+
+	*cls.downloadTempName = *cls.downloadName = 0;
+	Cvar_Set( "cl_downloadName", "" );
+
+	if ( clc.downloadSelectiveAck )
+	{
+		CL_AddReliableCommand( va( "nextdl %d", clc.downloadBlock - 1 ) );
+	}
+
+	// send intentions now
+	// We need this because without it, we would hold the last nextdl and then start
+	// loading right away.  If we take a while to load, the server is happily trying
+	// to send us that last block over and over.
+	// Write it twice to help make sure we acknowledge the download
+	CL_WritePacket();
+	CL_WritePacket();
+
+	// get another file if needed
+	CL_NextDownload();
+
+	return false;
+}
+
 /*
 =====================
 CL_ParseDownload
@@ -539,7 +634,11 @@ void CL_ParseDownload( msg_t *msg )
 				return;
 			}
 
-			if ( !DL_BeginDownload( cls.downloadTempName, cls.downloadName ) )
+			if ( DL_BeginDownload( cls.downloadTempName, cls.downloadName, cls.downloadPakName ) )
+			{
+				CL_QueueWWWDownloads();
+			}
+			else
 			{
 				// setting bWWWDl to false after sending the wwwdl fail doesn't work
 				// not sure why, but I suspect we have to eat all remaining block -1 that the server has sent us
@@ -596,15 +695,33 @@ void CL_ParseDownload( msg_t *msg )
 
 	MSG_ReadData( msg, data, size );
 
-	if ( clc.downloadBlock != block )
+	if ( block != clc.downloadBlock )
 	{
-		downloadLogger.Debug( "CL_ParseDownload: Expected block %i, got %i", clc.downloadBlock, block );
+		int ahead = block - clc.downloadBlock;
+
+		// keep blocks that overtook the one we are waiting for
+		if ( clc.downloadSelectiveAck && ahead > 0 && ahead < MAX_DOWNLOAD_WINDOW && size <= MAX_DOWNLOAD_BLKSIZE )
+		{
+			int index = block % MAX_DOWNLOAD_WINDOW;
+
+			memcpy( clc.downloadPending[ index ], data, size );
+			clc.downloadPendingSize[ index ] = size;
+			CL_AckDownload();
+		}
+		else
+		{
+			downloadLogger.Debug( "CL_ParseDownload: Expected block %i, got %i", clc.downloadBlock, block );
+		}
+
 		return;
 	}
 
 	// open the file if not opened yet
 	if ( !clc.download )
 	{
+		// the server doesn't redirect this one after all
+		DL_CancelDownload( cls.downloadTempName );
+
 		clc.download = FS_SV_FOpenFileWrite( cls.downloadTempName );
 
 		if ( !clc.download )
@@ -616,46 +733,26 @@ void CL_ParseDownload( msg_t *msg )
 		}
 	}
 
-	if ( size )
+	if ( !CL_WriteDownloadBlock( data, size ) )
 	{
-		FS_Write( data, size, clc.download );
+		return;
 	}
 
-	CL_AddReliableCommand( va( "nextdl %d", clc.downloadBlock ) );
-	clc.downloadBlock++;
-
-	clc.downloadCount += size;
+	// write the blocks that were waiting for this one
+	int index;
 
-	// So UI gets access to it
-	Cvar_SetValue( "cl_downloadCount", clc.downloadCount );
-
-	if ( !size )
+	while ( ( index = clc.downloadBlock % MAX_DOWNLOAD_WINDOW, clc.downloadPendingSize[ index ] >= 0 ) )
 	{
-        downloadLogger.Debug("Received EOF, closing '%s'", cls.downloadTempName);
-		// A zero length block means EOF
-		if ( clc.download )
-		{
-			FS_FCloseFile( clc.download );
-			clc.download = 0;
+		size = clc.downloadPendingSize[ index ];
+		clc.downloadPendingSize[ index ] = -1;
 
-			// rename the file
-			FS_SV_Rename( cls.downloadTempName, cls.downloadName );
+		if ( !CL_WriteDownloadBlock( clc.downloadPending[ index ], size ) )
+		{
+			return;
 		}
-
-		*cls.downloadTempName = *cls.downloadName = 0;
-		Cvar_Set( "cl_downloadName", "" );
-
-		// send intentions now
-		// We need this because without it, we would hold the last nextdl and then start
-		// loading right away.  If we take a while to load, the server is happily trying
-		// to send us that last block over and over.
-		// Write it twice to help make sure we acknowledge the download
-		CL_WritePacket();
-		CL_WritePacket();
-
-		// get another file if needed
-		CL_NextDownload();
 	}
+
+	CL_AckDownload();
 }
 
 /*
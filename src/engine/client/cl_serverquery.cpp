@@ -0,0 +1,275 @@
+/*
+===========================================================================
+
+Daemon GPL Source Code
+Copyright (C) 2024 Daemon Developers
+
+This file is part of the Daemon GPL Source Code (Daemon Source Code).
+
+Daemon Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Daemon Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Daemon Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+===========================================================================
+*/
+// cl_serverquery.cpp -- server browser info queries
+#include "client.h"
+#include "framework/Network.h"
+
+#include <deque>
+#include <unordered_map>
+
+/*
+=============================================================================
+
+SERVER QUERIES
+
+The server browser used to ping at most MAX_PINGREQUESTS servers at a time
+and matched every reply by scanning the ping list and all the server lists.
+Queries now wait in a queue and are sent at cl_serverQueryRate packets per
+second, with no limit on how many are in flight. Both the in-flight queries
+and the server lists are looked up through a hash of the server address.
+
+=============================================================================
+*/
+
+static Cvar::Range<Cvar::Cvar<int>> cl_serverQueryRate("cl_serverQueryRate", "server browser queries sent per second", Cvar::NONE, 250, 10, 5000);
+
+// hashes the same address fields that NET_CompareAdr compares, except the
+// port, which NET_CompareAdr ignores for broadcast addresses
+struct serverAddressHash_t
+{
+	size_t operator()( const netadr_t &adr ) const
+	{
+		netadrtype_t type = NET_TYPE( adr.type );
+		size_t hash = static_cast<size_t>( type );
+		const byte *bytes = nullptr;
+		int length = 0;
+
+		if ( type == netadrtype_t::NA_IP )
+		{
+			bytes = adr.ip;
+			length = sizeof( adr.ip );
+		}
+		else if ( type == netadrtype_t::NA_IP6 )
+		{
+			bytes = adr.ip6;
+			length = sizeof( adr.ip6 );
+		}
+
+		for ( int i = 0; i < length; i++ )
+		{
+			hash = hash * 31 + bytes[ i ];
+		}
+
+		return hash;
+	}
+};
+
+struct serverAddressEqual_t
+{
+	bool operator()( const netadr_t &a, const netadr_t &b ) const
+	{
+		return NET_CompareAdr( a, b );
+	}
+};
+
+struct serverQuery_t
+{
+	bool                         sent;
+	Sys::SteadyClock::time_point sendTime;
+};
+
+static std::unordered_map<netadr_t, serverQuery_t, serverAddressHash_t, serverAddressEqual_t> serverQueries;
+static std::deque<netadr_t> serverQueryQueue;
+static float serverQueryBudget;
+static Sys::SteadyClock::time_point serverQueryBudgetTime;
+
+static std::unordered_multimap<netadr_t, serverInfo_t *, serverAddressHash_t, serverAddressEqual_t> serverTable;
+static bool serverTableValid;
+
+/*
+===============
+CL_ServerListChanged
+
+Must be called whenever a server list entry gets a new address.
+===============
+*/
+void CL_ServerListChanged()
+{
+	serverTableValid = false;
+}
+
+/*
+===============
+CL_AddServersToTable
+===============
+*/
+static void CL_AddServersToTable( serverInfo_t *servers, int count )
+{
+	for ( int i = 0; i < count; i++ )
+	{
+		if ( servers[ i ].adr.port )
+		{
+			serverTable.emplace( servers[ i ].adr, &servers[ i ] );
+		}
+	}
+}
+
+/*
+===============
+CL_SetServerInfoByAddress
+===============
+*/
+void CL_SetServerInfoByAddress( netadr_t from, const char *info, int ping )
+{
+	if ( !serverTableValid )
+	{
+		serverTable.clear();
+		CL_AddServersToTable( cls.localServers, MAX_OTHER_SERVERS );
+		CL_AddServersToTable( cls.globalServers, MAX_GLOBAL_SERVERS );
+		CL_AddServersToTable( cls.favoriteServers, MAX_OTHER_SERVERS );
+		serverTableValid = true;
+	}
+
+	auto range = serverTable.equal_range( from );
+
+	for ( auto it = range.first; it != range.second; ++it )
+	{
+		// the entry may have been overwritten since the table was built
+		if ( NET_CompareAdr( from, it->second->adr ) )
+		{
+			CL_SetServerInfo( it->second, info, ping );
+		}
+	}
+}
+
+/*
+===============
+CL_QueueServerQuery
+
+Returns false if the server is already queued or waiting for a reply.
+===============
+*/
+bool CL_QueueServerQuery( const netadr_t &adr )
+{
+	if ( !serverQueries.emplace( adr, serverQuery_t{ false, {} } ).second )
+	{
+		return false;
+	}
+
+	serverQueryQueue.push_back( adr );
+	return true;
+}
+
+/*
+===============
+CL_SendServerQueries
+
+Sends as many queued queries as the rate allows since the last call, then
+drops queries that have waited longer than cl_maxPing for a reply.
+===============
+*/
+void CL_SendServerQueries()
+{
+	auto now = Sys::SteadyClock::now();
+	float elapsed = std::chrono::duration<float>( now - serverQueryBudgetTime ).count();
+
+	serverQueryBudgetTime = now;
+
+	if ( serverQueryQueue.empty() )
+	{
+		serverQueryBudget = 0.0f;
+	}
+	else
+	{
+		// allow a burst of at most a tenth of a second worth of queries
+		float rate = cl_serverQueryRate.Get();
+		serverQueryBudget = std::min( serverQueryBudget + elapsed * rate, std::max( rate * 0.1f, 1.0f ) );
+	}
+
+	while ( serverQueryBudget >= 1.0f && !serverQueryQueue.empty() )
+	{
+		netadr_t adr = serverQueryQueue.front();
+		serverQueryQueue.pop_front();
+
+		auto it = serverQueries.find( adr );
+
+		if ( it == serverQueries.end() || it->second.sent )
+		{
+			continue;
+		}
+
+		it->second.sent = true;
+		it->second.sendTime = Sys::SteadyClock::now();
+		Net::OutOfBandPrint( netsrc_t::NS_CLIENT, adr, "getinfo xxx" );
+		serverQueryBudget -= 1.0f;
+	}
+
+	int maxPing = std::max( Cvar_VariableIntegerValue( "cl_maxPing" ), 100 );
+
+	for ( auto it = serverQueries.begin(); it != serverQueries.end(); )
+	{
+		if ( it->second.sent && now - it->second.sendTime >= std::chrono::milliseconds( maxPing ) )
+		{
+			// lost or slower than cl_maxPing
+			CL_SetServerInfoByAddress( it->first, nullptr, 0 );
+			it = serverQueries.erase( it );
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+/*
+===============
+CL_PendingServerQueries
+===============
+*/
+int CL_PendingServerQueries()
+{
+	return serverQueries.size();
+}
+
+/*
+===============
+CL_ServerQueryResponse
+
+Returns false if the info packet does not answer a query of ours.
+===============
+*/
+bool CL_ServerQueryResponse( netadr_t from, const char *info )
+{
+	auto it = serverQueries.find( from );
+
+	if ( it == serverQueries.end() || !it->second.sent )
+	{
+		return false;
+	}
+
+	auto rtt = std::chrono::duration_cast<std::chrono::milliseconds>( Sys::SteadyClock::now() - it->second.sendTime );
+	int ping = std::max( static_cast<int>( rtt.count() ), 1 );
+
+	serverQueries.erase( it );
+
+	Log::Debug( "ping time %dms from %s", ping, NET_AdrToString( from ) );
+
+	// tack on the net type, as the replies to cl_pinglist do
+	char infoWithType[ MAX_INFO_STRING ];
+	Q_strncpyz( infoWithType, info, sizeof( infoWithType ) );
+	Info_SetValueForKey( infoWithType, "nettype", va( "%d", CL_ServerNetType( from.type ) ), false );
+
+	CL_SetServerInfoByAddress( from, infoWithType, ping );
+	return true;
+}
@@ -214,6 +214,9 @@ struct clientConnection_t
 	int          downloadCount; // how many bytes we got
 	int          downloadSize; // how many bytes we got
 	int          downloadFlags; // misc download behaviour flags sent by the server
+	bool         downloadSelectiveAck; // the server takes out of order acknowledgements
+	byte         downloadPending[ MAX_DOWNLOAD_WINDOW ][ MAX_DOWNLOAD_BLKSIZE ]; // blocks after downloadBlock
+	int          downloadPendingSize[ MAX_DOWNLOAD_WINDOW ]; // -1 for a block we don't have
 	char         downloadList[ MAX_INFO_STRING ]; // list of paks we need to download
 
 	// www downloading
@@ -347,6 +350,7 @@ struct clientStatic_t
 	char     downloadName[ MAX_OSPATH ];
 	char     downloadTempName[ MAX_OSPATH ]; // in wwwdl mode, this is OS path (it's a qpath otherwise)
 	char     originalDownloadName[ MAX_QPATH ]; // if we get a redirect, keep a copy of the original file path
+	char     downloadPakName[ MAX_QPATH ]; // the name the download was requested with, it has the pak checksum
 	bool downloadRestart; // if true, we need to do another FS_Restart because we downloaded a pak
 };
 
@@ -529,6 +533,7 @@ void        CL_StartDemoLoop();
 
 void        CL_InitDownloads();
 void        CL_NextDownload();
+void        CL_QueueWWWDownloads();
 
 void        CL_GetPing( int n, char *buf, int buflen, int *pingtime );
 void        CL_ClearPing( int n );
@@ -627,6 +632,18 @@ void     CL_GlobalServers_f();
 void     CL_FavoriteServers_f();
 void     CL_Ping_f();
 bool CL_UpdateVisiblePings_f( int source );
+void     CL_SetServerInfo( serverInfo_t *server, const char *info, int ping );
+
+//
+// cl_serverquery.c
+//
+void     CL_ServerListChanged();
+void     CL_SetServerInfoByAddress( netadr_t from, const char *info, int ping );
+bool     CL_QueueServerQuery( const netadr_t &adr );
+void     CL_SendServerQueries();
+int      CL_PendingServerQueries();
+bool     CL_ServerQueryResponse( netadr_t from, const char *info );
+int      CL_ServerNetType( netadrtype_t type );
 
 //
 // console
@@ -798,7 +815,7 @@ bool CL_Netchan_Process( netchan_t *chan, msg_t *msg );
 //
 bool CL_OpenAVIForWriting( const char *filename );
 void     CL_TakeVideoFrame();
-void     CL_WriteAVIVideoFrame( const byte *imageBuffer, int size );
+void     CL_QueueAVIVideoFrame( int frame, const byte *pixels, int lineLen );
 void     CL_WriteAVIAudioFrame( const byte *pcmBuffer, int size );
 bool CL_CloseAVI();
 bool CL_VideoRecording();
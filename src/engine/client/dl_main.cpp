@@ -41,33 +41,58 @@ Maryland 20850 USA.
 
 #include "qcommon/q_shared.h"
 #include "qcommon/qcommon.h"
+#include "common/FileSystem.h"
+
+static Cvar::Range<Cvar::Cvar<int>> cl_dlMaxTransfers( "cl_dlMaxTransfers", "HTTP downloads that run at the same time", Cvar::NONE, 4, 1, 16 );
+
+struct dlTransfer_t
+{
+	std::string              localName;
+	std::string              remoteName;
+	Util::optional<uint32_t> checksum; // of the pak, checked before it is renamed
+	CURL                     *request; // nullptr while it waits for a free slot
+	FS::File                 file;
+	FS::offset_t             resumeFrom;
+	dlStatus_t               status;
+};
 
 // initialize once
 static int   dl_initialized = 0;
 
 static CURLM *dl_multi = nullptr;
-static CURL  *dl_request = nullptr;
-static fileHandle_t dl_file;
+
+// a list so the transfers stay where the curl callbacks point
+static std::list<dlTransfer_t> dl_transfers;
+static dlTransfer_t            *dl_current = nullptr; // the one DL_DownloadLoop reports on
 
 /*
 ** Write to file
 */
 static size_t DL_cb_FWriteFile( void *ptr, size_t size, size_t nmemb, void *stream )
 {
-	fileHandle_t file = ( fileHandle_t )( intptr_t ) stream;
+	dlTransfer_t    *transfer = static_cast<dlTransfer_t *>( stream );
+	std::error_code err;
+
+	transfer->file.Write( ptr, size * nmemb, err );
 
-	return FS_Write( ptr, size * nmemb, file );
+	return err ? 0 : size * nmemb;
 }
 
 /*
 ** Print progress
 */
-static int DL_cb_Progress( void*, double, double dlnow, double, double )
+static int DL_cb_Progress( void *data, double, double dlnow, double, double )
 {
 	/* cl_downloadSize and cl_downloadTime are set by the Q3 protocol...
 	   and it would probably be expensive to verify them here.   -zinx */
 
-	Cvar_SetValue( "cl_downloadCount", ( float ) dlnow );
+	const dlTransfer_t *transfer = static_cast<const dlTransfer_t *>( data );
+
+	if ( transfer == dl_current )
+	{
+		Cvar_SetValue( "cl_downloadCount", ( float )( transfer->resumeFrom + dlnow ) );
+	}
+
 	return 0;
 }
 
@@ -87,6 +112,27 @@ void DL_InitDownload()
 	dl_initialized = 1;
 }
 
+/*
+================
+DL_StopTransfer
+
+Partial files stay, so a later attempt can resume them
+================
+*/
+static void DL_StopTransfer( dlTransfer_t &transfer )
+{
+	std::error_code err;
+
+	if ( transfer.request )
+	{
+		curl_multi_remove_handle( dl_multi, transfer.request );
+		curl_easy_cleanup( transfer.request );
+		transfer.request = nullptr;
+	}
+
+	transfer.file.Close( err );
+}
+
 /*
 ================
 DL_Shutdown
@@ -100,6 +146,14 @@ void DL_Shutdown()
 		return;
 	}
 
+	for ( dlTransfer_t &transfer : dl_transfers )
+	{
+		DL_StopTransfer( transfer );
+	}
+
+	dl_transfers.clear();
+	dl_current = nullptr;
+
 	curl_multi_cleanup( dl_multi );
 	dl_multi = nullptr;
 
@@ -110,39 +164,43 @@ void DL_Shutdown()
 
 /*
 ===============
-inspired from http://www.w3.org/Library/Examples/LoadToFile.c
-setup the download, return once we have a connection
+DL_StartTransfer
+
+Opens the file, appending to what an earlier attempt left of it, and
+adds the request to the multi handle
 ===============
 */
-int DL_BeginDownload( const char *localName, const char *remoteName )
+static bool DL_StartTransfer( dlTransfer_t &transfer )
 {
-	char referer[ MAX_STRING_CHARS + URI_SCHEME_LENGTH ];
+	char            referer[ MAX_STRING_CHARS + URI_SCHEME_LENGTH ];
+	std::error_code err;
 
-	if ( dl_request )
+	transfer.resumeFrom = 0;
+
+	if ( FS::HomePath::FileExists( transfer.localName ) )
 	{
-		curl_multi_remove_handle( dl_multi, dl_request );
-		curl_easy_cleanup( dl_request );
-		dl_request = nullptr;
-	}
+		transfer.file = FS::HomePath::OpenAppend( transfer.localName, err );
 
-	if ( dl_file )
+		if ( !err )
+		{
+			transfer.resumeFrom = transfer.file.Length( err );
+		}
+	}
+	else
 	{
-		FS_FCloseFile( dl_file );
-		dl_file = 0;
+		transfer.file = FS::HomePath::OpenWrite( transfer.localName, err );
 	}
 
-	if ( !localName || !remoteName )
+	if ( err )
 	{
-		Log::Debug( "Empty download URL or empty local file name" );
-		return 0;
+		Log::Warn( "DL_BeginDownload unable to open '%s' for writing\n", transfer.localName );
+		transfer.status = dlStatus_t::DL_FAILED;
+		return false;
 	}
 
-	dl_file = FS_SV_FOpenFileWrite( localName );
-
-	if ( !dl_file )
+	if ( transfer.resumeFrom )
 	{
-		Log::Warn( "DL_BeginDownload unable to open '%s' for writing\n", localName );
-		return 0;
+		Log::Debug( "Resuming '%s' at %d bytes", transfer.remoteName, ( int ) transfer.resumeFrom );
 	}
 
 	DL_InitDownload();
@@ -150,80 +208,287 @@ int DL_BeginDownload( const char *localName, const char *remoteName )
 	strcpy( referer, URI_SCHEME );
 	Q_strncpyz( referer + URI_SCHEME_LENGTH, Cvar_VariableString( "cl_currentServerIP" ), MAX_STRING_CHARS );
 
-	dl_request = curl_easy_init();
-	curl_easy_setopt( dl_request, CURLOPT_USERAGENT, va( "%s %s", PRODUCT_NAME "/" PRODUCT_VERSION, curl_version() ) );
-	curl_easy_setopt( dl_request, CURLOPT_REFERER, referer );
-	curl_easy_setopt( dl_request, CURLOPT_URL, remoteName );
-	curl_easy_setopt( dl_request, CURLOPT_WRITEFUNCTION, DL_cb_FWriteFile );
-	curl_easy_setopt( dl_request, CURLOPT_WRITEDATA, ( void * )( intptr_t ) dl_file );
-	curl_easy_setopt( dl_request, CURLOPT_PROGRESSFUNCTION, DL_cb_Progress );
-	curl_easy_setopt( dl_request, CURLOPT_NOPROGRESS, 0 );
-	curl_easy_setopt( dl_request, CURLOPT_FAILONERROR, 1 );
+	transfer.request = curl_easy_init();
+	curl_easy_setopt( transfer.request, CURLOPT_USERAGENT, va( "%s %s", PRODUCT_NAME "/" PRODUCT_VERSION, curl_version() ) );
+	curl_easy_setopt( transfer.request, CURLOPT_REFERER, referer );
+	curl_easy_setopt( transfer.request, CURLOPT_URL, transfer.remoteName.c_str() );
+	curl_easy_setopt( transfer.request, CURLOPT_WRITEFUNCTION, DL_cb_FWriteFile );
+	curl_easy_setopt( transfer.request, CURLOPT_WRITEDATA, &transfer );
+	curl_easy_setopt( transfer.request, CURLOPT_PROGRESSFUNCTION, DL_cb_Progress );
+	curl_easy_setopt( transfer.request, CURLOPT_PROGRESSDATA, &transfer );
+	curl_easy_setopt( transfer.request, CURLOPT_NOPROGRESS, 0 );
+	curl_easy_setopt( transfer.request, CURLOPT_FAILONERROR, 1 );
+	curl_easy_setopt( transfer.request, CURLOPT_RESUME_FROM_LARGE, ( curl_off_t ) transfer.resumeFrom );
 
-	curl_multi_add_handle( dl_multi, dl_request );
+	curl_multi_add_handle( dl_multi, transfer.request );
 
-	Cvar_Set( "cl_downloadName", remoteName );
+	transfer.status = dlStatus_t::DL_CONTINUE;
 
-	return 1;
+	return true;
 }
 
-// (maybe this should be CL_DL_DownloadLoop)
-dlStatus_t DL_DownloadLoop()
+/*
+===============
+DL_FinishTransfer
+===============
+*/
+static void DL_FinishTransfer( dlTransfer_t &transfer, CURLcode result )
 {
-	CURLMcode  status;
-	CURLMsg    *msg;
-	int        dls = 0;
-	const char *err = nullptr;
+	long            code = 0;
+	std::error_code err;
+
+	curl_easy_getinfo( transfer.request, CURLINFO_RESPONSE_CODE, &code );
+	DL_StopTransfer( transfer );
 
-	if ( !dl_request )
+	// a server that doesn't do ranges answers with the whole file, which
+	// libcurl refuses before writing any of it: start over without a range,
+	// or every later attempt would resume and fail the same way
+	if ( transfer.resumeFrom && ( result == CURLE_RANGE_ERROR || code == 200 ) )
 	{
-		Log::Debug( "DL_DownloadLoop: unexpected call with dl_request == NULL" );
-		return dlStatus_t::DL_DONE;
+		Log::Debug( "'%s' can't be resumed, starting over", transfer.remoteName );
+		FS::HomePath::DeleteFile( transfer.localName, err );
+
+		if ( err )
+		{
+			Log::Warn( "Couldn't delete the partial download '%s'", transfer.localName );
+			transfer.status = dlStatus_t::DL_FAILED;
+			return;
+		}
+
+		DL_StartTransfer( transfer );
+		return;
 	}
 
-	if ( ( status = curl_multi_perform( dl_multi, &dls ) ) == CURLM_CALL_MULTI_PERFORM && dls )
+	// a range that starts at the end of the file: the last attempt got all of it
+	if ( result != CURLE_OK && !( code == 416 && transfer.resumeFrom ) )
 	{
-		return dlStatus_t::DL_CONTINUE;
+		Log::Debug( "DL_DownloadLoop: request for '%s' terminated with failure status '%s'",
+		            transfer.remoteName, curl_easy_strerror( result ) );
+		transfer.status = dlStatus_t::DL_FAILED;
+		return;
 	}
 
-	while ( ( msg = curl_multi_info_read( dl_multi, &dls ) ) && msg->easy_handle != dl_request )
+	if ( transfer.checksum )
 	{
-		;
+		uint32_t checksum = FS::ComputePakChecksum( FS::Path::Build( FS::GetHomePath(), transfer.localName ), err );
+
+		if ( err || checksum != *transfer.checksum )
+		{
+			// don't resume from it next time
+			Log::Warn( "Download of '%s' has a wrong checksum, deleting it", transfer.remoteName );
+			FS::HomePath::DeleteFile( transfer.localName, err );
+			transfer.status = dlStatus_t::DL_FAILED;
+			return;
+		}
 	}
 
-	if ( !msg || msg->msg != CURLMSG_DONE )
+	transfer.status = dlStatus_t::DL_DONE;
+}
+
+/*
+===============
+DL_FindTransfer
+===============
+*/
+static dlTransfer_t *DL_FindTransfer( const char *localName )
+{
+	for ( dlTransfer_t &transfer : dl_transfers )
 	{
-		return dlStatus_t::DL_CONTINUE;
+		if ( transfer.localName == localName )
+		{
+			return &transfer;
+		}
 	}
 
-	if ( msg->data.result != CURLE_OK )
+	return nullptr;
+}
+
+/*
+===============
+DL_AddTransfer
+===============
+*/
+static dlTransfer_t &DL_AddTransfer( const char *localName, const char *remoteName, const char *pakName )
+{
+	std::string name, version;
+
+	dl_transfers.emplace_back();
+
+	dlTransfer_t &transfer = dl_transfers.back();
+	transfer.localName = localName;
+	transfer.remoteName = remoteName;
+	transfer.request = nullptr;
+	transfer.resumeFrom = 0;
+	transfer.status = dlStatus_t::DL_CONTINUE;
+
+	if ( pakName && !FS::ParsePakName( pakName, pakName + strlen( pakName ), name, version, transfer.checksum ) )
 	{
-#ifdef __MACOS__ // ���
-		err = "unknown curl error.";
-#else
-		err = curl_easy_strerror( msg->data.result );
-#endif
+		transfer.checksum = Util::nullopt;
 	}
-	else
+
+	return transfer;
+}
+
+/*
+===============
+inspired from http://www.w3.org/Library/Examples/LoadToFile.c
+setup the download, return once we have a connection
+
+A download that was queued before is taken over, otherwise it starts
+right away, before the queued ones. When pakName has a checksum the
+file is checked against it.
+===============
+*/
+int DL_BeginDownload( const char *localName, const char *remoteName, const char *pakName )
+{
+	if ( dl_current )
 	{
-		err = nullptr;
+		DL_StopTransfer( *dl_current );
+		dl_transfers.remove_if( []( const dlTransfer_t &transfer ) { return &transfer == dl_current; } );
+		dl_current = nullptr;
 	}
 
-	curl_multi_remove_handle( dl_multi, dl_request );
-	curl_easy_cleanup( dl_request );
+	if ( !localName || !remoteName )
+	{
+		Log::Debug( "Empty download URL or empty local file name" );
+		return 0;
+	}
 
-	FS_FCloseFile( dl_file );
-	dl_file = 0;
+	dlTransfer_t *transfer = DL_FindTransfer( localName );
 
-	dl_request = nullptr;
+	if ( !transfer || transfer->remoteName != remoteName )
+	{
+		if ( transfer )
+		{
+			DL_StopTransfer( *transfer );
+			dl_transfers.remove_if( [transfer]( const dlTransfer_t &other ) { return &other == transfer; } );
+		}
 
-	Cvar_Set( "ui_dl_running", "0" );
+		transfer = &DL_AddTransfer( localName, remoteName, pakName );
+	}
 
-	if ( err )
+	// a queued download that failed gets another try
+	if ( !transfer->request && transfer->status != dlStatus_t::DL_DONE && !DL_StartTransfer( *transfer ) )
+	{
+		dl_transfers.remove_if( [transfer]( const dlTransfer_t &other ) { return &other == transfer; } );
+		return 0;
+	}
+
+	dl_current = transfer;
+
+	Cvar_Set( "cl_downloadName", remoteName );
+
+	return 1;
+}
+
+/*
+===============
+DL_QueueDownload
+
+Fetches a file in the background, so that DL_BeginDownload finds it
+done or under way
+===============
+*/
+void DL_QueueDownload( const char *localName, const char *remoteName, const char *pakName )
+{
+	if ( DL_FindTransfer( localName ) )
+	{
+		return;
+	}
+
+	Log::Debug( "Queueing the download of '%s'", remoteName );
+	DL_AddTransfer( localName, remoteName, pakName );
+}
+
+/*
+===============
+DL_CancelDownload
+
+For a file that comes some other way
+===============
+*/
+void DL_CancelDownload( const char *localName )
+{
+	dlTransfer_t *transfer = DL_FindTransfer( localName );
+
+	if ( !transfer || transfer == dl_current )
 	{
-		Log::Debug( "DL_DownloadLoop: request terminated with failure status '%s'", err );
-		return dlStatus_t::DL_FAILED;
+		return;
+	}
+
+	DL_StopTransfer( *transfer );
+	dl_transfers.remove_if( [transfer]( const dlTransfer_t &other ) { return &other == transfer; } );
+}
+
+// (maybe this should be CL_DL_DownloadLoop)
+dlStatus_t DL_DownloadLoop()
+{
+	CURLMsg *msg;
+	int     running = 0;
+	int     left;
+
+	if ( !dl_current )
+	{
+		Log::Debug( "DL_DownloadLoop: unexpected call without a download" );
+		return dlStatus_t::DL_DONE;
 	}
 
-	return dlStatus_t::DL_DONE;
+	curl_multi_perform( dl_multi, &running );
+
+	while ( ( msg = curl_multi_info_read( dl_multi, &left ) ) )
+	{
+		if ( msg->msg != CURLMSG_DONE )
+		{
+			continue;
+		}
+
+		// msg doesn't survive removing the handle
+		CURL     *request = msg->easy_handle;
+		CURLcode result = msg->data.result;
+
+		for ( dlTransfer_t &transfer : dl_transfers )
+		{
+			if ( transfer.request == request )
+			{
+				DL_FinishTransfer( transfer, result );
+				break;
+			}
+		}
+	}
+
+	// start queued downloads in the slots that are free
+	running = 0;
+
+	for ( const dlTransfer_t &transfer : dl_transfers )
+	{
+		running += transfer.request != nullptr;
+	}
+
+	for ( dlTransfer_t &transfer : dl_transfers )
+	{
+		if ( running >= cl_dlMaxTransfers.Get() )
+		{
+			break;
+		}
+
+		if ( !transfer.request && transfer.status == dlStatus_t::DL_CONTINUE && DL_StartTransfer( transfer ) )
+		{
+			running++;
+		}
+	}
+
+	dlStatus_t status = dl_current->status;
+
+	if ( status == dlStatus_t::DL_CONTINUE )
+	{
+		return status;
+	}
+
+	// the caller renames or discards the file
+	dl_transfers.remove_if( []( const dlTransfer_t &transfer ) { return &transfer == dl_current; } );
+	dl_current = nullptr;
+
+	Cvar_Set( "ui_dl_running", "0" );
+
+	return status;
 }
@@ -34,6 +34,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "qcommon/qcommon.h"
 #include "qcommon/cvar.h"
 
+#include <thread>
+
 //TODO: thread safety (not possible with the C API that doesn't care at all about this)
 
 int cvar_modifiedFlags;
@@ -48,13 +50,64 @@ namespace Cvar {
         std::string description;
         CvarProxy* proxy;
         cvar_t ccvar; // The state of the cvar_t used to emulate the C API
-        //DO: mutex?
+        SnapshotHandle snapshot; // The value as seen by other threads
 
         inline bool IsArchived() const {
             return (flags & USER_ARCHIVE) && !(flags & TEMPORARY);
         }
     };
 
+    static std::atomic<uint64_t> snapshotGeneration(0);
+
+    void SnapshotHandle::Publish(std::unique_ptr<const Snapshot> newSnapshot) {
+        const Snapshot* old = current.exchange(newSnapshot.release());
+
+        if (old) {
+            retired.emplace_back(old);
+        }
+
+        // A reader counts itself in before it loads the pointer, so once
+        // the count is seen at zero after the exchange, every reader that
+        // could have loaded a retired snapshot is done with it. Otherwise
+        // they are freed by a later Publish.
+        if (readers.load() == 0) {
+            retired.clear();
+        }
+    }
+
+    // Parses the current value of the cvar_t once and publishes it for other threads
+    static void PublishSnapshot(cvarRecord_t& cvar) {
+        cvar_t& var = cvar.ccvar;
+        std::unique_ptr<Snapshot> snapshot(new Snapshot());
+
+        snapshot->string = var.string;
+        snapshot->value = atof(var.string);
+        snapshot->integer = atoi(var.string);
+
+        if (!ParseCvarValue(snapshot->string, snapshot->boolean)) {
+            snapshot->boolean = snapshot->integer != 0;
+        }
+
+        const char* text = var.string;
+        char* end;
+        for (float number = strtof(text, &end); end != text; number = strtof(text, &end)) {
+            snapshot->vector.push_back(number);
+            text = end;
+        }
+
+        // Snapshots are only published from the main thread. The global
+        // generation is bumped after the swap so that a reader seeing the new
+        // generation is guaranteed to also see the new snapshot.
+        uint64_t generation = snapshotGeneration.load() + 1;
+        snapshot->generation = generation;
+
+        var.value = snapshot->value;
+        var.integer = snapshot->integer;
+        cvar.snapshot.Publish(std::move(snapshot));
+
+        snapshotGeneration.store(generation);
+    }
+
     //Functions that emulate the C API
     void SetCStyleDescription(cvarRecord_t& cvar) {
         if (cvar.proxy) {
@@ -104,8 +157,7 @@ namespace Cvar {
 
         var.modified = modified;
         var.modificationCount++;
-        var.value = atof(var.string);
-        var.integer = atoi(var.string);
+        PublishSnapshot(cvar);
 
         if (modified) {
             cvar_modifiedFlags |= var.flags;
@@ -148,8 +200,7 @@ namespace Cvar {
 
         var.modified |= modified;
         var.modificationCount++;
-        var.value = atof(var.string);
-        var.integer = atoi(var.string);
+        PublishSnapshot(cvar);
 
         if (modified) {
             cvar_modifiedFlags |= var.flags;
@@ -238,7 +289,7 @@ namespace Cvar {
             }
 
             //The user creates a new cvar through a command.
-            cvars[cvarName] = new cvarRecord_t{value, value, flags | CVAR_USER_CREATED, "user created", nullptr, {}};
+            cvars[cvarName] = new cvarRecord_t{value, value, flags | CVAR_USER_CREATED, "user created", nullptr, {}, {}};
             Cmd::AddCommand(cvarName, cvarCommand, "cvar - user created");
             GetCCvar(cvarName, *cvars[cvarName]);
 
@@ -320,7 +371,7 @@ namespace Cvar {
             }
 
             //Create the cvar and parse its default value
-            cvar = new cvarRecord_t{defaultValue, defaultValue, flags, description, proxy, {}};
+            cvar = new cvarRecord_t{defaultValue, defaultValue, flags, description, proxy, {}, {}};
             cvars[name] = cvar;
 
             Cmd::AddCommand(name, cvarCommand, "cvar - \"" + defaultValue + "\" - " + description);
@@ -374,6 +425,21 @@ namespace Cvar {
         } //TODO else what?
     }
 
+    const SnapshotHandle* GetSnapshotHandle(const std::string& cvarName) {
+        CvarMap& cvars = GetCvarMap();
+
+        auto it = cvars.find(cvarName);
+        if (it != cvars.end()) {
+            return &it->second->snapshot;
+        }
+
+        return nullptr;
+    }
+
+    uint64_t GetGeneration() {
+        return snapshotGeneration.load();
+    }
+
     Cmd::CompletionResult Complete(Str::StringRef prefix) {
         CvarMap& cvars = GetCvarMap();
 
@@ -733,4 +799,71 @@ namespace Cvar {
     };
     static ListCvars ListCvarsRegistration;
 
+    // Sets a cvar from the main thread while other threads read its snapshots
+    // as fast as they can, every snapshot must be consistent and they must
+    // come in order. Meant to be run under a thread sanitizer.
+    class CvarStressTestCmd: public Cmd::StaticCmd {
+        public:
+            CvarStressTestCmd(): Cmd::StaticCmd("cvarStressTest", Cmd::BASE, "sets a cvar while other threads read it") {
+            }
+
+            void Run(const Cmd::Args& args) const OVERRIDE {
+                int numSets = 100000;
+                int numReaders = 4;
+
+                if (args.Argc() > 3 || (args.Argc() > 1 && !Str::ParseInt(numSets, args.Argv(1)))
+                        || (args.Argc() > 2 && !Str::ParseInt(numReaders, args.Argv(2)))) {
+                    PrintUsage(args, "[sets] [reader threads]", "sets a cvar while other threads read it");
+                    return;
+                }
+
+                const std::string name = "cvar_stressTest";
+                SetValue(name, "0");
+
+                const SnapshotHandle* handle = GetSnapshotHandle(name);
+                std::atomic<bool> done(false);
+                std::atomic<int> errors(0);
+                std::atomic<uint64_t> reads(0);
+                std::vector<std::thread> readers;
+
+                for (int i = 0; i < std::max(numReaders, 1); i++) {
+                    readers.emplace_back([handle, &done, &errors, &reads] {
+                        uint64_t lastGeneration = 0;
+                        int lastValue = 0;
+                        uint64_t count = 0;
+
+                        while (!done.load(std::memory_order_relaxed)) {
+                            SnapshotHandle::Reference snapshot = handle->Get();
+
+                            if (snapshot->string != std::to_string(snapshot->integer)
+                                    || snapshot->vector.size() != 1 || snapshot->vector[0] != snapshot->value
+                                    || snapshot->generation < lastGeneration || snapshot->integer < lastValue) {
+                                errors++;
+                            }
+
+                            lastGeneration = snapshot->generation;
+                            lastValue = snapshot->integer;
+                            count++;
+                        }
+
+                        reads += count;
+                    });
+                }
+
+                for (int i = 1; i <= numSets; i++) {
+                    SetValue(name, std::to_string(i));
+                }
+
+                done = true;
+
+                for (std::thread& reader : readers) {
+                    reader.join();
+                }
+
+                Print("%d sets, %llu reads on %d threads, %d errors", numSets,
+                        static_cast<unsigned long long>(reads.load()), static_cast<int>(readers.size()), errors.load());
+            }
+    };
+    static CvarStressTestCmd CvarStressTestCmdRegistration;
+
 }
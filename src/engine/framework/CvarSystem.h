@@ -55,6 +55,10 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  *  fps limit, ...)
  *  - Through SetValue and GetValue when the cvar doesn't belong to
  *  the local code, for example when doing commands (/set ...)
+ *
+ * Both are only safe on the main thread. Other threads (renderer,
+ * audio, ...) should get a SnapshotHandle on the main thread and then
+ * read consistent, already parsed values from it.
  */
 
 //TODO add callbacks for when cvars are modified
@@ -90,6 +94,97 @@ namespace Cvar {
     void SetCheatsAllowed(bool allowed);
     void Shutdown();
 
+    // An immutable copy of a cvar value, parsed once when the value changes.
+    struct Snapshot {
+        std::string string;
+        float value; // as atof
+        int integer; // as atoi
+        bool boolean; // a bool word like "on", or else integer != 0
+        std::vector<float> vector; // the leading whitespace separated numbers
+        uint64_t generation; // increases every time any cvar changes
+    };
+
+    /*
+     * Every cvar publishes a new Snapshot each time its value changes. Get()
+     * can be called from any thread and never blocks on the cvar system: it
+     * loads an atomic pointer and counts the reader in and out of the handle
+     * with two atomic increments, no mutex is involved. A snapshot replaced
+     * on the main thread is only freed once no reader is inside the handle,
+     * so it stays valid for as long as the Reference to it is alive. Compare
+     * the generation of two snapshots to detect a change without looking at
+     * the strings.
+     */
+    class SnapshotHandle {
+        public:
+            class Reference {
+                public:
+                    Reference(Reference&& other): handle(other.handle), snapshot(other.snapshot) {
+                        other.handle = nullptr;
+                    }
+
+                    ~Reference() {
+                        if (handle) {
+                            handle->readers.fetch_sub(1, std::memory_order_release);
+                        }
+                    }
+
+                    Reference(const Reference&) = delete;
+                    Reference& operator=(const Reference&) = delete;
+
+                    const Snapshot* operator->() const {
+                        return snapshot;
+                    }
+
+                    const Snapshot& operator*() const {
+                        return *snapshot;
+                    }
+
+                private:
+                    friend class SnapshotHandle;
+
+                    Reference(const SnapshotHandle* handle)
+                        : handle(handle) {
+                        // counted in before the load, see Publish
+                        handle->readers.fetch_add(1);
+                        snapshot = handle->current.load();
+                    }
+
+                    const SnapshotHandle* handle;
+                    const Snapshot* snapshot;
+            };
+
+            SnapshotHandle(): current(nullptr), readers(0) {
+            }
+
+            SnapshotHandle(const SnapshotHandle&) = delete;
+            SnapshotHandle& operator=(const SnapshotHandle&) = delete;
+
+            ~SnapshotHandle() {
+                delete current.load();
+            }
+
+            // Keep the reference only as long as needed, replaced snapshots
+            // are not freed while any reference to the handle exists.
+            Reference Get() const {
+                return Reference(this);
+            }
+
+            // Main thread only
+            void Publish(std::unique_ptr<const Snapshot> newSnapshot);
+
+        private:
+            std::atomic<const Snapshot*> current;
+            mutable std::atomic<int> readers;
+            std::vector<std::unique_ptr<const Snapshot>> retired; // replaced, maybe still being read
+    };
+
+    // Must be called on the main thread, returns nullptr if the cvar does not
+    // exist. The handle stays valid for the lifetime of the program.
+    const SnapshotHandle* GetSnapshotHandle(const std::string& cvarName);
+
+    // The generation of the latest snapshot, to check if any cvar changed
+    uint64_t GetGeneration();
+
     //Kept as a reference for cvar flags
 
     // Keep
@@ -32,6 +32,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "qcommon/q_shared.h"
 #include "qcommon/qcommon.h"
 #include "LogSystem.h"
+#include "CvarSystem.h"
 
 namespace Log {
 
@@ -107,6 +108,10 @@ namespace Log {
     Cvar::Cvar<std::string> logFileName("logs.logFile.filename", "the name of the logfile", Cvar::NONE, "daemon.log");
     Cvar::Cvar<bool> overwrite("logs.logFile.overwrite", "if true the logfile is deleted at each run else the logs are just appended", Cvar::NONE, true);
     Cvar::Cvar<bool> forceFlush("logs.logFile.forceFlush", "are all the logs flushed immediately (more accurate but slower)", Cvar::NONE, false);
+
+    // Any thread can log, so the target reads useLogFile through its snapshot
+    static std::atomic<const Cvar::SnapshotHandle*> useLogFileSnapshot(nullptr);
+
     class LogFileTarget: public Target {
         public:
             LogFileTarget() {
@@ -115,7 +120,8 @@ namespace Log {
 
             virtual bool Process(const std::vector<Log::Event>& events) OVERRIDE {
                 //If we have no log file drop the events
-                if (not useLogFile.Get()) {
+                const Cvar::SnapshotHandle* active = useLogFileSnapshot.load();
+                if (active and not active->Get()->boolean) {
                     return true;
                 }
 
@@ -135,6 +141,8 @@ namespace Log {
     static LogFileTarget logfile;
 
     void OpenLogFile() {
+        useLogFileSnapshot = Cvar::GetSnapshotHandle("logs.logFile.active");
+
         //If we have no log file do nothing here
         if (not useLogFile.Get()) {
             return;
@@ -0,0 +1,603 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2024, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#include "Profiler.h"
+#include "CommandSystem.h"
+#include "common/FileSystem.h"
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace Profiler {
+
+    std::atomic<bool> recording(false);
+
+    // Zones kept per thread, the oldest ones are overwritten
+    static const uint64_t RING_SIZE = 1 << 16;
+
+    struct zoneEvent_t {
+        const char* name;
+        uint64_t begin;
+        uint64_t end;
+    };
+
+    struct threadBuffer_t {
+        int id;
+        std::string name;
+        std::unique_ptr<zoneEvent_t[]> events;
+        std::atomic<uint64_t> count; // Number of zones written since the recording started
+        std::atomic<bool> writing; // Set while the thread may touch its events
+    };
+
+    // Buffers are never freed so that the zones of finished threads can still be exported
+    static std::mutex threadsLock;
+    static std::vector<std::unique_ptr<threadBuffer_t>> threads;
+    static thread_local threadBuffer_t* threadBuffer;
+    static uint64_t recordingStart;
+
+    static threadBuffer_t* GetThreadBuffer() {
+        if (!threadBuffer) {
+            std::unique_ptr<threadBuffer_t> buffer(new threadBuffer_t);
+            buffer->events.reset(new zoneEvent_t[RING_SIZE]);
+            buffer->count = 0;
+            buffer->writing = false;
+
+            std::lock_guard<std::mutex> lock(threadsLock);
+            buffer->id = threads.size() + 1;
+            threadBuffer = buffer.get();
+            threads.push_back(std::move(buffer));
+        }
+
+        return threadBuffer;
+    }
+
+    uint64_t Now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Sys::SteadyClock::now().time_since_epoch()).count();
+    }
+
+    void Record(const char* name, uint64_t begin) {
+        uint64_t end = Now();
+        threadBuffer_t* buffer = GetThreadBuffer();
+
+        // Stop() clears recording and then waits for writing to be cleared,
+        // both sequentially consistent, so no zone is written once it returns.
+        buffer->writing.store(true);
+
+        if (recording.load()) {
+            uint64_t count = buffer->count.load(std::memory_order_relaxed);
+            buffer->events[count % RING_SIZE] = {name, begin, end};
+            buffer->count.store(count + 1, std::memory_order_relaxed);
+        }
+
+        buffer->writing.store(false, std::memory_order_release);
+    }
+
+    void SetThreadName(const char* name) {
+        threadBuffer_t* buffer = GetThreadBuffer();
+
+        std::lock_guard<std::mutex> lock(threadsLock);
+        buffer->name = name;
+    }
+
+#ifdef USE_PROFILER
+    // Frames left to record for "profile check", 0 when no check is running
+    static int checkFrames;
+    static int checkFramesLeft;
+
+    static void RunCheck();
+
+    void NewFrame() {
+        if (checkFramesLeft > 0 and --checkFramesLeft == 0) {
+            RunCheck();
+        }
+    }
+
+    static void Start() {
+        std::lock_guard<std::mutex> lock(threadsLock);
+
+        for (auto& buffer : threads) {
+            buffer->count.store(0, std::memory_order_relaxed);
+        }
+
+        recordingStart = Now();
+        recording.store(true);
+    }
+
+    static void Stop() {
+        recording.store(false);
+
+        std::lock_guard<std::mutex> lock(threadsLock);
+
+        for (auto& buffer : threads) {
+            while (buffer->writing.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // Writes the recorded zones in the Chrome trace event format
+    static bool Export(Str::StringRef path, int& numZones, bool& overflowed) {
+        std::string json = "{\"traceEvents\":[\n";
+        const char* separator = "";
+
+        numZones = 0;
+        overflowed = false;
+
+        std::unique_lock<std::mutex> lock(threadsLock);
+
+        for (auto& buffer : threads) {
+            if (!buffer->name.empty()) {
+                json += Str::Format("%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                        separator, buffer->id, buffer->name);
+                separator = ",\n";
+            }
+
+            uint64_t count = buffer->count.load(std::memory_order_relaxed);
+            uint64_t first = 0;
+
+            if (count > RING_SIZE) {
+                first = count - RING_SIZE;
+                overflowed = true;
+            }
+
+            for (uint64_t i = first; i < count; i++) {
+                const zoneEvent_t& event = buffer->events[i % RING_SIZE];
+
+                // Zones that started before the recording would have a negative timestamp
+                if (event.begin < recordingStart) {
+                    continue;
+                }
+
+                json += Str::Format("%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                        separator, event.name, buffer->id, (event.begin - recordingStart) / 1000.0, (event.end - event.begin) / 1000.0);
+                separator = ",\n";
+                numZones++;
+            }
+        }
+
+        lock.unlock();
+
+        json += "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+        try {
+            FS::File file = FS::HomePath::OpenWrite(path);
+            file.Write(json.data(), json.size());
+            file.Close();
+        } catch (std::system_error& err) {
+            Log::Warn("Couldn't write %s: %s", path, err.what());
+            return false;
+        }
+
+        return true;
+    }
+
+    // Minimal JSON reader, only used to check the exported traces
+    struct jsonValue_t {
+        enum type_t {NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT};
+
+        type_t type = NUL;
+        double number = 0.0;
+        std::string string;
+        std::vector<std::string> keys; // For objects, the values are in items
+        std::vector<jsonValue_t> items;
+
+        const jsonValue_t* Get(Str::StringRef key, type_t wanted) const {
+            for (size_t i = 0; i < keys.size(); i++) {
+                if (keys[i] == key) {
+                    return items[i].type == wanted ? &items[i] : nullptr;
+                }
+            }
+            return nullptr;
+        }
+    };
+
+    class JsonReader {
+        public:
+            explicit JsonReader(std::string text): text(std::move(text)), pos(0) {
+            }
+
+            // Fails on anything that is not exactly one JSON value
+            bool Read(jsonValue_t& value) {
+                if (not ReadValue(value, 0)) {
+                    return false;
+                }
+                SkipSpace();
+                return pos == text.size();
+            }
+
+        private:
+            static const int MAX_DEPTH = 64;
+
+            std::string text;
+            size_t pos;
+
+            void SkipSpace() {
+                while (pos < text.size() and (text[pos] == ' ' or text[pos] == '\t' or text[pos] == '\n' or text[pos] == '\r')) {
+                    pos++;
+                }
+            }
+
+            bool Consume(char c) {
+                SkipSpace();
+                if (pos < text.size() and text[pos] == c) {
+                    pos++;
+                    return true;
+                }
+                return false;
+            }
+
+            bool ReadDigits() {
+                size_t start = pos;
+                while (pos < text.size() and Str::cisdigit(text[pos])) {
+                    pos++;
+                }
+                return pos != start;
+            }
+
+            bool ReadNumber(double& number) {
+                size_t start = pos;
+
+                if (pos < text.size() and text[pos] == '-') {
+                    pos++;
+                }
+                if (pos < text.size() and text[pos] == '0') {
+                    pos++;
+                } else if (not ReadDigits()) {
+                    return false;
+                }
+                if (pos < text.size() and text[pos] == '.') {
+                    pos++;
+                    if (not ReadDigits()) {
+                        return false;
+                    }
+                }
+                if (pos < text.size() and (text[pos] == 'e' or text[pos] == 'E')) {
+                    pos++;
+                    if (pos < text.size() and (text[pos] == '+' or text[pos] == '-')) {
+                        pos++;
+                    }
+                    if (not ReadDigits()) {
+                        return false;
+                    }
+                }
+
+                number = atof(text.substr(start, pos - start).c_str());
+                return true;
+            }
+
+            bool ReadString(std::string& string) {
+                if (not Consume('"')) {
+                    return false;
+                }
+
+                while (pos < text.size()) {
+                    char c = text[pos++];
+
+                    if (c == '"') {
+                        return true;
+                    } else if (static_cast<unsigned char>(c) < 0x20) {
+                        return false;
+                    } else if (c != '\\') {
+                        string += c;
+                        continue;
+                    }
+
+                    if (pos == text.size()) {
+                        return false;
+                    }
+
+                    switch (text[pos++]) {
+                        case '"': string += '"'; break;
+                        case '\\': string += '\\'; break;
+                        case '/': string += '/'; break;
+                        case 'b': string += '\b'; break;
+                        case 'f': string += '\f'; break;
+                        case 'n': string += '\n'; break;
+                        case 'r': string += '\r'; break;
+                        case 't': string += '\t'; break;
+                        case 'u':
+                            // Zone names are ASCII, the code point itself is not needed
+                            for (int i = 0; i < 4; i++) {
+                                if (pos == text.size() or not isxdigit(static_cast<unsigned char>(text[pos++]))) {
+                                    return false;
+                                }
+                            }
+                            string += '?';
+                            break;
+                        default:
+                            return false;
+                    }
+                }
+
+                return false;
+            }
+
+            bool ReadLiteral(const char* literal) {
+                size_t length = strlen(literal);
+                if (text.compare(pos, length, literal) == 0) {
+                    pos += length;
+                    return true;
+                }
+                return false;
+            }
+
+            bool ReadValue(jsonValue_t& value, int depth) {
+                SkipSpace();
+
+                if (pos == text.size() or depth > MAX_DEPTH) {
+                    return false;
+                }
+
+                switch (text[pos]) {
+                    case '{':
+                        pos++;
+                        value.type = jsonValue_t::OBJECT;
+                        if (Consume('}')) {
+                            return true;
+                        }
+                        do {
+                            value.keys.emplace_back();
+                            value.items.emplace_back();
+                            if (not ReadString(value.keys.back()) or not Consume(':') or not ReadValue(value.items.back(), depth + 1)) {
+                                return false;
+                            }
+                        } while (Consume(','));
+                        return Consume('}');
+
+                    case '[':
+                        pos++;
+                        value.type = jsonValue_t::ARRAY;
+                        if (Consume(']')) {
+                            return true;
+                        }
+                        do {
+                            value.items.emplace_back();
+                            if (not ReadValue(value.items.back(), depth + 1)) {
+                                return false;
+                            }
+                        } while (Consume(','));
+                        return Consume(']');
+
+                    case '"':
+                        value.type = jsonValue_t::STRING;
+                        return ReadString(value.string);
+
+                    case 't':
+                    case 'f':
+                        value.type = jsonValue_t::BOOLEAN;
+                        value.number = text[pos] == 't';
+                        return ReadLiteral(text[pos] == 't' ? "true" : "false");
+
+                    case 'n':
+                        value.type = jsonValue_t::NUL;
+                        return ReadLiteral("null");
+
+                    default:
+                        value.type = jsonValue_t::NUMBER;
+                        return ReadNumber(value.number);
+                }
+            }
+    };
+
+    struct checkedZone_t {
+        std::string name;
+        double begin;
+        double end;
+    };
+
+    // Reads back an exported trace and checks that it is well-formed and that
+    // the zones of each thread nest, returns the number of errors found.
+    static int CheckTrace(Str::StringRef path, int numFrames, bool overflowed, int& numThreads) {
+        // Timestamps are written with a nanosecond precision
+        const double epsilon = 0.0005;
+        int errors = 0;
+
+        numThreads = 0;
+
+        std::string text;
+        try {
+            FS::File file = FS::HomePath::OpenRead(path);
+            text = file.ReadAll();
+        } catch (std::system_error& err) {
+            Log::Warn("Couldn't read %s: %s", path, err.what());
+            return 1;
+        }
+
+        jsonValue_t root;
+        if (not JsonReader(std::move(text)).Read(root)) {
+            Log::Warn("%s is not valid JSON", path);
+            return 1;
+        }
+
+        const jsonValue_t* events = root.type == jsonValue_t::OBJECT ? root.Get("traceEvents", jsonValue_t::ARRAY) : nullptr;
+        const jsonValue_t* unit = root.type == jsonValue_t::OBJECT ? root.Get("displayTimeUnit", jsonValue_t::STRING) : nullptr;
+
+        if (not events or not unit or unit->string != "ms") {
+            Log::Warn("%s is missing traceEvents or displayTimeUnit", path);
+            return 1;
+        }
+
+        std::map<int, std::vector<checkedZone_t>> zonesByThread;
+        int numFrameZones = 0;
+
+        for (const jsonValue_t& event : events->items) {
+            const jsonValue_t* name = event.Get("name", jsonValue_t::STRING);
+            const jsonValue_t* phase = event.Get("ph", jsonValue_t::STRING);
+            const jsonValue_t* pid = event.Get("pid", jsonValue_t::NUMBER);
+            const jsonValue_t* tid = event.Get("tid", jsonValue_t::NUMBER);
+
+            if (not name or not phase or not pid or not tid) {
+                Log::Warn("Trace event without a name, phase, pid or tid");
+                errors++;
+                continue;
+            }
+
+            if (phase->string == "M") {
+                const jsonValue_t* args = event.Get("args", jsonValue_t::OBJECT);
+
+                if (name->string != "thread_name" or not args or not args->Get("name", jsonValue_t::STRING)) {
+                    Log::Warn("Bad metadata event %s", name->string);
+                    errors++;
+                }
+                continue;
+            }
+
+            const jsonValue_t* ts = event.Get("ts", jsonValue_t::NUMBER);
+            const jsonValue_t* dur = event.Get("dur", jsonValue_t::NUMBER);
+
+            if (phase->string != "X" or not ts or not dur or ts->number < 0.0 or dur->number < 0.0) {
+                Log::Warn("Bad zone event %s", name->string);
+                errors++;
+                continue;
+            }
+
+            if (name->string == "Com_Frame") {
+                numFrameZones++;
+            }
+
+            zonesByThread[static_cast<int>(tid->number)].push_back({name->string, ts->number, ts->number + dur->number});
+        }
+
+        // Zones of a thread are either disjoint or one contains the other
+        for (auto& thread : zonesByThread) {
+            std::vector<checkedZone_t>& zones = thread.second;
+            std::vector<const checkedZone_t*> open;
+
+            std::sort(zones.begin(), zones.end(), [](const checkedZone_t& a, const checkedZone_t& b) {
+                return a.begin < b.begin or (a.begin == b.begin and a.end > b.end);
+            });
+
+            for (const checkedZone_t& zone : zones) {
+                while (not open.empty() and open.back()->end <= zone.begin + epsilon) {
+                    open.pop_back();
+                }
+
+                if (not open.empty() and zone.end > open.back()->end + epsilon) {
+                    Log::Warn("Zone %s at %.3fus overlaps %s on thread %d without nesting in it",
+                            zone.name, zone.begin, open.back()->name, thread.first);
+                    errors++;
+                    continue;
+                }
+
+                open.push_back(&zone);
+            }
+        }
+
+        numThreads = zonesByThread.size();
+
+        // Older frames may have been overwritten
+        if (not overflowed and numFrameZones != numFrames) {
+            Log::Warn("Expected %d Com_Frame zones, found %d", numFrames, numFrameZones);
+            errors++;
+        }
+
+        return errors;
+    }
+
+    static void RunCheck() {
+        const std::string path = "profiles/check.json";
+        int numZones;
+        bool overflowed;
+        int numThreads;
+
+        Stop();
+
+        if (not Export(path, numZones, overflowed)) {
+            Log::Warn("Profiler check failed, the trace couldn't be written");
+            return;
+        }
+
+        int errors = CheckTrace(path, checkFrames, overflowed, numThreads);
+
+        Log::Notice("Profiler check: %d frames, %d zones on %d threads written to %s, %d errors",
+                checkFrames, numZones, numThreads, path, errors);
+    }
+
+    class ProfileCmd: public Cmd::StaticCmd {
+        public:
+            ProfileCmd(): StaticCmd("profile", Cmd::BASE, "records where the time of each frame goes") {
+            }
+
+            void Run(const Cmd::Args& args) const OVERRIDE {
+                int numFrames;
+
+                if (args.Argc() == 3 and args.Argv(1) == "check" and Str::ParseInt(numFrames, args.Argv(2)) and numFrames > 0) {
+                    if (recording.load()) {
+                        Stop();
+                    }
+
+                    // Counted from the next frame so that every one is recorded whole
+                    checkFrames = numFrames;
+                    checkFramesLeft = numFrames + 1;
+                    Start();
+                    Print("Recording %d frames to check the profiler", numFrames);
+
+                    return;
+                }
+
+                // Any other use of the profiler cancels a running check
+                checkFramesLeft = 0;
+
+                if (args.Argc() == 2 and args.Argv(1) == "start") {
+                    if (recording.load()) {
+                        Stop();
+                    }
+
+                    Start();
+                    Print("Recording profiler zones");
+
+                } else if (args.Argc() == 2 and args.Argv(1) == "stop") {
+                    Stop();
+
+                } else if (args.Argc() == 3 and args.Argv(1) == "export") {
+                    std::string path = Str::Format("profiles/%s.json", args.Argv(2));
+                    int numZones;
+                    bool overflowed;
+
+                    Stop();
+
+                    if (Export(path, numZones, overflowed)) {
+                        Print("Wrote %d zones to %s", numZones, path);
+
+                        if (overflowed) {
+                            Print("The oldest zones were overwritten, profile fewer frames to get all of them");
+                        }
+                    }
+
+                } else {
+                    PrintUsage(args, "start | stop | export <name> | check <frames>", "records where the time of each frame goes");
+                }
+            }
+    };
+    static ProfileCmd ProfileCmdRegistration;
+#endif
+}
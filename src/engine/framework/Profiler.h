@@ -0,0 +1,106 @@
+/*
+===========================================================================
+Daemon BSD Source Code
+Copyright (c) 2024, Daemon Developers
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Daemon developers nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL DAEMON DEVELOPERS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+===========================================================================
+*/
+
+#ifndef FRAMEWORK_PROFILER_H_
+#define FRAMEWORK_PROFILER_H_
+
+#include "common/Common.h"
+
+#include <atomic>
+
+/*
+ * Scoped zone profiler.
+ *
+ * PROFILE_ZONE("name") records the time spent until the end of the enclosing
+ * scope. Zones nest, so together they show where a frame goes. Each thread
+ * records into its own ring buffer, and "profile export" writes the recorded
+ * zones of all the threads as a Chrome trace (chrome://tracing, Perfetto).
+ *
+ * Zone names must be string literals or otherwise outlive the recording.
+ * When the engine is built without USE_PROFILER, zones compile to nothing;
+ * when the profiler is not recording they only test a flag.
+ *
+ * "profile check <frames>" records that many frames, exports them and reads
+ * the trace back to check its format and that the zones of each thread nest.
+ * It runs headless, e.g. on a dedicated server started with +profile check 100.
+ */
+
+namespace Profiler {
+
+    extern std::atomic<bool> recording;
+
+    uint64_t Now();
+    void Record(const char* name, uint64_t begin);
+
+    // Names the calling thread in the exported trace
+    void SetThreadName(const char* name);
+
+    // Called by the main loop before each frame, drives "profile check"
+    void NewFrame();
+
+    class Zone {
+        public:
+            explicit Zone(const char* name) {
+                if (recording.load(std::memory_order_relaxed)) {
+                    this->name = name;
+                    begin = Now();
+                } else {
+                    this->name = nullptr;
+                }
+            }
+
+            ~Zone() {
+                if (name) {
+                    Record(name, begin);
+                }
+            }
+
+            Zone(const Zone&) = delete;
+            Zone& operator=(const Zone&) = delete;
+
+        private:
+            const char* name;
+            uint64_t begin;
+    };
+}
+
+#ifdef USE_PROFILER
+#define PROFILE_ZONE_CONCAT2(a, b) a ## b
+#define PROFILE_ZONE_CONCAT(a, b) PROFILE_ZONE_CONCAT2(a, b)
+#define PROFILE_ZONE(name) Profiler::Zone PROFILE_ZONE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_THREAD(name) Profiler::SetThreadName(name)
+#define PROFILE_FRAME() Profiler::NewFrame()
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_THREAD(name)
+#define PROFILE_FRAME()
+#endif
+
+#endif // FRAMEWORK_PROFILER_H_
@@ -145,7 +145,14 @@ bool RE_LoadDynamicShader( const char*, const char* )
 	return true;
 }
 void RE_Finish() { }
-void RE_TakeVideoFrame( int, int, byte*, byte*, bool ) { }
+bool RE_TakeVideoFrame( int, int, byte*, int )
+{
+	return false;
+}
+int RE_SaveJPGToBuffer( byte*, size_t, int, int, int, byte* )
+{
+	return 0;
+}
 void RE_AddRefLightToScene( const refLight_t* ) { }
 int RE_RegisterAnimation( const char* )
 {
@@ -164,6 +171,14 @@ int RE_BlendSkeleton( refSkeleton_t*, const refSkeleton_t*, float )
 {
 	return 1;
 }
+void RE_BuildSkeletons( const refSkeletonJob_t*, int numJobs, refSkeleton_t *skels, int *results )
+{
+	for ( int i = 0; i < numJobs; i++ )
+	{
+		skels[ i ].numBones = 0;
+		results[ i ] = 1;
+	}
+}
 int RE_BoneIndex( qhandle_t, const char* )
 {
 	return 0;
@@ -287,6 +302,7 @@ refexport_t    *GetRefAPI( int, refimport_t* )
     re.Finish = RE_Finish;
 
     re.TakeVideoFrame = RE_TakeVideoFrame;
+    re.SaveJPGToBuffer = RE_SaveJPGToBuffer;
     re.AddRefLightToScene = RE_AddRefLightToScene;
 
     // RB: alternative skeletal animation system
@@ -294,6 +310,7 @@ refexport_t    *GetRefAPI( int, refimport_t* )
     re.CheckSkeleton = RE_CheckSkeleton;
     re.BuildSkeleton = RE_BuildSkeleton;
     re.BlendSkeleton = RE_BlendSkeleton;
+    re.BuildSkeletons = RE_BuildSkeletons;
     re.BoneIndex = RE_BoneIndex;
     re.AnimNumFrames = RE_AnimNumFrames;
     re.AnimFrameRate = RE_AnimFrameRate;
@@ -47,6 +47,7 @@ Maryland 20850 USA.
 #include "framework/CvarSystem.h"
 #include "framework/ConsoleHistory.h"
 #include "framework/LogSystem.h"
+#include "framework/Profiler.h"
 #include "framework/System.h"
 #include <common/FileSystem.h>
 
@@ -325,30 +326,25 @@ bool Com_ServerRunning()
 Goals:
         reproducable without history effects -- no out of memory errors on weird map to map changes
         allow restarting of the client without fragmentation
-        minimize total pages in use at run time
-        minimize total pages needed during load time
+        grow on demand instead of requiring every server to reserve for the biggest map
+        allow asset loading from several threads
 
-  Single block of memory with stack allocators coming from both ends towards the middle.
+  The hunk is a list of chunks that are filled in order by a stack allocator.
+  The first chunk is com_hunkMegs big, when it is full more chunks are added so
+  that running out of hunk memory is never an error.
 
-  One side is designated the temporary memory allocator.
+  Every permanent allocation is tagged with the subsystem that made it, meminfo
+  reports the memory used by each tag and its highwater mark.
 
-  Temporary memory can be allocated and freed in any order.
+  Any thread can allocate from the hunk, which is protected by a mutex. Threads
+  doing many allocations can use a hunkSubArena_t, which reserves blocks of the
+  hunk and allocates from them without taking the lock.
 
-  A highwater mark is kept of the most in use at any time.
+  A mark can be set to free everything allocated after it, for example to
+  restart the renderer without reloading the game.
 
-  When there is no temporary memory allocated, the permanent and temp sides
-  can be switched, allowing the already touched temp memory to be used for
-  permanent storage.
-
-  Temp memory must never be allocated on two ends at once, or fragmentation
-  could occur.
-
-  If we have any in-use temp memory, additional temp allocations must come from
-  that side.
-
-  If not, we can choose to make either side the new temp side and push future
-  permanent allocations to the other side.  Permanent allocations should be
-  kept on the side that has the current greatest wasted highwater mark.
+  Temporary memory is used to load files. It comes from the heap, so it can be
+  freed in any order, and it is accounted for in meminfo.
 
 ==============================================================================
 */
@@ -356,38 +352,71 @@ Goals:
 static const int HUNK_MAGIC      = 0x89537892;
 static const int HUNK_FREE_MAGIC = 0x89537893;
 
+// Minimum size of the chunks added when the hunk is full
+static const size_t HUNK_CHUNK_SIZE = 32 * 1024 * 1024;
+
+// Size of the blocks reserved by sub-arenas, bigger allocations bypass them
+static const int HUNK_SUBARENA_SIZE = 256 * 1024;
+
+static const int HUNK_NUM_TAGS = Util::ordinal( hunkTag_t::HT_NUM_TAGS );
+
+static const char *const hunkTagNames[ HUNK_NUM_TAGS ] =
+{
+	"misc",
+	"renderer",
+	"bsp",
+	"shaders",
+	"models",
+	"server",
+};
+
 struct hunkHeader_t
 {
 	int magic;
 	int size;
 };
 
-struct hunkUsed_t
+struct hunkChunk_t
 {
-	int mark;
-	int permanent;
-	int temp;
-	int tempHighwater;
+	byte   *data;
+	size_t size;
+	size_t used;
 };
 
-struct hunkblock_t
+// A position in the hunk and the usage of each tag at that point
+struct hunkMark_t
 {
-	int                size;
-	byte               printed;
-	hunkblock_t *next;
-
-	const char         *label;
-	const char         *file;
-	int                line;
+	size_t chunk;
+	size_t offset;
+	size_t used;
+	size_t tagUsed[ HUNK_NUM_TAGS ];
 };
-// for alignment purposes
-#define SIZEOF_HUNKBLOCK_T ( ( sizeof( hunkblock_t ) + 31 ) & ~31 )
 
-static hunkUsed_t  hunk_low, hunk_high;
-static hunkUsed_t  *hunk_permanent, *hunk_temp;
+static std::mutex               hunkMutex;
+static bool                     hunkInitialized = false;
 
-static byte        *s_hunkData = nullptr;
-static int         s_hunkTotal;
+// The chunks after the current one are always empty
+static std::vector<hunkChunk_t> hunkChunks;
+static size_t                   hunkCurrentChunk;
+static hunkMark_t               hunkMark;
+
+static size_t                   hunkUsed, hunkHighwater;
+static size_t                   hunkTagUsed[ HUNK_NUM_TAGS ];
+static size_t                   hunkTagHighwater[ HUNK_NUM_TAGS ];
+
+static size_t                   hunkTempUsed, hunkTempHighwater;
+static int                      hunkTempBlocks;
+
+// com_hunkused is only set from the thread that initialized the hunk
+static std::thread::id          hunkMainThread;
+
+// Changed when the memory reserved by sub-arenas must not be used anymore
+static std::atomic<int>         hunkGeneration;
+
+static float Hunk_Megs( size_t bytes )
+{
+	return bytes / Square( 1024.f );
+}
 
 /*
 =================
@@ -396,45 +425,33 @@ Com_Meminfo_f
 */
 void Com_Meminfo_f()
 {
-	Log::Notice( "%9i bytes (%6.2f MB) total hunk\n", s_hunkTotal, s_hunkTotal / Square( 1024.f ) );
-	Log::Notice( "\n" );
-	Log::Notice( "%9i bytes (%6.2f MB) low mark\n", hunk_low.mark, hunk_low.mark / Square( 1024.f ) );
-	Log::Notice( "%9i bytes (%6.2f MB) low permanent\n", hunk_low.permanent, hunk_low.permanent / Square( 1024.f ) );
-
-	if ( hunk_low.temp != hunk_low.permanent )
-	{
-		Log::Notice( "%9i bytes (%6.2f MB) low temp\n", hunk_low.temp, hunk_low.temp / Square( 1024.f ) );
-	}
+	std::lock_guard<std::mutex> lock( hunkMutex );
 
-	Log::Notice( "%9i bytes (%6.2f MB) low tempHighwater\n", hunk_low.tempHighwater, hunk_low.tempHighwater / Square( 1024.f ) );
-	Log::Notice( "\n" );
-	Log::Notice( "%9i bytes (%6.2f MB) high mark\n", hunk_high.mark, hunk_high.mark / Square( 1024.f ) );
-	Log::Notice( "%9i bytes (%6.2f MB) high permanent\n", hunk_high.permanent, hunk_high.permanent / Square( 1024.f ) );
+	size_t total = 0;
 
-	if ( hunk_high.temp != hunk_high.permanent )
+	for ( const hunkChunk_t &chunk : hunkChunks )
 	{
-		Log::Notice( "%9i bytes (%6.2f MB) high temp\n", hunk_high.temp, hunk_high.temp / Square( 1024.f ) );
+		total += chunk.size;
 	}
 
-	Log::Notice( "%9i bytes (%6.2f MB) high tempHighwater\n", hunk_high.tempHighwater, hunk_high.tempHighwater / Square( 1024.f ) );
+	Log::Notice( "%9i bytes (%6.2f MB) total hunk in %i chunks\n", total, Hunk_Megs( total ), hunkChunks.size() );
+	Log::Notice( "%9i bytes (%6.2f MB) mark\n", hunkMark.used, Hunk_Megs( hunkMark.used ) );
+	Log::Notice( "%9i bytes (%6.2f MB) total hunk in use\n", hunkUsed, Hunk_Megs( hunkUsed ) );
+	Log::Notice( "%9i bytes (%6.2f MB) highwater\n", hunkHighwater, Hunk_Megs( hunkHighwater ) );
 	Log::Notice( "\n" );
-	Log::Notice( "%9i bytes (%6.2f MB) total hunk in use\n", hunk_low.permanent + hunk_high.permanent,
-	            ( hunk_low.permanent + hunk_high.permanent ) / Square( 1024.f ) );
-	int unused = 0;
-
-	if ( hunk_low.tempHighwater > hunk_low.permanent )
-	{
-		unused += hunk_low.tempHighwater - hunk_low.permanent;
-	}
 
-	if ( hunk_high.tempHighwater > hunk_high.permanent )
+	for ( int i = 0; i < HUNK_NUM_TAGS; i++ )
 	{
-		unused += hunk_high.tempHighwater - hunk_high.permanent;
+		Log::Notice( "%9i bytes (%6.2f MB) %-8s highwater %9i bytes (%6.2f MB)\n", hunkTagUsed[ i ], Hunk_Megs( hunkTagUsed[ i ] ),
+		             hunkTagNames[ i ], hunkTagHighwater[ i ], Hunk_Megs( hunkTagHighwater[ i ] ) );
 	}
 
-	Log::Notice( "%9i bytes (%6.2f MB) unused highwater\n", unused, unused / Square( 1024.f ) );
+	Log::Notice( "\n" );
+	Log::Notice( "%9i bytes (%6.2f MB) temp in %i blocks\n", hunkTempUsed, Hunk_Megs( hunkTempUsed ), hunkTempBlocks );
+	Log::Notice( "%9i bytes (%6.2f MB) temp highwater\n", hunkTempHighwater, Hunk_Megs( hunkTempHighwater ) );
 }
 
+
 /*
 =================
 Com_Allocate_Aligned
@@ -471,6 +488,29 @@ void Com_Free_Aligned( void *ptr )
 #endif
 }
 
+
+static hunkChunk_t Hunk_NewChunk( size_t size )
+{
+	hunkChunk_t chunk;
+
+	// cacheline aligned
+	chunk.data = ( byte * ) Com_Allocate_Aligned( 64, size );
+
+	if ( !chunk.data )
+	{
+		Com_Error( errorParm_t::ERR_FATAL, "Hunk data failed to allocate %iMB", ( int ) ( size / ( 1024 * 1024 ) ) );
+	}
+
+	chunk.size = size;
+	chunk.used = 0;
+	return chunk;
+}
+
+static void Hunk_UpdateUsedCvar()
+{
+	Cvar_Set( "com_hunkused", va( "%i", com_hunkusedvalue ) );
+}
+
 /*
 =================
 Com_InitHunkMemory
@@ -479,31 +519,46 @@ Com_InitHunkMemory
 void Com_InitHunkMemory()
 {
 	cvar_t *cv;
+	size_t size;
 
-	// allocate the stack based hunk allocator
+	// the size of the first chunk of the hunk
 	cv = Cvar_Get( "com_hunkMegs", XSTRING(DEF_COMHUNKMEGS), CVAR_LATCH  );
 
 	if ( cv->integer < MIN_COMHUNKMEGS )
 	{
-		s_hunkTotal = 1024 * 1024 * MIN_COMHUNKMEGS;
+		size = 1024 * 1024 * MIN_COMHUNKMEGS;
 		Log::Notice( "Minimum com_hunkMegs is " XSTRING(MIN_COMHUNKMEGS) ", allocating " XSTRING(MIN_COMHUNKMEGS) "MB." );
 	}
 	else
 	{
-		s_hunkTotal = cv->integer * 1024 * 1024;
+		size = size_t( cv->integer ) * 1024 * 1024;
 	}
 
-	// cacheline aligned
-	s_hunkData = ( byte * ) Com_Allocate_Aligned( 64, s_hunkTotal );
+	hunkChunks.push_back( Hunk_NewChunk( size ) );
+	hunkInitialized = true;
+	hunkMainThread = std::this_thread::get_id();
+
+	Hunk_Clear();
 
-	if ( !s_hunkData )
+	Cmd_AddCommand( "meminfo", Com_Meminfo_f );
+}
+
+// Frees everything allocated after the mark, the lock must be held
+static void Hunk_ResetToMark()
+{
+	for ( size_t i = hunkMark.chunk + 1; i < hunkChunks.size(); i++ )
 	{
-		Com_Error( errorParm_t::ERR_FATAL, "Hunk data failed to allocate %iMB", s_hunkTotal / ( 1024 * 1024 ) );
+		hunkChunks[ i ].used = 0;
 	}
 
-	Hunk_Clear();
+	hunkChunks[ hunkMark.chunk ].used = hunkMark.offset;
+	hunkCurrentChunk = hunkMark.chunk;
 
-	Cmd_AddCommand( "meminfo", Com_Meminfo_f );
+	hunkUsed = hunkMark.used;
+	std::copy_n( hunkMark.tagUsed, HUNK_NUM_TAGS, hunkTagUsed );
+	com_hunkusedvalue = hunkUsed;
+
+	hunkGeneration++;
 }
 
 /*
@@ -515,8 +570,19 @@ The server calls this after the level and game VM have been loaded
 */
 void Hunk_SetMark()
 {
-	hunk_low.mark = hunk_low.permanent;
-	hunk_high.mark = hunk_high.permanent;
+	{
+		std::lock_guard<std::mutex> lock( hunkMutex );
+
+		hunkMark.chunk = hunkCurrentChunk;
+		hunkMark.offset = hunkChunks[ hunkCurrentChunk ].used;
+		hunkMark.used = hunkUsed;
+		std::copy_n( hunkTagUsed, HUNK_NUM_TAGS, hunkMark.tagUsed );
+
+		// sub-arenas must not keep allocating from blocks below the mark
+		hunkGeneration++;
+	}
+
+	Hunk_UpdateUsedCvar();
 }
 
 /*
@@ -528,8 +594,12 @@ The client calls this before starting a vid_restart or snd_restart
 */
 void Hunk_ClearToMark()
 {
-	hunk_low.permanent = hunk_low.temp = hunk_low.mark;
-	hunk_high.permanent = hunk_high.temp = hunk_high.mark;
+	{
+		std::lock_guard<std::mutex> lock( hunkMutex );
+		Hunk_ResetToMark();
+	}
+
+	Hunk_UpdateUsedCvar();
 }
 
 void SV_ShutdownGameProgs();
@@ -550,43 +620,65 @@ void Hunk_Clear()
 #ifdef BUILD_CLIENT
 	CIN_CloseAllVideos();
 #endif
-	hunk_low.mark = 0;
-	hunk_low.permanent = 0;
-	hunk_low.temp = 0;
-	hunk_low.tempHighwater = 0;
+	{
+		std::lock_guard<std::mutex> lock( hunkMutex );
 
-	hunk_high.mark = 0;
-	hunk_high.permanent = 0;
-	hunk_high.temp = 0;
-	hunk_high.tempHighwater = 0;
+		hunkMark = {};
+		Hunk_ResetToMark();
+
+		// give back the chunks added for a big map, the first one is never moved
+		for ( size_t i = 1; i < hunkChunks.size(); i++ )
+		{
+			Com_Free_Aligned( hunkChunks[ i ].data );
+		}
 
-	hunk_permanent = &hunk_low;
-	hunk_temp = &hunk_high;
+		hunkChunks.resize( 1 );
+	}
 
-	Cvar_Set( "com_hunkused", va( "%i", hunk_low.permanent + hunk_high.permanent ) );
-	com_hunkusedvalue = hunk_low.permanent + hunk_high.permanent;
+	Hunk_UpdateUsedCvar();
 
 	Log::Debug( "Hunk_Clear: reset the hunk ok" );
 }
 
-static void Hunk_SwapBanks()
+// Returns size bytes of permanent memory, the lock must be held
+static byte *Hunk_AllocLocked( size_t size, hunkTag_t tag )
 {
-	hunkUsed_t *swap;
+	hunkChunk_t *chunk = &hunkChunks[ hunkCurrentChunk ];
 
-	// can't swap banks if there is any temp already allocated
-	if ( hunk_temp->temp != hunk_temp->permanent )
+	if ( chunk->used + size > chunk->size )
 	{
-		return;
-	}
+		// use the first following chunk that is big enough or add one
+		size_t next = hunkCurrentChunk + 1;
+		size_t found = next;
 
-	// if we have a larger highwater mark on this side, start making
-	// our permanent allocations here and use the other side for temp
-	if ( hunk_temp->tempHighwater - hunk_temp->permanent > hunk_permanent->tempHighwater - hunk_permanent->permanent )
-	{
-		swap = hunk_temp;
-		hunk_temp = hunk_permanent;
-		hunk_permanent = swap;
+		while ( found < hunkChunks.size() && hunkChunks[ found ].size < size )
+		{
+			found++;
+		}
+
+		if ( found == hunkChunks.size() )
+		{
+			hunkChunks.push_back( Hunk_NewChunk( std::max( size, HUNK_CHUNK_SIZE ) ) );
+			Log::Debug( "Hunk_Alloc: added chunk %i for %i bytes", found, size );
+		}
+
+		std::swap( hunkChunks[ next ], hunkChunks[ found ] );
+		hunkCurrentChunk = next;
+		chunk = &hunkChunks[ next ];
 	}
+
+	byte *buf = chunk->data + chunk->used;
+	chunk->used += size;
+
+	int index = Util::ordinal( tag );
+	hunkTagUsed[ index ] += size;
+	hunkTagHighwater[ index ] = std::max( hunkTagHighwater[ index ], hunkTagUsed[ index ] );
+
+	hunkUsed += size;
+	hunkHighwater = std::max( hunkHighwater, hunkUsed );
+	com_hunkusedvalue = hunkUsed;
+
+	return buf;
 }
 
 /*
@@ -596,47 +688,91 @@ Hunk_Alloc
 Allocate permanent (until the hunk is cleared) memory
 =================
 */
-void           *Hunk_Alloc( int size, ha_pref)
+void           *Hunk_Alloc( int size, hunkTag_t tag )
 {
 	void *buf;
 
-	if ( s_hunkData == nullptr )
+	if ( !hunkInitialized )
 	{
 		Com_Error( errorParm_t::ERR_FATAL, "Hunk_Alloc: Hunk memory system not initialized" );
 	}
 
-	Hunk_SwapBanks();
-
 	// round to cacheline
 	size = ( size + 31 ) & ~31;
 
-	if ( hunk_low.temp + hunk_high.temp + size > s_hunkTotal )
+	int used;
+
 	{
-		Com_Error( errorParm_t::ERR_DROP, "Hunk_Alloc failed on %i", size );
+		std::lock_guard<std::mutex> lock( hunkMutex );
+		buf = Hunk_AllocLocked( size, tag );
+		used = com_hunkusedvalue;
 	}
 
-	if ( hunk_permanent == &hunk_low )
+	// Ridah, update the com_hunkused cvar in increments, so we don't update it too often, since this cvar call isn't very efficent
+	if ( com_hunkused && used > com_hunkused->integer + 2500 && std::this_thread::get_id() == hunkMainThread )
 	{
-		buf = ( void * )( s_hunkData + hunk_permanent->permanent );
-		hunk_permanent->permanent += size;
+		Cvar_Set( "com_hunkused", va( "%i", used ) );
 	}
-	else
+
+	memset( buf, 0, size );
+
+	return buf;
+}
+
+/*
+=================
+Hunk_InitSubArena
+=================
+*/
+void Hunk_InitSubArena( hunkSubArena_t *arena, hunkTag_t tag )
+{
+	arena->base = nullptr;
+	arena->size = 0;
+	arena->used = 0;
+	arena->generation = -1;
+	arena->tag = tag;
+}
+
+/*
+=================
+Hunk_SubArenaAlloc
+
+Allocate permanent memory from a block reserved by the sub-arena,
+the lock is only taken when a new block is needed
+=================
+*/
+void           *Hunk_SubArenaAlloc( hunkSubArena_t *arena, int size )
+{
+	void *buf;
+
+	// round to cacheline
+	size = ( size + 31 ) & ~31;
+
+	// big allocations would waste most of a block
+	if ( size > HUNK_SUBARENA_SIZE / 4 )
 	{
-		hunk_permanent->permanent += size;
-		buf = ( void * )( s_hunkData + s_hunkTotal - hunk_permanent->permanent );
+		return Hunk_Alloc( size, arena->tag );
 	}
 
-	hunk_permanent->temp = hunk_permanent->permanent;
+	if ( arena->generation != hunkGeneration.load( std::memory_order_acquire ) || arena->used + size > arena->size )
+	{
+		if ( !hunkInitialized )
+		{
+			Com_Error( errorParm_t::ERR_FATAL, "Hunk_SubArenaAlloc: Hunk memory system not initialized" );
+		}
 
-	memset( buf, 0, size );
+		std::lock_guard<std::mutex> lock( hunkMutex );
 
-	// Ridah, update the com_hunkused cvar in increments, so we don't update it too often, since this cvar call isn't very efficent
-	if ( ( hunk_low.permanent + hunk_high.permanent ) > com_hunkused->integer + 2500 )
-	{
-		Cvar_Set( "com_hunkused", va( "%i", hunk_low.permanent + hunk_high.permanent ) );
+		arena->base = Hunk_AllocLocked( HUNK_SUBARENA_SIZE, arena->tag );
+		arena->size = HUNK_SUBARENA_SIZE;
+		arena->used = 0;
+		arena->generation = hunkGeneration.load( std::memory_order_relaxed );
 	}
 
-	com_hunkusedvalue = hunk_low.permanent + hunk_high.permanent;
+	buf = arena->base + arena->used;
+	arena->used += size;
+
+	memset( buf, 0, size );
 
 	return buf;
 }
@@ -647,56 +783,32 @@ Hunk_AllocateTempMemory
 
 This is used by the file loading system.
 Multiple files can be loaded in temporary memory.
-When the files-in-use count reaches zero, all temp memory will be deleted
 =================
 */
 void           *Hunk_AllocateTempMemory( int size )
 {
-	void         *buf;
 	hunkHeader_t *hdr;
 
-	// return a Z_Malloc'd block if the hunk has not been initialized
-	// this allows the config and product id files ( journal files too ) to be loaded
-	// by the file system without redundant routines in the file system utilizing different
-	// memory systems
-	if ( s_hunkData == nullptr )
-	{
-		return Z_Malloc( size );
-	}
-
-	Hunk_SwapBanks();
+	hdr = ( hunkHeader_t * ) malloc( sizeof( hunkHeader_t ) + size );
 
-	size = PAD( size, sizeof( intptr_t ) ) + sizeof( hunkHeader_t );
-
-	if ( hunk_temp->temp + hunk_permanent->permanent + size > s_hunkTotal )
+	if ( !hdr )
 	{
 		Com_Error( errorParm_t::ERR_DROP, "Hunk_AllocateTempMemory: failed on %i", size );
 	}
 
-	if ( hunk_temp == &hunk_low )
-	{
-		buf = ( void * )( s_hunkData + hunk_temp->temp );
-		hunk_temp->temp += size;
-	}
-	else
-	{
-		hunk_temp->temp += size;
-		buf = ( void * )( s_hunkData + s_hunkTotal - hunk_temp->temp );
-	}
+	hdr->magic = HUNK_MAGIC;
+	hdr->size = size;
 
-	if ( hunk_temp->temp > hunk_temp->tempHighwater )
 	{
-		hunk_temp->tempHighwater = hunk_temp->temp;
-	}
-
-	hdr = ( hunkHeader_t * ) buf;
-	buf = ( void * )( hdr + 1 );
+		std::lock_guard<std::mutex> lock( hunkMutex );
 
-	hdr->magic = HUNK_MAGIC;
-	hdr->size = size;
+		hunkTempUsed += size;
+		hunkTempHighwater = std::max( hunkTempHighwater, hunkTempUsed );
+		hunkTempBlocks++;
+	}
 
 	// don't bother clearing, because we are going to load a file over it
-	return buf;
+	return hdr + 1;
 }
 
 /*
@@ -708,16 +820,6 @@ void Hunk_FreeTempMemory( void *buf )
 {
 	hunkHeader_t *hdr;
 
-	// free with Z_Free if the hunk has not been initialized
-	// this allows the config and product id files ( journal files too ) to be loaded
-	// by the file system without redundant routines in the file system utilizing different
-	// memory systems
-	if ( s_hunkData == nullptr )
-	{
-		Z_Free( buf );
-		return;
-	}
-
 	hdr = ( ( hunkHeader_t * ) buf ) - 1;
 
 	if ( hdr->magic != (int) HUNK_MAGIC )
@@ -727,30 +829,14 @@ void Hunk_FreeTempMemory( void *buf )
 
 	hdr->magic = HUNK_FREE_MAGIC;
 
-	// this only works if the files are freed in stack order,
-	// otherwise the memory will stay around until Hunk_ClearTempMemory
-	if ( hunk_temp == &hunk_low )
-	{
-		if ( hdr == ( void * )( s_hunkData + hunk_temp->temp - hdr->size ) )
-		{
-			hunk_temp->temp -= hdr->size;
-		}
-		else
-		{
-			Log::Notice( "Hunk_FreeTempMemory: not the final block\n" );
-		}
-	}
-	else
 	{
-		if ( hdr == ( void * )( s_hunkData + s_hunkTotal - hunk_temp->temp ) )
-		{
-			hunk_temp->temp -= hdr->size;
-		}
-		else
-		{
-			Log::Notice( "Hunk_FreeTempMemory: not the final block\n" );
-		}
+		std::lock_guard<std::mutex> lock( hunkMutex );
+
+		hunkTempUsed -= hdr->size;
+		hunkTempBlocks--;
 	}
+
+	free( hdr );
 }
 
 /*
@@ -1209,6 +1295,8 @@ void Com_Init( char *commandLine )
 	char              *s;
 	int               qport;
 
+	PROFILE_THREAD( "main" );
+
 	// prepare enough of the subsystems to handle
 	// cvar and command buffer management
 	Com_ParseCommandLine( commandLine );
@@ -1490,6 +1578,9 @@ static Cvar::Cvar<bool> showTraceStats("common.showTraceStats", "are physics tra
 
 void Com_Frame()
 {
+	PROFILE_FRAME();
+	PROFILE_ZONE( "Com_Frame" );
+
 	int             msec, minMsec;
 	static int      lastTime = 0;
 	//int             key;
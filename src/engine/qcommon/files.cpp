@@ -404,26 +404,35 @@ void FS_WriteFile(const char* path, const void* buffer, int size)
 	}
 }
 
+// Reads the file without going through the handle table so that it can be
+// used from worker threads, e.g. by the image decoders.
 int FS_ReadFile(const char* path, void** buffer)
 {
-	fileHandle_t handle;
-	int length = FS_FOpenFileRead(path, &handle, true);
+	if (buffer)
+		*buffer = nullptr;
 
-	if (length < 0) {
-		if (buffer)
-			*buffer = nullptr;
+	std::error_code err;
+	std::string data;
+	if (FS::PakPath::FileExists(path)) {
+		data = FS::PakPath::ReadFile(path, err);
+	} else {
+		FS::File file = FS::HomePath::OpenRead(path, err);
+		if (!err)
+			data = file.ReadAll(err);
+	}
+	if (err) {
+		Log::Debug("Failed to open '%s' for reading: %s", path, err.message().c_str());
 		return -1;
 	}
 
 	if (buffer) {
-		char* buf = new char[length + 1];
+		char* buf = new char[data.size() + 1];
 		*buffer = buf;
-		FS_Read(buf, length, handle);
-		buf[length] = '\0';
+		memcpy(buf, data.data(), data.size());
+		buf[data.size()] = '\0';
 	}
 
-	FS_FCloseFile(handle);
-	return length;
+	return data.size();
 }
 
 void FS_FreeFile(void* buffer)
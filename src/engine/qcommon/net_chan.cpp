@@ -505,11 +505,24 @@ struct packetQueue_t
 
 packetQueue_t *packetQueue = nullptr;
 
+// Simulates a bad link: drops loss percent of the packets and delays the
+// others by offset milliseconds
 static void NET_QueuePacket( int length, const void *data, netadr_t to,
-                             int offset )
+                             int offset, int loss )
 {
 	packetQueue_t *newp, *next = packetQueue;
 
+	if ( loss > 0 && rand() % 100 < loss )
+	{
+		return;
+	}
+
+	if ( offset <= 0 )
+	{
+		Sys_SendPacket( length, data, to );
+		return;
+	}
+
 	if ( offset > 999 )
 	{
 		offset = 999;
@@ -589,15 +602,15 @@ void NET_SendPacket( netsrc_t sock, int length, const void *data, netadr_t to )
 	}
 
 #ifndef BUILD_SERVER
-	if ( sock == netsrc_t::NS_CLIENT && cl_packetdelay->integer > 0 )
+	if ( sock == netsrc_t::NS_CLIENT && ( cl_packetdelay->integer > 0 || cl_packetloss->integer > 0 ) )
 	{
-		NET_QueuePacket( length, data, to, cl_packetdelay->integer );
+		NET_QueuePacket( length, data, to, cl_packetdelay->integer, cl_packetloss->integer );
 	}
 	else
 #endif
-	if ( sock == netsrc_t::NS_SERVER && sv_packetdelay->integer > 0 )
+	if ( sock == netsrc_t::NS_SERVER && ( sv_packetdelay->integer > 0 || sv_packetloss->integer > 0 ) )
 	{
-		NET_QueuePacket( length, data, to, sv_packetdelay->integer );
+		NET_QueuePacket( length, data, to, sv_packetdelay->integer, sv_packetloss->integer );
 	}
 	else
 	{
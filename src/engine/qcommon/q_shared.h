@@ -229,14 +229,19 @@ using clipHandle_t = int;
 //
 #define MAX_MAP_AREA_BYTES 32 // bit vector of area visibility
 
-	enum class ha_pref
+	// subsystems owning hunk memory, meminfo reports the usage of each of them
+	enum class hunkTag_t
 	{
-	  h_high,
-	  h_low,
-	  h_dontcare
+	  HT_MISC,
+	  HT_RENDERER,
+	  HT_BSP,
+	  HT_SHADERS,
+	  HT_MODELS,
+	  HT_SERVER,
+	  HT_NUM_TAGS
 	};
 
-	void *Hunk_Alloc( int size, ha_pref preference );
+	void *Hunk_Alloc( int size, hunkTag_t tag );
 
 #define Com_Memset   memset
 #define Com_Memcpy   memcpy
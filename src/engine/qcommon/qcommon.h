@@ -224,7 +224,7 @@ const char *NET_GeoIP_Country( const netadr_t *a );
 #define MAX_MSGLEN           32768 // max length of a message, which may
 //#define   MAX_MSGLEN              16384       // max length of a message, which may
 // be fragmented into multiple packets
-#define MAX_DOWNLOAD_WINDOW  8 // max of eight download frames
+#define MAX_DOWNLOAD_WINDOW  32 // blocks in flight, also the size of the selective ack bitmap
 #define MAX_DOWNLOAD_BLKSIZE 2048 // 2048 byte block chunks
 
 /*
@@ -554,7 +554,9 @@ enum class dlStatus_t
   DL_FAILED
 };
 
-int        DL_BeginDownload( const char *localName, const char *remoteName );
+int        DL_BeginDownload( const char *localName, const char *remoteName, const char *pakName );
+void       DL_QueueDownload( const char *localName, const char *remoteName, const char *pakName );
+void       DL_CancelDownload( const char *localName );
 dlStatus_t DL_DownloadLoop();
 
 void       DL_Shutdown();
@@ -653,6 +655,8 @@ extern cvar_t       *sv_paused;
 
 extern cvar_t       *cl_packetdelay;
 extern cvar_t       *sv_packetdelay;
+extern cvar_t       *cl_packetloss;
+extern cvar_t       *sv_packetloss;
 
 // com_speeds times
 extern int          time_game;
@@ -721,8 +725,19 @@ void     Hunk_ClearToMark();
 void     Hunk_SetMark();
 bool Hunk_CheckMark();
 
-//void *Hunk_Alloc( int size );
-// void *Hunk_Alloc( int size, ha_pref preference );
+// Part of the hunk used by a single thread, allocating from it
+// doesn't take the hunk lock most of the time
+struct hunkSubArena_t
+{
+	byte      *base;
+	int       size;
+	int       used;
+	int       generation;
+	hunkTag_t tag;
+};
+
+void   Hunk_InitSubArena( hunkSubArena_t *arena, hunkTag_t tag );
+void   *Hunk_SubArenaAlloc( hunkSubArena_t *arena, int size );
 void   Hunk_ClearTempMemory();
 void   *Hunk_AllocateTempMemory( int size );
 void   Hunk_FreeTempMemory( void *buf );
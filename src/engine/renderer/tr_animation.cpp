@@ -43,7 +43,7 @@ static skelAnimation_t *R_AllocAnimation()
 		return nullptr;
 	}
 
-	anim = (skelAnimation_t*) ri.Hunk_Alloc( sizeof( *anim ), ha_pref::h_low );
+	anim = (skelAnimation_t*) ri.Hunk_Alloc( sizeof( *anim ), hunkTag_t::HT_MODELS );
 	anim->index = tr.numAnimations;
 	tr.animations[ tr.numAnimations ] = anim;
 	tr.numAnimations++;
@@ -81,7 +81,7 @@ static bool R_LoadMD5Anim( skelAnimation_t *skelAnim, void *buffer, const char *
 	buf_p = (char*) buffer;
 
 	skelAnim->type = animType_t::AT_MD5;
-	skelAnim->md5 = anim = (md5Animation_t*) ri.Hunk_Alloc( sizeof( *anim ), ha_pref::h_low );
+	skelAnim->md5 = anim = (md5Animation_t*) ri.Hunk_Alloc( sizeof( *anim ), hunkTag_t::HT_MODELS );
 
 	// skip MD5Version indent string
 	COM_ParseExt2( &buf_p, false );
@@ -167,7 +167,7 @@ static bool R_LoadMD5Anim( skelAnimation_t *skelAnim, void *buffer, const char *
 	}
 
 	// parse all the channels
-	anim->channels = (md5Channel_t*) ri.Hunk_Alloc( sizeof( md5Channel_t ) * anim->numChannels, ha_pref::h_low );
+	anim->channels = (md5Channel_t*) ri.Hunk_Alloc( sizeof( md5Channel_t ) * anim->numChannels, hunkTag_t::HT_MODELS );
 
 	for ( i = 0, channel = anim->channels; i < anim->numChannels; i++, channel++ )
 	{
@@ -218,7 +218,7 @@ static bool R_LoadMD5Anim( skelAnimation_t *skelAnim, void *buffer, const char *
 		return false;
 	}
 
-	anim->frames = (md5Frame_t*) ri.Hunk_Alloc( sizeof( md5Frame_t ) * anim->numFrames, ha_pref::h_low );
+	anim->frames = (md5Frame_t*) ri.Hunk_Alloc( sizeof( md5Frame_t ) * anim->numFrames, hunkTag_t::HT_MODELS );
 
 	for ( i = 0, frame = anim->frames; i < anim->numFrames; i++, frame++ )
 	{
@@ -386,7 +386,7 @@ static bool R_LoadMD5Anim( skelAnimation_t *skelAnim, void *buffer, const char *
 			return false;
 		}
 
-		frame->components = (float*) ri.Hunk_Alloc( sizeof( float ) * anim->numAnimatedComponents, ha_pref::h_low );
+		frame->components = (float*) ri.Hunk_Alloc( sizeof( float ) * anim->numAnimatedComponents, hunkTag_t::HT_MODELS );
 
 		for (unsigned j = 0; j < anim->numAnimatedComponents; j++ )
 		{
@@ -1234,6 +1234,116 @@ int RE_CheckSkeleton( refSkeleton_t *skel, qhandle_t hModel, qhandle_t hAnim )
 	return false;
 }
 
+/*
+==============
+R_LerpTransforms
+
+out[ i ] = the lerp from a[ i ] to b[ i ], the same as TransStartLerp,
+TransAddWeight( 1 - frac, a ), TransAddWeight( frac, b ) and
+TransEndLerp. The arrays are walked with byte strides so that bones can
+be used in place. With SSE, four rotations at a time are transposed to
+SoA so their dot products and normalizations need no shuffles.
+==============
+*/
+template<typename T>
+static inline T *StridedElement( T *base, size_t stride, int i )
+{
+	return reinterpret_cast<T *>( reinterpret_cast<uintptr_t>( base ) + i * stride );
+}
+
+static void R_LerpTransforms( int count, float frac, const transform_t *a, size_t aStride,
+			      const transform_t *b, size_t bStride, transform_t *out, size_t outStride )
+{
+	int i = 0;
+
+#if idx86_sse
+	const __m128 wa = _mm_set1_ps( 1.0f - frac );
+	const __m128 wb = _mm_set1_ps( frac );
+	const __m128 half = _mm_set1_ps( 0.5f );
+	const __m128 three = _mm_set1_ps( 3.0f );
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 sign = sign_XYZW();
+
+	for ( ; i + 4 <= count; i += 4 )
+	{
+		const transform_t *a0 = StridedElement( a, aStride, i ), *a1 = StridedElement( a, aStride, i + 1 );
+		const transform_t *a2 = StridedElement( a, aStride, i + 2 ), *a3 = StridedElement( a, aStride, i + 3 );
+		const transform_t *b0 = StridedElement( b, bStride, i ), *b1 = StridedElement( b, bStride, i + 1 );
+		const transform_t *b2 = StridedElement( b, bStride, i + 2 ), *b3 = StridedElement( b, bStride, i + 3 );
+		transform_t *o[ 4 ] = { StridedElement( out, outStride, i ), StridedElement( out, outStride, i + 1 ),
+		                        StridedElement( out, outStride, i + 2 ), StridedElement( out, outStride, i + 3 ) };
+
+		// x, y, z and w of the four rotations
+		__m128 ax = a0->sseRot, ay = a1->sseRot, az = a2->sseRot, aw = a3->sseRot;
+		__m128 bx = b0->sseRot, by = b1->sseRot, bz = b2->sseRot, bw = b3->sseRot;
+		_MM_TRANSPOSE4_PS( ax, ay, az, aw );
+		_MM_TRANSPOSE4_PS( bx, by, bz, bw );
+
+		// the first TransAddWeight sees a dot product of -0 and negates
+		// a when all of its components are negative, and it adds to
+		// +0; both are kept so the results are the same bit for bit
+		__m128 w = _mm_xor_ps( wa, _mm_and_ps( _mm_and_ps( _mm_and_ps( ax, ay ), _mm_and_ps( az, aw ) ), sign ) );
+
+		ax = _mm_add_ps( zero, _mm_mul_ps( w, ax ) );
+		ay = _mm_add_ps( zero, _mm_mul_ps( w, ay ) );
+		az = _mm_add_ps( zero, _mm_mul_ps( w, az ) );
+		aw = _mm_add_ps( zero, _mm_mul_ps( w, aw ) );
+
+		// take the shorter way around like TransAddWeight
+		__m128 d = _mm_add_ps( _mm_add_ps( _mm_mul_ps( ax, bx ), _mm_mul_ps( ay, by ) ),
+				       _mm_add_ps( _mm_mul_ps( az, bz ), _mm_mul_ps( aw, bw ) ) );
+		w = _mm_xor_ps( wb, _mm_and_ps( d, sign ) );
+
+		__m128 x = _mm_add_ps( ax, _mm_mul_ps( w, bx ) );
+		__m128 y = _mm_add_ps( ay, _mm_mul_ps( w, by ) );
+		__m128 z = _mm_add_ps( az, _mm_mul_ps( w, bz ) );
+		__m128 q = _mm_add_ps( aw, _mm_mul_ps( w, bw ) );
+
+		// same refined rsqrt as sseQuatNormalize
+		__m128 p = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, x ), _mm_mul_ps( y, y ) ),
+				       _mm_add_ps( _mm_mul_ps( z, z ), _mm_mul_ps( q, q ) ) );
+		__m128 t = _mm_rsqrt_ps( p );
+		__m128 h = _mm_mul_ps( half, t );
+		t = _mm_mul_ps( _mm_mul_ps( t, t ), p );
+		t = _mm_mul_ps( h, _mm_sub_ps( three, t ) );
+
+		x = _mm_mul_ps( x, t );
+		y = _mm_mul_ps( y, t );
+		z = _mm_mul_ps( z, t );
+		q = _mm_mul_ps( q, t );
+		_MM_TRANSPOSE4_PS( x, y, z, q );
+
+		// translation and scale are already one bone per register
+		__m128 ts0 = _mm_add_ps( _mm_add_ps( zero, _mm_mul_ps( wa, a0->sseTransScale ) ), _mm_mul_ps( wb, b0->sseTransScale ) );
+		__m128 ts1 = _mm_add_ps( _mm_add_ps( zero, _mm_mul_ps( wa, a1->sseTransScale ) ), _mm_mul_ps( wb, b1->sseTransScale ) );
+		__m128 ts2 = _mm_add_ps( _mm_add_ps( zero, _mm_mul_ps( wa, a2->sseTransScale ) ), _mm_mul_ps( wb, b2->sseTransScale ) );
+		__m128 ts3 = _mm_add_ps( _mm_add_ps( zero, _mm_mul_ps( wa, a3->sseTransScale ) ), _mm_mul_ps( wb, b3->sseTransScale ) );
+
+		// written last, out may be a or b
+		o[ 0 ]->sseRot = x;
+		o[ 1 ]->sseRot = y;
+		o[ 2 ]->sseRot = z;
+		o[ 3 ]->sseRot = q;
+		o[ 0 ]->sseTransScale = ts0;
+		o[ 1 ]->sseTransScale = ts1;
+		o[ 2 ]->sseTransScale = ts2;
+		o[ 3 ]->sseTransScale = ts3;
+	}
+#endif
+
+	for ( ; i < count; i++ )
+	{
+		transform_t trans;
+
+		TransStartLerp( &trans );
+		TransAddWeight( 1.0f - frac, StridedElement( a, aStride, i ), &trans );
+		TransAddWeight( frac, StridedElement( b, bStride, i ), &trans );
+		TransEndLerp( &trans );
+
+		TransCopy( &trans, StridedElement( out, outStride, i ) );
+	}
+}
+
 /*
 ==============
 R_IQMBuildSkeleton
@@ -1275,13 +1385,11 @@ static int IQMBuildSkeleton( refSkeleton_t *skel, skelAnimation_t *skelAnim,
 		BoundsAdd( mins, maxs, bounds, bounds + 3 );
 	}
 
+	R_LerpTransforms( anim->num_joints, frac, oldPose, sizeof( *oldPose ), newPose, sizeof( *newPose ),
+			  &skel->bones[ 0 ].t, sizeof( skel->bones[ 0 ] ) );
+
 	for ( i = 0; i < anim->num_joints; i++ )
 	{
-		TransStartLerp( &skel->bones[ i ].t );
-		TransAddWeight( 1.0f - frac, &oldPose[ i ], &skel->bones[ i ].t );
-		TransAddWeight( frac, &newPose[ i ], &skel->bones[ i ].t );
-		TransEndLerp( &skel->bones[ i ].t );
-
 #if defined( REFBONE_NAMES )
 		Q_strncpyz( skel->bones[ i ].name, anim->name, sizeof( skel->bones[ i ].name ) );
 #endif
@@ -1471,17 +1579,8 @@ int RE_BlendSkeleton( refSkeleton_t *skel, const refSkeleton_t *blend, float fra
 	}
 
 	// lerp between the 2 bone poses
-	for ( i = 0; i < skel->numBones; i++ )
-	{
-		transform_t trans;
-
-		TransStartLerp( &trans );
-		TransAddWeight( 1.0f - frac, &skel->bones[ i ].t, &trans );
-		TransAddWeight( frac, &blend->bones[ i ].t, &trans );
-		TransEndLerp( &trans );
-
-		TransCopy( &trans, &skel->bones[ i ].t );
-	}
+	R_LerpTransforms( skel->numBones, frac, &skel->bones[ 0 ].t, sizeof( skel->bones[ 0 ] ),
+			  &blend->bones[ 0 ].t, sizeof( blend->bones[ 0 ] ), &skel->bones[ 0 ].t, sizeof( skel->bones[ 0 ] ) );
 
 	// calculate a bounding box in the current coordinate system
 	for ( i = 0; i < 3; i++ )
@@ -1496,6 +1595,63 @@ int RE_BlendSkeleton( refSkeleton_t *skel, const refSkeleton_t *blend, float fra
 	return true;
 }
 
+/*
+==============
+RE_BuildSkeletons
+
+Builds ( and blends ) a batch of skeletons, spread over the frontend
+jobs when there are enough of them
+==============
+*/
+static const refSkeletonJob_t *skeletonJobs;
+static refSkeleton_t          *skeletonOut;
+static int                    *skeletonResults;
+
+static void R_BuildSkeletonJob( int index )
+{
+	const refSkeletonJob_t *job = &skeletonJobs[ index ];
+	refSkeleton_t          *skel = &skeletonOut[ index ];
+	int                    result;
+
+	result = RE_BuildSkeleton( skel, job->anim, job->startFrame, job->endFrame, job->frac, job->clearOrigin );
+
+	if ( result && job->blendAnim > 0 )
+	{
+		refSkeleton_t blend;
+
+		result = RE_BuildSkeleton( &blend, job->blendAnim, job->blendStartFrame, job->blendEndFrame, job->blendFrac,
+		                           job->clearOrigin )
+		         && RE_BlendSkeleton( skel, &blend, job->blendWeight );
+	}
+
+	skeletonResults[ index ] = result;
+}
+
+void RE_BuildSkeletons( const refSkeletonJob_t *jobs, int numJobs, refSkeleton_t *skels, int *results )
+{
+	static const int MIN_PARALLEL_SKELETONS = 8;
+
+	skeletonJobs = jobs;
+	skeletonOut = skels;
+	skeletonResults = results;
+
+	if ( numJobs < MIN_PARALLEL_SKELETONS )
+	{
+		for ( int i = 0; i < numJobs; i++ )
+		{
+			R_BuildSkeletonJob( i );
+		}
+	}
+	else
+	{
+		R_RunJobs( numJobs, R_BuildSkeletonJob );
+	}
+
+	skeletonJobs = nullptr;
+	skeletonOut = nullptr;
+	skeletonResults = nullptr;
+}
+
 /*
 ==============
 RE_AnimNumFrames
@@ -24,6 +24,8 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "tr_local.h"
 #include "gl_shader.h"
+#include "framework/CvarSystem.h"
+#include "framework/Profiler.h"
 #if defined( REFBONE_NAMES )
 	#include <client/client.h>
 #endif
@@ -31,6 +33,78 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 backEndData_t  *backEndData[ SMP_FRAMES ];
 backEndState_t backEnd;
 
+// where backEnd.cvars come from
+static struct
+{
+	const Cvar::SnapshotHandle *logFile;
+	const Cvar::SnapshotHandle *nobind;
+	const Cvar::SnapshotHandle *speeds;
+	const Cvar::SnapshotHandle *showImages;
+	const Cvar::SnapshotHandle *finish;
+	const Cvar::SnapshotHandle *ignoreGLErrors;
+	const Cvar::SnapshotHandle *offsetFactor;
+	const Cvar::SnapshotHandle *offsetUnits;
+} backEndCvarHandles;
+
+static int RB_CvarInteger( const Cvar::SnapshotHandle *handle )
+{
+	return handle ? handle->Get()->integer : 0;
+}
+
+static float RB_CvarValue( const Cvar::SnapshotHandle *handle )
+{
+	return handle ? handle->Get()->value : 0.0f;
+}
+
+/*
+================
+RB_UpdateCvars
+
+Only reads the snapshots when a cvar changed since the last time.
+================
+*/
+static void RB_UpdateCvars()
+{
+	uint64_t generation = Cvar::GetGeneration();
+
+	if ( generation == backEnd.cvarGeneration )
+	{
+		return;
+	}
+
+	backEnd.cvarGeneration = generation;
+	backEnd.cvars.logFile = RB_CvarInteger( backEndCvarHandles.logFile );
+	backEnd.cvars.nobind = RB_CvarInteger( backEndCvarHandles.nobind );
+	backEnd.cvars.speeds = RB_CvarInteger( backEndCvarHandles.speeds );
+	backEnd.cvars.showImages = RB_CvarInteger( backEndCvarHandles.showImages );
+	backEnd.cvars.finish = RB_CvarInteger( backEndCvarHandles.finish );
+	backEnd.cvars.ignoreGLErrors = RB_CvarInteger( backEndCvarHandles.ignoreGLErrors );
+	backEnd.cvars.offsetFactor = RB_CvarValue( backEndCvarHandles.offsetFactor );
+	backEnd.cvars.offsetUnits = RB_CvarValue( backEndCvarHandles.offsetUnits );
+}
+
+/*
+================
+RB_InitCvars
+
+Called on the main thread once the renderer cvars are registered.
+================
+*/
+void RB_InitCvars()
+{
+	backEndCvarHandles.logFile = Cvar::GetSnapshotHandle( "r_logFile" );
+	backEndCvarHandles.nobind = Cvar::GetSnapshotHandle( "r_nobind" );
+	backEndCvarHandles.speeds = Cvar::GetSnapshotHandle( "r_speeds" );
+	backEndCvarHandles.showImages = Cvar::GetSnapshotHandle( "r_showImages" );
+	backEndCvarHandles.finish = Cvar::GetSnapshotHandle( "r_finish" );
+	backEndCvarHandles.ignoreGLErrors = Cvar::GetSnapshotHandle( "r_ignoreGLErrors" );
+	backEndCvarHandles.offsetFactor = Cvar::GetSnapshotHandle( "r_offsetFactor" );
+	backEndCvarHandles.offsetUnits = Cvar::GetSnapshotHandle( "r_offsetUnits" );
+
+	backEnd.cvarGeneration = 0;
+	RB_UpdateCvars();
+}
+
 void GL_Bind( image_t *image )
 {
 	int texnum;
@@ -42,7 +116,7 @@ void GL_Bind( image_t *image )
 	}
 	else
 	{
-		if ( r_logFile->integer )
+		if ( backEnd.cvars.logFile )
 		{
 			// don't just call LogComment, or we will get a call to va() every frame!
 			GLimp_LogComment( va( "--- GL_Bind( %s ) ---\n", image->name ) );
@@ -51,15 +125,18 @@ void GL_Bind( image_t *image )
 
 	texnum = image->texnum;
 
-	if ( r_nobind->integer && tr.blackImage )
+	if ( backEnd.cvars.nobind && tr.blackImage )
 	{
 		// performance evaluation option
 		texnum = tr.blackImage->texnum;
 	}
 
+	// texture streaming needs this even when the image stays bound; the
+	// front end may be a frame ahead, so use the one being rendered
+	image->frameUsed.store( backEnd.frameCount, std::memory_order_relaxed );
+
 	if ( glState.currenttextures[ glState.currenttmu ] != texnum )
 	{
-		image->frameUsed = tr.frameCount;
 		glState.currenttextures[ glState.currenttmu ] = texnum;
 		glBindTexture( image->type, texnum );
 	}
@@ -122,7 +199,7 @@ void GL_BindProgram( shaderProgram_t *program )
 
 void GL_BindNullProgram()
 {
-	if ( r_logFile->integer )
+	if ( backEnd.cvars.logFile )
 	{
 		GLimp_LogComment( "--- GL_BindNullProgram ---\n" );
 	}
@@ -145,7 +222,7 @@ void GL_SelectTexture( int unit )
 	{
 		glActiveTexture( GL_TEXTURE0 + unit );
 
-		if ( r_logFile->integer )
+		if ( backEnd.cvars.logFile )
 		{
 			GLimp_LogComment( va( "glActiveTexture( GL_TEXTURE%i )\n", unit ) );
 		}
@@ -631,7 +708,7 @@ void GL_VertexAttribsState( uint32_t stateBits )
 		{
 			if ( ( stateBits & bit ) )
 			{
-				if ( r_logFile->integer )
+				if ( backEnd.cvars.logFile )
 				{
 					static char buf[ MAX_STRING_CHARS ];
 					Q_snprintf( buf, sizeof( buf ), "glEnableVertexAttribArray( %s )\n", attributeNames[ i ] );
@@ -643,7 +720,7 @@ void GL_VertexAttribsState( uint32_t stateBits )
 			}
 			else
 			{
-				if ( r_logFile->integer )
+				if ( backEnd.cvars.logFile )
 				{
 					static char buf[ MAX_STRING_CHARS ];
 					Q_snprintf( buf, sizeof( buf ), "glDisableVertexAttribArray( %s )\n", attributeNames[ i ] );
@@ -668,7 +745,7 @@ void GL_VertexAttribPointers( uint32_t attribBits )
 		ri.Error( errorParm_t::ERR_FATAL, "GL_VertexAttribPointers: no VBO bound" );
 	}
 
-	if ( r_logFile->integer )
+	if ( backEnd.cvars.logFile )
 	{
 		// don't just call LogComment, or we will get a call to va() every frame!
 		GLimp_LogComment( va( "--- GL_VertexAttribPointers( %s ) ---\n", glState.currentVBO->name ) );
@@ -696,7 +773,7 @@ void GL_VertexAttribPointers( uint32_t attribBits )
 		{
 			const vboAttributeLayout_t *layout = &glState.currentVBO->attribs[ i ];
 
-			if ( r_logFile->integer )
+			if ( backEnd.cvars.logFile )
 			{
 				static char buf[ MAX_STRING_CHARS ];
 				Q_snprintf( buf, sizeof( buf ), "glVertexAttribPointer( %s )\n", attributeNames[ i ] );
@@ -1196,7 +1273,7 @@ static void RB_RenderInteractions()
 
 	GLimp_LogComment( "--- RB_RenderInteractions ---\n" );
 
-	if ( r_speeds->integer == Util::ordinal(renderSpeeds_t::RSPEEDS_SHADING_TIMES))
+	if ( backEnd.cvars.speeds == Util::ordinal(renderSpeeds_t::RSPEEDS_SHADING_TIMES))
 	{
 		glFinish();
 		startTime = ri.Milliseconds();
@@ -1323,7 +1400,7 @@ static void RB_RenderInteractions()
 
 	GL_CheckErrors();
 
-	if ( r_speeds->integer == Util::ordinal(renderSpeeds_t::RSPEEDS_SHADING_TIMES) )
+	if ( backEnd.cvars.speeds == Util::ordinal(renderSpeeds_t::RSPEEDS_SHADING_TIMES) )
 	{
 		glFinish();
 		endTime = ri.Milliseconds();
@@ -1354,7 +1431,7 @@ static void RB_SetupLightForShadowing( trRefLight_t *light, int index,
 				vec3_t   angles;
 				matrix_t rotationMatrix, transformMatrix, viewMatrix;
 
-				if ( r_logFile->integer )
+				if ( backEnd.cvars.logFile )
 				{
 					// don't just call LogComment, or we will get
 					// a call to va() every frame!
@@ -1373,7 +1450,7 @@ static void RB_SetupLightForShadowing( trRefLight_t *light, int index,
 							      tr.shadowCubeFBOImage[ light->shadowLOD ]->texnum, 0 );
 				}
 
-				if ( !r_ignoreGLErrors->integer )
+				if ( !backEnd.cvars.ignoreGLErrors )
 				{
 					R_CheckFBO( tr.shadowMapFBO[ light->shadowLOD ] );
 				}
@@ -1493,7 +1570,7 @@ static void RB_SetupLightForShadowing( trRefLight_t *light, int index,
 					R_AttachFBOTexture2D( GL_TEXTURE_2D, tr.shadowMapFBOImage[ light->shadowLOD ]->texnum, 0 );
 				}
 
-				if ( !r_ignoreGLErrors->integer )
+				if ( !backEnd.cvars.ignoreGLErrors )
 				{
 					R_CheckFBO( tr.shadowMapFBO[ light->shadowLOD ] );
 				}
@@ -1545,7 +1622,7 @@ static void RB_SetupLightForShadowing( trRefLight_t *light, int index,
 					R_AttachFBOTextureDepth( tr.sunShadowMapFBOImage[ splitFrustumIndex ]->texnum );
 				}
 
-				if ( !r_ignoreGLErrors->integer )
+				if ( !backEnd.cvars.ignoreGLErrors )
 				{
 					R_CheckFBO( tr.sunShadowMapFBO[ splitFrustumIndex ] );
 				}
@@ -1590,7 +1667,7 @@ static void RB_SetupLightForShadowing( trRefLight_t *light, int index,
 					R_CalcFrustumNearCorners( splitFrustum, splitFrustumCorners );
 					R_CalcFrustumFarCorners( splitFrustum, splitFrustumCorners + 4 );
 
-					if ( r_logFile->integer )
+					if ( backEnd.cvars.logFile )
 					{
 						vec3_t rayIntersectionNear, rayIntersectionFar;
 						float  zNear, zFar;
@@ -1670,7 +1747,7 @@ static void RB_SetupLightForShadowing( trRefLight_t *light, int index,
 						AddPointToBounds( transf, splitFrustumClipBounds[ 0 ], splitFrustumClipBounds[ 1 ] );
 					}
 
-					if ( r_logFile->integer )
+					if ( backEnd.cvars.logFile )
 					{
 						GLimp_LogComment( va( "shadow casters = %i\n", numCasters ) );
 
@@ -1753,7 +1830,7 @@ static void RB_SetupLightForShadowing( trRefLight_t *light, int index,
 			break;
 	}
 
-	if ( r_logFile->integer )
+	if ( backEnd.cvars.logFile )
 	{
 		// don't just call LogComment, or we will get
 		// a call to va() every frame!
@@ -1765,7 +1842,7 @@ static void RB_SetupLightForLighting( trRefLight_t *light )
 {
 	GLimp_LogComment( "--- Rendering lighting ---\n" );
 
-	if ( r_logFile->integer )
+	if ( backEnd.cvars.logFile )
 	{
 		// don't just call LogComment, or we will get
 		// a call to va() every frame!
@@ -1988,7 +2065,7 @@ static void RB_BlurShadowMap( const trRefLight_t *light, int i )
 	R_BindFBO( fbos[ index ] );
 	R_AttachFBOTexture2D( images[ index + MAX_SHADOWMAPS ]->type, images[ index + MAX_SHADOWMAPS ]->texnum, 0 );
 
-	if ( !r_ignoreGLErrors->integer )
+	if ( !backEnd.cvars.ignoreGLErrors )
 	{
 		R_CheckFBO( fbos[ index ] );
 	}
@@ -2066,7 +2143,7 @@ static void RB_RenderInteractionsShadowMapped()
 
 	GLimp_LogComment( "--- RB_RenderInteractionsShadowMapped ---\n" );
 
-	if ( r_speeds->integer == Util::ordinal(renderSpeeds_t::RSPEEDS_SHADING_TIMES) )
+	if ( backEnd.cvars.speeds == Util::ordinal(renderSpeeds_t::RSPEEDS_SHADING_TIMES) )
 	{
 		glFinish();
 		startTime = ri.Milliseconds();
@@ -2113,7 +2190,7 @@ static void RB_RenderInteractionsShadowMapped()
 
 			if ( light->l.noShadows || light->shadowLOD < 0 )
 			{
-				if ( r_logFile->integer )
+				if ( backEnd.cvars.logFile )
 				{
 					// don't just call LogComment, or we will get
 					// a call to va() every frame!
@@ -2175,7 +2252,7 @@ static void RB_RenderInteractionsShadowMapped()
 						{
 							if ( entity == oldEntity && ( alphaTest ? shader == oldShader : alphaTest == oldAlphaTest ) )
 							{
-								if ( r_logFile->integer )
+								if ( backEnd.cvars.logFile )
 								{
 									// don't just call LogComment, or we will get
 									// a call to va() every frame!
@@ -2191,7 +2268,7 @@ static void RB_RenderInteractionsShadowMapped()
 								// draw the contents of the last shader batch
 								Tess_End();
 
-								if ( r_logFile->integer )
+								if ( backEnd.cvars.logFile )
 								{
 									// don't just call LogComment, or we will get
 									// a call to va() every frame!
@@ -2279,7 +2356,7 @@ static void RB_RenderInteractionsShadowMapped()
 				oldAlphaTest = alphaTest;
 			}
 
-			if ( r_logFile->integer )
+			if ( backEnd.cvars.logFile )
 			{
 				// don't just call LogComment, or we will get
 				// a call to va() every frame!
@@ -2297,7 +2374,7 @@ static void RB_RenderInteractionsShadowMapped()
 
 				if ( light->l.noShadows || light->shadowLOD < 0 )
 				{
-					if ( r_logFile->integer )
+					if ( backEnd.cvars.logFile )
 					{
 						// don't just call LogComment, or we will get
 						// a call to va() every frame!
@@ -2354,7 +2431,7 @@ static void RB_RenderInteractionsShadowMapped()
 							{
 								if ( entity == oldEntity && ( alphaTest ? shader == oldShader : alphaTest == oldAlphaTest ) )
 								{
-									if ( r_logFile->integer )
+									if ( backEnd.cvars.logFile )
 									{
 										// don't just call LogComment, or we will get
 										// a call to va() every frame!
@@ -2370,7 +2447,7 @@ static void RB_RenderInteractionsShadowMapped()
 									// draw the contents of the last shader batch
 									Tess_End();
 
-									if ( r_logFile->integer )
+									if ( backEnd.cvars.logFile )
 									{
 										// don't just call LogComment, or we will get
 										// a call to va() every frame!
@@ -2458,7 +2535,7 @@ static void RB_RenderInteractionsShadowMapped()
 					oldAlphaTest = alphaTest;
 				}
 
-				if ( r_logFile->integer )
+				if ( backEnd.cvars.logFile )
 				{
 					// don't just call LogComment, or we will get
 					// a call to va() every frame!
@@ -2507,7 +2584,7 @@ static void RB_RenderInteractionsShadowMapped()
 
 			if ( entity == oldEntity && shader == oldShader )
 			{
-				if ( r_logFile->integer )
+				if ( backEnd.cvars.logFile )
 				{
 					// don't just call LogComment, or we will get
 					// a call to va() every frame!
@@ -2523,7 +2600,7 @@ static void RB_RenderInteractionsShadowMapped()
 				// draw the contents of the last shader batch
 				Tess_End();
 
-				if ( r_logFile->integer )
+				if ( backEnd.cvars.logFile )
 				{
 					// don't just call LogComment, or we will get
 					// a call to va() every frame!
@@ -2584,7 +2661,7 @@ static void RB_RenderInteractionsShadowMapped()
 			oldAlphaTest = alphaTest;
 		}
 
-		if ( r_logFile->integer )
+		if ( backEnd.cvars.logFile )
 		{
 			// don't just call LogComment, or we will get
 			// a call to va() every frame!
@@ -2614,7 +2691,7 @@ static void RB_RenderInteractionsShadowMapped()
 
 	GL_CheckErrors();
 
-	if ( r_speeds->integer == Util::ordinal(renderSpeeds_t::RSPEEDS_SHADING_TIMES) )
+	if ( backEnd.cvars.speeds == Util::ordinal(renderSpeeds_t::RSPEEDS_SHADING_TIMES) )
 	{
 		glFinish();
 		endTime = ri.Milliseconds();
@@ -2894,7 +2971,7 @@ void RB_RenderGlobalFog()
 
 		fog = &tr.world->fogs[ tr.world->globalFog ];
 
-		if ( r_logFile->integer )
+		if ( backEnd.cvars.logFile )
 		{
 			GLimp_LogComment( va( "--- RB_RenderGlobalFog( fogNum = %i, originalBrushNumber = %i ) ---\n", tr.world->globalFog, fog->originalBrushNumber ) );
 		}
@@ -4350,7 +4427,7 @@ static void RB_RenderDebugUtils()
 				if ( node->contents != -1 )
 				{
 					glEnable( GL_POLYGON_OFFSET_FILL );
-					GL_PolygonOffset( r_offsetFactor->value, r_offsetUnits->value );
+					GL_PolygonOffset( backEnd.cvars.offsetFactor, backEnd.cvars.offsetUnits );
 				}
 
 				tess.numVertexes = 0;
@@ -4456,7 +4533,7 @@ static void RB_RenderDebugUtils()
 		}
 
 		glEnable( GL_POLYGON_OFFSET_FILL );
-		GL_PolygonOffset( r_offsetFactor->value, r_offsetUnits->value );
+		GL_PolygonOffset( backEnd.cvars.offsetFactor, backEnd.cvars.offsetUnits );
 
 		for ( i = 0, srfDecal = backEnd.refdef.decals; i < backEnd.refdef.numDecals; i++, srfDecal++ )
 		{
@@ -4607,7 +4684,7 @@ static void RB_RenderView( bool depthPass )
 {
 	int startTime = 0, endTime = 0;
 
-	if ( r_logFile->integer )
+	if ( backEnd.cvars.logFile )
 	{
 		// don't just call LogComment, or we will get a call to va() every frame!
 		GLimp_LogComment( va
@@ -4647,7 +4724,7 @@ static void RB_RenderView( bool depthPass )
 
 	GL_CheckErrors();
 
-	if ( r_speeds->integer == Util::ordinal(renderSpeeds_t::RSPEEDS_SHADING_TIMES) )
+	if ( backEnd.cvars.speeds == Util::ordinal(renderSpeeds_t::RSPEEDS_SHADING_TIMES) )
 	{
 		glFinish();
 		startTime = ri.Milliseconds();
@@ -4682,7 +4759,7 @@ static void RB_RenderView( bool depthPass )
 		RB_RenderSSAO();
 	}
 
-	if ( r_speeds->integer == Util::ordinal(renderSpeeds_t::RSPEEDS_SHADING_TIMES) )
+	if ( backEnd.cvars.speeds == Util::ordinal(renderSpeeds_t::RSPEEDS_SHADING_TIMES) )
 	{
 		glFinish();
 		endTime = ri.Milliseconds();
@@ -4799,7 +4876,7 @@ void RE_StretchRaw( int x, int y, int w, int h, int cols, int rows, const byte *
 
 	start = end = 0;
 
-	if ( r_speeds->integer )
+	if ( backEnd.cvars.speeds )
 	{
 		glFinish();
 		start = ri.Milliseconds();
@@ -4868,7 +4945,7 @@ void RE_StretchRaw( int x, int y, int w, int h, int cols, int rows, const byte *
 		}
 	}
 
-	if ( r_speeds->integer )
+	if ( backEnd.cvars.speeds )
 	{
 		glFinish();
 		end = ri.Milliseconds();
@@ -5502,13 +5579,13 @@ const RenderCommand *ClearBufferCommand::ExecuteSelf( ) const
 	GL_CheckErrors();
 
 	// sync with gl if needed
-	if ( r_finish->integer == 1 && !glState.finishCalled )
+	if ( backEnd.cvars.finish == 1 && !glState.finishCalled )
 	{
 		glFinish();
 		glState.finishCalled = true;
 	}
 
-	if ( r_finish->integer == 0 )
+	if ( backEnd.cvars.finish == 0 )
 	{
 		glState.finishCalled = true;
 	}
@@ -5721,6 +5798,7 @@ const RenderCommand *DrawBufferCommand::ExecuteSelf( ) const
 
 	GL_DrawBuffer( buffer );
 
+	backEnd.frameCount = frameCount;
 	glState.finishCalled = false;
 	return this + 1;
 }
@@ -5792,7 +5870,7 @@ void RB_ShowImages()
 		y = i / 20 * h;
 
 		// show in proportional size in mode 2
-		if ( r_showImages->integer == 2 )
+		if ( backEnd.cvars.showImages == 2 )
 		{
 			w *= image->uploadWidth / 512.0f;
 			h *= image->uploadHeight / 512.0f;
@@ -5831,7 +5909,7 @@ const RenderCommand *SwapBuffersCommand::ExecuteSelf( ) const
 	}
 
 	// texture swapping test
-	if ( r_showImages->integer )
+	if ( backEnd.cvars.showImages )
 	{
 		RB_ShowImages();
 	}
@@ -5911,10 +5989,14 @@ void RB_ExecuteRenderCommands( const void *data )
 	const RenderCommand *cmd = (const RenderCommand *)data;
 	int t1, t2;
 
+	PROFILE_ZONE( "RB_ExecuteRenderCommands" );
+
 	GLimp_LogComment( "--- RB_ExecuteRenderCommands ---\n" );
 
 	t1 = ri.Milliseconds();
 
+	RB_UpdateCvars();
+
 	if ( !r_smp->integer || data == backEndData[ 0 ]->commands.cmds )
 	{
 		backEnd.smpFrame = 0;
@@ -5943,6 +6025,8 @@ void RB_RenderThread()
 {
 	const void *data;
 
+	PROFILE_THREAD( "renderer" );
+
 	// wait for either a rendering command or a quit command
 	while ( 1 )
 	{
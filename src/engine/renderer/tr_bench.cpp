@@ -0,0 +1,604 @@
+/*
+===========================================================================
+
+Daemon GPL Source Code
+Copyright (C) 2024 Daemon Developers
+
+This file is part of the Daemon GPL Source Code (Daemon Source Code).
+
+Daemon Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Daemon Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Daemon Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+===========================================================================
+*/
+// tr_bench.cpp -- recording scenes and replaying them through the frontend
+#include <common/FileSystem.h>
+#include "tr_local.h"
+
+/*
+============================================================================
+
+SCENE CAPTURE
+
+scenecapture writes everything the cgame hands to RE_RenderScene to a
+file in the homepath: the refdef, the entities, the dynamic lights and
+the polys, with models, skins and shaders stored by name. scenebench
+loads it on the same map and runs it through the frontend again with
+the render commands thrown away, so only the CPU side is measured.
+
+Poly buffers and decals point into cgame memory and are not recorded.
+
+============================================================================
+*/
+
+static const char sceneCaptureDir[] = "benchmark/";
+static const char sceneCaptureMagic[ 4 ] = { 'D', 'S', 'C', 'N' };
+static const int  sceneCaptureVersion = 1;
+
+// the structures are stored as they are in memory, so a file only
+// works with builds that agree on their layout
+struct sceneCaptureHeader_t
+{
+	char magic[ 4 ];
+	int  version;
+	int  refdefSize;
+	int  entitySize;
+	int  lightSize;
+	int  polyVertSize;
+	char mapName[ MAX_QPATH ];
+};
+
+enum sceneRecord_t
+{
+  SCENE_RECORD_SCENE,
+  SCENE_RECORD_FRAME_END
+};
+
+struct capturedLight_t
+{
+	refLight_t l;
+	int        restrictInteractionFirst;
+	int        restrictInteractionLast;
+};
+
+struct capturedPoly_t
+{
+	qhandle_t               hShader;
+	std::vector<polyVert_t> verts;
+};
+
+struct capturedScene_t
+{
+	refdef_t                     refdef;
+	std::vector<refEntity_t>     entities;
+	std::vector<capturedLight_t> lights;
+	std::vector<capturedPoly_t>  polys;
+};
+
+static FS::File captureFile;
+static int      captureFrames;
+
+static void R_CaptureWrite( const void *data, size_t size )
+{
+	captureFile.Write( data, size );
+}
+
+static void R_CaptureInt( int value )
+{
+	R_CaptureWrite( &value, sizeof( value ) );
+}
+
+static void R_CaptureString( const char *string )
+{
+	int length = strlen( string );
+
+	R_CaptureInt( length );
+	R_CaptureWrite( string, length );
+}
+
+static const char *R_ModelName( qhandle_t hModel )
+{
+	return hModel ? R_GetModelByHandle( hModel )->name : "";
+}
+
+static const char *R_SkinName( qhandle_t hSkin )
+{
+	return hSkin ? R_GetSkinByHandle( hSkin )->name : "";
+}
+
+static const char *R_ShaderName( qhandle_t hShader )
+{
+	return hShader ? R_GetShaderByHandle( hShader )->name : "";
+}
+
+/*
+===============
+R_StopSceneCapture
+===============
+*/
+void R_StopSceneCapture()
+{
+	if ( !captureFile )
+	{
+		return;
+	}
+
+	std::error_code err;
+	captureFile.Close( err );
+
+	if ( err )
+	{
+		Log::Warn( "Couldn't finish the scene capture: %s", err.message() );
+	}
+	else
+	{
+		Log::Notice( "captured %i frames", captureFrames );
+	}
+}
+
+/*
+===============
+R_CaptureScene
+
+Called by RE_RenderScene once the scene is complete, numLights leaves
+out the world lights that were added to it.
+===============
+*/
+void R_CaptureScene( const refdef_t *fd, int numLights )
+{
+	if ( !captureFile )
+	{
+		return;
+	}
+
+	try
+	{
+		R_CaptureInt( SCENE_RECORD_SCENE );
+		R_CaptureWrite( fd, sizeof( *fd ) );
+
+		R_CaptureInt( tr.refdef.numEntities );
+
+		for ( int i = 0; i < tr.refdef.numEntities; i++ )
+		{
+			const refEntity_t *ent = &tr.refdef.entities[ i ].e;
+
+			R_CaptureWrite( ent, sizeof( *ent ) );
+			R_CaptureString( R_ModelName( ent->hModel ) );
+			R_CaptureString( R_SkinName( ent->customSkin ) );
+			R_CaptureString( R_ShaderName( ent->customShader ) );
+		}
+
+		R_CaptureInt( numLights );
+
+		for ( int i = 0; i < numLights; i++ )
+		{
+			const trRefLight_t *light = &tr.refdef.lights[ i ];
+
+			R_CaptureWrite( &light->l, sizeof( light->l ) );
+			R_CaptureInt( light->restrictInteractionFirst );
+			R_CaptureInt( light->restrictInteractionLast );
+			R_CaptureString( R_ShaderName( light->l.attenuationShader ) );
+		}
+
+		R_CaptureInt( tr.refdef.numPolys );
+
+		for ( int i = 0; i < tr.refdef.numPolys; i++ )
+		{
+			const srfPoly_t *poly = &tr.refdef.polys[ i ];
+
+			R_CaptureString( R_ShaderName( poly->hShader ) );
+			R_CaptureInt( poly->numVerts );
+			R_CaptureWrite( poly->verts, poly->numVerts * sizeof( polyVert_t ) );
+		}
+	}
+	catch ( std::system_error &err )
+	{
+		Log::Warn( "Scene capture failed: %s", err.what() );
+		R_StopSceneCapture();
+	}
+}
+
+/*
+===============
+R_CaptureFrameEnd
+===============
+*/
+void R_CaptureFrameEnd()
+{
+	if ( !captureFile )
+	{
+		return;
+	}
+
+	try
+	{
+		R_CaptureInt( SCENE_RECORD_FRAME_END );
+		captureFrames++;
+	}
+	catch ( std::system_error &err )
+	{
+		Log::Warn( "Scene capture failed: %s", err.what() );
+		R_StopSceneCapture();
+	}
+}
+
+/*
+===============
+R_SceneCapture_f
+===============
+*/
+void R_SceneCapture_f()
+{
+	if ( ri.Cmd_Argc() < 2 )
+	{
+		if ( captureFile )
+		{
+			R_StopSceneCapture();
+		}
+		else
+		{
+			Log::Notice( "usage: scenecapture <name>, run it again without a name to stop" );
+		}
+
+		return;
+	}
+
+	if ( !tr.world )
+	{
+		Log::Warn( "scenecapture: no map loaded" );
+		return;
+	}
+
+	R_StopSceneCapture();
+
+	std::string path = Str::Format( "%s%s.scenes", sceneCaptureDir, ri.Cmd_Argv( 1 ) );
+	sceneCaptureHeader_t header = {};
+
+	memcpy( header.magic, sceneCaptureMagic, sizeof( sceneCaptureMagic ) );
+	header.version = sceneCaptureVersion;
+	header.refdefSize = sizeof( refdef_t );
+	header.entitySize = sizeof( refEntity_t );
+	header.lightSize = sizeof( refLight_t );
+	header.polyVertSize = sizeof( polyVert_t );
+	Q_strncpyz( header.mapName, tr.world->name, sizeof( header.mapName ) );
+
+	try
+	{
+		captureFile = FS::HomePath::OpenWrite( path );
+		R_CaptureWrite( &header, sizeof( header ) );
+	}
+	catch ( std::system_error &err )
+	{
+		Log::Warn( "Couldn't start the scene capture: %s", err.what() );
+		R_StopSceneCapture();
+		return;
+	}
+
+	captureFrames = 0;
+	Log::Notice( "capturing scenes to %s", path );
+}
+
+/*
+============================================================================
+
+SCENE BENCHMARK
+
+============================================================================
+*/
+
+struct sceneReader_t
+{
+	const char *data;
+	const char *end;
+	bool       failed;
+};
+
+static void R_ReadCaptured( sceneReader_t *reader, void *out, size_t size )
+{
+	if ( reader->failed || static_cast<size_t>( reader->end - reader->data ) < size )
+	{
+		reader->failed = true;
+		memset( out, 0, size );
+		return;
+	}
+
+	memcpy( out, reader->data, size );
+	reader->data += size;
+}
+
+static int R_ReadCapturedInt( sceneReader_t *reader )
+{
+	int value;
+
+	R_ReadCaptured( reader, &value, sizeof( value ) );
+	return value;
+}
+
+static int R_ReadCapturedCount( sceneReader_t *reader, int max )
+{
+	int count = R_ReadCapturedInt( reader );
+
+	if ( count < 0 || count > max )
+	{
+		reader->failed = true;
+		return 0;
+	}
+
+	return count;
+}
+
+static std::string R_ReadCapturedString( sceneReader_t *reader )
+{
+	int length = R_ReadCapturedCount( reader, MAX_QPATH );
+	std::string string( length, '\0' );
+
+	R_ReadCaptured( reader, &string[ 0 ], length );
+	return string;
+}
+
+static qhandle_t R_ReadCapturedShader( sceneReader_t *reader )
+{
+	std::string name = R_ReadCapturedString( reader );
+
+	return name.empty() ? 0 : RE_RegisterShader( name.c_str(), RSF_DEFAULT );
+}
+
+static bool R_ReadCapturedScene( sceneReader_t *reader, capturedScene_t *scene )
+{
+	R_ReadCaptured( reader, &scene->refdef, sizeof( scene->refdef ) );
+
+	scene->entities.resize( R_ReadCapturedCount( reader, MAX_REF_ENTITIES ) );
+
+	for ( refEntity_t &ent : scene->entities )
+	{
+		R_ReadCaptured( reader, &ent, sizeof( ent ) );
+
+		std::string model = R_ReadCapturedString( reader );
+		std::string skin = R_ReadCapturedString( reader );
+
+		ent.hModel = model.empty() ? 0 : RE_RegisterModel( model.c_str() );
+		ent.customSkin = skin.empty() ? 0 : RE_RegisterSkin( skin.c_str() );
+		ent.customShader = R_ReadCapturedShader( reader );
+	}
+
+	scene->lights.resize( R_ReadCapturedCount( reader, MAX_REF_LIGHTS ) );
+
+	for ( capturedLight_t &light : scene->lights )
+	{
+		R_ReadCaptured( reader, &light.l, sizeof( light.l ) );
+		light.restrictInteractionFirst = R_ReadCapturedInt( reader );
+		light.restrictInteractionLast = R_ReadCapturedInt( reader );
+		light.l.attenuationShader = R_ReadCapturedShader( reader );
+	}
+
+	scene->polys.resize( R_ReadCapturedCount( reader, r_maxPolys->integer ) );
+
+	for ( capturedPoly_t &poly : scene->polys )
+	{
+		poly.hShader = R_ReadCapturedShader( reader );
+		poly.verts.resize( R_ReadCapturedCount( reader, r_maxPolyVerts->integer ) );
+		R_ReadCaptured( reader, poly.verts.data(), poly.verts.size() * sizeof( polyVert_t ) );
+	}
+
+	return !reader->failed;
+}
+
+static bool R_LoadCapturedScenes( const char *name, std::vector<std::vector<capturedScene_t>> &frames )
+{
+	std::string path = Str::Format( "%s%s.scenes", sceneCaptureDir, name );
+	std::string data;
+	std::error_code err;
+
+	FS::File file = FS::HomePath::OpenRead( path, err );
+
+	if ( !err )
+	{
+		data = file.ReadAll( err );
+	}
+
+	if ( err )
+	{
+		Log::Warn( "Couldn't read %s: %s", path, err.message() );
+		return false;
+	}
+
+	sceneReader_t reader = { data.data(), data.data() + data.size(), false };
+	sceneCaptureHeader_t header;
+
+	R_ReadCaptured( &reader, &header, sizeof( header ) );
+
+	if ( reader.failed || memcmp( header.magic, sceneCaptureMagic, sizeof( sceneCaptureMagic ) )
+	     || header.version != sceneCaptureVersion )
+	{
+		Log::Warn( "%s is not a scene capture", path );
+		return false;
+	}
+
+	if ( header.refdefSize != sizeof( refdef_t ) || header.entitySize != sizeof( refEntity_t )
+	     || header.lightSize != sizeof( refLight_t ) || header.polyVertSize != sizeof( polyVert_t ) )
+	{
+		Log::Warn( "%s was captured by an incompatible build", path );
+		return false;
+	}
+
+	header.mapName[ sizeof( header.mapName ) - 1 ] = '\0';
+
+	if ( !tr.world || Q_stricmp( header.mapName, tr.world->name ) )
+	{
+		Log::Warn( "%s was captured on %s, load that map first", path, header.mapName );
+		return false;
+	}
+
+	frames.emplace_back();
+
+	while ( reader.data < reader.end )
+	{
+		int record = R_ReadCapturedInt( &reader );
+
+		if ( record == SCENE_RECORD_FRAME_END )
+		{
+			frames.emplace_back();
+		}
+		else if ( record == SCENE_RECORD_SCENE )
+		{
+			frames.back().emplace_back();
+
+			if ( !R_ReadCapturedScene( &reader, &frames.back().back() ) )
+			{
+				break;
+			}
+		}
+		else
+		{
+			reader.failed = true;
+			break;
+		}
+	}
+
+	if ( reader.failed )
+	{
+		Log::Warn( "%s is truncated or corrupted", path );
+		return false;
+	}
+
+	// a capture stopped in the middle of a frame
+	if ( frames.back().empty() )
+	{
+		frames.pop_back();
+	}
+
+	return true;
+}
+
+static void R_ReplayScene( const capturedScene_t &scene )
+{
+	RE_ClearScene();
+
+	for ( const refEntity_t &ent : scene.entities )
+	{
+		RE_AddRefEntityToScene( &ent );
+	}
+
+	for ( const capturedLight_t &light : scene.lights )
+	{
+		R_AddCapturedLightToScene( &light.l, light.restrictInteractionFirst, light.restrictInteractionLast );
+	}
+
+	for ( const capturedPoly_t &poly : scene.polys )
+	{
+		RE_AddPolysToScene( poly.hShader, poly.verts.size(), poly.verts.data(), 1 );
+	}
+
+	RE_RenderScene( &scene.refdef );
+}
+
+static double R_Msec( Sys::SteadyClock::duration duration )
+{
+	return std::chrono::duration<double, std::milli>( duration ).count();
+}
+
+/*
+===============
+R_SceneBench_f
+
+Replays a scene capture through the frontend and prints how long the
+frames and the stages of the top level views took on average. Views
+through portals and mirrors are part of the sort stage of their parent.
+===============
+*/
+void R_SceneBench_f()
+{
+	static const char *const stageNames[ FES_NUM_STAGES ] =
+	{
+		"setup", "world", "polys", "entities", "interactions", "sort"
+	};
+
+	std::vector<std::vector<capturedScene_t>> frames;
+	int numRuns = 1;
+
+	if ( ri.Cmd_Argc() < 2 )
+	{
+		Log::Notice( "usage: scenebench <name> [runs]" );
+		return;
+	}
+
+	if ( ri.Cmd_Argc() > 2 )
+	{
+		numRuns = Math::Clamp( atoi( ri.Cmd_Argv( 2 ) ), 1, 1000 );
+	}
+
+	if ( !R_LoadCapturedScenes( ri.Cmd_Argv( 1 ), frames ) )
+	{
+		return;
+	}
+
+	if ( frames.empty() )
+	{
+		Log::Warn( "scenebench: the capture has no frames" );
+		return;
+	}
+
+	// the render thread must be done with the frame before its
+	// buffers are reused, and none of this is ever drawn
+	R_SyncRenderThread();
+
+	int frontEndMsec = tr.frontEndMsec;
+	Sys::SteadyClock::duration total{}, fastest = Sys::SteadyClock::duration::max(), slowest{};
+	int numScenes = 0;
+
+	tr.benchmarking = true;
+	Com_Memset( tr.benchStageTimes, 0, sizeof( tr.benchStageTimes ) );
+
+	for ( int run = 0; run < numRuns; run++ )
+	{
+		for ( const std::vector<capturedScene_t> &frame : frames )
+		{
+			R_ToggleSmpFrame();
+
+			tr.frameCount++;
+			tr.frameSceneNum = 0;
+			tr.viewCount = 0;
+
+			Sys::SteadyClock::time_point start = Sys::SteadyClock::now();
+
+			for ( const capturedScene_t &scene : frame )
+			{
+				R_ReplayScene( scene );
+			}
+
+			Sys::SteadyClock::duration frameTime = Sys::SteadyClock::now() - start;
+
+			total += frameTime;
+			fastest = std::min( fastest, frameTime );
+			slowest = std::max( slowest, frameTime );
+			numScenes += frame.size();
+		}
+	}
+
+	// drop the commands of the last replayed frame
+	R_ToggleSmpFrame();
+
+	tr.benchmarking = false;
+	tr.frontEndMsec = frontEndMsec;
+
+	int numFrames = numRuns * frames.size();
+
+	Log::Notice( "%i frames, %i scenes: %.3f ms per frame, fastest %.3f ms, slowest %.3f ms",
+	             numFrames, numScenes, R_Msec( total ) / numFrames, R_Msec( fastest ), R_Msec( slowest ) );
+
+	for ( int i = 0; i < FES_NUM_STAGES; i++ )
+	{
+		Log::Notice( "  %-12s %.3f ms per frame", stageNames[ i ],
+		             R_Msec( std::chrono::nanoseconds( tr.benchStageTimes[ i ] ) ) / numFrames );
+	}
+}
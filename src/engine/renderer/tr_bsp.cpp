@@ -22,9 +22,12 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 ===========================================================================
 */
 // tr_bsp.c
+#include <common/FileSystem.h>
 #include "tr_local.h"
 #include "framework/CommandSystem.h"
 
+#include <zlib.h>
+
 /*
 ========================================================
 Loads and prepares a map file for scene rendering.
@@ -496,6 +499,10 @@ static void R_LoadLightmaps( lump_t *l, const char *bspName )
 
 				Log::Debug("...loading %i deluxemaps", numLightmaps);
 
+				for (int i = 0; i < numLightmaps; i++) {
+					R_PrefetchImageFile(va("%s/%s", mapName, lightmapFiles[i]), IF_NORMALMAP);
+				}
+
 				for (int i = 0; i < numLightmaps; i++) {
 					Log::Debug("...loading external lightmap '%s/%s'", mapName, lightmapFiles[i]);
 					auto image = R_FindImageFile(va("%s/%s", mapName, lightmapFiles[i]), IF_NORMALMAP | IF_NOCOMPRESSION, filterType_t::FT_DEFAULT, wrapTypeEnum_t::WT_CLAMP);
@@ -514,6 +521,11 @@ static void R_LoadLightmaps( lump_t *l, const char *bspName )
 
 			Log::Debug("...loading %i lightmaps", numLightmaps );
 
+			// decode them all in the background while uploading them in order
+			for (int i = 0; i < numLightmaps; i++) {
+				R_PrefetchImageFile(va("%s/%s", mapName, lightmapFiles[i]), !tr.worldDeluxeMapping || i % 2 == 0 ? IF_LIGHTMAP : IF_NORMALMAP);
+			}
+
 			// we are about to upload textures
 			R_SyncRenderThread();
 
@@ -664,7 +676,7 @@ static void R_LoadVisibility( lump_t *l )
 	Log::Debug("...loading visibility" );
 
 	len = ( s_worldData.numClusters + 63 ) & ~63;
-	s_worldData.novis = (byte*) ri.Hunk_Alloc( len, ha_pref::h_low );
+	s_worldData.novis = (byte*) ri.Hunk_Alloc( len, hunkTag_t::HT_BSP );
 	Com_Memset( s_worldData.novis, 0xff, len );
 
 	len = l->filelen;
@@ -689,14 +701,14 @@ static void R_LoadVisibility( lump_t *l )
 	{
 		byte *dest;
 
-		dest = (byte*) ri.Hunk_Alloc( len - 8, ha_pref::h_low );
+		dest = (byte*) ri.Hunk_Alloc( len - 8, hunkTag_t::HT_BSP );
 		Com_Memcpy( dest, buf + 8, len - 8 );
 		s_worldData.vis = dest;
 	}
 
 	// initialize visvis := vis
 	len = s_worldData.numClusters * s_worldData.clusterBytes;
-	s_worldData.visvis = (byte*) ri.Hunk_Alloc( len, ha_pref::h_low );
+	s_worldData.visvis = (byte*) ri.Hunk_Alloc( len, hunkTag_t::HT_BSP );
 	memcpy( s_worldData.visvis, s_worldData.vis, len );
 
 	for ( i = 0; i < s_worldData.numClusters; i++ )
@@ -862,14 +874,14 @@ static void ParseFace( dsurface_t *ds, drawVert_t *verts, bspSurface_t *surf, in
 
 	numTriangles = LittleLong( ds->numIndexes ) / 3;
 
-	cv = (srfSurfaceFace_t*) ri.Hunk_Alloc( sizeof( *cv ), ha_pref::h_low );
+	cv = (srfSurfaceFace_t*) ri.Hunk_Alloc( sizeof( *cv ), hunkTag_t::HT_BSP );
 	cv->surfaceType = surfaceType_t::SF_FACE;
 
 	cv->numTriangles = numTriangles;
-	cv->triangles = (srfTriangle_t*) ri.Hunk_Alloc( numTriangles * sizeof( cv->triangles[ 0 ] ), ha_pref::h_low );
+	cv->triangles = (srfTriangle_t*) ri.Hunk_Alloc( numTriangles * sizeof( cv->triangles[ 0 ] ), hunkTag_t::HT_BSP );
 
 	cv->numVerts = numVerts;
-	cv->verts = (srfVert_t*) ri.Hunk_Alloc( numVerts * sizeof( cv->verts[ 0 ] ), ha_pref::h_low );
+	cv->verts = (srfVert_t*) ri.Hunk_Alloc( numVerts * sizeof( cv->verts[ 0 ] ), hunkTag_t::HT_BSP );
 
 	surf->data = ( surfaceType_t * ) cv;
 
@@ -1008,17 +1020,26 @@ static void ParseFace( dsurface_t *ds, drawVert_t *verts, bspSurface_t *surf, in
 /*
 ===============
 ParseMesh
+
+Only reads the control points, the patches are tessellated together
+by R_TessellateMeshes
 ===============
 */
+struct meshJob_t
+{
+	dsurface_t             *ds;
+	bspSurface_t           *surf;
+	int                    width, height;
+	std::vector<srfVert_t> points;
+};
+
+static std::vector<meshJob_t> meshJobs;
+
 static void ParseMesh( dsurface_t *ds, drawVert_t *verts, bspSurface_t *surf )
 {
-	srfGridMesh_t        *grid;
 	int                  i, j;
 	int                  width, height, numPoints;
-	static srfVert_t     points[ MAX_PATCH_SIZE * MAX_PATCH_SIZE ];
-	vec3_t               bounds[ 2 ];
 	vec2_t               stBounds[ 2 ], tcOffset;
-	vec3_t               tmpVec;
 	static surfaceType_t skipData = surfaceType_t::SF_SKIP;
 	int                  realLightmapNum;
 
@@ -1069,6 +1090,16 @@ static void ParseMesh( dsurface_t *ds, drawVert_t *verts, bspSurface_t *surf )
 	verts += LittleLong( ds->firstVert );
 	numPoints = width * height;
 
+	meshJobs.emplace_back();
+	meshJob_t &job = meshJobs.back();
+	job.ds = ds;
+	job.surf = surf;
+	job.width = width;
+	job.height = height;
+	job.points.resize( numPoints );
+
+	srfVert_t *points = job.points.data();
+
 	// compute min/max texture coords on the fly
 	stBounds[ 0 ][ 0 ] =  99999.0f;
 	stBounds[ 0 ][ 1 ] =  99999.0f;
@@ -1114,9 +1145,25 @@ static void ParseMesh( dsurface_t *ds, drawVert_t *verts, bspSurface_t *surf )
 		}
 	}
 
+}
+
+/*
+===============
+R_TessellateMesh
+===============
+*/
+static void R_TessellateMesh( int index )
+{
+	meshJob_t     &job = meshJobs[ index ];
+	dsurface_t    *ds = job.ds;
+	srfGridMesh_t *grid;
+	vec3_t        bounds[ 2 ];
+	vec3_t        tmpVec;
+	int           i;
+
 	// pre-tesselate
-	grid = R_SubdividePatchToGrid( width, height, points );
-	surf->data = ( surfaceType_t * ) grid;
+	grid = R_SubdividePatchToGrid( job.width, job.height, job.points.data() );
+	job.surf->data = ( surfaceType_t * ) grid;
 
 	// copy the level of detail origin, which is the center
 	// of the group of all curves that must subdivide the same
@@ -1136,6 +1183,22 @@ static void ParseMesh( dsurface_t *ds, drawVert_t *verts, bspSurface_t *surf )
 	FinishGenericSurface( ds, ( srfGeneric_t * ) grid, grid->verts[ 0 ].xyz );
 }
 
+/*
+===============
+R_TessellateMeshes
+
+Every patch is subdivided on its own, so they are spread over the
+frontend job threads
+===============
+*/
+static void R_TessellateMeshes()
+{
+	R_RunJobs( meshJobs.size(), R_TessellateMesh );
+
+	meshJobs.clear();
+	meshJobs.shrink_to_fit();
+}
+
 /*
 ===============
 ParseTriSurf
@@ -1184,14 +1247,14 @@ static void ParseTriSurf( dsurface_t *ds, drawVert_t *verts, bspSurface_t *surf,
 	numVerts = LittleLong( ds->numVerts );
 	numTriangles = LittleLong( ds->numIndexes ) / 3;
 
-	cv = (srfTriangles_t*) ri.Hunk_Alloc( sizeof( *cv ), ha_pref::h_low );
+	cv = (srfTriangles_t*) ri.Hunk_Alloc( sizeof( *cv ), hunkTag_t::HT_BSP );
 	cv->surfaceType = surfaceType_t::SF_TRIANGLES;
 
 	cv->numTriangles = numTriangles;
-	cv->triangles = (srfTriangle_t*) ri.Hunk_Alloc( numTriangles * sizeof( cv->triangles[ 0 ] ), ha_pref::h_low );
+	cv->triangles = (srfTriangle_t*) ri.Hunk_Alloc( numTriangles * sizeof( cv->triangles[ 0 ] ), hunkTag_t::HT_BSP );
 
 	cv->numVerts = numVerts;
-	cv->verts = (srfVert_t*) ri.Hunk_Alloc( numVerts * sizeof( cv->verts[ 0 ] ), ha_pref::h_low );
+	cv->verts = (srfVert_t*) ri.Hunk_Alloc( numVerts * sizeof( cv->verts[ 0 ] ), hunkTag_t::HT_BSP );
 
 	surf->data = ( surfaceType_t * ) cv;
 
@@ -1344,7 +1407,7 @@ static void ParseFlare( dsurface_t *ds, bspSurface_t *surf )
 		surf->shader = tr.defaultShader;
 	}
 
-	flare = (srfFlare_t*) ri.Hunk_Alloc( sizeof( *flare ), ha_pref::h_low );
+	flare = (srfFlare_t*) ri.Hunk_Alloc( sizeof( *flare ), hunkTag_t::HT_BSP );
 	flare->surfaceType = surfaceType_t::SF_FLARE;
 
 	surf->data = ( surfaceType_t * ) flare;
@@ -1431,6 +1494,46 @@ int R_MergedHeightPoints( srfGridMesh_t *grid, int offset )
 	return false;
 }
 
+/*
+=================
+R_BuildLodGroups
+
+Patches are only stitched or have their LoD synced with the patches of
+their LoD group, which share the exact same lod origin and radius.
+Grouping them once by that key saves testing every pair of surfaces.
+Stitching keeps the lod origin and radius of the grids it rebuilds.
+=================
+*/
+using lodGroupKey_t = std::array<float, 4>;
+
+static std::map<lodGroupKey_t, std::vector<int>> lodGroups;
+
+static lodGroupKey_t R_LodGroupKey( const srfGridMesh_t *grid )
+{
+	return {{ grid->lodOrigin[ 0 ], grid->lodOrigin[ 1 ], grid->lodOrigin[ 2 ], grid->lodRadius }};
+}
+
+static void R_BuildLodGroups()
+{
+	lodGroups.clear();
+
+	// surfaces are visited in order, so every group is sorted
+	for ( int i = 0; i < s_worldData.numSurfaces; i++ )
+	{
+		srfGridMesh_t *grid = ( srfGridMesh_t * ) s_worldData.surfaces[ i ].data;
+
+		if ( grid->surfaceType == surfaceType_t::SF_GRID )
+		{
+			lodGroups[ R_LodGroupKey( grid ) ].push_back( i );
+		}
+	}
+}
+
+static const std::vector<int> &R_LodGroup( const srfGridMesh_t *grid )
+{
+	return lodGroups.at( R_LodGroupKey( grid ) );
+}
+
 /*
 =================
 R_FixSharedVertexLodError_r
@@ -1442,13 +1545,14 @@ FIXME: write generalized version that also avoids cracks between a patch and one
 */
 void R_FixSharedVertexLodError_r( int start, srfGridMesh_t *grid1 )
 {
-	int           j, k, l, m, n, offset1, offset2, touch;
+	int           k, l, m, n, offset1, offset2, touch;
 	srfGridMesh_t *grid2;
+	const std::vector<int> &group = R_LodGroup( grid1 );
 
-	for ( j = start; j < s_worldData.numSurfaces; j++ )
+	for ( auto it = std::lower_bound( group.begin(), group.end(), start ); it != group.end(); ++it )
 	{
 		//
-		grid2 = ( srfGridMesh_t * ) s_worldData.surfaces[ j ].data;
+		grid2 = ( srfGridMesh_t * ) s_worldData.surfaces[ *it ].data;
 
 		// if this surface is not a grid
 		if ( grid2->surfaceType != surfaceType_t::SF_GRID )
@@ -2523,14 +2627,17 @@ might still appear at that side.
 */
 int R_TryStitchingPatch( int grid1num )
 {
-	int           j, numstitches;
+	int           numstitches;
 	srfGridMesh_t *grid1, *grid2;
 
 	numstitches = 0;
 	grid1 = ( srfGridMesh_t * ) s_worldData.surfaces[ grid1num ].data;
 
-	for ( j = 0; j < s_worldData.numSurfaces; j++ )
+	for ( int j : R_LodGroup( grid1 ) )
 	{
+		// stitching may have reallocated grid1
+		grid1 = ( srfGridMesh_t * ) s_worldData.surfaces[ grid1num ].data;
+
 		//
 		grid2 = ( srfGridMesh_t * ) s_worldData.surfaces[ j ].data;
 
@@ -2619,50 +2726,77 @@ void R_StitchAllPatches()
 	Log::Debug("stitched %d LoD cracks", numstitches );
 }
 
+// the indexes of the grid surfaces, one R_MovePatchSurfaceToHunk job each
+static std::vector<int> patchSurfaces;
+
 /*
 ===============
-R_MovePatchSurfacesToHunk
+R_MovePatchSurfaceToHunk
+
+Every job thread copies the grids into its own part of the hunk, so
+they don't wait for each other on the hunk lock
 ===============
 */
-void R_MovePatchSurfacesToHunk()
+static void R_MovePatchSurfaceToHunk( int index )
 {
-	int           i, size;
-	srfGridMesh_t *grid, *hunkgrid;
+	static thread_local hunkSubArena_t arena;
+	static thread_local bool           arenaInitialized;
+	bspSurface_t                       *surface = &s_worldData.surfaces[ patchSurfaces[ index ] ];
+	srfGridMesh_t                      *grid, *hunkgrid;
+	int                                size;
 
-	for ( i = 0; i < s_worldData.numSurfaces; i++ )
+	if ( !arenaInitialized )
 	{
-		//
-		grid = ( srfGridMesh_t * ) s_worldData.surfaces[ i ].data;
+		ri.Hunk_InitSubArena( &arena, hunkTag_t::HT_BSP );
+		arenaInitialized = true;
+	}
 
-		// if this surface is not a grid
-		if ( grid->surfaceType != surfaceType_t::SF_GRID )
-		{
-			continue;
-		}
+	grid = ( srfGridMesh_t * ) surface->data;
 
-		//
-		size = sizeof( *grid );
-		hunkgrid = (srfGridMesh_t*) ri.Hunk_Alloc( size, ha_pref::h_low );
-		Com_Memcpy( hunkgrid, grid, size );
+	//
+	size = sizeof( *grid );
+	hunkgrid = (srfGridMesh_t*) ri.Hunk_SubArenaAlloc( &arena, size );
+	Com_Memcpy( hunkgrid, grid, size );
+
+	hunkgrid->widthLodError = (float*) ri.Hunk_SubArenaAlloc( &arena, grid->width * 4 );
+	Com_Memcpy( hunkgrid->widthLodError, grid->widthLodError, grid->width * 4 );
 
-		hunkgrid->widthLodError = (float*) ri.Hunk_Alloc( grid->width * 4, ha_pref::h_low );
-		Com_Memcpy( hunkgrid->widthLodError, grid->widthLodError, grid->width * 4 );
+	hunkgrid->heightLodError = (float*) ri.Hunk_SubArenaAlloc( &arena, grid->height * 4 );
+	Com_Memcpy( hunkgrid->heightLodError, grid->heightLodError, grid->height * 4 );
 
-		hunkgrid->heightLodError = (float*) ri.Hunk_Alloc( grid->height * 4, ha_pref::h_low );
-		Com_Memcpy( hunkgrid->heightLodError, grid->heightLodError, grid->height * 4 );
+	hunkgrid->numTriangles = grid->numTriangles;
+	hunkgrid->triangles = (srfTriangle_t*) ri.Hunk_SubArenaAlloc( &arena, grid->numTriangles * sizeof( srfTriangle_t ) );
+	Com_Memcpy( hunkgrid->triangles, grid->triangles, grid->numTriangles * sizeof( srfTriangle_t ) );
 
-		hunkgrid->numTriangles = grid->numTriangles;
-		hunkgrid->triangles = (srfTriangle_t*) ri.Hunk_Alloc( grid->numTriangles * sizeof( srfTriangle_t ), ha_pref::h_low );
-		Com_Memcpy( hunkgrid->triangles, grid->triangles, grid->numTriangles * sizeof( srfTriangle_t ) );
+	hunkgrid->numVerts = grid->numVerts;
+	hunkgrid->verts = (srfVert_t*) ri.Hunk_SubArenaAlloc( &arena, grid->numVerts * sizeof( srfVert_t ) );
+	Com_Memcpy( hunkgrid->verts, grid->verts, grid->numVerts * sizeof( srfVert_t ) );
 
-		hunkgrid->numVerts = grid->numVerts;
-		hunkgrid->verts = (srfVert_t*) ri.Hunk_Alloc( grid->numVerts * sizeof( srfVert_t ), ha_pref::h_low );
-		Com_Memcpy( hunkgrid->verts, grid->verts, grid->numVerts * sizeof( srfVert_t ) );
+	R_FreeSurfaceGridMesh( grid );
 
-		R_FreeSurfaceGridMesh( grid );
+	surface->data = ( surfaceType_t * ) hunkgrid;
+}
 
-		s_worldData.surfaces[ i ].data = ( surfaceType_t * ) hunkgrid;
+/*
+===============
+R_MovePatchSurfacesToHunk
+===============
+*/
+void R_MovePatchSurfacesToHunk()
+{
+	for ( int i = 0; i < s_worldData.numSurfaces; i++ )
+	{
+		// if this surface is a grid
+		if ( *s_worldData.surfaces[ i ].data == surfaceType_t::SF_GRID )
+		{
+			patchSurfaces.push_back( i );
+		}
 	}
+
+	R_RunJobs( patchSurfaces.size(), R_MovePatchSurfaceToHunk );
+
+	patchSurfaces.clear();
+	patchSurfaces.shrink_to_fit();
 }
 
 static void CopyVert( const srfVert_t *in, srfVert_t *out )
@@ -2778,87 +2912,16 @@ static int LeafSurfaceCompare( const void *a, const void *b )
 
 /*
 ===============
-R_CreateWorldVBO
+R_MarkMergeableSurfaces
+
+Gives the surfaces of a leaf that share shader, fog and lightmap the
+same viewCount so that R_CreateWorldVBO can merge them
 ===============
 */
-static void R_CreateWorldVBO()
+static void R_MarkMergeableSurfaces()
 {
-	int       i, j, k;
-
-	int       numVerts;
-	srfVert_t *verts;
-	shaderVertex_t *vboVerts;
-	glIndex_t      *vboIdxs;
-
-	int           numTriangles;
-	srfTriangle_t *triangles;
-
-	int            numSurfaces;
-	bspSurface_t  *surface;
-	bspSurface_t  **surfaces;
-	bspSurface_t  *mergedSurf;
-	int           startTime, endTime;
-
-	startTime = ri.Milliseconds();
-
-	numVerts = 0;
-	numTriangles = 0;
-	numSurfaces = 0;
-
-	for ( k = 0; k < s_worldData.numSurfaces; k++ )
-	{
-		surface = &s_worldData.surfaces[ k ];
-
-		if ( surface->shader->isSky || surface->shader->isPortal )
-		{
-			continue;
-		}
-
-		if ( *surface->data == surfaceType_t::SF_FACE )
-		{
-			srfSurfaceFace_t *face = ( srfSurfaceFace_t * ) surface->data;
-
-			numVerts += face->numVerts;
-			numTriangles += face->numTriangles;
-		}
-		else if ( *surface->data == surfaceType_t::SF_GRID )
-		{
-			srfGridMesh_t *grid = ( srfGridMesh_t * ) surface->data;
-
-			numVerts += grid->numVerts;
-			numTriangles += grid->numTriangles;
-		}
-		else if ( *surface->data == surfaceType_t::SF_TRIANGLES )
-		{
-			srfTriangles_t *tri = ( srfTriangles_t * ) surface->data;
-
-			numVerts += tri->numVerts;
-			numTriangles += tri->numTriangles;
-		}
-		else
-		{
-			continue;
-		}
-
-		numSurfaces++;
-	}
-
-	if ( !numVerts || !numTriangles || !numSurfaces )
-	{
-		return;
-	}
-
-	// reset surface view counts
-	for ( i = 0; i < s_worldData.numSurfaces; i++ )
-	{
-		surface = &s_worldData.surfaces[ i ];
-
-		surface->viewCount = -1;
-		surface->lightCount = -1;
-		surface->interactionBits = 0;
-	}
+	int i, j, k;
 
-	// mark matching surfaces
 	for ( i = 0; i < s_worldData.numnodes - s_worldData.numDecisionNodes; i++ )
 	{
 		bspNode_t *leaf = s_worldData.nodes + s_worldData.numDecisionNodes + i;
@@ -2909,67 +2972,812 @@ static void R_CreateWorldVBO()
 					continue;
 				}
 
-				if ( *surf2->data != surfaceType_t::SF_GRID && *surf2->data != surfaceType_t::SF_TRIANGLES && *surf2->data != surfaceType_t::SF_FACE )
-				{
-					continue;
-				}
+				if ( *surf2->data != surfaceType_t::SF_GRID && *surf2->data != surfaceType_t::SF_TRIANGLES && *surf2->data != surfaceType_t::SF_FACE )
+				{
+					continue;
+				}
+
+				shader2 = surf2->shader;
+				fogIndex2 = surf2->fogIndex;
+				lightMapNum2 = surf2->lightmapNum;
+				if ( shader1 != shader2 || fogIndex1 != fogIndex2 || lightMapNum1 != lightMapNum2 )
+				{
+					continue;
+				}
+
+				surf2->viewCount = surf1->viewCount;
+				surf2->lightCount = k;
+				surf2->interactionBits = i;
+				merged = true;
+			}
+
+			if ( !merged )
+			{
+				surf1->viewCount = -1;
+				surf1->lightCount = -1;
+				// don't clear the leaf number so
+				// surfaces that arn't merged are placed
+				// closer to other leafs in the vbo
+			}
+		}
+	}
+}
+
+/*
+============================================================================
+
+WORLD CACHE
+
+The output of the slow steps of the map loading is saved to the homepath
+and loaded from there the next time the map is loaded:
+- the patch grids after tessellation, stitching and the LoD crack fixes
+- the sorted surface order, the leaf merge groups and the contents of the
+  world VBO and IBO
+- the surfaces and leafs lit by every static light
+
+The cache is keyed on the checksum of the BSP file, worldCacheVersion and
+the settings the loading depends on, and is checked before the surfaces
+are loaded. The VBO and the interactions also depend on the shaders,
+which live outside of the BSP, so their sections carry a checksum of the
+shader properties they read and are rebuilt on their own when it changes.
+
+Bump worldCacheVersion whenever the loading code or a cached format changes.
+
+============================================================================
+*/
+
+static const char worldCacheDir[] = "cache/world/";
+static const char worldCacheMagic[ 4 ] = { 'D', 'W', 'V', 'B' };
+static const int  worldCacheVersion = 2;
+
+enum worldCacheSection_t
+{
+	WCS_GRIDS,
+	WCS_VBO,
+	WCS_INTERACTIONS,
+	WCS_NUM_SECTIONS
+};
+
+struct worldCacheHeader_t
+{
+	char     magic[ 4 ];
+	int      version;
+	uint32_t bspChecksum;
+	uint32_t settingsKey;
+	uint32_t sectionOffsets[ WCS_NUM_SECTIONS ];
+	uint32_t sectionSizes[ WCS_NUM_SECTIONS ];
+};
+
+// one per world VBO surface, in VBO order
+struct worldCacheSurface_t
+{
+	int index;
+	int mergeGroup;
+};
+
+// reads a section of the mapped cache, arrays are used in place
+struct worldCacheReader_t
+{
+	const byte *data;
+	size_t     size;
+	size_t     offset;
+
+	bool Read( void *out, size_t length )
+	{
+		if ( length > size - offset )
+		{
+			return false;
+		}
+
+		memcpy( out, data + offset, length );
+		offset += length;
+		return true;
+	}
+
+	template<typename T>
+	bool Read( T &value )
+	{
+		return Read( &value, sizeof( T ) );
+	}
+
+	// returns nullptr if the section is too short
+	const byte *Array( int count, size_t elementSize )
+	{
+		offset = std::min( static_cast<size_t>( PAD( offset, 16 ) ), size );
+
+		if ( count < 0 || static_cast<size_t>( count ) > ( size - offset ) / elementSize )
+		{
+			return nullptr;
+		}
+
+		const byte *array = data + offset;
+		offset += count * elementSize;
+		return array;
+	}
+};
+
+// builds a section, arrays start on 16 bytes from the start of the file
+struct worldCacheWriter_t
+{
+	std::vector<byte> data;
+
+	void Write( const void *in, size_t length )
+	{
+		const byte *bytes = static_cast<const byte *>( in );
+		data.insert( data.end(), bytes, bytes + length );
+	}
+
+	template<typename T>
+	void Write( const T &value )
+	{
+		Write( &value, sizeof( T ) );
+	}
+
+	void WriteArray( const void *in, int count, size_t elementSize )
+	{
+		data.resize( PAD( data.size(), 16 ) );
+		Write( in, count * elementSize );
+	}
+};
+
+struct worldCache_t
+{
+	bool               enabled;
+	uint32_t           bspChecksum;
+	uint32_t           settingsKey;
+	uint32_t           shaderKey;
+	FS::MappedFile     mapping;
+	worldCacheReader_t sections[ WCS_NUM_SECTIONS ]; // empty if the cache didn't match
+	worldCacheWriter_t rebuilt[ WCS_NUM_SECTIONS ];
+	bool               isRebuilt[ WCS_NUM_SECTIONS ];
+};
+
+static worldCache_t s_worldCache;
+
+static std::string R_WorldCachePath()
+{
+	return Str::Format( "%s%s.wvbo", worldCacheDir, s_worldData.baseName );
+}
+
+static bool R_WorldCacheCorrupted()
+{
+	Log::Warn( "The world cache of %s is corrupted", s_worldData.name );
+	return false;
+}
+
+/*
+===============
+R_WorldSettingsKey
+
+Checksum of the settings that change the loaded surfaces and lights
+===============
+*/
+static uint32_t R_WorldSettingsKey()
+{
+	int settings[] = { r_vertexLighting->integer, r_precomputedLighting->integer, r_singleShader->integer,
+	                   r_stitchCurves->integer, tr.mapOverBrightBits, tr.overbrightBits, tr.fatLightmapSize,
+	                   tr.fatLightmapStep, tr.worldDeluxeMapping, static_cast<int>( sizeof( srfVert_t ) ),
+	                   static_cast<int>( sizeof( srfGridMesh_t ) ), static_cast<int>( sizeof( shaderVertex_t ) ),
+	                   static_cast<int>( sizeof( glIndex_t ) ) };
+	float subdivisions = r_subdivisions->value;
+	uLong crc = crc32( 0, Z_NULL, 0 );
+
+	crc = crc32( crc, reinterpret_cast<const Bytef *>( settings ), sizeof( settings ) );
+	crc = crc32( crc, reinterpret_cast<const Bytef *>( &subdivisions ), sizeof( subdivisions ) );
+
+	return crc;
+}
+
+/*
+===============
+R_WorldShaderKey
+
+Checksum of the shader properties the world VBO and the interactions
+depend on
+===============
+*/
+static uint32_t R_WorldShaderKey()
+{
+	std::unordered_map<const shader_t *, int> shaderClasses;
+	uLong crc = crc32( 0, Z_NULL, 0 );
+
+	for ( int i = 0; i < s_worldData.numSurfaces; i++ )
+	{
+		const bspSurface_t *surface = &s_worldData.surfaces[ i ];
+
+		// shader pointers change from one run to the next, use the
+		// first surface with the same shader instead
+		int shaderClass = shaderClasses.emplace( surface->shader, i ).first->second;
+		int info[] = { shaderClass, surface->shader->autoSpriteMode, surface->shader->isSky, surface->shader->isPortal,
+		               surface->shader->interactLight, surface->shader->noShadows };
+
+		crc = crc32( crc, reinterpret_cast<const Bytef *>( info ), sizeof( info ) );
+	}
+
+	return crc;
+}
+
+/*
+===============
+R_OpenWorldCache
+
+Maps the world cache of the map being loaded if it was built from the
+same BSP file with the same settings, must be called once the
+lightmaps are loaded
+===============
+*/
+static void R_OpenWorldCache( uint32_t bspChecksum )
+{
+	s_worldCache.mapping = FS::MappedFile();
+
+	for ( int i = 0; i < WCS_NUM_SECTIONS; i++ )
+	{
+		s_worldCache.sections[ i ] = { nullptr, 0, 0 };
+		s_worldCache.rebuilt[ i ].data.clear();
+		s_worldCache.isRebuilt[ i ] = false;
+	}
+
+	s_worldCache.enabled = r_worldCache->integer != 0;
+
+	if ( !s_worldCache.enabled )
+	{
+		return;
+	}
+
+	s_worldCache.bspChecksum = bspChecksum;
+	s_worldCache.settingsKey = R_WorldSettingsKey();
+
+	std::error_code err;
+	FS::File file = FS::HomePath::OpenRead( R_WorldCachePath(), err );
+
+	if ( err )
+	{
+		return;
+	}
+
+	s_worldCache.mapping = FS::MappedFile::Map( file, err );
+
+	if ( err )
+	{
+		Log::Warn( "Couldn't map the world cache of %s: %s", s_worldData.name, err.message() );
+		return;
+	}
+
+	const byte *data = static_cast<const byte *>( s_worldCache.mapping.Data() );
+	size_t size = s_worldCache.mapping.Size();
+	worldCacheHeader_t header;
+
+	if ( size < sizeof( header ) )
+	{
+		R_WorldCacheCorrupted();
+		return;
+	}
+
+	memcpy( &header, data, sizeof( header ) );
+
+	if ( memcmp( header.magic, worldCacheMagic, sizeof( worldCacheMagic ) ) || header.version != worldCacheVersion
+	     || header.bspChecksum != s_worldCache.bspChecksum || header.settingsKey != s_worldCache.settingsKey )
+	{
+		Log::Debug( "world cache of %s is out of date", s_worldData.name );
+		return;
+	}
+
+	for ( int i = 0; i < WCS_NUM_SECTIONS; i++ )
+	{
+		if ( ( header.sectionOffsets[ i ] & 15 ) || header.sectionOffsets[ i ] > size
+		     || header.sectionSizes[ i ] > size - header.sectionOffsets[ i ] )
+		{
+			R_WorldCacheCorrupted();
+			return;
+		}
+	}
+
+	for ( int i = 0; i < WCS_NUM_SECTIONS; i++ )
+	{
+		s_worldCache.sections[ i ] = { data + header.sectionOffsets[ i ], header.sectionSizes[ i ], 0 };
+	}
+}
+
+/*
+===============
+R_CloseWorldCache
+
+Saves the cache again if any section had to be rebuilt
+===============
+*/
+static void R_CloseWorldCache()
+{
+	static const char padding[ 16 ] = {};
+	bool save = false;
+
+	for ( int i = 0; i < WCS_NUM_SECTIONS; i++ )
+	{
+		save |= s_worldCache.isRebuilt[ i ];
+	}
+
+	if ( s_worldCache.enabled && save )
+	{
+		const byte *sections[ WCS_NUM_SECTIONS ];
+		worldCacheHeader_t header;
+		uint32_t offset = PAD( sizeof( header ), 16 );
+
+		memcpy( header.magic, worldCacheMagic, sizeof( worldCacheMagic ) );
+		header.version = worldCacheVersion;
+		header.bspChecksum = s_worldCache.bspChecksum;
+		header.settingsKey = s_worldCache.settingsKey;
+
+		for ( int i = 0; i < WCS_NUM_SECTIONS; i++ )
+		{
+			// the sections that were still good are copied from the old cache
+			if ( s_worldCache.isRebuilt[ i ] )
+			{
+				sections[ i ] = s_worldCache.rebuilt[ i ].data.data();
+				header.sectionSizes[ i ] = s_worldCache.rebuilt[ i ].data.size();
+			}
+			else
+			{
+				sections[ i ] = s_worldCache.sections[ i ].data;
+				header.sectionSizes[ i ] = s_worldCache.sections[ i ].size;
+			}
+
+			header.sectionOffsets[ i ] = offset;
+			offset = PAD( offset + header.sectionSizes[ i ], 16 );
+		}
+
+		std::string path = R_WorldCachePath();
+		std::string tempPath = path + ".tmp";
+
+		// an interrupted write never leaves a truncated cache behind
+		try
+		{
+			FS::File file = FS::HomePath::OpenWrite( tempPath );
+			file.Write( &header, sizeof( header ) );
+			file.Write( padding, header.sectionOffsets[ 0 ] - sizeof( header ) );
+
+			for ( int i = 0; i < WCS_NUM_SECTIONS; i++ )
+			{
+				file.Write( sections[ i ], header.sectionSizes[ i ] );
+				file.Write( padding, PAD( header.sectionSizes[ i ], 16 ) - header.sectionSizes[ i ] );
+			}
+
+			file.Close();
+
+			// the old cache may still be mapped
+			s_worldCache.mapping = FS::MappedFile();
+			FS::HomePath::MoveFile( path, tempPath );
+		}
+		catch ( std::system_error &err )
+		{
+			Log::Warn( "Couldn't save the world cache of %s: %s", s_worldData.name, err.what() );
+			std::error_code ignored;
+			FS::HomePath::DeleteFile( tempPath, ignored );
+		}
+	}
+
+	s_worldCache.mapping = FS::MappedFile();
+
+	for ( int i = 0; i < WCS_NUM_SECTIONS; i++ )
+	{
+		s_worldCache.sections[ i ] = { nullptr, 0, 0 };
+		s_worldCache.rebuilt[ i ].data.clear();
+		s_worldCache.rebuilt[ i ].data.shrink_to_fit();
+		s_worldCache.isRebuilt[ i ] = false;
+	}
+}
+
+/*
+===============
+R_LoadCachedGrids
+
+Replaces the tessellation, stitching and LoD crack fixes of the patches
+that ParseMesh queued
+===============
+*/
+static bool R_LoadCachedGrids()
+{
+	struct cachedGrid_t
+	{
+		srfGridMesh_t grid;
+		const byte    *widthLodError;
+		const byte    *heightLodError;
+		const byte    *triangles;
+		const byte    *verts;
+	};
+
+	worldCacheReader_t reader = s_worldCache.sections[ WCS_GRIDS ];
+	int numGrids;
+
+	if ( !reader.size )
+	{
+		return false;
+	}
+
+	if ( !reader.Read( numGrids ) || numGrids != static_cast<int>( meshJobs.size() ) )
+	{
+		return R_WorldCacheCorrupted();
+	}
+
+	std::vector<cachedGrid_t> grids( numGrids );
+
+	// check everything before touching the surfaces
+	for ( int i = 0; i < numGrids; i++ )
+	{
+		cachedGrid_t  &cached = grids[ i ];
+		srfGridMesh_t &grid = cached.grid;
+		int           index;
+
+		if ( !reader.Read( index ) || index != meshJobs[ i ].surf - s_worldData.surfaces || !reader.Read( grid )
+		     || grid.surfaceType != surfaceType_t::SF_GRID
+		     || grid.width < 1 || grid.width > MAX_GRID_SIZE || grid.height < 1 || grid.height > MAX_GRID_SIZE
+		     || grid.numVerts != grid.width * grid.height
+		     || grid.numTriangles < 0 || grid.numTriangles > 2 * ( grid.width - 1 ) * ( grid.height - 1 ) )
+		{
+			return R_WorldCacheCorrupted();
+		}
+
+		cached.widthLodError = reader.Array( grid.width, sizeof( float ) );
+		cached.heightLodError = reader.Array( grid.height, sizeof( float ) );
+		cached.triangles = reader.Array( grid.numTriangles, sizeof( srfTriangle_t ) );
+		cached.verts = reader.Array( grid.numVerts, sizeof( srfVert_t ) );
+
+		if ( !cached.widthLodError || !cached.heightLodError || !cached.triangles || !cached.verts )
+		{
+			return R_WorldCacheCorrupted();
+		}
+
+		for ( int j = 0; j < grid.numTriangles; j++ )
+		{
+			srfTriangle_t triangle;
+			memcpy( &triangle, cached.triangles + j * sizeof( triangle ), sizeof( triangle ) );
+
+			for ( int k = 0; k < 3; k++ )
+			{
+				if ( triangle.indexes[ k ] < 0 || triangle.indexes[ k ] >= grid.numVerts )
+				{
+					return R_WorldCacheCorrupted();
+				}
+			}
+		}
+	}
+
+	for ( int i = 0; i < numGrids; i++ )
+	{
+		const cachedGrid_t &cached = grids[ i ];
+		srfGridMesh_t      *grid = ( srfGridMesh_t * ) ri.Hunk_Alloc( sizeof( *grid ), hunkTag_t::HT_BSP );
+
+		*grid = cached.grid;
+		grid->widthLodError = ( float * ) ri.Hunk_Alloc( grid->width * sizeof( float ), hunkTag_t::HT_BSP );
+		grid->heightLodError = ( float * ) ri.Hunk_Alloc( grid->height * sizeof( float ), hunkTag_t::HT_BSP );
+		grid->triangles = ( srfTriangle_t * ) ri.Hunk_Alloc( grid->numTriangles * sizeof( srfTriangle_t ), hunkTag_t::HT_BSP );
+		grid->verts = ( srfVert_t * ) ri.Hunk_Alloc( grid->numVerts * sizeof( srfVert_t ), hunkTag_t::HT_BSP );
+		grid->vbo = nullptr;
+		grid->ibo = nullptr;
+
+		Com_Memcpy( grid->widthLodError, cached.widthLodError, grid->width * sizeof( float ) );
+		Com_Memcpy( grid->heightLodError, cached.heightLodError, grid->height * sizeof( float ) );
+		Com_Memcpy( grid->triangles, cached.triangles, grid->numTriangles * sizeof( srfTriangle_t ) );
+		Com_Memcpy( grid->verts, cached.verts, grid->numVerts * sizeof( srfVert_t ) );
+
+		meshJobs[ i ].surf->data = ( surfaceType_t * ) grid;
+	}
+
+	Log::Debug( "...using %i cached patch grids", numGrids );
+	return true;
+}
+
+/*
+===============
+R_StoreGrids
+===============
+*/
+static void R_StoreGrids()
+{
+	if ( !s_worldCache.enabled )
+	{
+		return;
+	}
+
+	worldCacheWriter_t &writer = s_worldCache.rebuilt[ WCS_GRIDS ];
+	int numGrids = 0;
+
+	for ( int i = 0; i < s_worldData.numSurfaces; i++ )
+	{
+		if ( *s_worldData.surfaces[ i ].data == surfaceType_t::SF_GRID )
+		{
+			numGrids++;
+		}
+	}
+
+	writer.Write( numGrids );
+
+	for ( int i = 0; i < s_worldData.numSurfaces; i++ )
+	{
+		if ( *s_worldData.surfaces[ i ].data != surfaceType_t::SF_GRID )
+		{
+			continue;
+		}
+
+		const srfGridMesh_t *grid = ( const srfGridMesh_t * ) s_worldData.surfaces[ i ].data;
+		srfGridMesh_t header = *grid;
+
+		// the pointers are set up again when loading
+		header.widthLodError = header.heightLodError = nullptr;
+		header.triangles = nullptr;
+		header.verts = nullptr;
+		header.vbo = nullptr;
+		header.ibo = nullptr;
+
+		writer.Write( i );
+		writer.Write( header );
+		writer.WriteArray( grid->widthLodError, grid->width, sizeof( float ) );
+		writer.WriteArray( grid->heightLodError, grid->height, sizeof( float ) );
+		writer.WriteArray( grid->triangles, grid->numTriangles, sizeof( srfTriangle_t ) );
+		writer.WriteArray( grid->verts, grid->numVerts, sizeof( srfVert_t ) );
+	}
+
+	s_worldCache.isRebuilt[ WCS_GRIDS ] = true;
+}
+
+/*
+===============
+R_LoadCachedWorldVBO
+
+Checks the cached world VBO against the surfaces of the map, the
+returned arrays point into the mapping
+===============
+*/
+static bool R_LoadCachedWorldVBO( int numSurfaces, int numVerts, int numTriangles,
+				  const worldCacheSurface_t **surfaces, const shaderVertex_t **verts, const glIndex_t **indexes )
+{
+	worldCacheReader_t reader = s_worldCache.sections[ WCS_VBO ];
+	uint32_t shaderKey;
+	int cachedNumSurfaces, cachedNumVerts, cachedNumTriangles;
+
+	if ( !reader.size )
+	{
+		return false;
+	}
+
+	if ( !reader.Read( shaderKey ) || !reader.Read( cachedNumSurfaces ) || !reader.Read( cachedNumVerts )
+	     || !reader.Read( cachedNumTriangles ) )
+	{
+		return R_WorldCacheCorrupted();
+	}
+
+	if ( shaderKey != s_worldCache.shaderKey )
+	{
+		Log::Debug( "world VBO cache of %s is out of date", s_worldData.name );
+		return false;
+	}
+
+	if ( cachedNumSurfaces != numSurfaces || cachedNumVerts != numVerts || cachedNumTriangles != numTriangles )
+	{
+		return R_WorldCacheCorrupted();
+	}
+
+	*surfaces = reinterpret_cast<const worldCacheSurface_t *>( reader.Array( numSurfaces, sizeof( worldCacheSurface_t ) ) );
+	*verts = reinterpret_cast<const shaderVertex_t *>( reader.Array( numVerts, sizeof( shaderVertex_t ) ) );
+	*indexes = reinterpret_cast<const glIndex_t *>( reader.Array( 3 * numTriangles, sizeof( glIndex_t ) ) );
+
+	if ( !*surfaces || !*verts || !*indexes )
+	{
+		return R_WorldCacheCorrupted();
+	}
+
+	// everything below is used as an index
+	std::vector<bool> used( s_worldData.numSurfaces, false );
+
+	for ( int i = 0; i < numSurfaces; i++ )
+	{
+		int index = ( *surfaces )[ i ].index;
+		int mergeGroup = ( *surfaces )[ i ].mergeGroup;
+
+		if ( index < 0 || index >= s_worldData.numSurfaces || used[ index ]
+		     || mergeGroup < -1 || mergeGroup >= s_worldData.numSurfaces )
+		{
+			return R_WorldCacheCorrupted();
+		}
+
+		const bspSurface_t *surface = &s_worldData.surfaces[ index ];
+
+		if ( surface->shader->isSky || surface->shader->isPortal
+		     || ( *surface->data != surfaceType_t::SF_FACE && *surface->data != surfaceType_t::SF_GRID
+		          && *surface->data != surfaceType_t::SF_TRIANGLES ) )
+		{
+			return R_WorldCacheCorrupted();
+		}
+
+		used[ index ] = true;
+	}
+
+	for ( int i = 0; i < 3 * numTriangles; i++ )
+	{
+		if ( ( *indexes )[ i ] >= ( glIndex_t ) numVerts )
+		{
+			return R_WorldCacheCorrupted();
+		}
+	}
+
+	return true;
+}
+
+/*
+===============
+R_StoreWorldVBO
+===============
+*/
+static void R_StoreWorldVBO( bspSurface_t **surfaces, int numSurfaces, const shaderVertex_t *verts, int numVerts,
+			     const glIndex_t *indexes, int numTriangles )
+{
+	if ( !s_worldCache.enabled )
+	{
+		return;
+	}
+
+	worldCacheWriter_t &writer = s_worldCache.rebuilt[ WCS_VBO ];
+	std::vector<worldCacheSurface_t> cachedSurfaces( numSurfaces );
+
+	for ( int i = 0; i < numSurfaces; i++ )
+	{
+		cachedSurfaces[ i ].index = surfaces[ i ] - s_worldData.surfaces;
+		cachedSurfaces[ i ].mergeGroup = surfaces[ i ]->viewCount;
+	}
+
+	writer.Write( s_worldCache.shaderKey );
+	writer.Write( numSurfaces );
+	writer.Write( numVerts );
+	writer.Write( numTriangles );
+	writer.WriteArray( cachedSurfaces.data(), numSurfaces, sizeof( worldCacheSurface_t ) );
+	writer.WriteArray( verts, numVerts, sizeof( shaderVertex_t ) );
+	writer.WriteArray( indexes, 3 * numTriangles, sizeof( glIndex_t ) );
+
+	s_worldCache.isRebuilt[ WCS_VBO ] = true;
+}
+
+/*
+===============
+R_CreateWorldVBO
+===============
+*/
+static void R_CreateWorldVBO()
+{
+	int       i, j, k;
+
+	int       numVerts;
+	srfVert_t *verts;
+	shaderVertex_t *vboVerts;
+	glIndex_t      *vboIdxs;
+
+	int           numTriangles;
+	srfTriangle_t *triangles;
+
+	int            numSurfaces;
+	bspSurface_t  *surface;
+	bspSurface_t  **surfaces;
+	bspSurface_t  *mergedSurf;
+	int           startTime, endTime;
+
+	const worldCacheSurface_t *cachedSurfaces = nullptr;
+	const shaderVertex_t      *cachedVerts = nullptr;
+	const glIndex_t           *cachedIndexes = nullptr;
+	bool                      cached;
+
+	startTime = ri.Milliseconds();
+
+	numVerts = 0;
+	numTriangles = 0;
+	numSurfaces = 0;
+
+	for ( k = 0; k < s_worldData.numSurfaces; k++ )
+	{
+		surface = &s_worldData.surfaces[ k ];
+
+		if ( surface->shader->isSky || surface->shader->isPortal )
+		{
+			continue;
+		}
+
+		if ( *surface->data == surfaceType_t::SF_FACE )
+		{
+			srfSurfaceFace_t *face = ( srfSurfaceFace_t * ) surface->data;
+
+			numVerts += face->numVerts;
+			numTriangles += face->numTriangles;
+		}
+		else if ( *surface->data == surfaceType_t::SF_GRID )
+		{
+			srfGridMesh_t *grid = ( srfGridMesh_t * ) surface->data;
+
+			numVerts += grid->numVerts;
+			numTriangles += grid->numTriangles;
+		}
+		else if ( *surface->data == surfaceType_t::SF_TRIANGLES )
+		{
+			srfTriangles_t *tri = ( srfTriangles_t * ) surface->data;
+
+			numVerts += tri->numVerts;
+			numTriangles += tri->numTriangles;
+		}
+		else
+		{
+			continue;
+		}
+
+		numSurfaces++;
+	}
 
-				shader2 = surf2->shader;
-				fogIndex2 = surf2->fogIndex;
-				lightMapNum2 = surf2->lightmapNum;
-				if ( shader1 != shader2 || fogIndex1 != fogIndex2 || lightMapNum1 != lightMapNum2 )
-				{
-					continue;
-				}
+	if ( !numVerts || !numTriangles || !numSurfaces )
+	{
+		return;
+	}
 
-				surf2->viewCount = surf1->viewCount;
-				surf2->lightCount = k;
-				surf2->interactionBits = i;
-				merged = true;
-			}
+	// reset surface view counts
+	for ( i = 0; i < s_worldData.numSurfaces; i++ )
+	{
+		surface = &s_worldData.surfaces[ i ];
 
-			if ( !merged )
-			{
-				surf1->viewCount = -1;
-				surf1->lightCount = -1;
-				// don't clear the leaf number so
-				// surfaces that arn't merged are placed
-				// closer to other leafs in the vbo
-			}
-		}
+		surface->viewCount = -1;
+		surface->lightCount = -1;
+		surface->interactionBits = 0;
 	}
 
+	cached = R_LoadCachedWorldVBO( numSurfaces, numVerts, numTriangles, &cachedSurfaces, &cachedVerts, &cachedIndexes );
+
 	surfaces = ( bspSurface_t ** ) ri.Hunk_AllocateTempMemory( sizeof( *surfaces ) * numSurfaces );
 
-	numSurfaces = 0;
-	for ( k = 0; k < s_worldData.numSurfaces; k++ )
+	if ( cached )
 	{
-		surface = &s_worldData.surfaces[ k ];
+		Log::Debug( "...using the cached world VBO" );
 
-		if ( surface->shader->isSky || surface->shader->isPortal )
+		for ( k = 0; k < numSurfaces; k++ )
 		{
-			continue;
+			surfaces[ k ] = &s_worldData.surfaces[ cachedSurfaces[ k ].index ];
+			surfaces[ k ]->viewCount = cachedSurfaces[ k ].mergeGroup;
 		}
+	}
+	else
+	{
+		R_MarkMergeableSurfaces();
 
-		if ( *surface->data == surfaceType_t::SF_FACE || *surface->data == surfaceType_t::SF_GRID || *surface->data == surfaceType_t::SF_TRIANGLES )
+		numSurfaces = 0;
+		for ( k = 0; k < s_worldData.numSurfaces; k++ )
 		{
-			surfaces[ numSurfaces++ ] = surface;
+			surface = &s_worldData.surfaces[ k ];
+
+			if ( surface->shader->isSky || surface->shader->isPortal )
+			{
+				continue;
+			}
+
+			if ( *surface->data == surfaceType_t::SF_FACE || *surface->data == surfaceType_t::SF_GRID || *surface->data == surfaceType_t::SF_TRIANGLES )
+			{
+				surfaces[ numSurfaces++ ] = surface;
+			}
 		}
-	}
 
-	qsort( surfaces, numSurfaces, sizeof( *surfaces ), LeafSurfaceCompare );
+		qsort( surfaces, numSurfaces, sizeof( *surfaces ), LeafSurfaceCompare );
+	}
 
 	Log::Debug("...calculating world VBO ( %i verts %i tris )", numVerts, numTriangles );
 
 	// create arrays
 	s_worldData.numVerts = numVerts;
-	s_worldData.verts = verts = (srfVert_t*) ri.Hunk_Alloc( numVerts * sizeof( srfVert_t ), ha_pref::h_low );
+	s_worldData.verts = verts = (srfVert_t*) ri.Hunk_Alloc( numVerts * sizeof( srfVert_t ), hunkTag_t::HT_BSP );
 
 	s_worldData.numTriangles = numTriangles;
-	s_worldData.triangles = triangles = (srfTriangle_t*) ri.Hunk_Alloc( numTriangles * sizeof( srfTriangle_t ), ha_pref::h_low );
+	s_worldData.triangles = triangles = (srfTriangle_t*) ri.Hunk_Alloc( numTriangles * sizeof( srfTriangle_t ), hunkTag_t::HT_BSP );
 
-	vboVerts = (shaderVertex_t *)ri.Hunk_AllocateTempMemory( numVerts * sizeof( shaderVertex_t ) );
-	vboIdxs = (glIndex_t *)ri.Hunk_AllocateTempMemory( 3 * numTriangles * sizeof( glIndex_t ) );
+	if ( cached )
+	{
+		// only read by GL
+		vboVerts = const_cast<shaderVertex_t *>( cachedVerts );
+		vboIdxs = const_cast<glIndex_t *>( cachedIndexes );
+	}
+	else
+	{
+		vboVerts = (shaderVertex_t *)ri.Hunk_AllocateTempMemory( numVerts * sizeof( shaderVertex_t ) );
+		vboIdxs = (glIndex_t *)ri.Hunk_AllocateTempMemory( 3 * numTriangles * sizeof( glIndex_t ) );
+	}
 
 	// set up triangle and vertex arrays
 	numVerts = 0;
@@ -3016,9 +3824,12 @@ static void R_CreateWorldVBO()
 				numVerts += srf->numVerts;
 			}
 
-			rb_surfaceTable[Util::ordinal(surfaceType_t::SF_FACE)](srf );
-			Tess_AutospriteDeform( surface->shader->autoSpriteMode, srf->firstVert, srf->numVerts,
-					       3 * srf->firstTriangle, 3 * srf->numTriangles );
+			if ( !cached )
+			{
+				rb_surfaceTable[Util::ordinal(surfaceType_t::SF_FACE)](srf );
+				Tess_AutospriteDeform( surface->shader->autoSpriteMode, srf->firstVert, srf->numVerts,
+						       3 * srf->firstTriangle, 3 * srf->numTriangles );
+			}
 		}
 		else if ( *surface->data == surfaceType_t::SF_GRID )
 		{
@@ -3052,9 +3863,12 @@ static void R_CreateWorldVBO()
 				numVerts += srf->numVerts;
 			}
 
-			rb_surfaceTable[Util::ordinal(surfaceType_t::SF_GRID)](srf );
-			Tess_AutospriteDeform( surface->shader->autoSpriteMode, srf->firstVert, srf->numVerts,
-					       3 * srf->firstTriangle, 3 * srf->numTriangles );
+			if ( !cached )
+			{
+				rb_surfaceTable[Util::ordinal(surfaceType_t::SF_GRID)](srf );
+				Tess_AutospriteDeform( surface->shader->autoSpriteMode, srf->firstVert, srf->numVerts,
+						       3 * srf->firstTriangle, 3 * srf->numTriangles );
+			}
 		}
 		else if ( *surface->data == surfaceType_t::SF_TRIANGLES )
 		{
@@ -3088,9 +3902,12 @@ static void R_CreateWorldVBO()
 				numVerts += srf->numVerts;
 			}
 
-			rb_surfaceTable[Util::ordinal(surfaceType_t::SF_TRIANGLES)](srf );
-			Tess_AutospriteDeform( surface->shader->autoSpriteMode, srf->firstVert, srf->numVerts,
-					       3 * srf->firstTriangle, 3 * srf->numTriangles );
+			if ( !cached )
+			{
+				rb_surfaceTable[Util::ordinal(surfaceType_t::SF_TRIANGLES)](srf );
+				Tess_AutospriteDeform( surface->shader->autoSpriteMode, srf->firstVert, srf->numVerts,
+						       3 * srf->firstTriangle, 3 * srf->numTriangles );
+			}
 		}
 	}
 
@@ -3105,8 +3922,13 @@ static void R_CreateWorldVBO()
 	tess.indexes = nullptr;
 	tess.buildingVBO = false;
 
-	ri.Hunk_FreeTempMemory( vboIdxs );
-	ri.Hunk_FreeTempMemory( vboVerts );
+	if ( !cached )
+	{
+		R_StoreWorldVBO( surfaces, numSurfaces, vboVerts, numVerts, vboIdxs, numTriangles );
+
+		ri.Hunk_FreeTempMemory( vboIdxs );
+		ri.Hunk_FreeTempMemory( vboVerts );
+	}
 
 	if ( r_mergeLeafSurfaces->integer )
 	{
@@ -3131,7 +3953,10 @@ static void R_CreateWorldVBO()
 		}
 
 		// Allocate merged surfaces
-		s_worldData.mergedSurfaces = ( bspSurface_t * ) ri.Hunk_Alloc( sizeof( *s_worldData.mergedSurfaces ) * numMergedSurfaces, ha_pref::h_low );
+		s_worldData.mergedSurfaces = ( bspSurface_t * ) ri.Hunk_Alloc( sizeof( *s_worldData.mergedSurfaces ) * numMergedSurfaces, hunkTag_t::HT_BSP );
+
+		// merged surface of each merge group, the viewCount of its first surface
+		std::vector<bspSurface_t *> mergedGroups( s_worldData.numSurfaces, nullptr );
 
 		// actually merge surfaces
 		mergedSurf = s_worldData.mergedSurfaces;
@@ -3215,7 +4040,7 @@ static void R_CreateWorldVBO()
 				continue;
 			}
 
-			vboSurf = ( srfVBOMesh_t * ) ri.Hunk_Alloc( sizeof( *vboSurf ), ha_pref::h_low );
+			vboSurf = ( srfVBOMesh_t * ) ri.Hunk_Alloc( sizeof( *vboSurf ), hunkTag_t::HT_BSP );
 			memset( vboSurf, 0, sizeof( *vboSurf ) );
 			vboSurf->surfaceType = surfaceType_t::SF_VBO_MESH;
 
@@ -3239,20 +4064,22 @@ static void R_CreateWorldVBO()
 			mergedSurf->lightmapNum = surf1->lightmapNum;
 			mergedSurf->viewCount = -1;
 
-			// redirect view surfaces to this surf
-			for ( k = 0; k < s_worldData.numMarkSurfaces; k++ )
-			{
-				bspSurface_t **view = s_worldData.viewSurfaces + k;
-
-				if ( ( *view )->viewCount == surf1->viewCount )
-				{
-					*view = mergedSurf;
-				}
-			}
+			mergedGroups[ surf1->viewCount ] = mergedSurf;
 
 			mergedSurf++;
 		}
 
+		// redirect view surfaces to the merged surfaces
+		for ( k = 0; k < s_worldData.numMarkSurfaces; k++ )
+		{
+			bspSurface_t **view = s_worldData.viewSurfaces + k;
+
+			if ( ( *view )->viewCount != -1 && mergedGroups[ ( *view )->viewCount ] )
+			{
+				*view = mergedGroups[ ( *view )->viewCount ];
+			}
+		}
+
 		Log::Debug("Processed %d surfaces into %d merged, %d unmerged", numSurfaces, numMergedSurfaces, numUnmergedSurfaces );
 	}
 
@@ -3309,6 +4136,8 @@ static void R_LoadSurfaces( lump_t *surfs, lump_t *verts, lump_t *indexLump )
 
 	Log::Debug("...loading surfaces" );
 
+	meshJobs.clear();
+
 	numFaces = 0;
 	numMeshes = 0;
 	numTriSurfs = 0;
@@ -3338,7 +4167,7 @@ static void R_LoadSurfaces( lump_t *surfs, lump_t *verts, lump_t *indexLump )
 		ri.Error( errorParm_t::ERR_DROP, "LoadMap: funny lump size in %s", s_worldData.name );
 	}
 
-	out = (bspSurface_t*) ri.Hunk_Alloc( count * sizeof( *out ), ha_pref::h_low );
+	out = (bspSurface_t*) ri.Hunk_Alloc( count * sizeof( *out ), hunkTag_t::HT_BSP );
 
 	s_worldData.surfaces = out;
 	s_worldData.numSurfaces = count;
@@ -3381,16 +4210,75 @@ static void R_LoadSurfaces( lump_t *surfs, lump_t *verts, lump_t *indexLump )
 	Log::Debug("...loaded %d faces, %i meshes, %i trisurfs, %i flares %i foliages", numFaces, numMeshes, numTriSurfs,
 	           numFlares, numFoliages );
 
-	if ( r_stitchCurves->integer )
+	if ( R_LoadCachedGrids() )
 	{
-		R_StitchAllPatches();
+		meshJobs.clear();
+		meshJobs.shrink_to_fit();
 	}
+	else
+	{
+		R_TessellateMeshes();
 
-	R_FixSharedVertexLodError();
+		R_BuildLodGroups();
 
-	if ( r_stitchCurves->integer )
-	{
+		if ( r_stitchCurves->integer )
+		{
+			R_StitchAllPatches();
+		}
+
+		R_FixSharedVertexLodError();
+
+		lodGroups.clear();
+
+		// the grids were built outside of the hunk, as stitching reallocates them
 		R_MovePatchSurfacesToHunk();
+
+		R_StoreGrids();
+	}
+
+	s_worldCache.shaderKey = R_WorldShaderKey();
+}
+
+/*
+=================
+R_SetupViewSurfaceBounds
+
+Copies the bounds of the view surfaces into the structure of
+arrays used by R_CullBoxes
+=================
+*/
+static void R_SetupViewSurfaceBounds()
+{
+	int   i, j, count;
+	float *bounds;
+
+	count = s_worldData.numMarkSurfaces;
+	bounds = ( float * ) ri.Hunk_Alloc( 6 * ( count + 3 ) * sizeof( float ), hunkTag_t::HT_BSP );
+
+	for ( j = 0; j < 3; j++ )
+	{
+		s_worldData.viewSurfaceBounds.mins[ j ] = bounds + j * ( count + 3 );
+		s_worldData.viewSurfaceBounds.maxs[ j ] = bounds + ( j + 3 ) * ( count + 3 );
+	}
+
+	for ( i = 0; i < count; i++ )
+	{
+		surfaceType_t *surface = s_worldData.viewSurfaces[ i ]->data;
+
+		// only these are culled by their bounds, the others have no bounds
+		if ( *surface != surfaceType_t::SF_FACE && *surface != surfaceType_t::SF_TRIANGLES &&
+		     *surface != surfaceType_t::SF_VBO_MESH && *surface != surfaceType_t::SF_GRID )
+		{
+			continue;
+		}
+
+		srfGeneric_t *gen = ( srfGeneric_t * ) surface;
+
+		for ( j = 0; j < 3; j++ )
+		{
+			s_worldData.viewSurfaceBounds.mins[ j ][ i ] = gen->bounds[ 0 ][ j ];
+			s_worldData.viewSurfaceBounds.maxs[ j ][ i ] = gen->bounds[ 1 ][ j ];
+		}
 	}
 }
 
@@ -3417,7 +4305,7 @@ static void R_LoadSubmodels( lump_t *l )
 	count = l->filelen / sizeof( *in );
 
 	s_worldData.numModels = count;
-	s_worldData.models = out = (bspModel_t*) ri.Hunk_Alloc( count * sizeof( *out ), ha_pref::h_low );
+	s_worldData.models = out = (bspModel_t*) ri.Hunk_Alloc( count * sizeof( *out ), hunkTag_t::HT_BSP );
 
 	for ( i = 0; i < count; i++, in++, out++ )
 	{
@@ -3447,7 +4335,7 @@ static void R_LoadSubmodels( lump_t *l )
 
 		// ydnar: allocate decal memory
 		j = ( i == 0 ? MAX_WORLD_DECALS : MAX_ENTITY_DECALS );
-		out->decals = (decal_t*) ri.Hunk_Alloc( j * sizeof( *out->decals ), ha_pref::h_low );
+		out->decals = (decal_t*) ri.Hunk_Alloc( j * sizeof( *out->decals ), hunkTag_t::HT_BSP );
 		memset( out->decals, 0, j * sizeof( *out->decals ) );
 	}
 }
@@ -3500,7 +4388,7 @@ static void R_LoadNodesAndLeafs( lump_t *nodeLump, lump_t *leafLump )
 	numNodes = nodeLump->filelen / sizeof( dnode_t );
 	numLeafs = leafLump->filelen / sizeof( dleaf_t );
 
-	out = (bspNode_t*) ri.Hunk_Alloc( ( numNodes + numLeafs ) * sizeof( *out ), ha_pref::h_low );
+	out = (bspNode_t*) ri.Hunk_Alloc( ( numNodes + numLeafs ) * sizeof( *out ), hunkTag_t::HT_BSP );
 
 	s_worldData.nodes = out;
 	s_worldData.numnodes = numNodes + numLeafs;
@@ -3508,7 +4396,7 @@ static void R_LoadNodesAndLeafs( lump_t *nodeLump, lump_t *leafLump )
 
 	// ydnar: skybox optimization
 	s_worldData.numSkyNodes = 0;
-	s_worldData.skyNodes = (bspNode_t**) ri.Hunk_Alloc( WORLD_MAX_SKY_NODES * sizeof( *s_worldData.skyNodes ), ha_pref::h_low );
+	s_worldData.skyNodes = (bspNode_t**) ri.Hunk_Alloc( WORLD_MAX_SKY_NODES * sizeof( *s_worldData.skyNodes ), hunkTag_t::HT_BSP );
 
 	// load nodes
 	for ( i = 0; i < numNodes; i++, in++, out++ )
@@ -3565,12 +4453,12 @@ static void R_LoadNodesAndLeafs( lump_t *nodeLump, lump_t *leafLump )
 	// chain decendants and compute surface bounds
 	R_SetParent( s_worldData.nodes, nullptr );
 
-	backEndData[ 0 ]->traversalList = ( bspNode_t ** ) ri.Hunk_Alloc( sizeof( bspNode_t * ) * s_worldData.numnodes, ha_pref::h_low );
+	backEndData[ 0 ]->traversalList = ( bspNode_t ** ) ri.Hunk_Alloc( sizeof( bspNode_t * ) * s_worldData.numnodes, hunkTag_t::HT_BSP );
 	backEndData[ 0 ]->traversalLength = 0;
 
 	if ( r_smp->integer )
 	{
-		backEndData[ 1 ]->traversalList = ( bspNode_t ** ) ri.Hunk_Alloc( sizeof( bspNode_t * ) * s_worldData.numnodes, ha_pref::h_low );
+		backEndData[ 1 ]->traversalList = ( bspNode_t ** ) ri.Hunk_Alloc( sizeof( bspNode_t * ) * s_worldData.numnodes, hunkTag_t::HT_BSP );
 		backEndData[ 1 ]->traversalLength = 0;
 	}
 }
@@ -3597,7 +4485,7 @@ static void R_LoadShaders( lump_t *l )
 	}
 
 	count = l->filelen / sizeof( *in );
-	out = (dshader_t*) ri.Hunk_Alloc( count * sizeof( *out ), ha_pref::h_low );
+	out = (dshader_t*) ri.Hunk_Alloc( count * sizeof( *out ), hunkTag_t::HT_BSP );
 
 	s_worldData.shaders = out;
 	s_worldData.numShaders = count;
@@ -3611,6 +4499,12 @@ static void R_LoadShaders( lump_t *l )
 		out[ i ].surfaceFlags = LittleLong( out[ i ].surfaceFlags );
 		out[ i ].contentFlags = LittleLong( out[ i ].contentFlags );
 	}
+
+	// start decoding the textures while the rest of the map is loaded
+	for ( i = 0; i < count; i++ )
+	{
+		R_PrefetchShaderImages( out[ i ].shader );
+	}
 }
 
 /*
@@ -3634,11 +4528,11 @@ static void R_LoadMarksurfaces( lump_t *l )
 	}
 
 	count = l->filelen / sizeof( *in );
-	out = (bspSurface_t**) ri.Hunk_Alloc( count * sizeof( *out ), ha_pref::h_low );
+	out = (bspSurface_t**) ri.Hunk_Alloc( count * sizeof( *out ), hunkTag_t::HT_BSP );
 
 	s_worldData.markSurfaces = out;
 	s_worldData.numMarkSurfaces = count;
-	s_worldData.viewSurfaces = ( bspSurface_t ** ) ri.Hunk_Alloc( count * sizeof( *out ), ha_pref::h_low );
+	s_worldData.viewSurfaces = ( bspSurface_t ** ) ri.Hunk_Alloc( count * sizeof( *out ), hunkTag_t::HT_BSP );
 
 	for ( i = 0; i < count; i++ )
 	{
@@ -3670,7 +4564,7 @@ static void R_LoadPlanes( lump_t *l )
 	}
 
 	count = l->filelen / sizeof( *in );
-	out = (cplane_t*) ri.Hunk_Alloc( count * 2 * sizeof( *out ), ha_pref::h_low );
+	out = (cplane_t*) ri.Hunk_Alloc( count * 2 * sizeof( *out ), hunkTag_t::HT_BSP );
 
 	s_worldData.planes = out;
 	s_worldData.numplanes = count;
@@ -3720,7 +4614,7 @@ static void R_LoadFogs( lump_t *l, lump_t *brushesLump, lump_t *sidesLump )
 
 	// create fog strucutres for them
 	s_worldData.numFogs = count + 1;
-	s_worldData.fogs = (fog_t*) ri.Hunk_Alloc( s_worldData.numFogs * sizeof( *out ), ha_pref::h_low );
+	s_worldData.fogs = (fog_t*) ri.Hunk_Alloc( s_worldData.numFogs * sizeof( *out ), hunkTag_t::HT_BSP );
 	out = s_worldData.fogs + 1;
 
 	// ydnar: reset global fog
@@ -3921,7 +4815,7 @@ void R_LoadLightGrid( lump_t *l )
 		w->lightGridGLScale[ 1 ] = w->lightGridInverseSize[ 1 ];
 		w->lightGridGLScale[ 2 ] = w->lightGridInverseSize[ 2 ];
 
-		gridPoint1 = (bspGridPoint1_t *) ri.Hunk_Alloc( sizeof( *gridPoint1 ) + sizeof( *gridPoint2 ), ha_pref::h_low );
+		gridPoint1 = (bspGridPoint1_t *) ri.Hunk_Alloc( sizeof( *gridPoint1 ) + sizeof( *gridPoint2 ), hunkTag_t::HT_BSP );
 		gridPoint2 = (bspGridPoint2_t *) (gridPoint1 + w->numLightGridPoints);
 
 		// default some white light from above
@@ -3957,7 +4851,7 @@ void R_LoadLightGrid( lump_t *l )
 	}
 
 	i = w->numLightGridPoints * ( sizeof( *gridPoint1 ) + sizeof( *gridPoint2 ) );
-	gridPoint1 = (bspGridPoint1_t *) ri.Hunk_Alloc( i, ha_pref::h_low );
+	gridPoint1 = (bspGridPoint1_t *) ri.Hunk_Alloc( i, hunkTag_t::HT_BSP );
 	gridPoint2 = (bspGridPoint2_t *) (gridPoint1 + w->numLightGridPoints);
 
 	w->lightGridData1 = gridPoint1;
@@ -4142,7 +5036,7 @@ void R_LoadEntities( lump_t *l )
 	w->lightGridSize[ 2 ] = 128;
 
 	// store for reference by the cgame
-	w->entityString = (char*) ri.Hunk_Alloc( l->filelen + 1, ha_pref::h_low );
+	w->entityString = (char*) ri.Hunk_Alloc( l->filelen + 1, hunkTag_t::HT_BSP );
 	//strcpy(w->entityString, (char *)(fileBase + l->fileofs));
 	Q_strncpyz( w->entityString, ( char * )( fileBase + l->fileofs ), l->filelen + 1 );
 	w->entityParsePoint = w->entityString;
@@ -4362,7 +5256,7 @@ void R_LoadEntities( lump_t *l )
 	s_worldData.numLights = numLights;
 
 	// Tr3B: FIXME add 1 dummy light so we don't trash the hunk memory system ...
-	s_worldData.lights = (trRefLight_t*) ri.Hunk_Alloc( ( s_worldData.numLights + 1 ) * sizeof( trRefLight_t ), ha_pref::h_low );
+	s_worldData.lights = (trRefLight_t*) ri.Hunk_Alloc( ( s_worldData.numLights + 1 ) * sizeof( trRefLight_t ), hunkTag_t::HT_BSP );
 
 	// basic light setup
 	for ( i = 0, light = s_worldData.lights; i < s_worldData.numLights; i++, light++ )
@@ -4646,7 +5540,7 @@ static void R_PrecacheInteraction( trRefLight_t *light, bspSurface_t *surface )
 {
 	interactionCache_t *iaCache;
 
-	iaCache = (interactionCache_t*) ri.Hunk_Alloc( sizeof( *iaCache ), ha_pref::h_low );
+	iaCache = (interactionCache_t*) ri.Hunk_Alloc( sizeof( *iaCache ), hunkTag_t::HT_BSP );
 	Com_AddToGrowList( &s_interactions, iaCache );
 
 	// connect to interaction grid
@@ -4787,7 +5681,7 @@ static void R_RecursivePrecacheInteractionNode( bspNode_t *node, trRefLight_t *l
 		{
 			link_t *l;
 
-			l = ( link_t *)ri.Hunk_Alloc( sizeof( *l ), ha_pref::h_low );
+			l = ( link_t *)ri.Hunk_Alloc( sizeof( *l ), hunkTag_t::HT_BSP );
 			InitLink( l, node );
 
 			InsertLink( l, &light->leafs );
@@ -4806,7 +5700,7 @@ static interactionVBO_t *R_CreateInteractionVBO( trRefLight_t *light )
 {
 	interactionVBO_t *iaVBO;
 
-	iaVBO = (interactionVBO_t*) ri.Hunk_Alloc( sizeof( *iaVBO ), ha_pref::h_low );
+	iaVBO = (interactionVBO_t*) ri.Hunk_Alloc( sizeof( *iaVBO ), hunkTag_t::HT_BSP );
 
 	// connect to interaction grid
 	if ( !light->firstInteractionVBO )
@@ -5121,7 +6015,7 @@ static void R_CreateVBOLightMeshes( trRefLight_t *light )
 			}
 
 			// create surface
-			vboSurf = (srfVBOMesh_t*) ri.Hunk_Alloc( sizeof( *vboSurf ), ha_pref::h_low );
+			vboSurf = (srfVBOMesh_t*) ri.Hunk_Alloc( sizeof( *vboSurf ), hunkTag_t::HT_BSP );
 			vboSurf->surfaceType = surfaceType_t::SF_VBO_MESH;
 			vboSurf->numIndexes = numTriangles * 3;
 			vboSurf->numVerts = numVerts;
@@ -5483,7 +6377,7 @@ static void R_CreateVBOShadowMeshes( trRefLight_t *light )
 			}
 
 			// create surface
-			vboSurf = (srfVBOMesh_t*) ri.Hunk_Alloc( sizeof( *vboSurf ), ha_pref::h_low );
+			vboSurf = (srfVBOMesh_t*) ri.Hunk_Alloc( sizeof( *vboSurf ), hunkTag_t::HT_BSP );
 			vboSurf->surfaceType = surfaceType_t::SF_VBO_MESH;
 			vboSurf->numIndexes = numTriangles * 3;
 			vboSurf->numVerts = numVerts;
@@ -5834,7 +6728,7 @@ static void R_CreateVBOShadowCubeMeshes( trRefLight_t *light )
 				}
 
 				// create surface
-				vboSurf = (srfVBOMesh_t*) ri.Hunk_Alloc( sizeof( *vboSurf ), ha_pref::h_low );
+				vboSurf = (srfVBOMesh_t*) ri.Hunk_Alloc( sizeof( *vboSurf ), hunkTag_t::HT_BSP );
 				vboSurf->surfaceType = surfaceType_t::SF_VBO_MESH;
 				vboSurf->numIndexes = numTriangles * 3;
 				vboSurf->numVerts = numVerts;
@@ -5998,6 +6892,174 @@ static void R_CalcInteractionCubeSideBits( trRefLight_t *light )
 	}
 }
 
+// the surfaces and leafs a light touches, as saved in the world cache
+struct cachedLightInteractions_t
+{
+	int       numInteractions;
+	int       numLeafs;
+	const int *surfaces;
+	const int *leafs;
+};
+
+/*
+=================
+R_LoadCachedInteractions
+
+Checks the cached interactions of the lights that are precached, the
+returned arrays point into the mapping
+=================
+*/
+static bool R_LoadCachedInteractions( int numLights, std::vector<cachedLightInteractions_t> &lights, const int **lightCounts )
+{
+	worldCacheReader_t reader = s_worldCache.sections[ WCS_INTERACTIONS ];
+	uint32_t shaderKey;
+	int cachedNumLights, numSurfaces;
+
+	if ( !reader.size )
+	{
+		return false;
+	}
+
+	if ( !reader.Read( shaderKey ) || !reader.Read( cachedNumLights ) || !reader.Read( numSurfaces ) )
+	{
+		return R_WorldCacheCorrupted();
+	}
+
+	if ( shaderKey != s_worldCache.shaderKey )
+	{
+		Log::Debug( "interaction cache of %s is out of date", s_worldData.name );
+		return false;
+	}
+
+	if ( cachedNumLights != numLights || numSurfaces != s_worldData.numSurfaces )
+	{
+		return R_WorldCacheCorrupted();
+	}
+
+	lights.resize( numLights );
+
+	for ( cachedLightInteractions_t &light : lights )
+	{
+		if ( !reader.Read( light.numInteractions ) || !reader.Read( light.numLeafs ) )
+		{
+			return R_WorldCacheCorrupted();
+		}
+
+		light.surfaces = reinterpret_cast<const int *>( reader.Array( light.numInteractions, sizeof( int ) ) );
+		light.leafs = reinterpret_cast<const int *>( reader.Array( light.numLeafs, sizeof( int ) ) );
+
+		if ( !light.surfaces || !light.leafs )
+		{
+			return R_WorldCacheCorrupted();
+		}
+
+		for ( int i = 0; i < light.numInteractions; i++ )
+		{
+			int index = light.surfaces[ i ];
+
+			if ( index < 0 || index >= s_worldData.numSurfaces )
+			{
+				return R_WorldCacheCorrupted();
+			}
+
+			surfaceType_t type = *s_worldData.surfaces[ index ].data;
+
+			if ( type != surfaceType_t::SF_FACE && type != surfaceType_t::SF_GRID && type != surfaceType_t::SF_TRIANGLES )
+			{
+				return R_WorldCacheCorrupted();
+			}
+		}
+
+		for ( int i = 0; i < light.numLeafs; i++ )
+		{
+			int index = light.leafs[ i ];
+
+			if ( index < 0 || index >= s_worldData.numnodes || s_worldData.nodes[ index ].contents == -1 )
+			{
+				return R_WorldCacheCorrupted();
+			}
+		}
+	}
+
+	// the light count of every surface once all the lights were precached
+	*lightCounts = reinterpret_cast<const int *>( reader.Array( numSurfaces, sizeof( int ) ) );
+
+	if ( !*lightCounts )
+	{
+		return R_WorldCacheCorrupted();
+	}
+
+	for ( int i = 0; i < numSurfaces; i++ )
+	{
+		if ( ( *lightCounts )[ i ] < -1 || ( *lightCounts )[ i ] > numLights )
+		{
+			return R_WorldCacheCorrupted();
+		}
+	}
+
+	return true;
+}
+
+/*
+=================
+R_ReplayCachedInteractions
+
+Does what R_RecursivePrecacheInteractionNode did when the cache was built
+=================
+*/
+static void R_ReplayCachedInteractions( trRefLight_t *light, const cachedLightInteractions_t &cached )
+{
+	for ( int i = 0; i < cached.numInteractions; i++ )
+	{
+		R_PrecacheInteraction( light, &s_worldData.surfaces[ cached.surfaces[ i ] ] );
+	}
+
+	for ( int i = 0; i < cached.numLeafs; i++ )
+	{
+		link_t *l = ( link_t * ) ri.Hunk_Alloc( sizeof( *l ), hunkTag_t::HT_BSP );
+		InitLink( l, &s_worldData.nodes[ cached.leafs[ i ] ] );
+
+		InsertLink( l, &light->leafs );
+
+		light->leafs.numElements++;
+	}
+}
+
+/*
+=================
+R_StoreLightInteractions
+=================
+*/
+static void R_StoreLightInteractions( const trRefLight_t *light )
+{
+	if ( !s_worldCache.enabled )
+	{
+		return;
+	}
+
+	std::vector<int> surfaces, leafs;
+
+	for ( const interactionCache_t *iaCache = light->firstInteractionCache; iaCache; iaCache = iaCache->next )
+	{
+		surfaces.push_back( iaCache->surface - s_worldData.surfaces );
+	}
+
+	// InsertLink adds to the head, so the oldest leaf is the last one
+	for ( const link_t *l = light->leafs.prev; l != &light->leafs; l = l->prev )
+	{
+		leafs.push_back( ( const bspNode_t * ) l->data - s_worldData.nodes );
+	}
+
+	worldCacheWriter_t &writer = s_worldCache.rebuilt[ WCS_INTERACTIONS ];
+	int numInteractions = surfaces.size();
+	int numLeafs = leafs.size();
+
+	writer.Write( numInteractions );
+	writer.Write( numLeafs );
+	writer.WriteArray( surfaces.data(), numInteractions, sizeof( int ) );
+	writer.WriteArray( leafs.data(), numLeafs, sizeof( int ) );
+}
+
 /*
 =============
 R_PrecacheInteractions
@@ -6022,6 +7084,34 @@ void R_PrecacheInteractions()
 
 	Com_InitGrowList( &s_interactions, 100 );
 
+	std::vector<cachedLightInteractions_t> cachedLights;
+	const int *cachedLightCounts = nullptr;
+	int numLights = 0;
+	bool cached;
+
+	for ( i = 0; i < s_worldData.numLights; i++ )
+	{
+		if ( !( ( r_precomputedLighting->integer || r_vertexLighting->integer ) && !s_worldData.lights[ i ].noRadiosity ) )
+		{
+			numLights++;
+		}
+	}
+
+	cached = R_LoadCachedInteractions( numLights, cachedLights, &cachedLightCounts );
+
+	if ( cached )
+	{
+		Log::Debug( "...using the cached interactions" );
+	}
+	else if ( s_worldCache.enabled )
+	{
+		worldCacheWriter_t &writer = s_worldCache.rebuilt[ WCS_INTERACTIONS ];
+
+		writer.Write( s_worldCache.shaderKey );
+		writer.Write( numLights );
+		writer.Write( s_worldData.numSurfaces );
+	}
+
 	c_redundantInteractions = 0;
 	c_vboWorldSurfaces = 0;
 	c_vboLightSurfaces = 0;
@@ -6067,9 +7157,18 @@ void R_PrecacheInteractions()
 		light->lastInteractionVBO = nullptr;
 
 		// perform culling and add all the potentially visible surfaces
-		s_lightCount++;
 		QueueInit( &light->leafs );
-		R_RecursivePrecacheInteractionNode( s_worldData.nodes, light );
+
+		if ( cached )
+		{
+			R_ReplayCachedInteractions( light, cachedLights[ s_lightCount++ ] );
+		}
+		else
+		{
+			s_lightCount++;
+			R_RecursivePrecacheInteractionNode( s_worldData.nodes, light );
+			R_StoreLightInteractions( light );
+		}
 
 		// create a static VBO surface for each light geometry batch
 		R_CreateVBOLightMeshes( light );
@@ -6084,9 +7183,29 @@ void R_PrecacheInteractions()
 		R_CreateVBOShadowCubeMeshes( light );
 	}
 
+	if ( cached )
+	{
+		for ( i = 0, surface = s_worldData.surfaces; i < s_worldData.numSurfaces; i++, surface++ )
+		{
+			surface->lightCount = cachedLightCounts[ i ];
+		}
+	}
+	else if ( s_worldCache.enabled )
+	{
+		std::vector<int> lightCounts( s_worldData.numSurfaces );
+
+		for ( i = 0, surface = s_worldData.surfaces; i < s_worldData.numSurfaces; i++, surface++ )
+		{
+			lightCounts[ i ] = surface->lightCount;
+		}
+
+		s_worldCache.rebuilt[ WCS_INTERACTIONS ].WriteArray( lightCounts.data(), s_worldData.numSurfaces, sizeof( int ) );
+		s_worldCache.isRebuilt[ WCS_INTERACTIONS ] = true;
+	}
+
 	// move interactions grow list to hunk
 	s_worldData.numInteractions = s_interactions.currentElements;
-	s_worldData.interactions = (interactionCache_t**) ri.Hunk_Alloc( s_worldData.numInteractions * sizeof( *s_worldData.interactions ), ha_pref::h_low );
+	s_worldData.interactions = (interactionCache_t**) ri.Hunk_Alloc( s_worldData.numInteractions * sizeof( *s_worldData.interactions ), hunkTag_t::HT_BSP );
 
 	for ( i = 0; i < s_worldData.numInteractions; i++ )
 	{
@@ -6400,7 +7519,7 @@ void R_BuildCubeMaps()
 
 			if ( FindVertexInHashTable( tr.cubeHashTable, origin, 256 ) == nullptr )
 			{
-				cubeProbe = (cubemapProbe_t*) ri.Hunk_Alloc( sizeof( *cubeProbe ), ha_pref::h_high );
+				cubeProbe = (cubemapProbe_t*) ri.Hunk_Alloc( sizeof( *cubeProbe ), hunkTag_t::HT_BSP );
 				Com_AddToGrowList( &tr.cubeProbes, cubeProbe );
 
 				VectorCopy( origin, cubeProbe->origin );
@@ -6413,7 +7532,7 @@ void R_BuildCubeMaps()
 	// if we can't find one, fake one
 	if ( tr.cubeProbes.currentElements == 0 )
 	{
-		cubeProbe = (cubemapProbe_t*) ri.Hunk_Alloc( sizeof( *cubeProbe ), ha_pref::h_low );
+		cubeProbe = (cubemapProbe_t*) ri.Hunk_Alloc( sizeof( *cubeProbe ), hunkTag_t::HT_BSP );
 		Com_AddToGrowList( &tr.cubeProbes, cubeProbe );
 
 		VectorClear( cubeProbe->origin );
@@ -6692,10 +7811,11 @@ Called directly from cgame
 */
 void RE_LoadWorldMap( const char *name )
 {
-	int       i;
+	int       i, length;
 	dheader_t *header;
 	byte      *buffer;
 	byte      *startMarker;
+	uint32_t  bspChecksum;
 
 	if ( tr.worldMapLoaded )
 	{
@@ -6720,13 +7840,16 @@ void RE_LoadWorldMap( const char *name )
 	tr.worldMapLoaded = true;
 
 	// load it
-	ri.FS_ReadFile( name, ( void ** ) &buffer );
+	length = ri.FS_ReadFile( name, ( void ** ) &buffer );
 
 	if ( !buffer )
 	{
 		ri.Error( errorParm_t::ERR_DROP, "RE_LoadWorldMap: %s not found", name );
 	}
 
+	// checksum the file as it is on disk, before the lumps are swapped
+	bspChecksum = r_worldCache->integer ? crc32( crc32( 0, Z_NULL, 0 ), buffer, length ) : 0;
+
 	// clear tr.world so if the level fails to load, the next
 	// try will not look at the partially loaded version
 	tr.world = nullptr;
@@ -6741,7 +7864,7 @@ void RE_LoadWorldMap( const char *name )
 	Q_strncpyz( s_worldData.baseName, COM_SkipPath( s_worldData.name ), sizeof( s_worldData.name ) );
 	COM_StripExtension3( s_worldData.baseName, s_worldData.baseName, sizeof( s_worldData.baseName ) );
 
-	startMarker = (byte*) ri.Hunk_Alloc( 0, ha_pref::h_low );
+	startMarker = (byte*) ri.Hunk_Alloc( 0, hunkTag_t::HT_BSP );
 
 	header = ( dheader_t * ) buffer;
 	fileBase = ( byte * ) header;
@@ -6770,6 +7893,8 @@ void RE_LoadWorldMap( const char *name )
 
 	R_LoadPlanes( &header->lumps[ LUMP_PLANES ] );
 
+	R_OpenWorldCache( bspChecksum );
+
 	R_LoadSurfaces( &header->lumps[ LUMP_SURFACES ], &header->lumps[ LUMP_DRAWVERTS ], &header->lumps[ LUMP_DRAWINDEXES ] );
 
 	R_LoadMarksurfaces( &header->lumps[ LUMP_LEAFSURFACES ] );
@@ -6788,12 +7913,15 @@ void RE_LoadWorldMap( const char *name )
 	// create a static vbo for the world
 	R_CreateWorldVBO();
 	R_CreateClusters();
+	R_SetupViewSurfaceBounds();
 
 	// we precache interactions between lights and surfaces
 	// to reduce the polygon count
 	R_PrecacheInteractions();
 
-	s_worldData.dataSize = ( byte * ) ri.Hunk_Alloc( 0, ha_pref::h_low ) - startMarker;
+	R_CloseWorldCache();
+
+	s_worldData.dataSize = ( byte * ) ri.Hunk_Alloc( 0, hunkTag_t::HT_BSP ) - startMarker;
 
 	// only set tr.world now that we know the entire level has loaded properly
 	tr.world = &s_worldData;
@@ -6809,5 +7937,8 @@ void RE_LoadWorldMap( const char *name )
 	// build cubemaps after the necessary vbo stuff is done
 	//R_BuildCubeMaps();
 
+	// drop the prefetched images no shader ended up using
+	R_FinishImagePrefetch();
+
 	ri.FS_FreeFile( buffer );
 }
@@ -22,6 +22,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 */
 // tr_cmds.c
 #include "tr_local.h"
+#include "framework/Profiler.h"
 
 volatile bool            renderThreadActive;
 
@@ -770,6 +771,8 @@ void RE_BeginFrame()
 	tr.frameSceneNum = 0;
 	tr.viewCount = 0;
 
+	R_UpdateTextureResidency();
+
 	// do overdraw measurement
 	if ( r_measureOverdraw->integer )
 	{
@@ -881,6 +884,8 @@ void RE_BeginFrame()
 	{
 		cmd->buffer = ( int ) GL_BACK;
 	}
+
+	cmd->frameCount = tr.frameCount;
 }
 
 /*
@@ -894,6 +899,8 @@ void RE_EndFrame( int *frontEndMsec, int *backEndMsec )
 {
 	SwapBuffersCommand *cmd;
 
+	PROFILE_ZONE( "RE_EndFrame" );
+
 	if ( !tr.registered )
 	{
 		return;
@@ -910,6 +917,8 @@ void RE_EndFrame( int *frontEndMsec, int *backEndMsec )
 
 	R_IssueRenderCommands( true );
 
+	R_CaptureFrameEnd();
+
 	// use the other buffers next frame, because another CPU
 	// may still be rendering into the current ones
 	R_ToggleSmpFrame();
@@ -937,27 +946,28 @@ void RE_EndFrame( int *frontEndMsec, int *backEndMsec )
 RE_TakeVideoFrame
 =============
 */
-void RE_TakeVideoFrame( int width, int height, byte *captureBuffer, byte *encodeBuffer, bool motionJpeg )
+bool RE_TakeVideoFrame( int width, int height, byte *captureBuffer, int frame )
 {
 	VideoFrameCommand *cmd;
 
 	if ( !tr.registered )
 	{
-		return;
+		return false;
 	}
 
 	cmd = R_GetRenderCommand<VideoFrameCommand>();
 
 	if ( !cmd )
 	{
-		return;
+		return false;
 	}
 
 	cmd->width = width;
 	cmd->height = height;
 	cmd->captureBuffer = captureBuffer;
-	cmd->encodeBuffer = encodeBuffer;
-	cmd->motionJpeg = motionJpeg;
+	cmd->frame = frame;
+
+	return true;
 }
 
 //bani
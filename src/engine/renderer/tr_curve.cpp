@@ -283,8 +283,6 @@ static int MakeMeshTriangles( int width, int height, srfVert_t ctrl[ MAX_GRID_SI
 	int              i, j;
 	int              numTriangles;
 	int              w, h;
-	srfVert_t        *dv;
-	static srfVert_t ctrl2[ MAX_GRID_SIZE * MAX_GRID_SIZE ];
 
 	h = height - 1;
 	w = width - 1;
@@ -314,16 +312,6 @@ static int MakeMeshTriangles( int width, int height, srfVert_t ctrl[ MAX_GRID_SI
 		}
 	}
 
-	// FIXME: use more elegant way
-	for ( i = 0; i < width; i++ )
-	{
-		for ( j = 0; j < height; j++ )
-		{
-			dv = &ctrl2[ j * width + i ];
-			*dv = ctrl[ j ][ i ];
-		}
-	}
-
 	return numTriangles;
 }
 
@@ -417,45 +405,26 @@ static srfGridMesh_t *R_CreateSurfaceGridMesh( int width, int height,
 	vec3_t        tmpVec;
 	srfGridMesh_t *grid;
 
-	// copy the results out to a grid
+	// copy the results out to a grid, outside of the hunk because the
+	// patches are tessellated on several threads and stitching
+	// reallocates them; R_MovePatchSurfacesToHunk moves them later
 	size = sizeof( *grid );
 
-	if ( r_stitchCurves->integer )
-	{
-		grid = (srfGridMesh_t*)/*ri.Hunk_Alloc */ Com_Allocate( size );
-		Com_Memset( grid, 0, size );
+	grid = (srfGridMesh_t*) Com_Allocate( size );
+	Com_Memset( grid, 0, size );
 
-		grid->widthLodError = (float*)/*ri.Hunk_Alloc */ Com_Allocate( width * 4 );
-		Com_Memcpy( grid->widthLodError, errorTable[ 0 ], width * 4 );
+	grid->widthLodError = (float*) Com_Allocate( width * 4 );
+	Com_Memcpy( grid->widthLodError, errorTable[ 0 ], width * 4 );
 
-		grid->heightLodError = (float*)/*ri.Hunk_Alloc */ Com_Allocate( height * 4 );
-		Com_Memcpy( grid->heightLodError, errorTable[ 1 ], height * 4 );
+	grid->heightLodError = (float*) Com_Allocate( height * 4 );
+	Com_Memcpy( grid->heightLodError, errorTable[ 1 ], height * 4 );
 
-		grid->numTriangles = numTriangles;
-		grid->triangles = (srfTriangle_t*) Com_Allocate( grid->numTriangles * sizeof( srfTriangle_t ) );
-		Com_Memcpy( grid->triangles, triangles, numTriangles * sizeof( srfTriangle_t ) );
+	grid->numTriangles = numTriangles;
+	grid->triangles = (srfTriangle_t*) Com_Allocate( grid->numTriangles * sizeof( srfTriangle_t ) );
+	Com_Memcpy( grid->triangles, triangles, numTriangles * sizeof( srfTriangle_t ) );
 
-		grid->numVerts = ( width * height );
-		grid->verts = (srfVert_t*) Com_Allocate( grid->numVerts * sizeof( srfVert_t ) );
-	}
-	else
-	{
-		grid = (srfGridMesh_t*) ri.Hunk_Alloc( size, ha_pref::h_low );
-		Com_Memset( grid, 0, size );
-
-		grid->widthLodError = (float*) ri.Hunk_Alloc( width * 4, ha_pref::h_low );
-		Com_Memcpy( grid->widthLodError, errorTable[ 0 ], width * 4 );
-
-		grid->heightLodError = (float*) ri.Hunk_Alloc( height * 4, ha_pref::h_low );
-		Com_Memcpy( grid->heightLodError, errorTable[ 1 ], height * 4 );
-
-		grid->numTriangles = numTriangles;
-		grid->triangles = (srfTriangle_t*) ri.Hunk_Alloc( grid->numTriangles * sizeof( srfTriangle_t ), ha_pref::h_low );
-		Com_Memcpy( grid->triangles, triangles, numTriangles * sizeof( srfTriangle_t ) );
-
-		grid->numVerts = ( width * height );
-		grid->verts = (srfVert_t*) ri.Hunk_Alloc( grid->numVerts * sizeof( srfVert_t ), ha_pref::h_low );
-	}
+	grid->numVerts = ( width * height );
+	grid->verts = (srfVert_t*) Com_Allocate( grid->numVerts * sizeof( srfVert_t ) );
 
 	grid->width = width;
 	grid->height = height;
@@ -498,11 +467,21 @@ void R_FreeSurfaceGridMesh( srfGridMesh_t *grid )
 	Com_Dealloc( grid );
 }
 
-static srfTriangle_t gridtriangles[ SHADER_MAX_TRIANGLES ];
-static srfVert_t     gridctrl[ MAX_GRID_SIZE ][ MAX_GRID_SIZE ];
+// scratch space of the grid functions, too large for the stack
+struct gridScratch_t
+{
+	srfTriangle_t triangles[ SHADER_MAX_TRIANGLES ];
+	srfVert_t     ctrl[ MAX_GRID_SIZE ][ MAX_GRID_SIZE ];
+};
+
+// stitching is serial, so the insert functions share one
+static gridScratch_t stitchScratch;
+
 /*
 =================
 R_SubdividePatchToGrid
+
+Called from the frontend job threads at map load
 =================
 */
 srfGridMesh_t  *R_SubdividePatchToGrid( int width, int height, srfVert_t points[ MAX_PATCH_SIZE * MAX_PATCH_SIZE ] )
@@ -515,6 +494,10 @@ srfGridMesh_t  *R_SubdividePatchToGrid( int width, int height, srfVert_t points[
 	float                errorTable[ 2 ][ MAX_GRID_SIZE ];
 	int                  numTriangles;
 
+	std::unique_ptr<gridScratch_t> scratch( new gridScratch_t );
+	srfTriangle_t        *gridtriangles = scratch->triangles;
+	srfVert_t            ( *gridctrl )[ MAX_GRID_SIZE ] = scratch->ctrl;
+
 	for ( i = 0; i < width; i++ )
 	{
 		for ( j = 0; j < height; j++ )
@@ -705,6 +688,8 @@ srfGridMesh_t  *R_GridInsertColumn( srfGridMesh_t *grid, int column, int row, ve
 	float                lodRadius;
 	vec3_t               lodOrigin;
 	int                  numTriangles;
+	srfTriangle_t        *gridtriangles = stitchScratch.triangles;
+	srfVert_t            ( *gridctrl )[ MAX_GRID_SIZE ] = stitchScratch.ctrl;
 
 	oldwidth = 0;
 	width = grid->width + 1;
@@ -780,6 +765,8 @@ srfGridMesh_t  *R_GridInsertRow( srfGridMesh_t *grid, int row, int column, vec3_
 	float                lodRadius;
 	vec3_t               lodOrigin;
 	int                  numTriangles;
+	srfTriangle_t        *gridtriangles = stitchScratch.triangles;
+	srfVert_t            ( *gridctrl )[ MAX_GRID_SIZE ] = stitchScratch.ctrl;
 
 	oldheight = 0;
 	width = grid->width;
@@ -495,6 +495,57 @@ static void ChopWindingBehindPlane( int numInPoints, vec3_t inPoints[ MAX_DECAL_
 	}
 }
 
+/*
+StoreDecal()
+copies a projected decal into a free or the oldest decal slot of the model,
+or keeps it for later when projecting on the frontend jobs
+*/
+
+static thread_local std::vector<decal_t> *deferredDecals;
+
+static void StoreDecal( const decal_t *newDecal, bspModel_t *bmodel )
+{
+	int     i, count;
+	decal_t *decal, *oldest;
+
+	if ( deferredDecals )
+	{
+		deferredDecals->push_back( *newDecal );
+		return;
+	}
+
+	/* find first free decal (fixme: optimize this) */
+	count = ( bmodel == tr.world->models ? MAX_WORLD_DECALS : MAX_ENTITY_DECALS );
+	oldest = &bmodel->decals[ 0 ];
+	decal = bmodel->decals;
+
+	for ( i = 0; i < count; i++, decal++ )
+	{
+		/* try to find an empty decal slot */
+		if ( decal->shader == nullptr )
+		{
+			break;
+		}
+
+		/* find oldest decal */
+		if ( decal->fadeEndTime < oldest->fadeEndTime )
+		{
+			oldest = decal;
+		}
+	}
+
+	/* guess we have to use the oldest decal */
+	if ( i >= count )
+	{
+		decal = oldest;
+	}
+
+	/* r_speeds useful info */
+	tr.pc.c_decalSurfacesCreated++;
+
+	*decal = *newDecal;
+}
+
 /*
 ProjectDecalOntoWinding()
 projects decal onto a polygon
@@ -503,11 +554,11 @@ projects decal onto a polygon
 static void ProjectDecalOntoWinding( decalProjector_t *dp, int numPoints, vec3_t points[ 2 ][ MAX_DECAL_VERTS ], bspSurface_t *surf,
                                      bspModel_t *bmodel )
 {
-	int        i, pingPong, count, axis;
+	int        i, pingPong, axis;
 	float      pd, d, d2, alpha = 1.f;
 	vec4_t     plane;
 	vec3_t     absNormal;
-	decal_t    *decal, *oldest;
+	decal_t    decal;
 	polyVert_t *vert;
 
 	/* make a plane from the winding */
@@ -587,45 +638,16 @@ static void ProjectDecalOntoWinding( decalProjector_t *dp, int numPoints, vec3_t
 		}
 	}
 
-	/* find first free decal (fixme: optimize this) */
-	count = ( bmodel == tr.world->models ? MAX_WORLD_DECALS : MAX_ENTITY_DECALS );
-	oldest = &bmodel->decals[ 0 ];
-	decal = bmodel->decals;
-
-	for ( i = 0; i < count; i++, decal++ )
-	{
-		/* try to find an empty decal slot */
-		if ( decal->shader == nullptr )
-		{
-			break;
-		}
-
-		/* find oldest decal */
-		if ( decal->fadeEndTime < oldest->fadeEndTime )
-		{
-			oldest = decal;
-		}
-	}
-
-	/* guess we have to use the oldest decal */
-	if ( i >= count )
-	{
-		decal = oldest;
-	}
-
-	/* r_speeds useful info */
-	tr.pc.c_decalSurfacesCreated++;
-
 	/* set it up (fixme: get the shader before this happens) */
-	decal->parent = surf;
-	decal->shader = dp->shader;
-	decal->fadeStartTime = dp->fadeStartTime;
-	decal->fadeEndTime = dp->fadeEndTime;
-	decal->fogIndex = surf->fogIndex;
+	decal.parent = surf;
+	decal.shader = dp->shader;
+	decal.fadeStartTime = dp->fadeStartTime;
+	decal.fadeEndTime = dp->fadeEndTime;
+	decal.fogIndex = surf->fogIndex;
 
 	/* add points */
-	decal->numVerts = numPoints;
-	vert = decal->verts;
+	decal.numVerts = numPoints;
+	vert = decal.verts;
 
 	for ( i = 0; i < numPoints; i++, vert++ )
 	{
@@ -658,6 +680,8 @@ static void ProjectDecalOntoWinding( decalProjector_t *dp, int numPoints, vec3_t
 		( dp->color * pd * alpha ).ToArray( vert->modulate );
 		vert->modulate[ 3 ] = alpha * dp->color.Alpha();
 	}
+
+	StoreDecal( &decal, bmodel );
 }
 
 /*
@@ -832,6 +856,75 @@ void R_ProjectDecalOntoSurface( decalProjector_t *dp, bspSurface_t *surf, bspMod
 	}
 }
 
+/*
+R_QueueDecalSurface()
+remembers a visible world surface for R_ProjectQueuedDecals
+*/
+
+struct queuedDecalSurface_t
+{
+	bspSurface_t         *surf;
+	int                  decalBits;
+	std::vector<decal_t> decals; // projected on the jobs, stored in order afterwards
+};
+
+static std::vector<queuedDecalSurface_t> queuedDecalSurfaces;
+static int                               numQueuedDecalSurfaces;
+
+void R_QueueDecalSurface( bspSurface_t *surf, int decalBits )
+{
+	if ( numQueuedDecalSurfaces == static_cast<int>( queuedDecalSurfaces.size() ) )
+	{
+		queuedDecalSurfaces.emplace_back();
+	}
+
+	queuedDecalSurface_t &queued = queuedDecalSurfaces[ numQueuedDecalSurfaces++ ];
+	queued.surf = surf;
+	queued.decalBits = decalBits;
+}
+
+/*
+R_ProjectQueuedDecals()
+projects the decal projectors onto the queued surfaces on the frontend jobs,
+the decals are then stored in the model in the order they were projected in
+*/
+
+static void R_ProjectDecalsJob( int index )
+{
+	queuedDecalSurface_t &queued = queuedDecalSurfaces[ index ];
+	int                  i;
+
+	deferredDecals = &queued.decals;
+	deferredDecals->clear();
+
+	for ( i = 0; i < tr.refdef.numDecalProjectors; i++ )
+	{
+		if ( queued.decalBits & ( 1 << i ) )
+		{
+			R_ProjectDecalOntoSurface( &tr.refdef.decalProjectors[ i ], queued.surf, &tr.world->models[ 0 ] );
+		}
+	}
+
+	deferredDecals = nullptr;
+}
+
+void R_ProjectQueuedDecals( bspModel_t *bmodel )
+{
+	int i;
+
+	R_RunJobs( numQueuedDecalSurfaces, R_ProjectDecalsJob );
+
+	for ( i = 0; i < numQueuedDecalSurfaces; i++ )
+	{
+		for ( const decal_t &decal : queuedDecalSurfaces[ i ].decals )
+		{
+			StoreDecal( &decal, bmodel );
+		}
+	}
+
+	numQueuedDecalSurfaces = 0;
+}
+
 /*
 AddDecalSurface()
 adds a decal surface to the scene
@@ -106,7 +106,7 @@ FBO_t          *R_CreateFBO( const char *name, int width, int height )
 		ri.Error(errorParm_t::ERR_DROP, "R_CreateFBO: MAX_FBOS hit" );
 	}
 
-	fbo = tr.fbos[ tr.numFBOs ] = (FBO_t*) ri.Hunk_Alloc( sizeof( *fbo ), ha_pref::h_low );
+	fbo = tr.fbos[ tr.numFBOs ] = (FBO_t*) ri.Hunk_Alloc( sizeof( *fbo ), hunkTag_t::HT_RENDERER );
 	Q_strncpyz( fbo->name, name, sizeof( fbo->name ) );
 	fbo->index = tr.numFBOs++;
 	fbo->width = width;
@@ -24,6 +24,9 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include <common/FileSystem.h>
 #include "tr_local.h"
 
+#include <condition_variable>
+#include <thread>
+
 int                  gl_filter_min = GL_LINEAR_MIPMAP_NEAREST;
 int                  gl_filter_max = GL_LINEAR;
 
@@ -32,6 +35,8 @@ image_t              *r_imageHashTable[ IMAGE_FILE_HASH_SIZE ];
 #define Tex_ByteToFloat(v) ( ( (int)(v) - 128 ) / 127.0f )
 #define Tex_FloatToByte(v) ( 128 + (int) ( (v) * 127.0f + 0.5 ) )
 
+static size_t R_ImageMemorySize( const image_t *image );
+
 struct textureMode_t
 {
 	const char *name;
@@ -155,16 +160,22 @@ void R_ImageList_f()
 	int        texels;
 	int        dataSize;
 	int        imageDataSize;
+	int        streamedImages, reducedImages, pendingImages;
+	size_t     residentSize;
 	const char *yesno[] =
 	{
 		"no ", "yes"
 	};
 	const char *filter = ri.Cmd_Argc() > 1 ? ri.Cmd_Argv(1) : nullptr;
 
-	Log::Notice("\n      -w-- -h-- -mm- -type-   -if-- wrap --name-------" );
+	Log::Notice("\n      -w-- -h-- -mm- -st- -type-   -if-- wrap --name-------" );
 
 	texels = 0;
 	dataSize = 0;
+	streamedImages = 0;
+	reducedImages = 0;
+	pendingImages = 0;
+	residentSize = 0;
 
 	for ( i = 0; i < tr.images.currentElements; i++ )
 	{
@@ -177,9 +188,19 @@ void R_ImageList_f()
 			continue;
 		}
 
-		Com_sprintf( buffer, sizeof( buffer ), "%4i: %4i %4i  %s   ",
-		           i, image->uploadWidth, image->uploadHeight, yesno[ image->filterType == filterType_t::FT_DEFAULT ] );
+		Com_sprintf( buffer, sizeof( buffer ), "%4i: %4i %4i  %s  %s ",
+		           i, image->uploadWidth, image->uploadHeight, yesno[ image->filterType == filterType_t::FT_DEFAULT ],
+		           image->streamed ? va( "%2i%c", image->streamLevel, image->streamRequest >= 0 ? '*' : ' ' ) : " - " );
 		out += buffer;
+
+		residentSize += R_ImageMemorySize( image );
+
+		if ( image->streamed )
+		{
+			streamedImages++;
+			reducedImages += image->streamLevel > 0;
+			pendingImages += image->streamRequest >= 0;
+		}
 		switch ( image->type )
 		{
 			case GL_TEXTURE_2D:
@@ -428,7 +449,12 @@ void R_ImageList_f()
 	Log::Notice(" %i total texels (not including mipmaps)", texels );
 	Log::Notice(" %d.%02d MB total image memory", dataSize / ( 1024 * 1024 ),
 	           ( dataSize % ( 1024 * 1024 ) ) * 100 / ( 1024 * 1024 ) );
-	Log::Notice(" %i total images\n", tr.images.currentElements );
+	Log::Notice(" %i total images", tr.images.currentElements );
+	Log::Notice(" %d.%02d MB resident, texture budget %s", static_cast<int>( residentSize >> 20 ),
+	           static_cast<int>( ( residentSize & 0xfffff ) * 100 >> 20 ),
+	           r_textureBudget->integer > 0 ? va( "%i MB", r_textureBudget->integer ) : "off" );
+	Log::Notice(" %i streamed images, %i at reduced resolution, %i loading\n",
+	           streamedImages, reducedImages, pendingImages );
 }
 
 //=======================================================================
@@ -812,6 +838,8 @@ void R_UploadImage( const byte **dataArray, int numLayers, int numMips,
 		if( picmip < 0 )
 			picmip = 0;
 
+		picmip += image->streamLevel;
+
 		scaledWidth >>= picmip;
 		scaledHeight >>= picmip;
 
@@ -1401,10 +1429,11 @@ image_t        *R_AllocImage( const char *name, bool linkIntoHashTable )
 		return nullptr;
 	}
 
-	image = (image_t*) ri.Hunk_Alloc( sizeof( image_t ), ha_pref::h_low );
+	image = (image_t*) ri.Hunk_Alloc( sizeof( image_t ), hunkTag_t::HT_RENDERER );
 	Com_Memset( image, 0, sizeof( image_t ) );
 
 	glGenTextures( 1, &image->texnum );
+	image->streamRequest = -1;
 
 	Com_AddToGrowList( &tr.images, image );
 
@@ -1635,35 +1664,28 @@ static int                   numImageLoaders = ARRAY_LEN( imageLoaders );
 
 /*
 =================
-R_LoadImage
+R_LoadImageFile
 
 Loads any of the supported image types into a canonical
 32 bit format.
+
+This only touches the filesystem and the decoders, so it
+may be called from the image prefetch workers.
 =================
 */
-static void R_LoadImage( const char **buffer, byte **pic, int *width, int *height,
-			 int *numLayers, int *numMips,
-			 int *bits )
+static void R_LoadImageFile( const char *name, byte **pic, int *width, int *height,
+			     int *numLayers, int *numMips,
+			     int *bits )
 {
-	char *token;
-
-	*pic = nullptr;
-	*width = 0;
-	*height = 0;
-
-	token = COM_ParseExt2( buffer, false );
-
-	if ( !token[ 0 ] )
-	{
-		Log::Warn("NULL parameter for R_LoadImage" );
-		return;
-	}
-
 	int        i;
 	const char *ext;
 	char       filename[ MAX_QPATH ];
 	byte       alphaByte;
 
+	*pic = nullptr;
+	*width = 0;
+	*height = 0;
+
 	// Tr3B: clear alpha of normalmaps for displacement mapping
 	if ( *bits & IF_NORMALMAP )
 	{
@@ -1674,7 +1696,7 @@ static void R_LoadImage( const char **buffer, byte **pic, int *width, int *heigh
 		alphaByte = 0xFF;
 	}
 
-	Q_strncpyz( filename, token, sizeof( filename ) );
+	Q_strncpyz( filename, name, sizeof( filename ) );
 
 	ext = COM_GetExtension( filename );
 
@@ -1698,7 +1720,7 @@ static void R_LoadImage( const char **buffer, byte **pic, int *width, int *heigh
 			{
 				// loader failed, most likely because the file isn't there;
 				// try again without the extension
-				COM_StripExtension3( token, filename, MAX_QPATH );
+				COM_StripExtension3( name, filename, MAX_QPATH );
 			}
 			else
 			{
@@ -1709,29 +1731,717 @@ static void R_LoadImage( const char **buffer, byte **pic, int *width, int *heigh
 	}
 
 	int bestLoader = -1;
-	const FS::PakInfo* bestPak = nullptr;
+	uint32_t bestPak = 0;
 
 	// try and find a suitable match using all the image formats supported
-	// prioritize with the pak priority
-	for ( i = 0; i < numImageLoaders; i++ )
+	// prioritize with the pak priority, the extensions are sorted by it so
+	// only the formats in the first pak with a loadable one are compared
+	for ( const auto &entry : FS::PakPath::LocateExtensions( filename ) )
 	{
-		std::string altName = Str::Format("%s.%s", filename, imageLoaders[i].ext);
-		const FS::PakInfo* pak = FS::PakPath::LocateFile(altName);
+		if ( bestLoader >= 0 && entry.second != bestPak )
+		{
+			break;
+		}
 
-		// We found a file and its pak is better than the best pak we have
-		// this relies on how the filesystem works internally and should be moved
-		// to a more explicit interface once there is one. (FIXME)
-		if ( pak != nullptr && (bestPak == nullptr || pak < bestPak ) )
+		for ( i = 0; i < numImageLoaders; i++ )
 		{
-			bestPak = pak;
-			bestLoader = i;
+			if ( entry.first == imageLoaders[ i ].ext && ( bestLoader < 0 || i < bestLoader ) )
+			{
+				bestPak = entry.second;
+				bestLoader = i;
+			}
 		}
 	}
 
 	if ( bestLoader >= 0 )
 	{
-		char *altName = va( "%s.%s", filename, imageLoaders[ bestLoader ].ext );
-		imageLoaders[ bestLoader ].ImageLoader( altName, pic, width, height, numLayers, numMips, bits, alphaByte );
+		std::string altName = Str::Format( "%s.%s", filename, imageLoaders[ bestLoader ].ext );
+		imageLoaders[ bestLoader ].ImageLoader( altName.c_str(), pic, width, height, numLayers, numMips, bits, alphaByte );
+	}
+}
+
+/*
+=================
+R_LoadImage
+
+Parses the image name from the buffer and loads it.
+=================
+*/
+static void R_LoadImage( const char **buffer, byte **pic, int *width, int *height,
+			 int *numLayers, int *numMips,
+			 int *bits )
+{
+	char *token;
+
+	*pic = nullptr;
+	*width = 0;
+	*height = 0;
+
+	token = COM_ParseExt2( buffer, false );
+
+	if ( !token[ 0 ] )
+	{
+		Log::Warn("NULL parameter for R_LoadImage" );
+		return;
+	}
+
+	R_LoadImageFile( token, pic, width, height, numLayers, numMips, bits );
+}
+
+/*
+=================
+R_DecodeImage
+
+Loads an image and applies the CPU side processing that only
+depends on the image flags.
+=================
+*/
+static void R_DecodeImage( const char *name, byte **pic, int *width, int *height,
+			   int *numLayers, int *numMips, int *bits )
+{
+	R_LoadImageFile( name, pic, width, height, numLayers, numMips, bits );
+
+	if ( pic[ 0 ] && *numLayers == 0 && ( *bits & IF_LIGHTMAP ) )
+	{
+		R_ProcessLightmap( pic[ 0 ], 4, *width, *height, *bits, pic[ 0 ] );
+
+		*bits |= IF_NOCOMPRESSION;
+	}
+}
+
+/*
+============================================================================
+
+IMAGE PREFETCHING
+
+Map and shader loading know most of the images they need before
+R_FindImageFile asks for them, so reading and decoding them is started
+on a pool of worker threads. R_FindImageFile picks up the decoded pixels
+and only does the upload on the main thread.
+
+Decoded images wait in memory until they are asked for, so the workers
+stop taking jobs while more than r_imagePrefetchMegs of them are waiting.
+
+============================================================================
+*/
+
+// the flags that change what R_DecodeImage produces
+#define IF_PREFETCH_BITS ( IF_NORMALMAP | IF_LIGHTMAP )
+
+struct imagePrefetch_t
+{
+	std::string name;
+	int         requestBits;
+	int         bits;
+	byte        *pic[ MAX_TEXTURE_MIPS * MAX_TEXTURE_LAYERS ];
+	int         width, height, numLayers, numMips;
+	size_t      size; // bytes of decoded pixels held
+	bool        failed; // decoded again on the main thread to report the error
+	bool        started;
+	bool        done;
+};
+
+static std::mutex                  prefetchMutex;
+static std::condition_variable     prefetchQueued;
+static std::condition_variable     prefetchFinished;
+static std::deque<imagePrefetch_t *> prefetchQueue;
+static std::unordered_map<std::string, std::unique_ptr<imagePrefetch_t>, Str::IHash, Str::IEqual> prefetchJobs;
+static std::vector<std::thread>    prefetchWorkers;
+static bool                        prefetchShutdown;
+static size_t                      prefetchBytes; // held by the finished jobs
+static size_t                      prefetchMaxBytes;
+
+// set while a prefetch worker decodes, see R_ImageDecodeError
+static thread_local std::string    *imageDecodeError;
+
+/*
+===============
+R_ImageDecodeError
+
+Image decoders report broken files through this and then return without
+pixels. On the main thread it drops like ri.Error does. A prefetch worker
+must not drop, Sys::Drop is not thread safe and escalates to a fatal error
+when many images are broken, so there the message is only recorded and
+the image is decoded again by R_FindImageFile to report it.
+===============
+*/
+void R_ImageDecodeError( const char *fmt, ... )
+{
+	va_list argptr;
+	char    msg[ MAX_STRING_CHARS ];
+
+	va_start( argptr, fmt );
+	Q_vsnprintf( msg, sizeof( msg ), fmt, argptr );
+	va_end( argptr );
+
+	if ( imageDecodeError )
+	{
+		if ( imageDecodeError->empty() )
+		{
+			*imageDecodeError = msg;
+		}
+
+		return;
+	}
+
+	ri.Error( errorParm_t::ERR_DROP, "%s", msg );
+}
+
+// a job that was taken out of prefetchJobs no longer counts, must be
+// called with prefetchMutex held
+static void R_ReleasePrefetchJob( const imagePrefetch_t *job )
+{
+	prefetchBytes -= job->size;
+	prefetchQueued.notify_all();
+}
+
+static void R_ImagePrefetchWorker()
+{
+	std::unique_lock<std::mutex> lock( prefetchMutex );
+
+	while ( true )
+	{
+		prefetchQueued.wait( lock, [] {
+			return prefetchShutdown || ( !prefetchQueue.empty() && prefetchBytes < prefetchMaxBytes );
+		} );
+
+		if ( prefetchShutdown )
+		{
+			return;
+		}
+
+		imagePrefetch_t *job = prefetchQueue.front();
+		prefetchQueue.pop_front();
+		job->started = true;
+		lock.unlock();
+
+		std::string error;
+		imageDecodeError = &error;
+
+		try
+		{
+			R_DecodeImage( job->name.c_str(), job->pic, &job->width, &job->height,
+				       &job->numLayers, &job->numMips, &job->bits );
+		}
+		catch ( std::exception& err )
+		{
+			// an error must not escape the worker
+			error = err.what();
+		}
+
+		imageDecodeError = nullptr;
+
+		if ( !error.empty() )
+		{
+			Log::Debug( "failed to prefetch %s: %s", job->name, error );
+
+			if ( job->pic[ 0 ] )
+			{
+				ri.Free( job->pic[ 0 ] );
+			}
+
+			memset( job->pic, 0, sizeof( job->pic ) );
+			job->failed = true;
+		}
+
+		if ( job->pic[ 0 ] )
+		{
+			job->size = static_cast<size_t>( job->width ) * job->height * 4 * std::max( job->numLayers, 1 );
+
+			if ( job->numMips > 1 )
+			{
+				job->size += job->size / 3;
+			}
+		}
+
+		lock.lock();
+		prefetchBytes += job->size;
+		job->done = true;
+		prefetchFinished.notify_all();
+	}
+}
+
+static void R_StartImagePrefetch()
+{
+	if ( !r_imagePrefetch->integer )
+	{
+		return;
+	}
+
+	int numThreads = Math::Clamp( static_cast<int>( std::thread::hardware_concurrency() ) - 1, 1, 8 );
+
+	prefetchShutdown = false;
+	prefetchBytes = 0;
+	prefetchMaxBytes = static_cast<size_t>( std::max( r_imagePrefetchMegs->integer, 1 ) ) << 20;
+
+	for ( int i = 0; i < numThreads; i++ )
+	{
+		prefetchWorkers.emplace_back( R_ImagePrefetchWorker );
+	}
+
+	Log::Debug( "started %i image decoding threads", numThreads );
+}
+
+static void R_StopImagePrefetch()
+{
+	R_FinishImagePrefetch();
+
+	{
+		std::lock_guard<std::mutex> lock( prefetchMutex );
+		prefetchShutdown = true;
+	}
+
+	prefetchQueued.notify_all();
+
+	for ( std::thread &worker : prefetchWorkers )
+	{
+		worker.join();
+	}
+
+	prefetchWorkers.clear();
+}
+
+static void R_QueueImageDecode( const char *name, int bits )
+{
+	std::lock_guard<std::mutex> lock( prefetchMutex );
+
+	if ( prefetchJobs.count( name ) )
+	{
+		return;
+	}
+
+	std::unique_ptr<imagePrefetch_t> job( new imagePrefetch_t() );
+	job->name = name;
+	job->requestBits = bits & IF_PREFETCH_BITS;
+	job->bits = job->requestBits;
+
+	prefetchQueue.push_back( job.get() );
+	prefetchJobs.emplace( name, std::move( job ) );
+	prefetchQueued.notify_one();
+}
+
+/*
+===============
+R_PrefetchImageFile
+
+Starts decoding an image that R_FindImageFile will be asked for soon.
+Only IF_NORMALMAP and IF_LIGHTMAP of bits matter here, the request is
+decoded again if R_FindImageFile disagrees with them.
+===============
+*/
+void R_PrefetchImageFile( const char *name, int bits )
+{
+	image_t *image;
+
+	if ( prefetchWorkers.empty() || !name || !name[ 0 ] )
+	{
+		return;
+	}
+
+	for ( image = r_imageHashTable[ GenerateImageHashValue( name ) ]; image; image = image->next )
+	{
+		if ( !Q_strnicmp( name, image->name, sizeof( image->name ) ) )
+		{
+			return;
+		}
+	}
+
+	R_QueueImageDecode( name, bits );
+}
+
+/*
+===============
+R_TakePrefetchedImage
+
+Returns false if the image has to be decoded by the caller.
+===============
+*/
+static bool R_TakePrefetchedImage( const char *name, byte **pic, int *width, int *height,
+				   int *numLayers, int *numMips, int *bits )
+{
+	if ( prefetchWorkers.empty() )
+	{
+		return false;
+	}
+
+	std::unique_lock<std::mutex> lock( prefetchMutex );
+
+	auto it = prefetchJobs.find( name );
+
+	if ( it == prefetchJobs.end() )
+	{
+		return false;
+	}
+
+	std::unique_ptr<imagePrefetch_t> job = std::move( it->second );
+	prefetchJobs.erase( it );
+
+	if ( !job->started )
+	{
+		// decoding it here is quicker than waiting for a worker
+		prefetchQueue.erase( std::find( prefetchQueue.begin(), prefetchQueue.end(), job.get() ) );
+		return false;
+	}
+
+	prefetchFinished.wait( lock, [ &job ] { return job->done; } );
+	R_ReleasePrefetchJob( job.get() );
+	lock.unlock();
+
+	// the error is raised by decoding it again here
+	if ( job->failed || ( job->requestBits ^ *bits ) & IF_PREFETCH_BITS )
+	{
+		if ( job->pic[ 0 ] )
+		{
+			ri.Free( job->pic[ 0 ] );
+		}
+
+		return false;
+	}
+
+	memcpy( pic, job->pic, sizeof( job->pic ) );
+	*width = job->width;
+	*height = job->height;
+	*numLayers = job->numLayers;
+	*numMips = job->numMips;
+	*bits |= job->bits;
+
+	return true;
+}
+
+/*
+===============
+R_PollPrefetchedImage
+
+R_TakePrefetchedImage for the texture streaming, which must not block:
+returns 1 once the pixels are there, 0 while the job is still running
+and -1 if there is no such job or it failed.
+===============
+*/
+static int R_PollPrefetchedImage( const char *name, byte **pic, int *width, int *height,
+				  int *numLayers, int *numMips )
+{
+	std::unique_lock<std::mutex> lock( prefetchMutex );
+
+	auto it = prefetchJobs.find( name );
+
+	if ( it == prefetchJobs.end() )
+	{
+		return -1;
+	}
+
+	if ( !it->second->done )
+	{
+		return 0;
+	}
+
+	std::unique_ptr<imagePrefetch_t> job = std::move( it->second );
+	prefetchJobs.erase( it );
+	R_ReleasePrefetchJob( job.get() );
+	lock.unlock();
+
+	if ( job->failed )
+	{
+		Log::Warn( "could not stream image %s", job->name );
+		return -1;
+	}
+
+	memcpy( pic, job->pic, sizeof( job->pic ) );
+	*width = job->width;
+	*height = job->height;
+	*numLayers = job->numLayers;
+	*numMips = job->numMips;
+
+	return 1;
+}
+
+/*
+===============
+R_FinishImagePrefetch
+
+Waits for the workers and throws away the images nobody asked for.
+===============
+*/
+void R_FinishImagePrefetch()
+{
+	std::unique_lock<std::mutex> lock( prefetchMutex );
+
+	for ( imagePrefetch_t *job : prefetchQueue )
+	{
+		prefetchJobs.erase( job->name );
+	}
+
+	prefetchQueue.clear();
+
+	prefetchFinished.wait( lock, [] {
+		for ( const auto &job : prefetchJobs )
+		{
+			if ( !job.second->done )
+			{
+				return false;
+			}
+		}
+
+		return true;
+	} );
+
+	if ( !prefetchJobs.empty() )
+	{
+		Log::Debug( "%i prefetched images were not used", static_cast<int>( prefetchJobs.size() ) );
+	}
+
+	for ( const auto &job : prefetchJobs )
+	{
+		if ( job.second->pic[ 0 ] )
+		{
+			ri.Free( job.second->pic[ 0 ] );
+		}
+	}
+
+	prefetchJobs.clear();
+	prefetchBytes = 0;
+	prefetchQueued.notify_all();
+}
+
+/*
+============================================================================
+
+TEXTURE STREAMING
+
+With r_textureBudget set, images loaded by R_FindImageFile are uploaded
+with r_textureStreamLevels of their top mip levels dropped. Images that
+got drawn are decoded again by the prefetch workers and re-uploaded at
+full resolution, as far as the budget allows; when it runs out, the
+images that were not drawn for the longest time go back to the reduced
+resolution. Both cvars are latched, without a budget images are created
+as usual and none of this runs.
+
+============================================================================
+*/
+
+// frames an image has to be unused before it may lose resolution again
+#define STREAM_IDLE_FRAMES 250
+
+// streamed images re-uploaded per frame at most, as each one is a hitch
+#define STREAM_UPLOADS_PER_FRAME 4
+
+static bool R_IsStreamable( int bits, filterType_t filterType )
+{
+	// regenerated images and lightmaps can't be reloaded at another size
+	return r_textureBudget->integer > 0
+		&& !( bits & ( IF_NOPICMIP | IF_LIGHTMAP ) )
+		&& filterType == filterType_t::FT_DEFAULT
+		&& !prefetchWorkers.empty();
+}
+
+static int R_TexelBits( uint32_t internalFormat )
+{
+	switch ( internalFormat )
+	{
+		case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_RED_RGTC1:
+			return 4;
+
+		case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+		case GL_COMPRESSED_RG_RGTC2:
+		case GL_ALPHA8:
+			return 8;
+
+		case GL_R16F:
+		case GL_ALPHA16F_ARB:
+		case GL_DEPTH_COMPONENT16:
+			return 16;
+
+		case GL_RGB16F:
+		case GL_RGBA16F:
+		case GL_RG32F:
+		case GL_LUMINANCE_ALPHA32F_ARB:
+			return 64;
+
+		case GL_RGB32F:
+		case GL_RGBA32F:
+		case GL_RGBA32UI:
+			return 128;
+
+		default:
+			// drivers pad RGB8 to four bytes as well
+			return 32;
+	}
+}
+
+/*
+===============
+R_ImageMemorySize
+
+Rough amount of video memory an image takes, mip levels included.
+===============
+*/
+static size_t R_ImageMemorySize( const image_t *image )
+{
+	size_t size = static_cast<size_t>( image->uploadWidth ) * image->uploadHeight * R_TexelBits( image->internalFormat ) / 8;
+
+	if ( image->type == GL_TEXTURE_CUBE_MAP )
+	{
+		size *= 6;
+	}
+
+	if ( image->filterType == filterType_t::FT_DEFAULT )
+	{
+		size += size / 3;
+	}
+
+	return size;
+}
+
+// the size of a streamed image once it is at the given level
+static size_t R_StreamedImageSize( const image_t *image, int level )
+{
+	size_t size = R_ImageMemorySize( image );
+	int    shift = 2 * ( image->streamLevel - level );
+
+	return shift >= 0 ? size << shift : size >> -shift;
+}
+
+static void R_ReuploadStreamedImage( image_t *image, int level, const byte **pic, int numMips )
+{
+	// the mip chain of the old storage doesn't match the new size,
+	// so start over with a fresh texture object
+	for ( int &texnum : glState.currenttextures )
+	{
+		if ( texnum == static_cast<int>( image->texnum ) )
+		{
+			texnum = 0;
+		}
+	}
+
+	glDeleteTextures( 1, &image->texnum );
+	glGenTextures( 1, &image->texnum );
+
+	image->streamLevel = level;
+	R_UploadImage( pic, 1, numMips, image );
+}
+
+/*
+===============
+R_UpdateTextureResidency
+
+Called once per frame from the main thread.
+===============
+*/
+void R_UpdateTextureResidency()
+{
+	std::vector<image_t *> streamed;
+	size_t                 projected = 0;
+	int                    uploads = 0;
+
+	// r_textureBudget is latched, so without it no image is streamed
+	if ( r_textureBudget->integer <= 0 )
+	{
+		return;
+	}
+
+	for ( int i = 0; i < tr.images.currentElements; i++ )
+	{
+		image_t *image = (image_t*) Com_GrowListElement( &tr.images, i );
+
+		if ( image->streamed && image->streamRequest >= 0 && uploads < STREAM_UPLOADS_PER_FRAME )
+		{
+			byte *pic[ MAX_TEXTURE_MIPS * MAX_TEXTURE_LAYERS ];
+			int  width, height, numLayers, numMips;
+			int  result = R_PollPrefetchedImage( image->name, pic, &width, &height, &numLayers, &numMips );
+
+			if ( result > 0 )
+			{
+				if ( width == image->width && height == image->height && numLayers == 0 )
+				{
+					if ( !uploads++ )
+					{
+						R_SyncRenderThread();
+					}
+
+					R_ReuploadStreamedImage( image, image->streamRequest, (const byte **)pic, numMips );
+				}
+
+				ri.Free( pic[ 0 ] );
+			}
+
+			if ( result != 0 )
+			{
+				image->streamRequest = -1;
+			}
+		}
+
+		if ( image->streamed )
+		{
+			streamed.push_back( image );
+			projected += R_StreamedImageSize( image, image->streamRequest >= 0 ? image->streamRequest : image->streamLevel );
+		}
+		else
+		{
+			projected += R_ImageMemorySize( image );
+		}
+	}
+
+	size_t budget = static_cast<size_t>( r_textureBudget->integer ) << 20;
+	int    lowLevel = std::max( r_textureStreamLevels->integer, 0 );
+
+	if ( streamed.empty() )
+	{
+		return;
+	}
+
+	// most recently drawn first
+	std::sort( streamed.begin(), streamed.end(), []( const image_t *a, const image_t *b ) {
+		return a->frameUsed.load( std::memory_order_relaxed ) > b->frameUsed.load( std::memory_order_relaxed );
+	} );
+
+	// give the images drawn last frame their full resolution, and
+	// take it from the ones that have not been drawn in a while if
+	// that doesn't fit
+	auto evict = streamed.end();
+
+	for ( image_t *image : streamed )
+	{
+		// the render thread may still be working on the last frame
+		if ( image->frameUsed.load( std::memory_order_relaxed ) < tr.frameCount - 2 )
+		{
+			break;
+		}
+
+		if ( image->streamLevel == 0 || image->streamRequest >= 0 )
+		{
+			continue;
+		}
+
+		size_t growth = R_StreamedImageSize( image, 0 ) - R_ImageMemorySize( image );
+
+		while ( projected + growth > budget && evict != streamed.begin() )
+		{
+			image_t *victim = *--evict;
+
+			if ( victim->frameUsed.load( std::memory_order_relaxed ) >= tr.frameCount - STREAM_IDLE_FRAMES )
+			{
+				evict = streamed.begin();
+				break;
+			}
+
+			if ( victim->streamLevel < lowLevel && victim->streamRequest < 0 )
+			{
+				projected -= R_ImageMemorySize( victim ) - R_StreamedImageSize( victim, lowLevel );
+				victim->streamRequest = lowLevel;
+				R_QueueImageDecode( victim->name, victim->bits );
+			}
+		}
+
+		if ( projected + growth > budget )
+		{
+			break;
+		}
+
+		projected += growth;
+		image->streamRequest = 0;
+		R_QueueImageDecode( image->name, image->bits );
 	}
 }
 
@@ -1751,7 +2461,6 @@ image_t        *R_FindImageFile( const char *imageName, int bits, filterType_t f
 	byte          *mallocPtr = nullptr;
 	long          hash;
 	char          buffer[ 1024 ];
-	const char          *buffer_p;
 	unsigned long diff;
 
 	if ( !imageName )
@@ -1787,10 +2496,13 @@ image_t        *R_FindImageFile( const char *imageName, int bits, filterType_t f
 		}
 	}
 
-	// load the pic from disk
+	// load the pic from disk, unless a prefetch worker already did
 	pic[ 0 ] = nullptr;
-	buffer_p = &buffer[ 0 ];
-	R_LoadImage( &buffer_p, pic, &width, &height, &numLayers, &numMips, &bits );
+
+	if ( !R_TakePrefetchedImage( buffer, pic, &width, &height, &numLayers, &numMips, &bits ) )
+	{
+		R_DecodeImage( buffer, pic, &width, &height, &numLayers, &numMips, &bits );
+	}
 
 	if ( (mallocPtr = pic[ 0 ]) == nullptr || numLayers > 0 )
 	{
@@ -1801,21 +2513,42 @@ image_t        *R_FindImageFile( const char *imageName, int bits, filterType_t f
 		return nullptr;
 	}
 
-	if ( bits & IF_LIGHTMAP )
+	if ( R_IsStreamable( bits, filterType ) )
 	{
-		R_ProcessLightmap( pic[ 0 ], 4, width, height, bits, pic[ 0 ] );
+		image = R_AllocImage( buffer, true );
 
-		bits |= IF_NOCOMPRESSION;
-	}
+		image->type = GL_TEXTURE_2D;
+		image->width = width;
+		image->height = height;
+		image->bits = bits;
+		image->filterType = filterType;
+		image->wrapType = wrapType;
+		image->streamed = true;
+
+		// start small and let R_UpdateTextureResidency bring it up
+		// to full resolution once it is drawn
+		image->streamLevel = std::max( r_textureStreamLevels->integer, 0 );
+
+		R_UploadImage( (const byte **)pic, 1, numMips, image );
 
-	image = R_CreateImage( ( char * ) buffer, (const byte **)pic,
-			       width, height, numMips, bits,
-			       filterType, wrapType );
+		// the export is the uploaded texture, so only full size ones
+		if ( r_exportTextures->integer && !image->streamLevel )
+		{
+			R_ExportTexture( image );
+		}
+	}
+	else
+	{
+		image = R_CreateImage( ( char * ) buffer, (const byte **)pic,
+				       width, height, numMips, bits,
+				       filterType, wrapType );
+	}
 
 	ri.Free( mallocPtr );
 	return image;
 }
 
+
 static void R_Flip( byte *in, int width, int height )
 {
 	int32_t *data = (int32_t *) in;
@@ -2813,6 +3546,8 @@ void R_InitImages()
 	// create default texture and white texture
 	R_CreateBuiltinImages();
 
+	R_StartImagePrefetch();
+
 #if defined( REFBONE_NAMES )
 	char fileName [ MAX_QPATH ];
 	char strippedName [ MAX_QPATH ];
@@ -2835,6 +3570,8 @@ void R_ShutdownImages()
 
 	Log::Debug("------- R_ShutdownImages -------" );
 
+	R_StopImagePrefetch();
+
 	for ( i = 0; i < tr.images.currentElements; i++ )
 	{
 		image = (image_t*) Com_GrowListElement( &tr.images, i );
@@ -33,6 +33,8 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include <jpeglib.h>
 
+#include <csetjmp>
+
 
 /*
 =========================================================
@@ -42,16 +44,26 @@ JPEG LOADING
 =========================================================
 */
 
-static void NORETURN R_JPGErrorExit( j_common_ptr cinfo )
+/*
+ * libjpeg is C, so its errors must not unwind through it as exceptions:
+ * the error handler jumps back to the setjmp in LoadJPG or SaveJPGToBuffer,
+ * which clean up and report the error once they are out of the library.
+ * Nothing with a destructor may live in those functions.
+ */
+struct jpegErrorManager_t
 {
-	char buffer[ JMSG_LENGTH_MAX ];
+	struct jpeg_error_mgr pub;
+	jmp_buf               setjmpBuffer;
+	char                  message[ JMSG_LENGTH_MAX ];
+};
 
-	( *cinfo->err->format_message )( cinfo, buffer );
+static void NORETURN R_JPGErrorExit( j_common_ptr cinfo )
+{
+	jpegErrorManager_t *err = ( jpegErrorManager_t * ) cinfo->err;
 
-	/* Let the memory manager delete any temp files before we die */
-	jpeg_destroy( cinfo );
+	( *cinfo->err->format_message )( cinfo, err->message );
 
-	ri.Error( errorParm_t::ERR_FATAL, "%s", buffer );
+	longjmp( err->setjmpBuffer, 1 );
 }
 
 static void R_JPGOutputMessage( j_common_ptr cinfo )
@@ -85,14 +97,14 @@ void LoadJPG( const char *filename, unsigned char **pic, int *width, int *height
 	 * Note that this struct must live as long as the main JPEG parameter
 	 * struct, to avoid dangling-pointer problems.
 	 */
-	struct jpeg_error_mgr jerr;
+	jpegErrorManager_t    jerr;
 
 	/* More stuff */
 	JSAMPARRAY            buffer; /* Output row buffer */
 	unsigned int          row_stride; /* physical row width in output buffer */
 	unsigned int          pixelcount, memcount;
 	unsigned int          sindex, dindex;
-	byte                  *out;
+	byte                  *volatile out = nullptr; /* set after the setjmp */
 	int                   len;
 	union
 	{
@@ -102,7 +114,7 @@ void LoadJPG( const char *filename, unsigned char **pic, int *width, int *height
 
 	byte *buf;
 #if JPEG_LIB_VERSION < 80
-	FILE *jpegfd;
+	FILE *volatile jpegfd;
 #endif
 
 	/* In this example we want to open the input file before doing anything else,
@@ -125,10 +137,35 @@ void LoadJPG( const char *filename, unsigned char **pic, int *width, int *height
 	 * This routine fills in the contents of struct jerr, and returns jerr's
 	 * address which we place into the link field in cinfo.
 	 */
-	cinfo.err = jpeg_std_error( &jerr );
+	cinfo.err = jpeg_std_error( &jerr.pub );
 	cinfo.err->error_exit = R_JPGErrorExit;
 	cinfo.err->output_message = R_JPGOutputMessage;
 
+#if JPEG_LIB_VERSION < 80
+	jpegfd = nullptr;
+#endif
+
+	if ( setjmp( jerr.setjmpBuffer ) )
+	{
+		/* The library signaled an error, clean up what it left behind */
+		jpeg_destroy_decompress( &cinfo );
+#if JPEG_LIB_VERSION < 80
+		if ( jpegfd )
+		{
+			fclose( jpegfd );
+		}
+#endif
+		ri.FS_FreeFile( fbuffer.v );
+
+		if ( out )
+		{
+			ri.Free( out );
+		}
+
+		R_ImageDecodeError( "LoadJPG: %s: %s", filename, jerr.message );
+		return;
+	}
+
 	/* Now we can initialize the JPEG decompression object. */
 	jpeg_create_decompress( &cinfo );
 
@@ -188,8 +225,9 @@ void LoadJPG( const char *filename, unsigned char **pic, int *width, int *height
 		fclose( jpegfd );
 #endif
 
-		ri.Error(errorParm_t::ERR_DROP, "LoadJPG: %s has an invalid image format: %dx%d*4=%d, components: %d", filename,
-		          cinfo.output_width, cinfo.output_height, pixelcount * 4, cinfo.output_components );
+		R_ImageDecodeError( "LoadJPG: %s has an invalid image format: %dx%d*4=%d, components: %d", filename,
+		                    cinfo.output_width, cinfo.output_height, pixelcount * 4, cinfo.output_components );
+		return;
 	}
 
 	memcount = pixelcount * 4;
@@ -322,14 +360,13 @@ static void init_destination( j_compress_ptr cinfo )
 
 static          boolean empty_output_buffer( j_compress_ptr cinfo )
 {
-	my_dest_ptr dest = ( my_dest_ptr ) cinfo->dest;
-
-	jpeg_destroy_compress( cinfo );
+	my_dest_ptr        dest = ( my_dest_ptr ) cinfo->dest;
+	jpegErrorManager_t *err = ( jpegErrorManager_t * ) cinfo->err;
 
-	// Make crash fatal or we would probably leak memory.
-	ri.Error( errorParm_t::ERR_FATAL, "Output buffer for encoded JPEG image has insufficient size of %d bytes", dest->size );
-
-	return FALSE;
+	// SaveJPGToBuffer cleans up and returns a size of 0
+	Com_sprintf( err->message, sizeof( err->message ),
+	             "Output buffer for encoded JPEG image has insufficient size of %d bytes", dest->size );
+	longjmp( err->setjmpBuffer, 1 );
 }
 
 /*
@@ -381,14 +418,14 @@ static void jpegDest( j_compress_ptr cinfo, byte *outfile, int size )
 SaveJPGToBuffer
 
 Encodes JPEG from image in image_buffer and writes to buffer.
-Expects RGB input data
+Expects RGB input data, returns 0 if the encoding failed
 =================
 */
 int SaveJPGToBuffer( byte *buffer, size_t bufSize, int quality, int image_width, int image_height, byte *image_buffer )
 {
-	struct jpeg_compress_struct cinfo;
+	struct jpeg_compress_struct cinfo {};
 
-	struct jpeg_error_mgr       jerr;
+	jpegErrorManager_t          jerr;
 
 	JSAMPROW                    row_pointer[ 1 ]; /* pointer to JSAMPLE row[s] */
 	my_dest_ptr                 dest;
@@ -396,10 +433,19 @@ int SaveJPGToBuffer( byte *buffer, size_t bufSize, int quality, int image_width,
 	size_t                      outcount;
 
 	/* Step 1: allocate and initialize JPEG compression object */
-	cinfo.err = jpeg_std_error( &jerr );
+	cinfo.err = jpeg_std_error( &jerr.pub );
 	cinfo.err->error_exit = R_JPGErrorExit;
 	cinfo.err->output_message = R_JPGOutputMessage;
 
+	if ( setjmp( jerr.setjmpBuffer ) )
+	{
+		jpeg_destroy_compress( &cinfo );
+
+		// may run on the video encoding thread, so the caller decides
+		Log::Warn( "SaveJPGToBuffer: %s", jerr.message );
+		return 0;
+	}
+
 	/* Now we can initialize the JPEG compression object. */
 	jpeg_create_compress( &cinfo );
 
@@ -462,7 +508,11 @@ void SaveJPG( char *filename, int quality, int image_width, int image_height, by
 	out = (byte*) ri.Hunk_AllocateTempMemory( bufSize );
 
 	bufSize = SaveJPGToBuffer( out, bufSize, quality, image_width, image_height, image_buffer );
-	ri.FS_WriteFile( filename, out, bufSize );
+
+	if ( bufSize )
+	{
+		ri.FS_WriteFile( filename, out, bufSize );
+	}
 
 	ri.Hunk_FreeTempMemory( out );
 }
@@ -76,19 +76,22 @@ void LoadTGA( const char *name, byte **pic, int *width, int *height,
 	if ( targa_header.image_type != 2 && targa_header.image_type != 10 && targa_header.image_type != 3 )
 	{
 		ri.FS_FreeFile( buffer );
-		ri.Error(errorParm_t::ERR_DROP, "LoadTGA: Only type 2 (RGB), 3 (gray), and 10 (RGB) TGA images supported (%s)", name );
+		R_ImageDecodeError( "LoadTGA: Only type 2 (RGB), 3 (gray), and 10 (RGB) TGA images supported (%s)", name );
+		return;
 	}
 
 	if ( targa_header.colormap_type != 0 )
 	{
 		ri.FS_FreeFile( buffer );
-		ri.Error(errorParm_t::ERR_DROP, "LoadTGA: colormaps not supported (%s)", name );
+		R_ImageDecodeError( "LoadTGA: colormaps not supported (%s)", name );
+		return;
 	}
 
 	if ( ( targa_header.pixel_size != 32 && targa_header.pixel_size != 24 ) && targa_header.image_type != 3 )
 	{
 		ri.FS_FreeFile( buffer );
-		ri.Error(errorParm_t::ERR_DROP, "LoadTGA: Only 32 or 24 bit images supported (no colormaps) (%s)", name );
+		R_ImageDecodeError( "LoadTGA: Only 32 or 24 bit images supported (no colormaps) (%s)", name );
+		return;
 	}
 
 	columns = targa_header.width;
@@ -108,7 +111,8 @@ void LoadTGA( const char *name, byte **pic, int *width, int *height,
 	if ( !columns || !rows || numPixels > 0x7FFFFFFF || numPixels / columns / 4 != rows )
 	{
 		ri.FS_FreeFile( buffer );
-		ri.Error(errorParm_t::ERR_DROP, "LoadTGA: %s has an invalid image size", name );
+		R_ImageDecodeError( "LoadTGA: %s has an invalid image size", name );
+		return;
 	}
 
 	targa_rgba = (byte*) ri.Z_Malloc( numPixels );
@@ -166,8 +170,10 @@ void LoadTGA( const char *name, byte **pic, int *width, int *height,
 
 					default:
 						ri.Free( targa_rgba );
+						*pic = nullptr;
 						ri.FS_FreeFile( buffer );
-						ri.Error(errorParm_t::ERR_DROP, "LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name );
+						R_ImageDecodeError( "LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name );
+						return;
 				}
 			}
 		}
@@ -212,8 +218,10 @@ void LoadTGA( const char *name, byte **pic, int *width, int *height,
 
 						default:
 							ri.Free( targa_rgba );
+							*pic = nullptr;
 							ri.FS_FreeFile( buffer );
-							ri.Error(errorParm_t::ERR_DROP, "LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name );
+							R_ImageDecodeError( "LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name );
+							return;
 					}
 
 					for ( j = 0; j < packetSize; j++ )
@@ -272,9 +280,10 @@ void LoadTGA( const char *name, byte **pic, int *width, int *height,
 
 							default:
 								ri.Free( targa_rgba );
+								*pic = nullptr;
 								ri.FS_FreeFile( buffer );
-								ri.Error(errorParm_t::ERR_DROP,
-								          "LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name );
+								R_ImageDecodeError( "LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name );
+								return;
 						}
 
 						column++;
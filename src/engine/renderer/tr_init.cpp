@@ -86,6 +86,12 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 	cvar_t      *r_compressSpecularMaps;
 	cvar_t      *r_compressNormalMaps;
 	cvar_t      *r_exportTextures;
+	cvar_t      *r_imagePrefetch;
+	cvar_t      *r_imagePrefetchMegs;
+	cvar_t      *r_frontendThreads;
+	cvar_t      *r_worldCache;
+	cvar_t      *r_textureBudget;
+	cvar_t      *r_textureStreamLevels;
 	cvar_t      *r_heatHaze;
 	cvar_t      *r_noMarksOnTrisurfs;
 	cvar_t      *r_recompileShaders;
@@ -753,17 +759,16 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 	/*
 	==================
 	RB_TakeVideoFrameCmd
+
+	Only reads the frame back, the client encodes and writes it on
+	its own thread
 	==================
 	*/
 	const RenderCommand *VideoFrameCommand::ExecuteSelf( ) const
 	{
 		GLint                     packAlign;
-		int                       lineLen, captureLineLen;
+		int                       captureLineLen;
 		byte                      *pixels;
-		int                       i;
-		int                       outputSize;
-		int                       j;
-		int                       aviLineLen;
 
 		// RB: it is possible to we still have a videoFrameCommand_t but we already stopped
 		// video recording
@@ -773,44 +778,12 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 			glGetIntegerv( GL_PACK_ALIGNMENT, &packAlign );
 
-			lineLen = width * 3;
-			captureLineLen = PAD( lineLen, packAlign );
+			captureLineLen = PAD( width * 3, packAlign );
 
 			pixels = ( byte * ) PADP( captureBuffer, packAlign );
 			glReadPixels( 0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels );
 
-			if ( motionJpeg )
-			{
-				// Drop alignment and line padding bytes
-				for ( i = 0; i < height; ++i )
-				{
-					memmove( captureBuffer + i * lineLen, pixels + i * captureLineLen, lineLen );
-				}
-
-				outputSize = SaveJPGToBuffer( encodeBuffer, 3 * width * height, 90, width, height, captureBuffer );
-				ri.CL_WriteAVIVideoFrame( encodeBuffer, outputSize );
-			}
-			else
-			{
-				aviLineLen = PAD( lineLen, AVI_LINE_PADDING );
-
-				for ( i = 0; i < height; ++i )
-				{
-					for ( j = 0; j < lineLen; j += 3 )
-					{
-						encodeBuffer[ i * aviLineLen + j + 0 ] = pixels[ i * captureLineLen + j + 2 ];
-						encodeBuffer[ i * aviLineLen + j + 1 ] = pixels[ i * captureLineLen + j + 1 ];
-						encodeBuffer[ i * aviLineLen + j + 2 ] = pixels[ i * captureLineLen + j + 0 ];
-					}
-
-					while ( j < aviLineLen )
-					{
-						encodeBuffer[ i * aviLineLen + j++ ] = 0;
-					}
-				}
-
-				ri.CL_WriteAVIVideoFrame( encodeBuffer, aviLineLen * height );
-			}
+			ri.CL_QueueAVIVideoFrame( frame, pixels, captureLineLen );
 		}
 
 		return this + 1;
@@ -1107,6 +1080,12 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 		r_compressSpecularMaps = ri.Cvar_Get( "r_compressSpecularMaps", "1", CVAR_LATCH );
 		r_compressNormalMaps = ri.Cvar_Get( "r_compressNormalMaps", "0", CVAR_LATCH );
 		r_exportTextures = ri.Cvar_Get( "r_exportTextures", "0", 0 );
+		r_imagePrefetch = ri.Cvar_Get( "r_imagePrefetch", "1", 0 );
+		r_imagePrefetchMegs = ri.Cvar_Get( "r_imagePrefetchMegs", "256", 0 );
+		r_frontendThreads = ri.Cvar_Get( "r_frontendThreads", "0", CVAR_LATCH );
+		r_worldCache = ri.Cvar_Get( "r_worldCache", "1", 0 );
+		r_textureBudget = ri.Cvar_Get( "r_textureBudget", "0", CVAR_LATCH | CVAR_ARCHIVE );
+		r_textureStreamLevels = ri.Cvar_Get( "r_textureStreamLevels", "2", CVAR_LATCH | CVAR_ARCHIVE );
 		r_heatHaze = ri.Cvar_Get( "r_heatHaze", "1", 0 );
 		r_noMarksOnTrisurfs = ri.Cvar_Get( "r_noMarksOnTrisurfs", "1", CVAR_CHEAT );
 		r_recompileShaders = ri.Cvar_Get( "r_recompileShaders", "0", 0 );
@@ -1351,6 +1330,9 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 		ri.Cmd_AddCommand( "screenshotPNG", R_ScreenShotPNG_f );
 		ri.Cmd_AddCommand( "gfxinfo", GfxInfo_f );
 		ri.Cmd_AddCommand( "buildcubemaps", R_BuildCubeMaps );
+		ri.Cmd_AddCommand( "cullbench", R_CullBench_f );
+		ri.Cmd_AddCommand( "scenecapture", R_SceneCapture_f );
+		ri.Cmd_AddCommand( "scenebench", R_SceneBench_f );
 
 		ri.Cmd_AddCommand( "glsl_restart", GLSL_restart_f );
 	}
@@ -1406,6 +1388,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 		R_NoiseInit();
 
 		R_Register();
+		RB_InitCvars();
 
 		if ( !InitOpenGL() )
 		{
@@ -1416,19 +1399,19 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 		GLSL_InitGPUShaders();
 #endif
 
-		backEndData[ 0 ] = ( backEndData_t * ) ri.Hunk_Alloc( sizeof( *backEndData[ 0 ] ), ha_pref::h_low );
-		backEndData[ 0 ]->polys = ( srfPoly_t * ) ri.Hunk_Alloc( r_maxPolys->integer * sizeof( srfPoly_t ), ha_pref::h_low );
-		backEndData[ 0 ]->polyVerts = ( polyVert_t * ) ri.Hunk_Alloc( r_maxPolyVerts->integer * sizeof( polyVert_t ), ha_pref::h_low );
-		backEndData[ 0 ]->polyIndexes = ( int * ) ri.Hunk_Alloc( r_maxPolyVerts->integer * sizeof( int ), ha_pref::h_low );
-		backEndData[ 0 ]->polybuffers = ( srfPolyBuffer_t * ) ri.Hunk_Alloc( r_maxPolys->integer * sizeof( srfPolyBuffer_t ), ha_pref::h_low );
+		backEndData[ 0 ] = ( backEndData_t * ) ri.Hunk_Alloc( sizeof( *backEndData[ 0 ] ), hunkTag_t::HT_RENDERER );
+		backEndData[ 0 ]->polys = ( srfPoly_t * ) ri.Hunk_Alloc( r_maxPolys->integer * sizeof( srfPoly_t ), hunkTag_t::HT_RENDERER );
+		backEndData[ 0 ]->polyVerts = ( polyVert_t * ) ri.Hunk_Alloc( r_maxPolyVerts->integer * sizeof( polyVert_t ), hunkTag_t::HT_RENDERER );
+		backEndData[ 0 ]->polyIndexes = ( int * ) ri.Hunk_Alloc( r_maxPolyVerts->integer * sizeof( int ), hunkTag_t::HT_RENDERER );
+		backEndData[ 0 ]->polybuffers = ( srfPolyBuffer_t * ) ri.Hunk_Alloc( r_maxPolys->integer * sizeof( srfPolyBuffer_t ), hunkTag_t::HT_RENDERER );
 
 		if ( r_smp->integer )
 		{
-			backEndData[ 1 ] = ( backEndData_t * ) ri.Hunk_Alloc( sizeof( *backEndData[ 1 ] ), ha_pref::h_low );
-			backEndData[ 1 ]->polys = ( srfPoly_t * ) ri.Hunk_Alloc( r_maxPolys->integer * sizeof( srfPoly_t ), ha_pref::h_low );
-			backEndData[ 1 ]->polyVerts = ( polyVert_t * ) ri.Hunk_Alloc( r_maxPolyVerts->integer * sizeof( polyVert_t ), ha_pref::h_low );
-			backEndData[ 1 ]->polyIndexes = ( int * ) ri.Hunk_Alloc( r_maxPolyVerts->integer * sizeof( int ), ha_pref::h_low );
-			backEndData[ 1 ]->polybuffers = ( srfPolyBuffer_t * ) ri.Hunk_Alloc( r_maxPolys->integer * sizeof( srfPolyBuffer_t ), ha_pref::h_low );
+			backEndData[ 1 ] = ( backEndData_t * ) ri.Hunk_Alloc( sizeof( *backEndData[ 1 ] ), hunkTag_t::HT_RENDERER );
+			backEndData[ 1 ]->polys = ( srfPoly_t * ) ri.Hunk_Alloc( r_maxPolys->integer * sizeof( srfPoly_t ), hunkTag_t::HT_RENDERER );
+			backEndData[ 1 ]->polyVerts = ( polyVert_t * ) ri.Hunk_Alloc( r_maxPolyVerts->integer * sizeof( polyVert_t ), hunkTag_t::HT_RENDERER );
+			backEndData[ 1 ]->polyIndexes = ( int * ) ri.Hunk_Alloc( r_maxPolyVerts->integer * sizeof( int ), hunkTag_t::HT_RENDERER );
+			backEndData[ 1 ]->polybuffers = ( srfPolyBuffer_t * ) ri.Hunk_Alloc( r_maxPolys->integer * sizeof( srfPolyBuffer_t ), hunkTag_t::HT_RENDERER );
 		}
 		else
 		{
@@ -1439,6 +1422,8 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 		R_InitImages();
 
+		R_InitJobs();
+
 		R_InitFBOs();
 
 		R_InitVBOs();
@@ -1496,6 +1481,11 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 		ri.Cmd_RemoveCommand( "vbolist" );
 		ri.Cmd_RemoveCommand( "generatemtr" );
 		ri.Cmd_RemoveCommand( "buildcubemaps" );
+		ri.Cmd_RemoveCommand( "cullbench" );
+		ri.Cmd_RemoveCommand( "scenecapture" );
+		ri.Cmd_RemoveCommand( "scenebench" );
+
+		R_StopSceneCapture();
 
 		ri.Cmd_RemoveCommand( "glsl_restart" );
 
@@ -1504,6 +1494,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 			R_SyncRenderThread();
 
 			R_ShutdownBackend();
+			R_ShutdownJobs();
 			R_ShutdownImages();
 			R_ShutdownVBOs();
 			R_ShutdownFBOs();
@@ -1646,6 +1637,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 		// XreaL BEGIN
 		re.TakeVideoFrame = RE_TakeVideoFrame;
+		re.SaveJPGToBuffer = SaveJPGToBuffer;
 
 		re.AddRefLightToScene = RE_AddRefLightToScene;
 
@@ -1653,6 +1645,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 		re.CheckSkeleton = RE_CheckSkeleton;
 		re.BuildSkeleton = RE_BuildSkeleton;
 		re.BlendSkeleton = RE_BlendSkeleton;
+		re.BuildSkeletons = RE_BuildSkeletons;
 		re.BoneIndex = RE_BoneIndex;
 		re.AnimNumFrames = RE_AnimNumFrames;
 		re.AnimFrameRate = RE_AnimFrameRate;
@@ -0,0 +1,204 @@
+/*
+===========================================================================
+
+Daemon GPL Source Code
+Copyright (C) 2024 Daemon Developers
+
+This file is part of the Daemon GPL Source Code (Daemon Source Code).
+
+Daemon Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Daemon Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Daemon Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+===========================================================================
+*/
+// tr_jobs.cpp -- worker pool for the parallel parts of the frontend
+#include "tr_local.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <thread>
+
+/*
+============================================================================
+
+FRONTEND JOBS
+
+R_RunJobs calls a function once for every index in [0, count), spread
+over a small pool of worker threads and the calling thread, and returns
+when all of them are done. Jobs must only write to the object selected
+by their index; anything that touches shared tr state stays serial.
+tr.currentEntity, tr.currentModel, tr.orientation and tr.pc are per
+thread, the counters of the workers are added to the ones of the
+calling thread when all the jobs are done.
+
+============================================================================
+*/
+
+static std::mutex               jobMutex;
+static std::condition_variable  jobStart;
+static std::condition_variable  jobDone;
+static std::vector<std::thread> jobWorkers;
+static void                     ( *jobFunc )( int index );
+static int                      jobCount;
+static std::atomic<int>         jobNext;
+static int                      jobBusy;
+static unsigned                 jobGeneration;
+static bool                     jobShutdown;
+static frontEndCounters_t       jobCounters; // of the workers, added to tr.pc by R_RunJobs
+
+static void R_MoveFrontEndCounters( frontEndCounters_t &to, frontEndCounters_t &from )
+{
+	static_assert( sizeof( frontEndCounters_t ) % sizeof( int ) == 0, "frontEndCounters_t must only hold ints" );
+
+	int *dst = reinterpret_cast<int *>( &to );
+	int *src = reinterpret_cast<int *>( &from );
+
+	for ( size_t i = 0; i < sizeof( frontEndCounters_t ) / sizeof( int ); i++ )
+	{
+		dst[ i ] += src[ i ];
+	}
+
+	Com_Memset( &from, 0, sizeof( from ) );
+}
+
+static void R_WorkJobs( void ( *func )( int index ), int count )
+{
+	int index;
+
+	while ( ( index = jobNext.fetch_add( 1, std::memory_order_relaxed ) ) < count )
+	{
+		func( index );
+	}
+}
+
+static void R_JobWorker()
+{
+	std::unique_lock<std::mutex> lock( jobMutex );
+	unsigned seen = jobGeneration;
+
+	while ( true )
+	{
+		jobStart.wait( lock, [ &seen ] { return jobShutdown || jobGeneration != seen; } );
+
+		if ( jobShutdown )
+		{
+			return;
+		}
+
+		seen = jobGeneration;
+
+		auto func = jobFunc;
+		int count = jobCount;
+
+		jobBusy++;
+		lock.unlock();
+
+		R_WorkJobs( func, count );
+
+		lock.lock();
+
+		R_MoveFrontEndCounters( jobCounters, tr.pc );
+
+		if ( --jobBusy == 0 )
+		{
+			jobDone.notify_all();
+		}
+	}
+}
+
+/*
+===============
+R_RunJobs
+===============
+*/
+void R_RunJobs( int count, void ( *job )( int index ) )
+{
+	if ( jobWorkers.empty() || count < 2 )
+	{
+		for ( int i = 0; i < count; i++ )
+		{
+			job( i );
+		}
+
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock( jobMutex );
+
+	// a worker that woke up late for the previous batch may still be
+	// looking at the counters
+	jobDone.wait( lock, [] { return jobBusy == 0; } );
+
+	jobFunc = job;
+	jobCount = count;
+	jobNext.store( 0, std::memory_order_relaxed );
+	jobGeneration++;
+	jobStart.notify_all();
+	lock.unlock();
+
+	R_WorkJobs( job, count );
+
+	// every index has been handed out, wait for the ones still running
+	lock.lock();
+	jobDone.wait( lock, [] { return jobBusy == 0; } );
+
+	R_MoveFrontEndCounters( tr.pc, jobCounters );
+}
+
+/*
+===============
+R_InitJobs
+===============
+*/
+void R_InitJobs()
+{
+	int numThreads = r_frontendThreads->integer;
+
+	if ( numThreads <= 0 )
+	{
+		numThreads = static_cast<int>( std::thread::hardware_concurrency() );
+	}
+
+	// the calling thread counts as one
+	int numWorkers = Math::Clamp( numThreads - 1, 0, 8 );
+
+	jobShutdown = false;
+
+	for ( int i = 0; i < numWorkers; i++ )
+	{
+		jobWorkers.emplace_back( R_JobWorker );
+	}
+
+	Log::Debug( "started %i frontend job threads", numWorkers );
+}
+
+/*
+===============
+R_ShutdownJobs
+===============
+*/
+void R_ShutdownJobs()
+{
+	{
+		std::lock_guard<std::mutex> lock( jobMutex );
+		jobShutdown = true;
+		jobStart.notify_all();
+	}
+
+	for ( std::thread &worker : jobWorkers )
+	{
+		worker.join();
+	}
+
+	jobWorkers.clear();
+}
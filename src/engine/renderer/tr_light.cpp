@@ -861,6 +861,8 @@ void R_SetupLightProjection( trRefLight_t *light )
 R_AddLightInteraction
 =================
 */
+thread_local std::vector<deferredInteraction_t> *deferredInteractions;
+
 bool R_AddLightInteraction( trRefLight_t *light, surfaceType_t *surface, shader_t *surfaceShader, byte cubeSideBits,
                                 interactionType_t iaType )
 {
@@ -880,6 +882,12 @@ bool R_AddLightInteraction( trRefLight_t *light, surfaceType_t *surface, shader_
 		return false;
 	}
 
+	if ( deferredInteractions )
+	{
+		deferredInteractions->push_back( { tr.currentEntity, surface, surfaceShader, cubeSideBits, iaType } );
+		return true;
+	}
+
 	// instead of checking for overflow, we just mask the index
 	// so it wraps around
 	iaIndex = tr.refdef.numInteractions & INTERACTION_MASK;
@@ -252,6 +252,23 @@ static inline void halfToFloat( const f16vec4_t in, vec4_t out )
 
 	using frustum_t = cplane_t[6];
 
+	// the culling planes of a frustum as a structure of arrays, so that
+	// boxes can be tested against several planes at once
+	// planes past FRUSTUM_PLANES never cull anything
+	struct cullPlanes_t
+	{
+		float normal[ 3 ][ 8 ];
+		float dist[ 8 ];
+	};
+
+	// axis aligned boxes as a structure of arrays for R_CullBoxes, each
+	// array has 3 extra elements so that batches may read past the end
+	struct cullBoxes_t
+	{
+		float *mins[ 3 ];
+		float *maxs[ 3 ];
+	};
+
 	enum
 	{
 	  CUBESIDE_PX = ( 1 << 0 ),
@@ -584,7 +601,7 @@ static inline void halfToFloat( const f16vec4_t in, vec4_t out )
 		uint16_t       width, height; // source image
 		uint16_t       uploadWidth, uploadHeight; // after power of two and picmip but not including clamp to MAX_TEXTURE_SIZE
 
-		int            frameUsed; // for texture usage in frame statistics
+		std::atomic<int> frameUsed; // for texture usage in frame statistics, stamped by the render thread
 
 		uint32_t       internalFormat;
 
@@ -592,6 +609,10 @@ static inline void halfToFloat( const f16vec4_t in, vec4_t out )
 		filterType_t   filterType;
 		wrapType_t     wrapType;
 
+		bool           streamed; // can be reloaded from its file at another resolution
+		int            streamLevel; // mip levels dropped to stay within r_textureBudget
+		int            streamRequest; // level being decoded for it, -1 if none
+
 		image_t *next;
 	};
 
@@ -1503,6 +1524,7 @@ static inline void halfToFloat( const f16vec4_t in, vec4_t out )
 
 		frustum_t      frustums[ MAX_SHADOWMAPS + 1 ]; // first frustum is the default one with complete zNear - zFar range
 		// and the other ones are for PSSM
+		cullPlanes_t   cullPlanes; // frustums[ 0 ] for the SIMD culling
 
 		vec3_t               visBounds[ 2 ];
 		float                zNear;
@@ -2026,6 +2048,7 @@ static inline void halfToFloat( const f16vec4_t in, vec4_t out )
 		bspSurface_t       **markSurfaces;
 
 		bspSurface_t       **viewSurfaces;
+		cullBoxes_t        viewSurfaceBounds; // bounds of the viewSurfaces
 
 		int                numMergedSurfaces;
 		bspSurface_t       *mergedSurfaces;
@@ -2520,9 +2543,27 @@ static inline void halfToFloat( const f16vec4_t in, vec4_t out )
 
 // all state modified by the back end is separated
 // from the front end state
+	// the cvars read for every draw call, copied from their snapshots when the
+	// render thread starts on a frame, as the main thread may be changing the
+	// cvar_t under r_smp
+	struct backEndCvars_t
+	{
+		int   logFile;
+		int   nobind;
+		int   speeds;
+		int   showImages;
+		int   finish;
+		int   ignoreGLErrors;
+		float offsetFactor;
+		float offsetUnits;
+	};
+
 	struct backEndState_t
 	{
 		int               smpFrame;
+		int               frameCount; // tr.frameCount of the frame being rendered
+		backEndCvars_t    cvars;
+		uint64_t          cvarGeneration; // of the snapshots cvars was copied from
 		trRefdef_t        refdef;
 		viewParms_t       viewParms;
 		orientationr_t    orientation;
@@ -2588,6 +2629,18 @@ static inline void halfToFloat( const f16vec4_t in, vec4_t out )
 	** but may read fields that aren't dynamically modified
 	** by the frontend.
 	*/
+	// frontend stages that scenebench times separately
+	enum frontEndStage_t
+	{
+	  FES_SETUP,
+	  FES_WORLD,
+	  FES_POLYS,
+	  FES_ENTITIES,
+	  FES_INTERACTIONS,
+	  FES_SORT,
+	  FES_NUM_STAGES
+	};
+
 	struct trGlobals_t
 	{
 		bool registered; // cleared at shutdown, set at beginRegistration
@@ -2697,10 +2750,11 @@ static inline void halfToFloat( const f16vec4_t in, vec4_t out )
 		image_t   *lightGrid1Image;
 		image_t   *lightGrid2Image;
 
-		// render entities
-		trRefEntity_t *currentEntity;
+		// render entities, the current ones are per thread so that
+		// the frontend jobs can add several entities at once
+		static thread_local trRefEntity_t *currentEntity;
 		trRefEntity_t worldEntity; // point currentEntity at this when rendering world
-		model_t       *currentModel;
+		static thread_local model_t       *currentModel;
 
 		// render lights
 		trRefLight_t *currentLight;
@@ -2713,16 +2767,19 @@ static inline void halfToFloat( const f16vec4_t in, vec4_t out )
 		int            overbrightBits; // r_overbrightBits->integer, but set to 0 if no hw gamma
 		int            mapOverBrightBits; // r_mapOverbrightBits->integer, but can be overriden by mapper using the worldspawn
 
-		orientationr_t orientation; // for current entity
+		static thread_local orientationr_t orientation; // for current entity
 
 		trRefdef_t     refdef;
 
 		vec3_t         sunLight; // from the sky shader for this level
 		vec3_t         sunDirection;
 
-		frontEndCounters_t pc;
+		static thread_local frontEndCounters_t pc; // R_RunJobs adds the counts of its workers
 		int                frontEndMsec; // not in pc due to clearing issue
 
+		bool               benchmarking; // scenebench is replaying a capture
+		int64_t            benchStageTimes[ FES_NUM_STAGES ]; // nanoseconds
+
 		vec4_t             clipRegion; // 2D clipping region
 
 		//
@@ -2847,6 +2904,12 @@ static inline void halfToFloat( const f16vec4_t in, vec4_t out )
 	extern cvar_t *r_compressSpecularMaps;
 	extern cvar_t *r_compressNormalMaps;
 	extern cvar_t *r_exportTextures;
+	extern cvar_t *r_imagePrefetch;
+	extern cvar_t *r_imagePrefetchMegs;
+	extern cvar_t *r_frontendThreads;
+	extern cvar_t *r_worldCache;
+	extern cvar_t *r_textureBudget;
+	extern cvar_t *r_textureStreamLevels;
 	extern cvar_t *r_heatHaze;
 	extern cvar_t *r_noMarksOnTrisurfs;
 	extern cvar_t *r_recompileShaders;
@@ -3053,7 +3116,10 @@ static inline void halfToFloat( const f16vec4_t in, vec4_t out )
 	void           R_LocalNormalToWorld( const vec3_t local, vec3_t world );
 	void           R_LocalPointToWorld( const vec3_t local, vec3_t world );
 
+	int            R_BoxPlaneSides( const vec3_t mins, const vec3_t maxs, int *backBits );
+	void           R_CullBoxes( const cullBoxes_t *boxes, int first, int count, cullResult_t *results );
 	cullResult_t   R_CullBox( vec3_t worldBounds[ 2 ] );
+	void           R_CullBench_f();
 	cullResult_t   R_CullLocalBox( vec3_t bounds[ 2 ] );
 	cullResult_t   R_CullLocalPointAndRadius( vec3_t origin, float radius );
 	cullResult_t   R_CullPointAndRadius( vec3_t origin, float radius );
@@ -3222,6 +3288,10 @@ static inline void halfToFloat( const f16vec4_t in, vec4_t out )
 	int     R_SumOfUsedImages();
 
 	image_t *R_FindImageFile( const char *name, int bits, filterType_t filterType, wrapType_t wrapType );
+	void    R_PrefetchImageFile( const char *name, int bits );
+	void    R_ImageDecodeError( const char *fmt, ... ) PRINTF_LIKE(1);
+	void    R_FinishImagePrefetch();
+	void    R_UpdateTextureResidency();
 	image_t *R_FindCubeImage( const char *name, int bits, filterType_t filterType, wrapType_t wrapType );
 
 	image_t *R_CreateImage( const char *name, const byte **pic,
@@ -3264,6 +3334,7 @@ static inline void halfToFloat( const f16vec4_t in, vec4_t out )
 				 RegisterShaderFlags_t flags );
 	shader_t  *R_GetShaderByHandle( qhandle_t hShader );
 	shader_t  *R_FindShaderByName( const char *name );
+	void      R_PrefetchShaderImages( const char *name );
 	const char *RE_GetShaderNameFromHandle( qhandle_t shader );
 	void      R_InitShaders();
 	void      R_ShaderList_f();
@@ -3498,6 +3569,20 @@ static inline void halfToFloat( const f16vec4_t in, vec4_t out )
 	bool R_AddLightInteraction( trRefLight_t *light, surfaceType_t *surface, shader_t *surfaceShader, byte cubeSideBits,
 	                                interactionType_t iaType );
 
+	// the arguments of an R_AddLightInteraction call made on a frontend job,
+	// the interaction is added to tr.refdef once all the jobs are done
+	struct deferredInteraction_t
+	{
+		trRefEntity_t     *entity;
+		surfaceType_t     *surface;
+		shader_t          *shader;
+		byte              cubeSideBits;
+		interactionType_t iaType;
+	};
+
+	// while set, R_AddLightInteraction appends to it instead of tr.refdef
+	extern thread_local std::vector<deferredInteraction_t> *deferredInteractions;
+
 	void     R_SortInteractions( trRefLight_t *light );
 
 	void     R_SetupLightScissor( trRefLight_t *light );
@@ -3551,6 +3636,17 @@ static inline void halfToFloat( const f16vec4_t in, vec4_t out )
 	/*
 	============================================================
 
+	FRONTEND JOBS, tr_jobs.c
+
+	============================================================
+	*/
+	void R_InitJobs();
+	void R_ShutdownJobs();
+	void R_RunJobs( int count, void ( *job )( int index ) );
+
+	/*
+	============================================================
+
 	FRAME BUFFER OBJECTS, tr_fbo.c
 
 	============================================================
@@ -3615,6 +3711,8 @@ static inline void halfToFloat( const f16vec4_t in, vec4_t out )
 	bool R_TestDecalBoundingSphere( decalProjector_t *dp, vec3_t center, float radius2 );
 
 	void     R_ProjectDecalOntoSurface( decalProjector_t *dp, bspSurface_t *surf, bspModel_t *bmodel );
+	void     R_QueueDecalSurface( bspSurface_t *surf, int decalBits );
+	void     R_ProjectQueuedDecals( bspModel_t *bmodel );
 
 	void     R_AddDecalSurface( decal_t *decal );
 	void     R_AddDecalSurfaces( bspModel_t *bmodel );
@@ -3644,6 +3742,21 @@ static inline void halfToFloat( const f16vec4_t in, vec4_t out )
 	void RE_AddDynamicLightToSceneQ3A( const vec3_t org, float intensity, float r, float g, float b );
 
 	void RE_RenderScene( const refdef_t *fd );
+	void R_AddCapturedLightToScene( const refLight_t *l, int restrictInteractionFirst, int restrictInteractionLast );
+
+	/*
+	============================================================
+
+	SCENE CAPTURE AND BENCHMARK, tr_bench.c
+
+	============================================================
+	*/
+
+	void R_CaptureScene( const refdef_t *fd, int numLights );
+	void R_CaptureFrameEnd();
+	void R_StopSceneCapture();
+	void R_SceneCapture_f();
+	void R_SceneBench_f();
 
 	qhandle_t RE_RegisterVisTest();
 	void RE_AddVisTestToScene( qhandle_t hTest, const vec3_t pos,
@@ -3679,6 +3792,7 @@ static inline void halfToFloat( const f16vec4_t in, vec4_t out )
 	int             RE_BuildSkeleton( refSkeleton_t *skel, qhandle_t anim, int startFrame, int endFrame, float frac,
 	                                  bool clearOrigin );
 	int             RE_BlendSkeleton( refSkeleton_t *skel, const refSkeleton_t *blend, float frac );
+	void            RE_BuildSkeletons( const refSkeletonJob_t *jobs, int numJobs, refSkeleton_t *skels, int *results );
 	int             RE_AnimNumFrames( qhandle_t hAnim );
 	int             RE_AnimFrameRate( qhandle_t hAnim );
 
@@ -3716,6 +3830,7 @@ static inline void halfToFloat( const f16vec4_t in, vec4_t out )
 
 	void RB_RenderThread();
 	void RB_ExecuteRenderCommands( const void *data );
+	void RB_InitCvars();
 
 	/*
 	=============================================================
@@ -3753,6 +3868,7 @@ static inline void halfToFloat( const f16vec4_t in, vec4_t out )
 		const RenderCommand *ExecuteSelf() const;
 
 		int buffer;
+		int frameCount;
 	};
 	struct SwapBuffersCommand : public RenderCommand {
 		const RenderCommand *ExecuteSelf() const;
@@ -3829,8 +3945,7 @@ static inline void halfToFloat( const f16vec4_t in, vec4_t out )
 		int      width;
 		int      height;
 		byte     *captureBuffer;
-		byte     *encodeBuffer;
-		bool motionJpeg;
+		int      frame;
 	};
 	struct RenderFinishCommand : public RenderCommand {
 		const RenderCommand *ExecuteSelf() const;
@@ -3951,7 +4066,7 @@ static inline void halfToFloat( const f16vec4_t in, vec4_t out )
 
 // video stuff
 	const void *RB_TakeVideoFrameCmd( const void *data );
-	void       RE_TakeVideoFrame( int width, int height, byte *captureBuffer, byte *encodeBuffer, bool motionJpeg );
+	bool       RE_TakeVideoFrame( int width, int height, byte *captureBuffer, int frame );
 
 // cubemap reflections stuff
 	void       R_BuildCubeMaps();
@@ -25,6 +25,11 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 trGlobals_t tr;
 
+thread_local trRefEntity_t      *trGlobals_t::currentEntity;
+thread_local model_t            *trGlobals_t::currentModel;
+thread_local orientationr_t     trGlobals_t::orientation;
+thread_local frontEndCounters_t trGlobals_t::pc;
+
 // convert from our coordinate system (looking down X)
 // to OpenGL's coordinate system (looking down -Z)
 const matrix_t quakeToOpenGLMatrix =
@@ -328,6 +333,153 @@ void R_TBNtoQtangents( const vec3_t tangent, const vec3_t binormal,
 	}
 }
 
+/*
+=================
+R_BoxPlaneSides
+
+Tests a box against all the culling planes of the view at once.
+Returns the bits of the planes the box is completely in front of,
+like BoxOnPlaneSide returning 1, and sets backBits to the planes it
+is completely behind, like BoxOnPlaneSide returning 2.
+=================
+*/
+int R_BoxPlaneSides( const vec3_t mins, const vec3_t maxs, int *backBits )
+{
+	const cullPlanes_t *planes = &tr.viewParms.cullPlanes;
+	int frontBits = 0;
+
+	*backBits = 0;
+
+#if idx86_sse
+	__m128 minX = _mm_set1_ps( mins[ 0 ] ), maxX = _mm_set1_ps( maxs[ 0 ] );
+	__m128 minY = _mm_set1_ps( mins[ 1 ] ), maxY = _mm_set1_ps( maxs[ 1 ] );
+	__m128 minZ = _mm_set1_ps( mins[ 2 ] ), maxZ = _mm_set1_ps( maxs[ 2 ] );
+
+	for ( int i = 0; i < FRUSTUM_PLANES; i += 4 )
+	{
+		__m128 normalX = _mm_loadu_ps( &planes->normal[ 0 ][ i ] );
+		__m128 normalY = _mm_loadu_ps( &planes->normal[ 1 ][ i ] );
+		__m128 normalZ = _mm_loadu_ps( &planes->normal[ 2 ][ i ] );
+		__m128 dist = _mm_loadu_ps( &planes->dist[ i ] );
+
+		__m128 x0 = _mm_mul_ps( normalX, minX ), x1 = _mm_mul_ps( normalX, maxX );
+		__m128 y0 = _mm_mul_ps( normalY, minY ), y1 = _mm_mul_ps( normalY, maxY );
+		__m128 z0 = _mm_mul_ps( normalZ, minZ ), z1 = _mm_mul_ps( normalZ, maxZ );
+
+		// distances of the corners nearest to and farthest from each plane
+		__m128 nearDist = _mm_add_ps( _mm_add_ps( _mm_min_ps( x0, x1 ), _mm_min_ps( y0, y1 ) ), _mm_min_ps( z0, z1 ) );
+		__m128 farDist = _mm_add_ps( _mm_add_ps( _mm_max_ps( x0, x1 ), _mm_max_ps( y0, y1 ) ), _mm_max_ps( z0, z1 ) );
+
+		frontBits |= _mm_movemask_ps( _mm_cmpge_ps( nearDist, dist ) ) << i;
+		*backBits |= _mm_movemask_ps( _mm_cmplt_ps( farDist, dist ) ) << i;
+	}
+#else
+	for ( int i = 0; i < FRUSTUM_PLANES; i++ )
+	{
+		switch ( BoxOnPlaneSide( mins, maxs, &tr.viewParms.frustums[ 0 ][ i ] ) )
+		{
+			case 1:
+				frontBits |= 1 << i;
+				break;
+
+			case 2:
+				*backBits |= 1 << i;
+				break;
+		}
+	}
+#endif
+
+	*backBits &= FRUSTUM_CLIPALL;
+	return frontBits & FRUSTUM_CLIPALL;
+}
+
+/*
+=================
+R_CullBoxes
+
+Culls count boxes starting at first against the view frustum,
+four at a time. Gives the same results as R_CullBox.
+=================
+*/
+void R_CullBoxes( const cullBoxes_t *boxes, int first, int count, cullResult_t *results )
+{
+	int i;
+
+	if ( r_nocull->integer )
+	{
+		for ( i = 0; i < count; i++ )
+		{
+			results[ i ] = cullResult_t::CULL_CLIP;
+		}
+
+		return;
+	}
+
+#if idx86_sse
+	const cullPlanes_t *planes = &tr.viewParms.cullPlanes;
+
+	for ( i = 0; i < count; i += 4 )
+	{
+		__m128 minX = _mm_loadu_ps( &boxes->mins[ 0 ][ first + i ] ), maxX = _mm_loadu_ps( &boxes->maxs[ 0 ][ first + i ] );
+		__m128 minY = _mm_loadu_ps( &boxes->mins[ 1 ][ first + i ] ), maxY = _mm_loadu_ps( &boxes->maxs[ 1 ][ first + i ] );
+		__m128 minZ = _mm_loadu_ps( &boxes->mins[ 2 ][ first + i ] ), maxZ = _mm_loadu_ps( &boxes->maxs[ 2 ][ first + i ] );
+		__m128 clipped = _mm_setzero_ps();
+		__m128 culled = _mm_setzero_ps();
+
+		for ( int j = 0; j < FRUSTUM_PLANES; j++ )
+		{
+			__m128 normalX = _mm_set1_ps( planes->normal[ 0 ][ j ] );
+			__m128 normalY = _mm_set1_ps( planes->normal[ 1 ][ j ] );
+			__m128 normalZ = _mm_set1_ps( planes->normal[ 2 ][ j ] );
+			__m128 dist = _mm_set1_ps( planes->dist[ j ] );
+
+			__m128 x0 = _mm_mul_ps( normalX, minX ), x1 = _mm_mul_ps( normalX, maxX );
+			__m128 y0 = _mm_mul_ps( normalY, minY ), y1 = _mm_mul_ps( normalY, maxY );
+			__m128 z0 = _mm_mul_ps( normalZ, minZ ), z1 = _mm_mul_ps( normalZ, maxZ );
+
+			__m128 nearDist = _mm_add_ps( _mm_add_ps( _mm_min_ps( x0, x1 ), _mm_min_ps( y0, y1 ) ), _mm_min_ps( z0, z1 ) );
+			__m128 farDist = _mm_add_ps( _mm_add_ps( _mm_max_ps( x0, x1 ), _mm_max_ps( y0, y1 ) ), _mm_max_ps( z0, z1 ) );
+
+			clipped = _mm_or_ps( clipped, _mm_cmplt_ps( nearDist, dist ) );
+			culled = _mm_or_ps( culled, _mm_cmplt_ps( farDist, dist ) );
+		}
+
+		int clipBits = _mm_movemask_ps( clipped );
+		int cullBits = _mm_movemask_ps( culled );
+		int n = std::min( 4, count - i );
+
+		for ( int j = 0; j < n; j++ )
+		{
+			if ( cullBits & ( 1 << j ) )
+			{
+				results[ i + j ] = cullResult_t::CULL_OUT;
+			}
+			else if ( clipBits & ( 1 << j ) )
+			{
+				results[ i + j ] = cullResult_t::CULL_CLIP;
+			}
+			else
+			{
+				results[ i + j ] = cullResult_t::CULL_IN;
+			}
+		}
+	}
+#else
+	for ( i = 0; i < count; i++ )
+	{
+		vec3_t worldBounds[ 2 ];
+
+		for ( int j = 0; j < 3; j++ )
+		{
+			worldBounds[ 0 ][ j ] = boxes->mins[ j ][ first + i ];
+			worldBounds[ 1 ][ j ] = boxes->maxs[ j ][ first + i ];
+		}
+
+		results[ i ] = R_CullBox( worldBounds );
+	}
+#endif
+}
+
 /*
 =================
 R_CullBox
@@ -337,9 +489,7 @@ Returns CULL_IN, CULL_CLIP, or CULL_OUT
 */
 cullResult_t R_CullBox( vec3_t worldBounds[ 2 ] )
 {
-	bool anyClip;
-	cplane_t *frust;
-	int i, r;
+	int frontBits, backBits;
 
 	if ( r_nocull->integer )
 	{
@@ -347,34 +497,125 @@ cullResult_t R_CullBox( vec3_t worldBounds[ 2 ] )
 	}
 
 	// check against frustum planes
-	anyClip = false;
+	frontBits = R_BoxPlaneSides( worldBounds[ 0 ], worldBounds[ 1 ], &backBits );
 
-	for ( i = 0; i < FRUSTUM_PLANES; i++ )
+	if ( backBits )
 	{
-		frust = &tr.viewParms.frustums[ 0 ][ i ];
+		// completely outside frustum
+		return cullResult_t::CULL_OUT;
+	}
+
+	if ( frontBits == FRUSTUM_CLIPALL )
+	{
+		// completely inside frustum
+		return cullResult_t::CULL_IN;
+	}
+
+	// partially clipped
+	return cullResult_t::CULL_CLIP;
+}
 
-		r = BoxOnPlaneSide( worldBounds[ 0 ], worldBounds[ 1 ], frust );
+/*
+=================
+R_CullBench_f
+
+Measures how many boxes per microsecond the culling functions
+test against the frustum of the last rendered view
+=================
+*/
+void R_CullBench_f()
+{
+	int        numBoxes = 1 << 20;
+	int        i, j, backBits;
+	int        numOut[ 3 ] = {};
+	float      *bounds;
+	cullBoxes_t boxes;
 
-		if ( r == 2 )
+	if ( ri.Cmd_Argc() > 1 )
+	{
+		numBoxes = Math::Clamp( atoi( ri.Cmd_Argv( 1 ) ), 4, 1 << 24 );
+	}
+
+	bounds = ( float * ) ri.Hunk_AllocateTempMemory( 6 * ( numBoxes + 3 ) * sizeof( float ) );
+
+	for ( j = 0; j < 3; j++ )
+	{
+		boxes.mins[ j ] = bounds + j * ( numBoxes + 3 );
+		boxes.maxs[ j ] = bounds + ( j + 3 ) * ( numBoxes + 3 );
+	}
+
+	// boxes scattered around the view
+	for ( i = 0; i < numBoxes + 3; i++ )
+	{
+		for ( j = 0; j < 3; j++ )
 		{
-			// completely outside frustum
-			return cullResult_t::CULL_OUT;
+			float center = tr.viewParms.orientation.origin[ j ] + crandom() * 4096.0f;
+			float size = 8.0f + random() * 256.0f;
+
+			boxes.mins[ j ][ i ] = center - size;
+			boxes.maxs[ j ][ i ] = center + size;
 		}
+	}
+
+	std::vector<cullResult_t> results( numBoxes );
+	int startTime, scalarTime, singleTime, batchTime;
 
-		if ( r == 3 )
+	startTime = ri.Milliseconds();
+
+	for ( i = 0; i < numBoxes; i++ )
+	{
+		vec3_t mins, maxs;
+
+		for ( j = 0; j < 3; j++ )
+		{
+			mins[ j ] = boxes.mins[ j ][ i ];
+			maxs[ j ] = boxes.maxs[ j ][ i ];
+		}
+
+		for ( j = 0; j < FRUSTUM_PLANES; j++ )
 		{
-			anyClip = true;
+			if ( BoxOnPlaneSide( mins, maxs, &tr.viewParms.frustums[ 0 ][ j ] ) == 2 )
+			{
+				numOut[ 0 ]++;
+				break;
+			}
 		}
 	}
 
-	if ( !anyClip )
+	scalarTime = ri.Milliseconds();
+
+	for ( i = 0; i < numBoxes; i++ )
 	{
-		// completely inside frustum
-		return cullResult_t::CULL_IN;
+		vec3_t mins, maxs;
+
+		for ( j = 0; j < 3; j++ )
+		{
+			mins[ j ] = boxes.mins[ j ][ i ];
+			maxs[ j ] = boxes.maxs[ j ][ i ];
+		}
+
+		R_BoxPlaneSides( mins, maxs, &backBits );
+
+		if ( backBits )
+		{
+			numOut[ 1 ]++;
+		}
 	}
 
-	// partially clipped
-	return cullResult_t::CULL_CLIP;
+	singleTime = ri.Milliseconds();
+
+	R_CullBoxes( &boxes, 0, numBoxes, results.data() );
+
+	batchTime = ri.Milliseconds();
+
+	numOut[ 2 ] = std::count( results.begin(), results.end(), cullResult_t::CULL_OUT );
+
+	Log::Notice( "%i boxes, %i/%i/%i culled", numBoxes, numOut[ 0 ], numOut[ 1 ], numOut[ 2 ] );
+	Log::Notice( "BoxOnPlaneSide:  %.1f boxes/us", numBoxes / ( 1000.0f * std::max( 1, scalarTime - startTime ) ) );
+	Log::Notice( "R_BoxPlaneSides: %.1f boxes/us", numBoxes / ( 1000.0f * std::max( 1, singleTime - scalarTime ) ) );
+	Log::Notice( "R_CullBoxes:     %.1f boxes/us", numBoxes / ( 1000.0f * std::max( 1, batchTime - singleTime ) ) );
+
+	ri.Hunk_FreeTempMemory( bounds );
 }
 
 /*
@@ -938,6 +1179,31 @@ static void R_SetupUnprojection()
 	MatrixMultiplyScale( unprojectMatrix, 2.0f / glConfig.vidWidth, 2.0f / glConfig.vidHeight, 2.0 );
 }
 
+/*
+=================
+R_SetupCullPlanes
+
+Copies the culling planes into the layout used by R_BoxPlaneSides
+and R_CullBoxes
+=================
+*/
+static void R_SetupCullPlanes()
+{
+	cullPlanes_t *planes = &tr.viewParms.cullPlanes;
+	int          i, j;
+
+	for ( i = 0; i < 8; i++ )
+	{
+		for ( j = 0; j < 3; j++ )
+		{
+			planes->normal[ j ][ i ] = i < FRUSTUM_PLANES ? tr.viewParms.frustums[ 0 ][ i ].normal[ j ] : 0.0f;
+		}
+
+		// every box is in front of the padding planes
+		planes->dist[ i ] = i < FRUSTUM_PLANES ? tr.viewParms.frustums[ 0 ][ i ].dist : -FLT_MAX;
+	}
+}
+
 /*
 =================
 R_SetupFrustum
@@ -1011,6 +1277,8 @@ static void R_SetupFrustum()
 		tr.viewParms.frustums[ 0 ][ FRUSTUM_NEAR ].dist = DotProduct( planeOrigin, tr.viewParms.frustums[ 0 ][ FRUSTUM_NEAR ].normal );
 		SetPlaneSignbits( &tr.viewParms.frustums[ 0 ][ FRUSTUM_NEAR ] );
 	}
+
+	R_SetupCullPlanes();
 }
 
 /*
@@ -1947,11 +2215,29 @@ int R_SpriteFogNum( trRefEntity_t *ent )
 R_AddDrawSurf
 =================
 */
+struct deferredDrawSurf_t
+{
+	surfaceType_t *surface;
+	shader_t      *shader;
+	int           lightmapNum;
+	int           fogNum;
+};
+
+// set while a frontend job adds the surfaces of an entity, they are
+// added to tr.refdef in entity order once all the jobs are done
+static thread_local std::vector<deferredDrawSurf_t> *deferredDrawSurfs;
+
 void R_AddDrawSurf( surfaceType_t *surface, shader_t *shader, int lightmapNum, int fogNum )
 {
 	int        index;
 	drawSurf_t *drawSurf;
 
+	if ( deferredDrawSurfs )
+	{
+		deferredDrawSurfs->push_back( { surface, shader, lightmapNum, fogNum } );
+		return;
+	}
+
 	// instead of checking for overflow, we just mask the index
 	// so it wraps around
 	index = tr.refdef.numDrawSurfs & DRAWSURF_MASK;
@@ -1987,6 +2273,91 @@ void R_AddDrawSurf( surfaceType_t *surface, shader_t *shader, int lightmapNum, i
 	}
 }
 
+/*
+=================
+R_RadixSortDrawSurfs
+
+Sorts the surfaces by their packed 64 bit sort key. The keys are sorted
+with a LSD radix sort along with the position of their surface, and the
+surfaces are moved only once at the end, instead of swapping whole
+drawSurf_t for every comparison.
+=================
+*/
+struct drawSurfKey_t
+{
+	uint64_t sort;
+	uint32_t index;
+};
+
+// below this std::sort is faster than building the histograms
+static const int RADIX_SORT_MIN_SURFS = 256;
+
+static void R_RadixSortDrawSurfs( drawSurf_t *drawSurfs, int numDrawSurfs )
+{
+	static std::vector<drawSurfKey_t> keys, keysTemp;
+	static std::vector<drawSurf_t> sorted;
+	uint32_t counts[ 8 ][ 256 ];
+	int      i, digit;
+
+	keys.resize( numDrawSurfs );
+	keysTemp.resize( numDrawSurfs );
+	sorted.resize( numDrawSurfs );
+
+	// count the values of all the 8 bit digits in a single pass
+	memset( counts, 0, sizeof( counts ) );
+
+	for ( i = 0; i < numDrawSurfs; i++ )
+	{
+		uint64_t sort = drawSurfs[ i ].sort;
+
+		keys[ i ].sort = sort;
+		keys[ i ].index = i;
+
+		for ( digit = 0; digit < 8; digit++ )
+		{
+			counts[ digit ][ ( sort >> ( digit * 8 ) ) & 0xff ]++;
+		}
+	}
+
+	drawSurfKey_t *src = keys.data();
+	drawSurfKey_t *dst = keysTemp.data();
+
+	for ( digit = 0; digit < 8; digit++ )
+	{
+		uint32_t *count = counts[ digit ];
+		int      shift = digit * 8;
+
+		// skip the digits all keys share, e.g. the fog bits in a fogless map
+		if ( count[ ( src[ 0 ].sort >> shift ) & 0xff ] == ( uint32_t ) numDrawSurfs )
+		{
+			continue;
+		}
+
+		uint32_t offset = 0;
+
+		for ( i = 0; i < 256; i++ )
+		{
+			uint32_t c = count[ i ];
+			count[ i ] = offset;
+			offset += c;
+		}
+
+		for ( i = 0; i < numDrawSurfs; i++ )
+		{
+			dst[ count[ ( src[ i ].sort >> shift ) & 0xff ]++ ] = src[ i ];
+		}
+
+		std::swap( src, dst );
+	}
+
+	for ( i = 0; i < numDrawSurfs; i++ )
+	{
+		sorted[ i ] = drawSurfs[ src[ i ].index ];
+	}
+
+	std::copy( sorted.begin(), sorted.end(), drawSurfs );
+}
+
 /*
 =================
 R_SortDrawSurfs
@@ -2028,10 +2399,17 @@ static void R_SortDrawSurfs()
 		ia->next = nullptr;
 	}
 
-	std::sort( tr.viewParms.drawSurfs, tr.viewParms.drawSurfs + tr.viewParms.numDrawSurfs,
-	           []( const drawSurf_t &a, const drawSurf_t &b ) {
-	               return a.sort < b.sort;
-	           } );
+	if ( tr.viewParms.numDrawSurfs >= RADIX_SORT_MIN_SURFS )
+	{
+		R_RadixSortDrawSurfs( tr.viewParms.drawSurfs, tr.viewParms.numDrawSurfs );
+	}
+	else
+	{
+		std::sort( tr.viewParms.drawSurfs, tr.viewParms.drawSurfs + tr.viewParms.numDrawSurfs,
+		           []( const drawSurf_t &a, const drawSurf_t &b ) {
+		               return a.sort < b.sort;
+		           } );
+	}
 
 	// compute the offsets of the first surface of each SS_* type
 	sort = Util::ordinal( shaderSort_t::SS_BAD ) - 1;
@@ -2082,6 +2460,76 @@ static void R_SortDrawSurfs()
 	R_AddDrawViewCmd( false );
 }
 
+/*
+=============
+R_AddEntityJob
+
+Culls, lights and adds the surfaces of a model entity on the frontend
+jobs. The surfaces are kept in entityDrawSurfs and added to the view
+by R_AddEntitySurfaces. Brush models are left to R_AddEntitySurfaces,
+they mark the surfaces they share with other entities of the model.
+=============
+*/
+static std::vector<deferredDrawSurf_t> entityDrawSurfs[ MAX_REF_ENTITIES ];
+
+static bool R_IsJobModel( const model_t *model )
+{
+	return model && ( model->type == modtype_t::MOD_MESH || model->type == modtype_t::MOD_MD5 ||
+	                  model->type == modtype_t::MOD_IQM );
+}
+
+static void R_AddEntityJob( int index )
+{
+	trRefEntity_t *ent = tr.currentEntity = &tr.refdef.entities[ index ];
+
+	entityDrawSurfs[ index ].clear();
+
+	if ( ent->e.reType != refEntityType_t::RT_MODEL )
+	{
+		return;
+	}
+
+	// see R_AddEntitySurfaces
+	if ( ( ent->e.renderfx & RF_FIRST_PERSON ) &&
+	     ( tr.viewParms.portalLevel > 0 || tr.viewParms.isMirror ) )
+	{
+		return;
+	}
+
+	tr.currentModel = R_GetModelByHandle( ent->e.hModel );
+
+	if ( !R_IsJobModel( tr.currentModel ) )
+	{
+		return;
+	}
+
+	// we must set up parts of tr.or for model culling
+	R_RotateEntityForViewParms( ent, &tr.viewParms, &tr.orientation );
+
+	deferredDrawSurfs = &entityDrawSurfs[ index ];
+
+	// lighting is only set up for the entities that pass the cull
+	switch ( tr.currentModel->type )
+	{
+		case modtype_t::MOD_MESH:
+			R_AddMDVSurfaces( ent );
+			break;
+
+		case modtype_t::MOD_MD5:
+			R_AddMD5Surfaces( ent );
+			break;
+
+		case modtype_t::MOD_IQM:
+			R_AddIQMSurfaces( ent );
+			break;
+
+		default:
+			break;
+	}
+
+	deferredDrawSurfs = nullptr;
+}
+
 /*
 =============
 R_AddEntitySurfaces
@@ -2098,6 +2546,8 @@ void R_AddEntitySurfaces()
 		return;
 	}
 
+	R_RunJobs( tr.refdef.numEntities, R_AddEntityJob );
+
 	for ( i = 0; i < tr.refdef.numEntities; i++ )
 	{
 		ent = tr.currentEntity = &tr.refdef.entities[ i ];
@@ -2135,32 +2585,27 @@ void R_AddEntitySurfaces()
 				break;
 
 			case refEntityType_t::RT_MODEL:
-				// we must set up parts of tr.or for model culling
-				R_RotateEntityForViewParms( ent, &tr.viewParms, &tr.orientation );
-
 				tr.currentModel = R_GetModelByHandle( ent->e.hModel );
 
 				if ( !tr.currentModel )
 				{
 					R_AddDrawSurf( &entitySurface, tr.defaultShader, -1, 0 );
 				}
+				else if ( R_IsJobModel( tr.currentModel ) )
+				{
+					// culled and lit by R_AddEntityJob
+					for ( const deferredDrawSurf_t &drawSurf : entityDrawSurfs[ i ] )
+					{
+						R_AddDrawSurf( drawSurf.surface, drawSurf.shader, drawSurf.lightmapNum, drawSurf.fogNum );
+					}
+				}
 				else
 				{
 					switch ( tr.currentModel->type )
 					{
-						case modtype_t::MOD_MESH:
-							R_AddMDVSurfaces( ent );
-							break;
-
-						case modtype_t::MOD_MD5:
-							R_AddMD5Surfaces( ent );
-							break;
-
-						case modtype_t::MOD_IQM:
-							R_AddIQMSurfaces( ent );
-							break;
-
 						case modtype_t::MOD_BSP:
+							// we must set up parts of tr.or for model culling
+							R_RotateEntityForViewParms( ent, &tr.viewParms, &tr.orientation );
 							R_AddBSPModelSurfaces( ent );
 							break;
 
@@ -2333,6 +2778,68 @@ void R_TransformShadowLight( trRefLight_t *light ) {
 	VectorScale( forward, light->l.radius, light->l.projTarget );
 }
 
+/*
+=============
+R_SetupLightJob
+
+View independent setup of the dynamic lights that pass the
+r_dynamicLight filter, run on the frontend jobs
+=============
+*/
+static void R_SetupLightJob( int index )
+{
+	trRefLight_t *light = &tr.refdef.lights[ index ];
+
+	if ( light->isStatic )
+	{
+		return;
+	}
+
+	if ( light->l.inverseShadows ? !r_dynamicLight->integer : r_dynamicLight->integer != 1 )
+	{
+		return;
+	}
+
+	R_TransformShadowLight( light );
+
+	// set up light transform matrix
+	MatrixSetupTransformFromQuat( light->transformMatrix, light->l.rotation, light->l.origin );
+
+	// set up light origin for lighting and shadowing
+	R_SetupLightOrigin( light );
+
+	// set up model to light view matrix
+	R_SetupLightView( light );
+
+	// set up projection
+	R_SetupLightProjection( light );
+
+	// calc local bounds for culling
+	R_SetupLightLocalBounds( light );
+}
+
+/*
+=============
+R_AddEntityInteractionsJob
+
+Finds the interactions of the entities with one of the visible lights
+on the frontend jobs, they are added after the world interactions of
+the light by R_AddLightInteractions
+=============
+*/
+static std::vector<trRefLight_t *> interactionLights;
+static std::vector<std::vector<deferredInteraction_t>> lightInteractions;
+
+static void R_AddEntityInteractionsJob( int index )
+{
+	deferredInteractions = &lightInteractions[ index ];
+	deferredInteractions->clear();
+
+	R_AddEntityInteractions( interactionLights[ index ] );
+
+	deferredInteractions = nullptr;
+}
+
 /*
 =============
 R_AddLightInteractions
@@ -2345,6 +2852,10 @@ void R_AddLightInteractions()
 	bspNode_t    *leaf;
 	link_t       *l;
 
+	R_RunJobs( tr.refdef.numLights, R_SetupLightJob );
+
+	interactionLights.clear();
+
 	tr.refdef.numShaderLights = 0;
 	for ( i = 0; i < tr.refdef.numLights; i++ )
 	{
@@ -2379,7 +2890,10 @@ void R_AddLightInteractions()
 			}
 		}
 
-		R_TransformShadowLight( light );
+		if ( light->isStatic )
+		{
+			R_TransformShadowLight( light );
+		}
 
 		// we must set up parts of tr.or for light culling
 		R_RotateLightForViewParms( light, &tr.viewParms, &tr.orientation );
@@ -2437,20 +2951,7 @@ void R_AddLightInteractions()
 		}
 		else
 		{
-			// set up light transform matrix
-			MatrixSetupTransformFromQuat( light->transformMatrix, light->l.rotation, light->l.origin );
-
-			// set up light origin for lighting and shadowing
-			R_SetupLightOrigin( light );
-
-			// set up model to light view matrix
-			R_SetupLightView( light );
-
-			// set up projection
-			R_SetupLightProjection( light );
-
-			// calc local bounds for culling
-			R_SetupLightLocalBounds( light );
+			// light matrices and local bounds were set up by R_SetupLightJob
 
 			// look if we have to draw the light including its interactions
 			switch ( R_CullLocalBox( light->localBounds ) )
@@ -2497,6 +2998,20 @@ void R_AddLightInteractions()
 		// look for proper attenuation shader
 		R_SetupLightShader( light );
 
+		interactionLights.push_back( light );
+	}
+
+	if ( lightInteractions.size() < interactionLights.size() )
+	{
+		lightInteractions.resize( interactionLights.size() );
+	}
+
+	R_RunJobs( interactionLights.size(), R_AddEntityInteractionsJob );
+
+	for ( i = 0; i < static_cast<int>( interactionLights.size() ); i++ )
+	{
+		light = tr.currentLight = interactionLights[ i ];
+
 		// setup interactions
 		light->firstInteraction = nullptr;
 		light->lastInteraction = nullptr;
@@ -2515,7 +3030,11 @@ void R_AddLightInteractions()
 			R_AddWorldInteractions( light );
 		}
 
-		R_AddEntityInteractions( light );
+		for ( const deferredInteraction_t &ia : lightInteractions[ i ] )
+		{
+			tr.currentEntity = ia.entity;
+			R_AddLightInteraction( light, ia.surface, ia.shader, ia.cubeSideBits, ia.iaType );
+		}
 
 		if ( light->numInteractions && light->numInteractions != light->numShadowOnlyInteractions )
 		{
@@ -2742,6 +3261,20 @@ void R_RenderView( viewParms_t *parms )
 	firstDrawSurf = tr.refdef.numDrawSurfs;
 	firstInteraction = tr.refdef.numInteractions;
 
+	// scenebench times the stages of the top level views, the views
+	// through portals and mirrors are done in their parent's sort
+	bool timeStages = tr.benchmarking && parms->portalLevel == 0;
+	Sys::SteadyClock::time_point stageStart = Sys::SteadyClock::now();
+
+	auto endStage = [ & ]( frontEndStage_t stage ) {
+		if ( timeStages )
+		{
+			Sys::SteadyClock::time_point now = Sys::SteadyClock::now();
+			tr.benchStageTimes[ stage ] += std::chrono::duration_cast<std::chrono::nanoseconds>( now - stageStart ).count();
+			stageStart = now;
+		}
+	};
+
 	// set viewParms.world
 	R_RotateForViewer();
 
@@ -2755,12 +3288,18 @@ void R_RenderView( viewParms_t *parms )
 	// because it requires the decalBits
 	R_CullDecalProjectors();
 
+	endStage( FES_SETUP );
+
 	R_AddWorldSurfaces();
 
+	endStage( FES_WORLD );
+
 	R_AddPolygonSurfaces();
 
 	R_AddPolygonBufferSurfaces();
 
+	endStage( FES_POLYS );
+
 	// we have tr.viewParms.visBounds set and now we need to add the light bounds
 	// or we get wrong occlusion query results
 	R_AddLightBoundsToVisBounds();
@@ -2781,8 +3320,12 @@ void R_RenderView( viewParms_t *parms )
 
 	R_AddEntitySurfaces();
 
+	endStage( FES_ENTITIES );
+
 	R_AddLightInteractions();
 
+	endStage( FES_INTERACTIONS );
+
 	// Transform the blur vector in view space, FIXME for some we need reason invert its Z component
 	MatrixTransformNormal2( tr.viewParms.world.viewMatrix, tr.refdef.blurVec );
 	tr.refdef.blurVec[2] *= -1;
@@ -2795,6 +3338,8 @@ void R_RenderView( viewParms_t *parms )
 
 	R_SortDrawSurfs();
 
+	endStage( FES_SORT );
+
 	// draw main system development information (surface outlines, etc)
 	R_DebugGraphics();
 }
@@ -64,7 +64,7 @@ model_t        *R_AllocModel()
 		return nullptr;
 	}
 
-	mod = (model_t*) ri.Hunk_Alloc( sizeof( *tr.models[ tr.numModels ] ), ha_pref::h_low );
+	mod = (model_t*) ri.Hunk_Alloc( sizeof( *tr.models[ tr.numModels ] ), hunkTag_t::HT_MODELS );
 	mod->index = tr.numModels;
 	tr.models[ tr.numModels ] = mod;
 	tr.numModels++;
@@ -489,7 +489,7 @@ bool R_LoadIQModel( model_t *mod, void *buffer, int filesize,
 	size += header->num_joints * sizeof(int);		// parents
 	size += len_names;					// joint and anim names
 
-	IQModel = (IQModel_t *)ri.Hunk_Alloc( size, ha_pref::h_low );
+	IQModel = (IQModel_t *)ri.Hunk_Alloc( size, hunkTag_t::HT_MODELS );
 	mod->type = modtype_t::MOD_IQM;
 	mod->iqm = IQModel;
 	ptr = IQModel + 1;
@@ -70,7 +70,7 @@ bool R_LoadMD3( model_t *mod, int lod, void *buffer, const char *modName )
 	mod->type = modtype_t::MOD_MESH;
 	size = LittleLong( md3Model->ofsEnd );
 	mod->dataSize += size;
-	mdvModel = mod->mdv[ lod ] = (mdvModel_t*) ri.Hunk_Alloc( sizeof( mdvModel_t ), ha_pref::h_low );
+	mdvModel = mod->mdv[ lod ] = (mdvModel_t*) ri.Hunk_Alloc( sizeof( mdvModel_t ), hunkTag_t::HT_MODELS );
 
 	LL( md3Model->ident );
 	LL( md3Model->version );
@@ -90,7 +90,7 @@ bool R_LoadMD3( model_t *mod, int lod, void *buffer, const char *modName )
 
 	// swap all the frames
 	mdvModel->numFrames = md3Model->numFrames;
-	mdvModel->frames = frame = (mdvFrame_t*) ri.Hunk_Alloc( sizeof( *frame ) * md3Model->numFrames, ha_pref::h_low );
+	mdvModel->frames = frame = (mdvFrame_t*) ri.Hunk_Alloc( sizeof( *frame ) * md3Model->numFrames, hunkTag_t::HT_MODELS );
 
 	md3Frame = ( md3Frame_t * )( ( byte * ) md3Model + md3Model->ofsFrames );
 
@@ -108,7 +108,7 @@ bool R_LoadMD3( model_t *mod, int lod, void *buffer, const char *modName )
 
 	// swap all the tags
 	mdvModel->numTags = md3Model->numTags;
-	mdvModel->tags = tag = (mdvTag_t*) ri.Hunk_Alloc( sizeof( *tag ) * ( md3Model->numTags * md3Model->numFrames ), ha_pref::h_low );
+	mdvModel->tags = tag = (mdvTag_t*) ri.Hunk_Alloc( sizeof( *tag ) * ( md3Model->numTags * md3Model->numFrames ), hunkTag_t::HT_MODELS );
 
 	md3Tag = ( md3Tag_t * )( ( byte * ) md3Model + md3Model->ofsTags );
 
@@ -123,7 +123,7 @@ bool R_LoadMD3( model_t *mod, int lod, void *buffer, const char *modName )
 		}
 	}
 
-	mdvModel->tagNames = tagName = (mdvTagName_t*) ri.Hunk_Alloc( sizeof( *tagName ) * ( md3Model->numTags ), ha_pref::h_low );
+	mdvModel->tagNames = tagName = (mdvTagName_t*) ri.Hunk_Alloc( sizeof( *tagName ) * ( md3Model->numTags ), hunkTag_t::HT_MODELS );
 
 	md3Tag = ( md3Tag_t * )( ( byte * ) md3Model + md3Model->ofsTags );
 
@@ -134,7 +134,7 @@ bool R_LoadMD3( model_t *mod, int lod, void *buffer, const char *modName )
 
 	// swap all the surfaces
 	mdvModel->numSurfaces = md3Model->numSurfaces;
-	mdvModel->surfaces = surf = (mdvSurface_t*) ri.Hunk_Alloc( sizeof( *surf ) * md3Model->numSurfaces, ha_pref::h_low );
+	mdvModel->surfaces = surf = (mdvSurface_t*) ri.Hunk_Alloc( sizeof( *surf ) * md3Model->numSurfaces, hunkTag_t::HT_MODELS );
 
 	md3Surf = ( md3Surface_t * )( ( byte * ) md3Model + md3Model->ofsSurfaces );
 
@@ -191,7 +191,7 @@ bool R_LoadMD3( model_t *mod, int lod, void *buffer, const char *modName )
 
 		// swap all the triangles
 		surf->numTriangles = md3Surf->numTriangles;
-		surf->triangles = tri = (srfTriangle_t*) ri.Hunk_Alloc( sizeof( *tri ) * md3Surf->numTriangles, ha_pref::h_low );
+		surf->triangles = tri = (srfTriangle_t*) ri.Hunk_Alloc( sizeof( *tri ) * md3Surf->numTriangles, hunkTag_t::HT_MODELS );
 
 		md3Tri = ( md3Triangle_t * )( ( byte * ) md3Surf + md3Surf->ofsTriangles );
 
@@ -204,8 +204,8 @@ bool R_LoadMD3( model_t *mod, int lod, void *buffer, const char *modName )
 
 		// swap all the XyzNormals
 		surf->numVerts = md3Surf->numVerts;
-		surf->verts = v = (mdvXyz_t*) ri.Hunk_Alloc( sizeof( *v ) * ( md3Surf->numVerts * md3Surf->numFrames ), ha_pref::h_low );
-		surf->normals = n = (mdvNormal_t *) ri.Hunk_Alloc( sizeof( *n ) * ( md3Surf->numVerts * md3Surf->numFrames ), ha_pref::h_low );
+		surf->verts = v = (mdvXyz_t*) ri.Hunk_Alloc( sizeof( *v ) * ( md3Surf->numVerts * md3Surf->numFrames ), hunkTag_t::HT_MODELS );
+		surf->normals = n = (mdvNormal_t *) ri.Hunk_Alloc( sizeof( *n ) * ( md3Surf->numVerts * md3Surf->numFrames ), hunkTag_t::HT_MODELS );
 
 		md3xyz = ( md3XyzNormal_t * )( ( byte * ) md3Surf + md3Surf->ofsXyzNormals );
 
@@ -226,7 +226,7 @@ bool R_LoadMD3( model_t *mod, int lod, void *buffer, const char *modName )
 		}
 
 		// swap all the ST
-		surf->st = st = (mdvSt_t*) ri.Hunk_Alloc( sizeof( *st ) * md3Surf->numVerts, ha_pref::h_low );
+		surf->st = st = (mdvSt_t*) ri.Hunk_Alloc( sizeof( *st ) * md3Surf->numVerts, hunkTag_t::HT_MODELS );
 
 		md3st = ( md3St_t * )( ( byte * ) md3Surf + md3Surf->ofsSt );
 
@@ -337,7 +337,7 @@ bool R_LoadMD3( model_t *mod, int lod, void *buffer, const char *modName )
 
 			// create surface
 
-			vboSurf = (srfVBOMDVMesh_t*) ri.Hunk_Alloc( sizeof( *vboSurf ), ha_pref::h_low );
+			vboSurf = (srfVBOMDVMesh_t*) ri.Hunk_Alloc( sizeof( *vboSurf ), hunkTag_t::HT_MODELS );
 			Com_AddToGrowList( &vboSurfaces, vboSurf );
 
 			vboSurf->surfaceType = surfaceType_t::SF_VBO_MDVMESH;
@@ -365,7 +365,7 @@ bool R_LoadMD3( model_t *mod, int lod, void *buffer, const char *modName )
 
 		// move VBO surfaces list to hunk
 		mdvModel->numVBOSurfaces = vboSurfaces.currentElements;
-		mdvModel->vboSurfaces = (srfVBOMDVMesh_t**) ri.Hunk_Alloc( mdvModel->numVBOSurfaces * sizeof( *mdvModel->vboSurfaces ), ha_pref::h_low );
+		mdvModel->vboSurfaces = (srfVBOMDVMesh_t**) ri.Hunk_Alloc( mdvModel->numVBOSurfaces * sizeof( *mdvModel->vboSurfaces ), hunkTag_t::HT_MODELS );
 
 		for ( i = 0; i < mdvModel->numVBOSurfaces; i++ )
 		{
@@ -71,7 +71,7 @@ bool R_LoadMD5( model_t *mod, void *buffer, const char *modName )
 
 	mod->type = modtype_t::MOD_MD5;
 	mod->dataSize += sizeof( md5Model_t );
-	md5 = mod->md5 = (md5Model_t*) ri.Hunk_Alloc( sizeof( md5Model_t ), ha_pref::h_low );
+	md5 = mod->md5 = (md5Model_t*) ri.Hunk_Alloc( sizeof( md5Model_t ), hunkTag_t::HT_MODELS );
 
 	// skip commandline <arguments string>
 	token = COM_ParseExt2( &buf_p, true );
@@ -114,7 +114,7 @@ bool R_LoadMD5( model_t *mod, void *buffer, const char *modName )
 	}
 
 	// parse all the bones
-	md5->bones = (md5Bone_t*) ri.Hunk_Alloc( sizeof( *bone ) * md5->numBones, ha_pref::h_low );
+	md5->bones = (md5Bone_t*) ri.Hunk_Alloc( sizeof( *bone ) * md5->numBones, hunkTag_t::HT_MODELS );
 
 	// parse joints {
 	token = COM_ParseExt2( &buf_p, true );
@@ -219,7 +219,7 @@ bool R_LoadMD5( model_t *mod, void *buffer, const char *modName )
 		return false;
 	}
 
-	md5->surfaces = (md5Surface_t*) ri.Hunk_Alloc( sizeof( *surf ) * md5->numSurfaces, ha_pref::h_low );
+	md5->surfaces = (md5Surface_t*) ri.Hunk_Alloc( sizeof( *surf ) * md5->numSurfaces, hunkTag_t::HT_MODELS );
 
     surf = md5->surfaces;
 	for ( unsigned i = 0; i < md5->numSurfaces; i++, surf++ )
@@ -292,7 +292,7 @@ bool R_LoadMD5( model_t *mod, void *buffer, const char *modName )
 			          modName, SHADER_MAX_VERTEXES, surf->numVerts );
 		}
 
-		surf->verts = (md5Vertex_t*) ri.Hunk_Alloc( sizeof( *v ) * surf->numVerts, ha_pref::h_low );
+		surf->verts = (md5Vertex_t*) ri.Hunk_Alloc( sizeof( *v ) * surf->numVerts, hunkTag_t::HT_MODELS );
 		ASSERT_EQ(((intptr_t) surf->verts & 15), 0);
 
         v = surf->verts;
@@ -364,7 +364,7 @@ bool R_LoadMD5( model_t *mod, void *buffer, const char *modName )
 			          modName, SHADER_MAX_TRIANGLES, surf->numTriangles );
 		}
 
-		surf->triangles = (srfTriangle_t*) ri.Hunk_Alloc( sizeof( *tri ) * surf->numTriangles, ha_pref::h_low );
+		surf->triangles = (srfTriangle_t*) ri.Hunk_Alloc( sizeof( *tri ) * surf->numTriangles, hunkTag_t::HT_MODELS );
 
         tri = surf->triangles;
 		for (unsigned j = 0; j < surf->numTriangles; j++, tri++ )
@@ -399,7 +399,7 @@ bool R_LoadMD5( model_t *mod, void *buffer, const char *modName )
 		token = COM_ParseExt2( &buf_p, false );
 		surf->numWeights = atoi( token );
 
-		surf->weights = (md5Weight_t*) ri.Hunk_Alloc( sizeof( *weight ) * surf->numWeights, ha_pref::h_low );
+		surf->weights = (md5Weight_t*) ri.Hunk_Alloc( sizeof( *weight ) * surf->numWeights, hunkTag_t::HT_MODELS );
 
         weight = surf->weights;
 		for (unsigned j = 0; j < surf->numWeights; j++, weight++ )
@@ -636,7 +636,7 @@ bool R_LoadMD5( model_t *mod, void *buffer, const char *modName )
 
 	// move VBO surfaces list to hunk
 	md5->numVBOSurfaces = vboSurfaces.currentElements;
-	md5->vboSurfaces = (srfVBOMD5Mesh_t**) ri.Hunk_Alloc( md5->numVBOSurfaces * sizeof( *md5->vboSurfaces ), ha_pref::h_low );
+	md5->vboSurfaces = (srfVBOMD5Mesh_t**) ri.Hunk_Alloc( md5->numVBOSurfaces * sizeof( *md5->vboSurfaces ), hunkTag_t::HT_MODELS );
 
 	for ( unsigned i = 0; i < md5->numVBOSurfaces; i++ )
 	{
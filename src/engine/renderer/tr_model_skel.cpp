@@ -115,7 +115,7 @@ void AddSurfaceToVBOSurfacesList( growList_t *vboSurfaces, growList_t *vboTriang
 	indexesNum = vboTriangles->currentElements * 3;
 
 	// create surface
-	vboSurf = (srfVBOMD5Mesh_t*) ri.Hunk_Alloc( sizeof( *vboSurf ), ha_pref::h_low );
+	vboSurf = (srfVBOMD5Mesh_t*) ri.Hunk_Alloc( sizeof( *vboSurf ), hunkTag_t::HT_MODELS );
 	Com_AddToGrowList( vboSurfaces, vboSurf );
 
 	vboSurf->surfaceType = surfaceType_t::SF_VBO_MD5MESH;
@@ -150,7 +150,8 @@ struct refexport_t
 	void ( *Finish )();
 
 	// XreaL BEGIN
-	void ( *TakeVideoFrame )( int h, int w, byte *captureBuffer, byte *encodeBuffer, bool motionJpeg );
+	bool ( *TakeVideoFrame )( int width, int height, byte *captureBuffer, int frame );
+	int ( *SaveJPGToBuffer )( byte *buffer, size_t bufferSize, int quality, int width, int height, byte *image );
 
 	void ( *AddRefLightToScene )( const refLight_t *light );
 
@@ -160,6 +161,7 @@ struct refexport_t
 	int ( *BuildSkeleton )( refSkeleton_t *skel, qhandle_t anim, int startFrame, int endFrame, float frac,
 	                        bool clearOrigin );
 	int ( *BlendSkeleton )( refSkeleton_t *skel, const refSkeleton_t *blend, float frac );
+	void ( *BuildSkeletons )( const refSkeletonJob_t *jobs, int numJobs, refSkeleton_t *skels, int *results );
 	int ( *BoneIndex )( qhandle_t hModel, const char *boneName );
 	int ( *AnimNumFrames )( qhandle_t hAnim );
 	int ( *AnimFrameRate )( qhandle_t hAnim );
@@ -187,6 +189,8 @@ struct refexport_t
 	const char *( *ShaderNameFromHandle )( qhandle_t shader );
 };
 
+struct hunkSubArena_t;
+
 //
 // these are the functions imported by the refresh module
 //
@@ -204,7 +208,9 @@ struct refimport_t
 	// stack based memory allocation for per-level things that
 	// won't be freed
 	void ( *Hunk_Clear )();
-	void            *( *Hunk_Alloc )( int size, ha_pref pref );
+	void            *( *Hunk_Alloc )( int size, hunkTag_t tag );
+	void ( *Hunk_InitSubArena )( hunkSubArena_t *arena, hunkTag_t tag );
+	void            *( *Hunk_SubArenaAlloc )( hunkSubArena_t *arena, int size );
 	void            *( *Hunk_AllocateTempMemory )( int size );
 	void ( *Hunk_FreeTempMemory )( void *block );
 
@@ -252,7 +258,7 @@ struct refimport_t
 
 	// XreaL BEGIN
 	bool( *CL_VideoRecording )();
-	void ( *CL_WriteAVIVideoFrame )( const byte *buffer, int size );
+	void ( *CL_QueueAVIVideoFrame )( int frame, const byte *pixels, int lineLen );
 	// XreaL END
 
 	// input event handling
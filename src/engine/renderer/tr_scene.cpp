@@ -22,6 +22,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 */
 // tr_scene.c
 #include "tr_local.h"
+#include "framework/Profiler.h"
 
 static int r_firstSceneDrawSurf;
 static int r_firstSceneInteraction;
@@ -533,6 +534,32 @@ void RE_AddDynamicLightToSceneET( const vec3_t org, float radius, float intensit
 		light->l.scale = intensity;
 }
 
+/*
+=====================
+R_AddCapturedLightToScene
+
+Adds a dynamic light the way scenecapture recorded it, after the
+adjustments the functions above made to it.
+=====================
+*/
+void R_AddCapturedLightToScene( const refLight_t *l, int restrictInteractionFirst, int restrictInteractionLast )
+{
+	trRefLight_t *light;
+
+	if ( r_numLights >= MAX_REF_LIGHTS )
+	{
+		return;
+	}
+
+	light = &backEndData[ tr.smpFrame ]->lights[ r_numLights++ ];
+	Com_Memcpy( &light->l, l, sizeof( light->l ) );
+
+	light->restrictInteractionFirst = restrictInteractionFirst;
+	light->restrictInteractionLast = restrictInteractionLast;
+	light->isStatic = false;
+	light->additive = true;
+}
+
 void RE_AddDynamicLightToSceneQ3A( const vec3_t org, float radius, float r, float g, float b )
 {
 	RE_AddDynamicLightToSceneET( org, radius, r_lightScale->value, r, g, b, 0, 0 );
@@ -559,6 +586,8 @@ void RE_RenderScene( const refdef_t *fd )
 		return;
 	}
 
+	PROFILE_ZONE( "RE_RenderScene" );
+
 	GLimp_LogComment( "====== RE_RenderScene =====\n" );
 
 	if ( r_norefresh->integer )
@@ -614,6 +643,8 @@ void RE_RenderScene( const refdef_t *fd )
 		}
 	}
 
+	int numSceneLights = r_numLights - r_firstSceneLight;
+
 	R_AddWorldLightsToScene();
 
 	// derived info
@@ -646,6 +677,8 @@ void RE_RenderScene( const refdef_t *fd )
 	tr.refdef.numVisTests = r_numVisTests - r_firstSceneVisTest;
 	tr.refdef.visTests = &backEndData[ tr.smpFrame ]->visTests[ r_firstSceneVisTest ];
 
+	R_CaptureScene( fd, numSceneLights );
+
 	// a single frame may have multiple scenes draw inside it --
 	// a 3D game view, 3D status bar renderings, 3D menus, etc.
 	// They need to be distinguished by the light flare code, because
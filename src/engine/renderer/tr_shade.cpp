@@ -566,7 +566,7 @@ void Tess_Begin( void ( *stageIteratorFunc )(),
 	tess.lightmapNum = lightmapNum;
 	tess.fogNum = fogNum;
 
-	if ( r_logFile->integer )
+	if ( backEnd.cvars.logFile )
 	{
 		// don't just call LogComment, or we will get
 		// a call to va() every frame!
@@ -888,7 +888,7 @@ static void Render_vertexLighting_DBS_entity( int stage )
 
 			float interpolate = cubeProbeNearestDistance / ( cubeProbeNearestDistance + cubeProbeSecondNearestDistance );
 
-			if ( r_logFile->integer )
+			if ( backEnd.cvars.logFile )
 			{
 				GLimp_LogComment( va( "cubeProbeNearestDistance = %f, cubeProbeSecondNearestDistance = %f, interpolation = %f\n",
 						      cubeProbeNearestDistance, cubeProbeSecondNearestDistance, interpolate ) );
@@ -2280,7 +2280,7 @@ static void Render_fog()
 		return;
 	}
 
-	if ( r_logFile->integer )
+	if ( backEnd.cvars.logFile )
 	{
 		GLimp_LogComment( va( "--- Render_fog( fogNum = %i, originalBrushNumber = %i ) ---\n", tess.fogNum, fog->originalBrushNumber ) );
 	}
@@ -2642,7 +2642,7 @@ static void Tess_ComputeTexMatrices( shaderStage_t *pStage )
 void Tess_StageIteratorDebug()
 {
 	// log this call
-	if ( r_logFile->integer )
+	if ( backEnd.cvars.logFile )
 	{
 		// don't just call LogComment, or we will get
 		// a call to va() every frame!
@@ -2665,7 +2665,7 @@ void Tess_StageIteratorGeneric()
 	int stage;
 
 	// log this call
-	if ( r_logFile->integer )
+	if ( backEnd.cvars.logFile )
 	{
 		// don't just call LogComment, or we will get
 		// a call to va() every frame!
@@ -2691,7 +2691,7 @@ void Tess_StageIteratorGeneric()
 	if ( tess.surfaceShader->polygonOffset )
 	{
 		glEnable( GL_POLYGON_OFFSET_FILL );
-		GL_PolygonOffset( r_offsetFactor->value, r_offsetUnits->value );
+		GL_PolygonOffset( backEnd.cvars.offsetFactor, backEnd.cvars.offsetUnits );
 	}
 
 	// call shader function
@@ -2847,7 +2847,7 @@ void Tess_StageIteratorDepthFill()
 	int stage;
 
 	// log this call
-	if ( r_logFile->integer )
+	if ( backEnd.cvars.logFile )
 	{
 		// don't just call LogComment, or we will get
 		// a call to va() every frame!
@@ -2873,7 +2873,7 @@ void Tess_StageIteratorDepthFill()
 	if ( tess.surfaceShader->polygonOffset )
 	{
 		glEnable( GL_POLYGON_OFFSET_FILL );
-		GL_PolygonOffset( r_offsetFactor->value, r_offsetUnits->value );
+		GL_PolygonOffset( backEnd.cvars.offsetFactor, backEnd.cvars.offsetUnits );
 	}
 
 	// call shader function
@@ -2935,7 +2935,7 @@ void Tess_StageIteratorShadowFill()
 	int stage;
 
 	// log this call
-	if ( r_logFile->integer )
+	if ( backEnd.cvars.logFile )
 	{
 		// don't just call LogComment, or we will get
 		// a call to va() every frame!
@@ -2961,7 +2961,7 @@ void Tess_StageIteratorShadowFill()
 	if ( tess.surfaceShader->polygonOffset )
 	{
 		glEnable( GL_POLYGON_OFFSET_FILL );
-		GL_PolygonOffset( r_offsetFactor->value, r_offsetUnits->value );
+		GL_PolygonOffset( backEnd.cvars.offsetFactor, backEnd.cvars.offsetUnits );
 	}
 
 	// call shader function
@@ -3021,7 +3021,7 @@ void Tess_StageIteratorLighting()
 	shaderStage_t *attenuationZStage;
 
 	// log this call
-	if ( r_logFile->integer )
+	if ( backEnd.cvars.logFile )
 	{
 		// don't just call LogComment, or we will get
 		// a call to va() every frame!
@@ -3066,7 +3066,7 @@ void Tess_StageIteratorLighting()
 	if ( tess.surfaceShader->polygonOffset )
 	{
 		glEnable( GL_POLYGON_OFFSET_FILL );
-		GL_PolygonOffset( r_offsetFactor->value, r_offsetUnits->value );
+		GL_PolygonOffset( backEnd.cvars.offsetFactor, backEnd.cvars.offsetUnits );
 	}
 
 	// call shader function
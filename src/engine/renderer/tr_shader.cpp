@@ -21,6 +21,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 ===========================================================================
 */
 // tr_shader.c -- this file deals with the parsing and definition of shaders
+#include <common/FileSystem.h>
 #include "tr_local.h"
 #include "gl_shader.h"
 
@@ -30,10 +31,37 @@ static shaderTable_t *shaderTableHashTable[ MAX_SHADERTABLE_HASH ];
 static const int FILE_HASH_SIZE       = 1024;
 static shader_t      *shaderHashTable[ FILE_HASH_SIZE ];
 
-static const int MAX_SHADERTEXT_HASH  = 2048;
-static const char          **shaderTextHashTable[ MAX_SHADERTEXT_HASH ];
+// the index of the shaders defined by the shader files, saved in the homepath
+static const char    SHADER_INDEX_FILE[] = "cache/shaderIndex.bin";
+static const int     SHADER_INDEX_VERSION = 1;
 
-static char          *s_shaderText;
+struct shaderIndexHeader_t
+{
+	int      version;
+	unsigned checkSum;
+	int      numFiles;
+	int      numShaders;
+	int      numTables;
+};
+
+// location of the text of a shader or table in the shader files
+struct shaderTextEntry_t
+{
+	int fileNum;
+	int offset;
+	int length;
+};
+
+struct shaderFile_t
+{
+	std::string name;
+	std::string text; // unixified and compressed
+	bool        loaded;
+};
+
+static std::vector<shaderFile_t> shaderFiles;
+static std::unordered_map<std::string, shaderTextEntry_t, Str::IHash, Str::IEqual> shaderTextIndex;
+static std::vector<shaderTextEntry_t> shaderTableEntries;
 
 // the shader is parsed into these global variables, then copied into
 // dynamically allocated memory if it is valid.
@@ -3485,7 +3513,7 @@ static bool ParseShader( const char *_text )
 			        because it breaks the computation of the current shader
 			*/
 			tokenLen = strlen( token ) + 1;
-			tr.sunShaderName = (char*) ri.Hunk_Alloc( sizeof( char ) * tokenLen, ha_pref::h_low );
+			tr.sunShaderName = (char*) ri.Hunk_Alloc( sizeof( char ) * tokenLen, hunkTag_t::HT_SHADERS );
 			Q_strncpyz( tr.sunShaderName, token, tokenLen );
 		}
 		// light <value> determines flaring in xmap, not needed here
@@ -3700,7 +3728,7 @@ static bool ParseShader( const char *_text )
 
 				tokenLen = strlen( token ) + 1;
 				shader.altShader[ index ].index = 0;
-				shader.altShader[ index ].name = ( char* )ri.Hunk_Alloc( sizeof( char ) * tokenLen, ha_pref::h_low );
+				shader.altShader[ index ].name = ( char* )ri.Hunk_Alloc( sizeof( char ) * tokenLen, hunkTag_t::HT_SHADERS );
 				Q_strncpyz( shader.altShader[ index ].name, token, tokenLen );
 			}
 		}
@@ -4066,7 +4094,7 @@ static shader_t *GeneratePermanentShader()
 		return tr.defaultShader;
 	}
 
-	newShader = (shader_t*) ri.Hunk_Alloc( sizeof( shader_t ), ha_pref::h_low );
+	newShader = (shader_t*) ri.Hunk_Alloc( sizeof( shader_t ), hunkTag_t::HT_SHADERS );
 
 	*newShader = shader;
 
@@ -4094,13 +4122,13 @@ static shader_t *GeneratePermanentShader()
 			break;
 		}
 
-		newShader->stages[ i ] = (shaderStage_t*) ri.Hunk_Alloc( sizeof( stages[ i ] ), ha_pref::h_low );
+		newShader->stages[ i ] = (shaderStage_t*) ri.Hunk_Alloc( sizeof( stages[ i ] ), hunkTag_t::HT_SHADERS );
 		*newShader->stages[ i ] = stages[ i ];
 
 		for ( b = 0; b < MAX_TEXTURE_BUNDLES; b++ )
 		{
 			size = newShader->stages[ i ]->bundle[ b ].numTexMods * sizeof( texModInfo_t );
-			newShader->stages[ i ]->bundle[ b ].texMods = (texModInfo_t*) ri.Hunk_Alloc( size, ha_pref::h_low );
+			newShader->stages[ i ]->bundle[ b ].texMods = (texModInfo_t*) ri.Hunk_Alloc( size, hunkTag_t::HT_SHADERS );
 			Com_Memcpy( newShader->stages[ i ]->bundle[ b ].texMods, stages[ i ].bundle[ b ].texMods, size );
 		}
 	}
@@ -4131,7 +4159,7 @@ static void GeneratePermanentShaderTable( float *values, int numValues )
 		return;
 	}
 
-	newTable = (shaderTable_t*) ri.Hunk_Alloc( sizeof( shaderTable_t ), ha_pref::h_low );
+	newTable = (shaderTable_t*) ri.Hunk_Alloc( sizeof( shaderTable_t ), hunkTag_t::HT_SHADERS );
 
 	*newTable = table;
 
@@ -4141,7 +4169,7 @@ static void GeneratePermanentShaderTable( float *values, int numValues )
 	tr.numTables++;
 
 	newTable->numValues = numValues;
-	newTable->values = (float*) ri.Hunk_Alloc( sizeof( float ) * numValues, ha_pref::h_low );
+	newTable->values = (float*) ri.Hunk_Alloc( sizeof( float ) * numValues, hunkTag_t::HT_SHADERS );
 
 	for ( i = 0; i < numValues; i++ )
 	{
@@ -4592,12 +4620,496 @@ bool RE_LoadDynamicShader( const char *shadername, const char *shadertext )
 
 //========================================================================================
 
+/*
+====================
+ParseShaderTable
+
+Parses a table after its "table" keyword and creates it if it
+doesn't exist yet
+=====================
+*/
+static void ParseShaderTable( const char **text )
+{
+	const char    *token;
+	int           depth;
+	float         values[ FUNCTABLE_SIZE ];
+	int           numValues;
+	shaderTable_t *tb;
+	int           hash;
+
+	Com_Memset( &table, 0, sizeof( table ) );
+
+	token = COM_ParseExt2( text, true );
+
+	Q_strncpyz( table.name, token, sizeof( table.name ) );
+
+	// check if already created
+	hash = generateHashValue( table.name, MAX_SHADERTABLE_HASH );
+
+	for ( tb = shaderTableHashTable[ hash ]; tb; tb = tb->next )
+	{
+		if ( Q_stricmp( tb->name, table.name ) == 0 )
+		{
+			// match found
+			return;
+		}
+	}
+
+	depth = 0;
+	numValues = 0;
+
+	do
+	{
+		token = COM_ParseExt2( text, true );
+
+		if ( !Q_stricmp( token, "snap" ) )
+		{
+			table.snap = true;
+		}
+		else if ( !Q_stricmp( token, "clamp" ) )
+		{
+			table.clamp = true;
+		}
+		else if ( token[ 0 ] == '{' )
+		{
+			depth++;
+		}
+		else if ( token[ 0 ] == '}' )
+		{
+			depth--;
+		}
+		else if ( token[ 0 ] == ',' )
+		{
+			continue;
+		}
+		else
+		{
+			if ( numValues == FUNCTABLE_SIZE )
+			{
+				Log::Warn("FUNCTABLE_SIZE hit" );
+				break;
+			}
+
+			values[ numValues++ ] = atof( token );
+		}
+	}
+	while ( depth && *text );
+
+	Log::Debug("...generating '%s'", table.name );
+	GeneratePermanentShaderTable( values, numValues );
+}
+
+/*
+====================
+ReadShaderFile
+
+Reads a shader file and prepares it for parsing
+=====================
+*/
+static bool ReadShaderFile( const std::string &filename, std::string &text, bool fromPaksOnly )
+{
+	std::error_code err;
+	text = FS::PakPath::ReadFile( filename, err );
+
+	if ( err )
+	{
+		// the legacy filesystem also finds files in the homepath
+		if ( fromPaksOnly )
+		{
+			return false;
+		}
+
+		char *buffer;
+
+		if ( ri.FS_ReadFile( filename.c_str(), ( void ** ) &buffer ) < 0 || !buffer )
+		{
+			return false;
+		}
+
+		text = buffer;
+		ri.FS_FreeFile( buffer );
+	}
+
+	// ydnar: unixify all shaders
+	text.push_back( '\0' );
+	COM_FixPath( &text[ 0 ] );
+	COM_Compress( &text[ 0 ] );
+	text.resize( strlen( text.c_str() ) );
+	return true;
+}
+
+/*
+====================
+GetShaderFileText
+
+Returns the text of a shader file, which is loaded the first
+time one of its shaders is used
+=====================
+*/
+static const char *GetShaderFileText( int fileNum )
+{
+	shaderFile_t &file = shaderFiles[ fileNum ];
+
+	if ( !file.loaded )
+	{
+		std::string filename = Str::Format( "scripts/%s", file.name );
+
+		Log::Debug("...loading '%s'", filename );
+
+		if ( !ReadShaderFile( filename, file.text, false ) )
+		{
+			Log::Warn("Couldn't load %s", filename );
+			return nullptr;
+		}
+
+		file.loaded = true;
+	}
+
+	return file.text.c_str();
+}
+
+/*
+====================
+ShaderIndexChecksum
+
+Identifies the exact versions of the shader files the index was built from
+=====================
+*/
+static unsigned ShaderIndexChecksum()
+{
+	std::string key;
+
+	for ( const shaderFile_t &file : shaderFiles )
+	{
+		std::string filename = Str::Format( "scripts/%s", file.name );
+		const FS::LoadedPakInfo *pak = FS::PakPath::LocateFile( filename );
+
+		if ( !pak )
+		{
+			// not in a pak, don't try to guess whether it changed
+			return 0;
+		}
+
+		if ( pak->realChecksum )
+		{
+			key += Str::Format( "%s %s_%s %08x\n", filename, pak->name, pak->version, *pak->realChecksum );
+		}
+		else
+		{
+			std::error_code err;
+			auto timestamp = FS::PakPath::FileTimestamp( filename, err );
+
+			if ( err )
+			{
+				return 0;
+			}
+
+			key += Str::Format( "%s %s_%s @%d\n", filename, pak->name, pak->version, std::chrono::system_clock::to_time_t( timestamp ) );
+		}
+	}
+
+	return Com_BlockChecksum( key.data(), key.size() ) | 1;
+}
+
+static void WriteIndexInt( std::string &out, int value )
+{
+	out.append( reinterpret_cast<const char *>( &value ), sizeof( value ) );
+}
+
+static void WriteIndexString( std::string &out, const std::string &value )
+{
+	WriteIndexInt( out, value.size() );
+	out.append( value );
+}
+
+static bool ReadIndexInt( const char *&p, const char *end, int &value )
+{
+	if ( end - p < ( int ) sizeof( value ) )
+	{
+		return false;
+	}
+
+	memcpy( &value, p, sizeof( value ) );
+	p += sizeof( value );
+	return true;
+}
+
+static bool ReadIndexString( const char *&p, const char *end, std::string &value )
+{
+	int length;
+
+	if ( !ReadIndexInt( p, end, length ) || length < 0 || end - p < length )
+	{
+		return false;
+	}
+
+	value.assign( p, length );
+	p += length;
+	return true;
+}
+
+static bool ReadIndexEntry( const char *&p, const char *end, shaderTextEntry_t &entry )
+{
+	return ReadIndexInt( p, end, entry.fileNum ) && ReadIndexInt( p, end, entry.offset ) && ReadIndexInt( p, end, entry.length ) &&
+	       entry.fileNum >= 0 && entry.fileNum < ( int ) shaderFiles.size() && entry.offset >= 0 && entry.length >= 0;
+}
+
+/*
+====================
+LoadShaderIndex
+=====================
+*/
+static bool LoadShaderIndex( unsigned checkSum )
+{
+	std::error_code err;
+	FS::File indexFile = FS::HomePath::OpenRead( SHADER_INDEX_FILE, err );
+
+	if ( err )
+	{
+		return false;
+	}
+
+	std::string data = indexFile.ReadAll( err );
+
+	if ( err )
+	{
+		return false;
+	}
+
+	const char *p = data.data();
+	const char *end = p + data.size();
+	shaderIndexHeader_t header;
+
+	if ( data.size() < sizeof( header ) )
+	{
+		return false;
+	}
+
+	memcpy( &header, p, sizeof( header ) );
+	p += sizeof( header );
+
+	if ( header.version != SHADER_INDEX_VERSION || header.checkSum != checkSum || header.numFiles != ( int ) shaderFiles.size() )
+	{
+		return false;
+	}
+
+	for ( const shaderFile_t &file : shaderFiles )
+	{
+		std::string name;
+
+		if ( !ReadIndexString( p, end, name ) || name != file.name )
+		{
+			return false;
+		}
+	}
+
+	for ( int i = 0; i < header.numShaders; i++ )
+	{
+		std::string name;
+		shaderTextEntry_t entry;
+
+		if ( !ReadIndexString( p, end, name ) || !ReadIndexEntry( p, end, entry ) )
+		{
+			shaderTextIndex.clear();
+			return false;
+		}
+
+		shaderTextIndex.emplace( std::move( name ), entry );
+	}
+
+	for ( int i = 0; i < header.numTables; i++ )
+	{
+		shaderTextEntry_t entry;
+
+		if ( !ReadIndexEntry( p, end, entry ) )
+		{
+			shaderTextIndex.clear();
+			shaderTableEntries.clear();
+			return false;
+		}
+
+		shaderTableEntries.push_back( entry );
+	}
+
+	return true;
+}
+
+/*
+====================
+SaveShaderIndex
+=====================
+*/
+static void SaveShaderIndex( unsigned checkSum )
+{
+	shaderIndexHeader_t header{}; // Zero init.
+	std::string data;
+
+	header.version = SHADER_INDEX_VERSION;
+	header.checkSum = checkSum;
+	header.numFiles = shaderFiles.size();
+	header.numShaders = shaderTextIndex.size();
+	header.numTables = shaderTableEntries.size();
+
+	data.append( reinterpret_cast<const char *>( &header ), sizeof( header ) );
+
+	for ( const shaderFile_t &file : shaderFiles )
+	{
+		WriteIndexString( data, file.name );
+	}
+
+	for ( const auto &shaderText : shaderTextIndex )
+	{
+		WriteIndexString( data, shaderText.first );
+		WriteIndexInt( data, shaderText.second.fileNum );
+		WriteIndexInt( data, shaderText.second.offset );
+		WriteIndexInt( data, shaderText.second.length );
+	}
+
+	for ( const shaderTextEntry_t &entry : shaderTableEntries )
+	{
+		WriteIndexInt( data, entry.fileNum );
+		WriteIndexInt( data, entry.offset );
+		WriteIndexInt( data, entry.length );
+	}
+
+	ri.FS_WriteFile( SHADER_INDEX_FILE, data.data(), data.size() );
+}
+
+/*
+====================
+BuildShaderIndex
+
+Loads all the shader files, reading and decompressing them in parallel,
+and records where each shader and table is
+=====================
+*/
+static void BuildShaderIndex()
+{
+	int numFiles = shaderFiles.size();
+	std::vector<char> read( numFiles, false );
+	std::atomic<int> nextFile( 0 );
+
+	auto readFiles = [&]()
+	{
+		int i;
+
+		while ( ( i = nextFile++ ) < numFiles )
+		{
+			std::string filename = Str::Format( "scripts/%s", shaderFiles[ i ].name );
+			read[ i ] = ReadShaderFile( filename, shaderFiles[ i ].text, true );
+		}
+	};
+
+	int numThreads = Math::Clamp( ( int ) std::thread::hardware_concurrency(), 1, 8 );
+	std::vector<std::thread> threads;
+
+	for ( int i = 1; i < numThreads; i++ )
+	{
+		threads.emplace_back( readFiles );
+	}
+
+	readFiles();
+
+	for ( std::thread &thread : threads )
+	{
+		thread.join();
+	}
+
+	// the later files override the earlier ones so look at them first
+	for ( int i = numFiles - 1; i >= 0; i-- )
+	{
+		shaderFile_t &file = shaderFiles[ i ];
+		std::string filename = Str::Format( "scripts/%s", file.name );
+
+		Log::Debug("...loading '%s'", filename );
+
+		// files outside of paks must be read with the legacy filesystem
+		if ( !read[ i ] && !ReadShaderFile( filename, file.text, false ) )
+		{
+			ri.Error(errorParm_t::ERR_DROP, "Couldn't load %s", filename.c_str() );
+		}
+
+		file.loaded = true;
+
+		std::vector<std::pair<std::string, shaderTextEntry_t>> shaders;
+		std::vector<shaderTextEntry_t> tables;
+		const char *text = file.text.c_str();
+		const char *p = text;
+		bool valid = true;
+
+		while ( 1 )
+		{
+			const char *token = COM_ParseExt2( &p, true );
+
+			if ( !*token )
+			{
+				break;
+			}
+
+			// Step over the "table" and the name
+			bool isTable = !Q_stricmp( token, "table" );
+			const char *start = p;
+
+			if ( isTable )
+			{
+				token = COM_ParseExt2( &p, true );
+
+				if ( !*token )
+				{
+					break;
+				}
+			}
+
+			std::string name = token;
+
+			if ( !isTable )
+			{
+				start = p;
+			}
+
+			token = COM_ParseExt2( &p, true );
+
+			if ( token[ 0 ] != '{' || token[ 1 ] != '\0' || !SkipBracedSection_Depth( &p, 1 ) )
+			{
+				Log::Warn("Bad shader file %s has incorrect syntax.", filename );
+				valid = false;
+				break;
+			}
+
+			shaderTextEntry_t entry = { i, int( start - text ), int( p - start ) };
+
+			if ( isTable )
+			{
+				tables.push_back( entry );
+			}
+			else
+			{
+				shaders.emplace_back( std::move( name ), entry );
+			}
+		}
+
+		if ( !valid )
+		{
+			file.text.clear();
+			continue;
+		}
+
+		// the first definition of a shader in a file is used
+		for ( auto &shaderText : shaders )
+		{
+			shaderTextIndex.emplace( std::move( shaderText.first ), shaderText.second );
+		}
+
+		shaderTableEntries.insert( shaderTableEntries.end(), tables.begin(), tables.end() );
+	}
+}
+
 /*
 ====================
 FindShaderInShaderText
 
-Scans the combined text description of all the shader files for
-the given shader name.
+Looks for the given shader name in the index of the shader
+files and returns its text.
 
 return nullptr if not found
 
@@ -4606,25 +5118,119 @@ If found, it will return a valid shader
 */
 static const char    *FindShaderInShaderText( const char *shaderName )
 {
-	const char *token, *p;
+	auto it = shaderTextIndex.find( shaderName );
 
-	int  i, hash;
+	// if the shader is not in the index, it must not exist
+	if ( it == shaderTextIndex.end() )
+	{
+		return nullptr;
+	}
+
+	const shaderTextEntry_t &entry = it->second;
+	const char *text = GetShaderFileText( entry.fileNum );
+
+	if ( !text || entry.offset + entry.length > ( int ) shaderFiles[ entry.fileNum ].text.size() )
+	{
+		return nullptr;
+	}
+
+	return text + entry.offset;
+}
+
+/*
+====================
+R_PrefetchShaderImages
+
+Scans the text of a shader for the images it uses so that they
+are decoded in the background before the shader is parsed.
+=====================
+*/
+static void R_PrefetchShaderImage( const char *name, int bits )
+{
+	// builtin images and image processing expressions
+	if ( name[ 0 ] == '$' || name[ 0 ] == '_' || name[ 0 ] == '*' || strchr( name, '(' ) )
+	{
+		return;
+	}
+
+	R_PrefetchImageFile( name, bits );
+}
 
-	hash = generateHashValue( shaderName, MAX_SHADERTEXT_HASH );
+void R_PrefetchShaderImages( const char *name )
+{
+	char       strippedName[ MAX_QPATH ];
+	const char *text;
+	char       *token;
+	int        depth = 0;
+	int        stageBits = IF_NONE;
+
+	if ( !name || !name[ 0 ] )
+	{
+		return;
+	}
+
+	COM_StripExtension3( name, strippedName, sizeof( strippedName ) );
+
+	text = FindShaderInShaderText( strippedName );
+
+	if ( !text )
+	{
+		// an implicit shader uses the image with the same name
+		R_PrefetchShaderImage( strippedName, IF_NONE );
+		return;
+	}
 
-	for ( i = 0; shaderTextHashTable[ hash ][ i ]; i++ )
+	while ( true )
 	{
-		p = shaderTextHashTable[ hash ][ i ];
-		token = COM_ParseExt2( &p, true );
+		token = COM_ParseExt2( &text, true );
 
-		if ( !Q_stricmp( token, shaderName ) )
+		if ( !token[ 0 ] )
 		{
-			return p;
+			break;
 		}
-	}
 
-	// if the shader is not in the table, it must not exist
-	return nullptr;
+		if ( token[ 0 ] == '{' )
+		{
+			stageBits = IF_NONE;
+			depth++;
+		}
+		else if ( token[ 0 ] == '}' )
+		{
+			if ( --depth <= 0 )
+			{
+				break;
+			}
+		}
+		else if ( depth == 1 )
+		{
+			if ( !Q_stricmp( token, "diffuseMap" ) || !Q_stricmp( token, "specularMap" ) ||
+			     !Q_stricmp( token, "materialMap" ) || !Q_stricmp( token, "glowMap" ) )
+			{
+				R_PrefetchShaderImage( COM_ParseExt2( &text, false ), IF_NONE );
+			}
+			else if ( !Q_stricmp( token, "normalMap" ) || !Q_stricmp( token, "bumpMap" ) )
+			{
+				R_PrefetchShaderImage( COM_ParseExt2( &text, false ), IF_NORMALMAP );
+			}
+		}
+		else if ( depth == 2 )
+		{
+			if ( !Q_stricmp( token, "stage" ) || !Q_stricmp( token, "blend" ) || !Q_stricmp( token, "blendFunc" ) )
+			{
+				token = COM_ParseExt2( &text, false );
+
+				if ( !Q_stricmp( token, "normalMap" ) || !Q_stricmp( token, "bumpMap" ) ||
+				     !Q_stricmp( token, "heathazeMap" ) || !Q_stricmp( token, "liquidMap" ) )
+				{
+					stageBits = IF_NORMALMAP;
+				}
+			}
+			else if ( !Q_stricmp( token, "map" ) || !Q_stricmp( token, "clampmap" ) )
+			{
+				R_PrefetchShaderImage( COM_ParseExt2( &text, false ), stageBits );
+			}
+		}
+	}
 }
 
 /*
@@ -5247,31 +5853,28 @@ void R_ShaderExp_f()
 ====================
 ScanAndLoadShaderFiles
 
-Finds and loads all .shader files, combining them into
-a single large text block that can be scanned for shader names
+Finds all .shader files and indexes the shaders they define, the
+index is saved so that the files don't all have to be parsed again.
+The shader texts are loaded when they are first used.
 =====================
 */
 static const int MAX_SHADER_FILES = 4096;
 static void ScanAndLoadShaderFiles()
 {
-	char **shaderFiles;
-	char *buffers[ MAX_SHADER_FILES ];
-	const char *p;
+	char **shaderFileList;
 	int  numShaderFiles;
-	int  i;
-	const char *oldp, *token;
-	char *textEnd;
-	const char **hashMem;
-	int  shaderTextHashTableSizes[ MAX_SHADERTEXT_HASH ], hash, size;
-	char filename[ MAX_QPATH ];
-	long sum = 0, summand;
+	int  startTime = ri.Milliseconds();
 
 	Log::Debug("----- ScanAndLoadShaderFiles -----" );
 
+	shaderFiles.clear();
+	shaderTextIndex.clear();
+	shaderTableEntries.clear();
+
 	// scan for shader files
-	shaderFiles = ri.FS_ListFiles( "scripts", ".shader", &numShaderFiles );
+	shaderFileList = ri.FS_ListFiles( "scripts", ".shader", &numShaderFiles );
 
-	if ( !shaderFiles || !numShaderFiles )
+	if ( !shaderFileList || !numShaderFiles )
 	{
 		Log::Warn("no shader files found" );
 	}
@@ -5281,225 +5884,45 @@ static void ScanAndLoadShaderFiles()
 		numShaderFiles = MAX_SHADER_FILES;
 	}
 
-	// load and parse shader files
-	for ( i = 0; i < numShaderFiles; i++ )
+	for ( int i = 0; i < numShaderFiles; i++ )
 	{
-		Com_sprintf( filename, sizeof( filename ), "scripts/%s", shaderFiles[ i ] );
-
-		Log::Debug("...loading '%s'", filename );
-		summand = ri.FS_ReadFile( filename, ( void ** ) &buffers[ i ] );
-
-		if ( !buffers[ i ] )
-		{
-			ri.Error(errorParm_t::ERR_DROP, "Couldn't load %s", filename );
-		}
-
-		p = buffers[ i ];
-
-		while ( 1 )
-		{
-			token = COM_ParseExt2( &p, true );
-
-			if ( !*token )
-			{
-				break;
-			}
-
-			// Step over the "table" and the name
-			if ( !Q_stricmp( token, "table" ) )
-			{
-				token = COM_ParseExt2( &p, true );
-
-				if ( !*token )
-				{
-					break;
-				}
-			}
-
-			token = COM_ParseExt2( &p, true );
-
-			if ( token[ 0 ] != '{' || token[ 1 ] != '\0' || !SkipBracedSection_Depth( &p, 1 ) )
-			{
-				Log::Warn("Bad shader file %s has incorrect syntax.", filename );
-				ri.FS_FreeFile( buffers[ i ] );
-				buffers[ i ] = nullptr;
-				break;
-			}
-		}
-
-		if ( buffers[ i ] )
-		{
-			sum += summand;
-		}
-	}
-
-	// build single large buffer
-	s_shaderText = (char*) ri.Hunk_Alloc( sum + numShaderFiles * 2, ha_pref::h_low );
-	s_shaderText[ 0 ] = '\0';
-	textEnd = s_shaderText;
-
-	// free in reverse order, so the temp files are all dumped
-	for ( i = numShaderFiles - 1; i >= 0; i-- )
-	{
-		if ( !buffers[ i ] )
-		{
-			continue;
-		}
-
-		strcat( textEnd, buffers[ i ] );
-		strcat( textEnd, "\n" );
-		textEnd += strlen( textEnd );
-		ri.FS_FreeFile( buffers[ i ] );
+		shaderFiles.push_back( { shaderFileList[ i ], "", false } );
 	}
 
-	// ydnar: unixify all shaders
-	COM_FixPath( s_shaderText );
-
-	COM_Compress( s_shaderText );
-
 	// free up memory
-	ri.FS_FreeFileList( shaderFiles );
-
-	Com_Memset( shaderTextHashTableSizes, 0, sizeof( shaderTextHashTableSizes ) );
-	size = 0;
+	ri.FS_FreeFileList( shaderFileList );
 
-	p = s_shaderText;
+	unsigned checkSum = ShaderIndexChecksum();
 
-	// look for shader names
-	while ( 1 )
+	if ( checkSum && LoadShaderIndex( checkSum ) )
 	{
-		token = COM_ParseExt2( &p, true );
-
-		if ( token[ 0 ] == 0 )
-		{
-			break;
-		}
-
-		// skip shader tables
-		if ( !Q_stricmp( token, "table" ) )
-		{
-			// skip table name
-			token = COM_ParseExt2( &p, true );
+		Log::Debug("...using the shader index" );
+	}
+	else
+	{
+		BuildShaderIndex();
 
-			SkipBracedSection( &p );
-		}
-		else
+		if ( checkSum )
 		{
-			hash = generateHashValue( token, MAX_SHADERTEXT_HASH );
-			shaderTextHashTableSizes[ hash ]++;
-			size++;
-			SkipBracedSection( &p );
+			SaveShaderIndex( checkSum );
 		}
 	}
 
-	size += MAX_SHADERTEXT_HASH;
-
-	hashMem = (const char**) ri.Hunk_Alloc( size * sizeof( char * ), ha_pref::h_low );
-
-	for ( i = 0; i < MAX_SHADERTEXT_HASH; i++ )
+	// tables can be referenced by any shader, create them now
+	for ( const shaderTextEntry_t &entry : shaderTableEntries )
 	{
-		shaderTextHashTable[ i ] = hashMem;
-		hashMem += shaderTextHashTableSizes[ i ] + 1;
-	}
-
-	Com_Memset( shaderTextHashTableSizes, 0, sizeof( shaderTextHashTableSizes ) );
-
-	p = s_shaderText;
-
-	// look for shader names
-	while ( 1 )
-	{
-		oldp = p;
-		token = COM_ParseExt( &p, true );
-
-		if ( token[ 0 ] == 0 )
-		{
-			break;
-		}
+		const char *text = GetShaderFileText( entry.fileNum );
 
-		// parse shader tables
-		if ( !Q_stricmp( token, "table" ) )
+		if ( !text || entry.offset + entry.length > ( int ) shaderFiles[ entry.fileNum ].text.size() )
 		{
-			int           depth;
-			float         values[ FUNCTABLE_SIZE ];
-			int           numValues;
-			shaderTable_t *tb;
-			bool      alreadyCreated;
-
-			Com_Memset( &table, 0, sizeof( table ) );
-
-			token = COM_ParseExt2( &p, true );
-
-			Q_strncpyz( table.name, token, sizeof( table.name ) );
-
-			// check if already created
-			alreadyCreated = false;
-			hash = generateHashValue( table.name, MAX_SHADERTABLE_HASH );
-
-			for ( tb = shaderTableHashTable[ hash ]; tb; tb = tb->next )
-			{
-				if ( Q_stricmp( tb->name, table.name ) == 0 )
-				{
-					// match found
-					alreadyCreated = true;
-					break;
-				}
-			}
-
-			depth = 0;
-			numValues = 0;
-
-			do
-			{
-				token = COM_ParseExt2( &p, true );
-
-				if ( !Q_stricmp( token, "snap" ) )
-				{
-					table.snap = true;
-				}
-				else if ( !Q_stricmp( token, "clamp" ) )
-				{
-					table.clamp = true;
-				}
-				else if ( token[ 0 ] == '{' )
-				{
-					depth++;
-				}
-				else if ( token[ 0 ] == '}' )
-				{
-					depth--;
-				}
-				else if ( token[ 0 ] == ',' )
-				{
-					continue;
-				}
-				else
-				{
-					if ( numValues == FUNCTABLE_SIZE )
-					{
-						Log::Warn("FUNCTABLE_SIZE hit" );
-						break;
-					}
-
-					values[ numValues++ ] = atof( token );
-				}
-			}
-			while ( depth && p );
-
-			if ( !alreadyCreated )
-			{
-				Log::Debug("...generating '%s'", table.name );
-				GeneratePermanentShaderTable( values, numValues );
-			}
+			continue;
 		}
-		else
-		{
-			hash = generateHashValue( token, MAX_SHADERTEXT_HASH );
-			shaderTextHashTable[ hash ][ shaderTextHashTableSizes[ hash ]++ ] = oldp;
 
-			SkipBracedSection( &p );
-		}
+		const char *p = text + entry.offset;
+		ParseShaderTable( &p );
 	}
+
+	Log::Debug("%i shaders in %i files indexed in %i msec", shaderTextIndex.size(), shaderFiles.size(), ri.Milliseconds() - startTime );
 }
 
 /*
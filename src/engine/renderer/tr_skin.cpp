@@ -221,7 +221,7 @@ qhandle_t RE_RegisterSkin( const char *name )
 	}
 
 	tr.numSkins++;
-	skin = (skin_t*) ri.Hunk_Alloc( sizeof( skin_t ), ha_pref::h_low );
+	skin = (skin_t*) ri.Hunk_Alloc( sizeof( skin_t ), hunkTag_t::HT_MODELS );
 	tr.skins[ hSkin ] = skin;
 	Q_strncpyz( skin->name, name, sizeof( skin->name ) );
 	skin->numSurfaces = 0;
@@ -258,7 +258,7 @@ qhandle_t RE_RegisterSkin( const char *name )
 		if ( !Q_strnicmp( token, "md3_", 4 ) )
 		{
 			// this is specifying a model
-			model = skin->models[ skin->numModels ] = (skinModel_t*) ri.Hunk_Alloc( sizeof( *skin->models[ 0 ] ), ha_pref::h_low );
+			model = skin->models[ skin->numModels ] = (skinModel_t*) ri.Hunk_Alloc( sizeof( *skin->models[ 0 ] ), hunkTag_t::HT_MODELS );
 			Q_strncpyz( model->type, token, sizeof( model->type ) );
 			model->hash = Com_HashKey( model->type, sizeof( model->type ) );
 
@@ -274,7 +274,7 @@ qhandle_t RE_RegisterSkin( const char *name )
 		// parse the shader name
 		token = CommaParse( &text_p );
 
-		surf = skin->surfaces[ skin->numSurfaces ] = (skinSurface_t*) ri.Hunk_Alloc( sizeof( *skin->surfaces[ 0 ] ), ha_pref::h_low );
+		surf = skin->surfaces[ skin->numSurfaces ] = (skinSurface_t*) ri.Hunk_Alloc( sizeof( *skin->surfaces[ 0 ] ), hunkTag_t::HT_MODELS );
 		Q_strncpyz( surf->name, surfName, sizeof( surf->name ) );
 
 		// RB: bspSurface_t does not have ::hash yet
@@ -305,10 +305,10 @@ void R_InitSkins()
 	tr.numSkins = 1;
 
 	// make the default skin have all default shaders
-	skin = tr.skins[ 0 ] = (skin_t*) ri.Hunk_Alloc( sizeof( skin_t ), ha_pref::h_low );
+	skin = tr.skins[ 0 ] = (skin_t*) ri.Hunk_Alloc( sizeof( skin_t ), hunkTag_t::HT_MODELS );
 	Q_strncpyz( skin->name, "<default skin>", sizeof( skin->name ) );
 	skin->numSurfaces = 1;
-	skin->surfaces[ 0 ] = (skinSurface_t*) ri.Hunk_Alloc( sizeof( *skin->surfaces[ 0 ] ), ha_pref::h_low );
+	skin->surfaces[ 0 ] = (skinSurface_t*) ri.Hunk_Alloc( sizeof( *skin->surfaces[ 0 ] ), hunkTag_t::HT_MODELS );
 	skin->surfaces[ 0 ]->shader = tr.defaultShader;
 }
 
@@ -156,6 +156,21 @@ ALIGNED(16, struct refSkeleton_t
 	refBone_t         bones[ MAX_BONES ];
 });
 
+// one skeleton of a BuildSkeletons batch: the lerp between two frames of
+// an animation, optionally blended with the lerp of a second animation
+struct refSkeletonJob_t
+{
+	qhandle_t anim;
+	int       startFrame, endFrame;
+	float     frac;
+	bool      clearOrigin;
+
+	qhandle_t blendAnim; // 0 for none
+	int       blendStartFrame, blendEndFrame;
+	float     blendFrac;
+	float     blendWeight; // frac of the blend skeleton
+};
+
 // XreaL END
 
 struct refEntity_t
@@ -522,7 +522,7 @@ VBO_t *R_CreateDynamicVBO( const char *name, int numVertexes, uint32_t stateBits
 	// make sure the render thread is stopped
 	R_SyncRenderThread();
 
-	vbo = (VBO_t*) ri.Hunk_Alloc( sizeof( *vbo ), ha_pref::h_low );
+	vbo = (VBO_t*) ri.Hunk_Alloc( sizeof( *vbo ), hunkTag_t::HT_RENDERER );
 	memset( vbo, 0, sizeof( *vbo ) );
 
 	Com_AddToGrowList( &tr.vbos, vbo );
@@ -576,7 +576,7 @@ VBO_t *R_CreateStaticVBO( const char *name, vboData_t data, vboLayout_t layout )
 	// make sure the render thread is stopped
 	R_SyncRenderThread();
 
-	vbo = (VBO_t*) ri.Hunk_Alloc( sizeof( *vbo ), ha_pref::h_low );
+	vbo = (VBO_t*) ri.Hunk_Alloc( sizeof( *vbo ), hunkTag_t::HT_RENDERER );
 	memset( vbo, 0, sizeof( *vbo ) );
 
 	Com_AddToGrowList( &tr.vbos, vbo );
@@ -639,7 +639,7 @@ VBO_t *R_CreateStaticVBO2( const char *name, int numVertexes, shaderVertex_t *ve
 	// make sure the render thread is stopped
 	R_SyncRenderThread();
 
-	vbo = ( VBO_t * ) ri.Hunk_Alloc( sizeof( *vbo ), ha_pref::h_low );
+	vbo = ( VBO_t * ) ri.Hunk_Alloc( sizeof( *vbo ), hunkTag_t::HT_RENDERER );
 	memset( vbo, 0, sizeof( *vbo ) );
 
 	Com_AddToGrowList( &tr.vbos, vbo );
@@ -692,7 +692,7 @@ IBO_t *R_CreateDynamicIBO( const char *name, int numIndexes )
 	// make sure the render thread is stopped
 	R_SyncRenderThread();
 
-	ibo = (IBO_t*) ri.Hunk_Alloc( sizeof( *ibo ), ha_pref::h_low );
+	ibo = (IBO_t*) ri.Hunk_Alloc( sizeof( *ibo ), hunkTag_t::HT_RENDERER );
 	Com_AddToGrowList( &tr.ibos, ibo );
 
 	Q_strncpyz( ibo->name, name, sizeof( ibo->name ) );
@@ -742,7 +742,7 @@ IBO_t *R_CreateStaticIBO( const char *name, glIndex_t *indexes, int numIndexes )
 	// make sure the render thread is stopped
 	R_SyncRenderThread();
 
-	ibo = ( IBO_t * ) ri.Hunk_Alloc( sizeof( *ibo ), ha_pref::h_low );
+	ibo = ( IBO_t * ) ri.Hunk_Alloc( sizeof( *ibo ), hunkTag_t::HT_RENDERER );
 	Com_AddToGrowList( &tr.ibos, ibo );
 
 	Q_strncpyz( ibo->name, name, sizeof( ibo->name ) );
@@ -786,7 +786,7 @@ IBO_t *R_CreateStaticIBO2( const char *name, int numTriangles, glIndex_t *indexe
 	// make sure the render thread is stopped
 	R_SyncRenderThread();
 
-	ibo = ( IBO_t * ) ri.Hunk_Alloc( sizeof( *ibo ), ha_pref::h_low );
+	ibo = ( IBO_t * ) ri.Hunk_Alloc( sizeof( *ibo ), hunkTag_t::HT_RENDERER );
 	Com_AddToGrowList( &tr.ibos, ibo );
 
 	Q_strncpyz( ibo->name, name, sizeof( ibo->name ) );
@@ -33,9 +33,11 @@ Tries to back face cull surfaces before they are lighted or
 added to the sorting list.
 
 This will also allow mirrors on both sides of a model without recursion.
+boxCull may point to the result of culling the surface bounds if it
+has already been computed with R_CullBoxes.
 ================
 */
-static bool R_CullSurface( surfaceType_t *surface, shader_t *shader, int planeBits )
+static bool R_CullSurface( surfaceType_t *surface, shader_t *shader, int planeBits, const cullResult_t *boxCull )
 {
 	srfGeneric_t *gen;
 	float        d;
@@ -93,7 +95,11 @@ static bool R_CullSurface( surfaceType_t *surface, shader_t *shader, int planeBi
 	{
 		cullResult_t cull;
 
-		if ( tr.currentEntity != &tr.worldEntity )
+		if ( boxCull )
+		{
+			cull = *boxCull;
+		}
+		else if ( tr.currentEntity != &tr.worldEntity )
 		{
 			cull = R_CullLocalBox( gen->bounds );
 		}
@@ -260,19 +266,11 @@ static void R_AddInteractionSurface( bspSurface_t *surf, trRefLight_t *light, in
 
 static void R_AddDecalSurface( bspSurface_t *surf, int decalBits )
 {
-	int i;
-
 	// add decals
 	if ( decalBits )
 	{
-		// ydnar: project any decals
-		for ( i = 0; i < tr.refdef.numDecalProjectors; i++ )
-		{
-			if ( decalBits & ( 1 << i ) )
-			{
-				R_ProjectDecalOntoSurface( &tr.refdef.decalProjectors[ i ], surf, &tr.world->models[ 0 ] );
-			}
-		}
+		// ydnar: project any decals, done by R_ProjectQueuedDecals
+		R_QueueDecalSurface( surf, decalBits );
 	}
 }
 
@@ -281,7 +279,7 @@ static void R_AddDecalSurface( bspSurface_t *surf, int decalBits )
 R_AddWorldSurface
 ======================
 */
-static bool R_AddWorldSurface( bspSurface_t *surf, int fogIndex, int planeBits )
+static bool R_AddWorldSurface( bspSurface_t *surf, int fogIndex, int planeBits, const cullResult_t *boxCull = nullptr )
 {
 	if ( surf->viewCount == tr.viewCountNoReset )
 	{
@@ -291,7 +289,7 @@ static bool R_AddWorldSurface( bspSurface_t *surf, int fogIndex, int planeBits )
 	surf->viewCount = tr.viewCountNoReset;
 
 	// try to cull before lighting or adding
-	if ( R_CullSurface( surf->data, surf->shader, planeBits ) )
+	if ( R_CullSurface( surf->data, surf->shader, planeBits, boxCull ) )
 	{
 		return true;
 	}
@@ -366,9 +364,11 @@ void R_AddBSPModelSurfaces( trRefEntity_t *ent )
 
 static void R_AddLeafSurfaces( bspNode_t *node, int decalBits, int planeBits )
 {
+	static std::vector<cullResult_t> boxCulls;
 	int          c;
 	bspSurface_t **mark;
 	bspSurface_t **view;
+	const cullResult_t *boxCull = nullptr;
 
 	tr.pc.c_leafs++;
 
@@ -408,11 +408,19 @@ static void R_AddLeafSurfaces( bspNode_t *node, int decalBits, int planeBits )
 	c = node->numMarkSurfaces;
 	view = tr.world->viewSurfaces + node->firstMarkSurface;
 
+	// cull the bounds of all the surfaces of the leaf in one batch
+	if ( planeBits && !r_nocull->integer && tr.currentEntity == &tr.worldEntity && tr.world->viewSurfaceBounds.mins[ 0 ] )
+	{
+		boxCulls.resize( std::max<size_t>( boxCulls.size(), c ) );
+		R_CullBoxes( &tr.world->viewSurfaceBounds, node->firstMarkSurface, c, boxCulls.data() );
+		boxCull = boxCulls.data();
+	}
+
 	while ( c-- )
 	{
 		// the surface may have already been added if it
 		// spans multiple leafs
-		if ( R_AddWorldSurface( *view, ( *view )->fogIndex, planeBits ) )
+		if ( R_AddWorldSurface( *view, ( *view )->fogIndex, planeBits, boxCull ) )
 		{
 			R_AddDecalSurface( *mark, decalBits );
 		}
@@ -421,6 +429,11 @@ static void R_AddLeafSurfaces( bspNode_t *node, int decalBits, int planeBits )
 
 		mark++;
 		view++;
+
+		if ( boxCull )
+		{
+			boxCull++;
+		}
 	}
 }
 
@@ -447,28 +460,17 @@ static void R_RecursiveWorldNode( bspNode_t *node, int planeBits, int decalBits
 
 		// if the bounding volume is outside the frustum, nothing
 		// inside can be visible
-		if ( !r_nocull->integer )
+		if ( !r_nocull->integer && planeBits )
 		{
-			int i;
-			int r;
+			int backBits;
+			int frontBits = R_BoxPlaneSides( node->mins, node->maxs, &backBits );
 
-			for ( i = 0; i < FRUSTUM_PLANES; i++ )
+			if ( backBits & planeBits )
 			{
-				if ( planeBits & ( 1 << i ) )
-				{
-					r = BoxOnPlaneSide( node->mins, node->maxs, &tr.viewParms.frustums[ 0 ][ i ] );
-
-					if ( r == 2 )
-					{
-						return; // culled
-					}
-
-					if ( r == 1 )
-					{
-						planeBits &= ~( 1 << i );  // all descendants will also be in front
-					}
-				}
+				return; // culled
 			}
+
+			planeBits &= ~frontBits;  // all descendants will also be in front
 		}
 
 		backEndData[ tr.smpFrame ]->traversalList[ backEndData[ tr.smpFrame ]->traversalLength++ ] = node;
@@ -523,7 +525,6 @@ R_RecursiveInteractionNode
 */
 static void R_RecursiveInteractionNode( bspNode_t *node, trRefLight_t *light, int planeBits, int interactionBits )
 {
-	int i;
 	int r;
 
 	do
@@ -540,27 +541,18 @@ static void R_RecursiveInteractionNode( bspNode_t *node, trRefLight_t *light, in
 
 		// Tr3B - even surfaces that belong to nodes that are outside of the view frustum
 		// can cast shadows into the view frustum
-		if ( !r_nocull->integer )
+		if ( !r_nocull->integer && planeBits )
 		{
-			for ( i = 0; i < FRUSTUM_PLANES; i++ )
-			{
-				if ( planeBits & ( 1 << i ) )
-				{
-					r = BoxOnPlaneSide( node->mins, node->maxs, &tr.viewParms.frustums[ 0 ][ i ] );
+			int backBits;
+			int frontBits = R_BoxPlaneSides( node->mins, node->maxs, &backBits );
 
-					if ( r == 2 )
-					{
-						// this node cannot be lighted, but may cast shadows
-						interactionBits &= ~IA_LIGHT;
-						break;
-					}
-
-					if ( r == 1 )
-					{
-						planeBits &= ~( 1 << i );  // all descendants will also be in front
-					}
-				}
+			if ( backBits & planeBits )
+			{
+				// this node cannot be lighted, but may cast shadows
+				interactionBits &= ~IA_LIGHT;
 			}
+
+			planeBits &= ~frontBits;  // all descendants will also be in front
 		}
 
 		// don't waste time on nodes with no interactions
@@ -914,6 +906,7 @@ void R_AddWorldSurfaces()
 		R_RecursiveWorldNode( tr.world->nodes, FRUSTUM_CLIPALL, tr.refdef.decalBits );
 
 		// ydnar: add decal surfaces
+		R_ProjectQueuedDecals( tr.world->models );
 		R_AddDecalSurfaces( tr.world->models );
 	}
 }
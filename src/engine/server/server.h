@@ -135,12 +135,13 @@ enum class clientState_t
   CS_ACTIVE // client is fully in game
 };
 
+// number of messages a client can have waiting behind a fragmented one
+#define NETCHAN_QUEUE_SLOTS 8
+
 struct netchan_buffer_t
 {
-	msg_t                   msg;
-	byte                    msgBuffer[ MAX_MSGLEN ];
-	char                    lastClientCommandString[ MAX_STRING_CHARS ];
-	netchan_buffer_t *next;
+	int                     cursize;
+	byte                    data[ MAX_MSGLEN ];
 };
 
 struct client_t
@@ -172,13 +173,22 @@ struct client_t
 	FS::File*     download; // file being downloaded
 	int           downloadSize; // total bytes (can't use EOF because of paks)
 	int           downloadCount; // bytes sent
-	int           downloadClientBlock; // last block we sent to the client, awaiting ack
+	int           downloadClientBlock; // first block the client hasn't acknowledged
 	int           downloadCurrentBlock; // current block number
-	int           downloadXmitBlock; // last block we xmited
 	unsigned char *downloadBlocks[ MAX_DOWNLOAD_WINDOW ]; // the buffers for the download blocks
 	int           downloadBlockSize[ MAX_DOWNLOAD_WINDOW ];
+	int           downloadBlockSentTime[ MAX_DOWNLOAD_WINDOW ];
+	int           downloadBlockSends[ MAX_DOWNLOAD_WINDOW ]; // times the block was sent
+	bool          downloadBlockAcked[ MAX_DOWNLOAD_WINDOW ]; // acknowledged, possibly out of order
+	bool          downloadSelectiveAck; // the client sent an acknowledgement bitmap
+	int           downloadStartTime;
+	int           downloadResent; // blocks sent more than once
 	bool      downloadEOF; // We have sent the EOF block
-	int           downloadSendTime; // time we last got an ack from the client
+	float         downloadCwnd; // blocks that may be in flight
+	int           downloadSsthresh;
+	int           downloadRecover; // no more window cuts until this block is acknowledged
+	int           downloadSrtt; // smoothed round trip time of the blocks, 0 until measured
+	int           downloadRttVar;
 
 	// www downloading
 	char     downloadURL[ MAX_OSPATH ]; // the URL we redirected the client to
@@ -203,9 +213,9 @@ struct client_t
 	// queuing outgoing fragmented messages to send them properly, without udp packet bursts
 	// in case large fragmented messages are stacking up
 	// buffer them into this queue, and hand them out to netchan as needed
-	netchan_buffer_t *netchan_start_queue;
-	//% netchan_buffer_t **netchan_end_queue;
-	netchan_buffer_t *netchan_end_queue;
+	netchan_buffer_t *netchan_queue; // [ NETCHAN_QUEUE_SLOTS ], allocated on first use
+	int              netchan_queueHead;
+	int              netchan_queueCount;
 
 	char             pubkey[ RSA_STRING_LENGTH ];
 
@@ -340,6 +350,7 @@ extern cvar_t *sv_wwwFallbackURL;
 
 //bani
 extern cvar_t *sv_packetdelay;
+extern cvar_t *sv_packetloss;
 
 //fretn
 extern cvar_t *sv_fullmsg;
@@ -452,6 +463,20 @@ void     SV_Netchan_TransmitNextFragment( client_t *client );
 bool SV_Netchan_Process( client_t *client, msg_t *msg );
 void     SV_Netchan_FreeQueue( client_t *client );
 
+//
+// sv_http.cpp
+//
+void        SV_HttpUpdate();
+void        SV_HttpShutdown();
+std::string SV_HttpBaseURL();
+
+//
+// sv_bench.cpp
+//
+void SV_NetCaptureFrame( const client_t *client );
+void SV_StopNetCapture();
+bool SV_LoopbackInUse();
+
 //bani - cl->downloadnotify
 #define DLNOTIFY_REDIRECT 0x00000001 // "Redirecting client ..."
 #define DLNOTIFY_BEGIN    0x00000002 // "clientDownload: 4 : beginning ..."
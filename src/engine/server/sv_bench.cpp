@@ -0,0 +1,781 @@
+/*
+===========================================================================
+
+Daemon GPL Source Code
+Copyright (C) 2024 Daemon Developers
+
+This file is part of the Daemon GPL Source Code (Daemon Source Code).
+
+Daemon Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Daemon Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Daemon Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+===========================================================================
+*/
+// sv_bench.cpp -- recording snapshot streams and replaying them through the wire code
+#include <common/FileSystem.h>
+#include "server.h"
+
+#include <random>
+
+/*
+============================================================================
+
+SNAPSHOT CAPTURE
+
+netcapture writes the player state and the entities of every snapshot
+built for one client to a file in the homepath. netbench replays such a
+file, or a synthetic stream, through the delta encoding, the message
+huffman coding and a loopback netchan, and reports how fast each of
+them goes. Nothing is sent over a socket.
+
+============================================================================
+*/
+
+static const char netCaptureDir[] = "benchmark/";
+static const char netCaptureMagic[ 4 ] = { 'D', 'N', 'E', 'T' };
+static const int  netCaptureVersion = 1;
+
+// the structures are stored as they are in memory, so a file only
+// works with builds that agree on their layout
+struct netCaptureHeader_t
+{
+	char magic[ 4 ];
+	int  version;
+	int  playerStateSize;
+	int  entitySize;
+};
+
+struct netFrame_t
+{
+	playerState_t              ps;
+	std::vector<entityState_t> entities; // in increasing number order
+};
+
+static FS::File netCaptureFile;
+static int      netCaptureClient;
+static int      netCaptureFrames;
+
+/*
+===============
+SV_StopNetCapture
+===============
+*/
+void SV_StopNetCapture()
+{
+	if ( !netCaptureFile )
+	{
+		return;
+	}
+
+	std::error_code err;
+	netCaptureFile.Close( err );
+
+	if ( err )
+	{
+		Log::Warn( "Couldn't finish the snapshot capture: %s", err.message() );
+	}
+	else
+	{
+		Log::Notice( "captured %i snapshots", netCaptureFrames );
+	}
+}
+
+/*
+===============
+SV_NetCaptureFrame
+
+Called with every snapshot built, records it when it is for the client
+being captured
+===============
+*/
+void SV_NetCaptureFrame( const client_t *client )
+{
+	if ( !netCaptureFile || client - svs.clients != netCaptureClient )
+	{
+		return;
+	}
+
+	const clientSnapshot_t *frame = &client->frames[ client->netchan.outgoingSequence & PACKET_MASK ];
+
+	try
+	{
+		netCaptureFile.Write( &frame->ps, sizeof( frame->ps ) );
+		netCaptureFile.Write( &frame->num_entities, sizeof( frame->num_entities ) );
+
+		for ( int i = 0; i < frame->num_entities; i++ )
+		{
+			const entityState_t *ent = &svs.snapshotEntities[ ( frame->first_entity + i ) % svs.numSnapshotEntities ];
+
+			netCaptureFile.Write( ent, sizeof( *ent ) );
+		}
+
+		netCaptureFrames++;
+	}
+	catch ( std::system_error &err )
+	{
+		Log::Warn( "Snapshot capture failed: %s", err.what() );
+		SV_StopNetCapture();
+	}
+}
+
+class NetCaptureCmd: public Cmd::StaticCmd
+{
+public:
+	NetCaptureCmd():
+		StaticCmd("netcapture", Cmd::SYSTEM, "Records the snapshots sent to a client for netbench")
+	{}
+
+	void Run(const Cmd::Args& args) const OVERRIDE
+	{
+		if ( args.Argc() < 2 )
+		{
+			if ( netCaptureFile )
+			{
+				SV_StopNetCapture();
+			}
+			else
+			{
+				PrintUsage( args, "<name> [client]", "run it again without a name to stop" );
+			}
+
+			return;
+		}
+
+		if ( !com_sv_running->integer )
+		{
+			Print( "Server is not running." );
+			return;
+		}
+
+		int clientNum = 0;
+
+		if ( args.Argc() > 2 && !Str::ParseInt( clientNum, args.Argv( 2 ) ) )
+		{
+			PrintUsage( args, "<name> [client]", "" );
+			return;
+		}
+
+		if ( clientNum < 0 || clientNum >= sv_maxclients->integer
+		     || svs.clients[ clientNum ].state != clientState_t::CS_ACTIVE )
+		{
+			Print( "Client %d is not active.", clientNum );
+			return;
+		}
+
+		SV_StopNetCapture();
+
+		std::string path = Str::Format( "%s%s.snapshots", netCaptureDir, args.Argv( 1 ) );
+		netCaptureHeader_t header = {};
+
+		memcpy( header.magic, netCaptureMagic, sizeof( netCaptureMagic ) );
+		header.version = netCaptureVersion;
+		header.playerStateSize = sizeof( playerState_t );
+		header.entitySize = sizeof( entityState_t );
+
+		try
+		{
+			netCaptureFile = FS::HomePath::OpenWrite( path );
+			netCaptureFile.Write( &header, sizeof( header ) );
+		}
+		catch ( std::system_error &err )
+		{
+			Print( "Couldn't start the snapshot capture: %s", err.what() );
+			netCaptureFile = FS::File();
+			return;
+		}
+
+		netCaptureClient = clientNum;
+		netCaptureFrames = 0;
+		Print( "capturing the snapshots of client %d to %s", clientNum, path );
+	}
+};
+static NetCaptureCmd NetCaptureCmdRegistration;
+
+/*
+============================================================================
+
+SNAPSHOT BENCHMARK
+
+============================================================================
+*/
+
+static bool SV_LoadNetCapture( const std::string &name, std::vector<netFrame_t> &frames )
+{
+	std::string path = Str::Format( "%s%s.snapshots", netCaptureDir, name );
+	std::string data;
+	std::error_code err;
+
+	FS::File file = FS::HomePath::OpenRead( path, err );
+
+	if ( !err )
+	{
+		data = file.ReadAll( err );
+	}
+
+	if ( err )
+	{
+		Log::Warn( "Couldn't read %s: %s", path, err.message() );
+		return false;
+	}
+
+	const char *p = data.data();
+	const char *end = data.data() + data.size();
+	netCaptureHeader_t header;
+
+	auto read = [ &p, end ]( void *out, size_t size )
+	{
+		if ( static_cast<size_t>( end - p ) < size )
+		{
+			return false;
+		}
+
+		memcpy( out, p, size );
+		p += size;
+		return true;
+	};
+
+	if ( !read( &header, sizeof( header ) ) || memcmp( header.magic, netCaptureMagic, sizeof( netCaptureMagic ) )
+	     || header.version != netCaptureVersion )
+	{
+		Log::Warn( "%s is not a snapshot capture", path );
+		return false;
+	}
+
+	if ( header.playerStateSize != sizeof( playerState_t ) || header.entitySize != sizeof( entityState_t ) )
+	{
+		Log::Warn( "%s was captured by an incompatible build", path );
+		return false;
+	}
+
+	while ( p != end )
+	{
+		netFrame_t frame;
+		int numEntities;
+
+		if ( !read( &frame.ps, sizeof( frame.ps ) ) || !read( &numEntities, sizeof( numEntities ) )
+		     || numEntities < 0 || numEntities >= MAX_GENTITIES )
+		{
+			Log::Warn( "%s is truncated", path );
+			return false;
+		}
+
+		frame.entities.resize( numEntities );
+
+		if ( !read( frame.entities.data(), numEntities * sizeof( entityState_t ) ) )
+		{
+			Log::Warn( "%s is truncated", path );
+			return false;
+		}
+
+		frames.push_back( std::move( frame ) );
+	}
+
+	return true;
+}
+
+/*
+===============
+SV_SyntheticNetFrames
+
+Players and missiles moving around among idle entities, with one entity
+going away and coming back every few frames. Always the same stream for
+the same arguments.
+===============
+*/
+static void SV_SyntheticNetFrames( int numEntities, int numFrames, std::vector<netFrame_t> &frames )
+{
+	std::mt19937 rng( 1 );
+	std::uniform_real_distribution<float> coord( -2048.0f, 2048.0f );
+	std::uniform_real_distribution<float> speed( -320.0f, 320.0f );
+	std::vector<entityState_t> entities( numEntities );
+
+	for ( int i = 0; i < numEntities; i++ )
+	{
+		entityState_t *ent = &entities[ i ];
+
+		memset( ent, 0, sizeof( *ent ) );
+		ent->number = MAX_CLIENTS + i;
+		ent->eType = i % 4 ? entityType_t::ET_GENERAL : entityType_t::ET_PLAYER;
+		ent->modelindex = 1 + i % 32;
+		ent->solid = 0x181810;
+		VectorSet( ent->pos.trBase, coord( rng ), coord( rng ), coord( rng ) / 4 );
+		VectorCopy( ent->pos.trBase, ent->origin );
+
+		// every fourth entity moves
+		if ( !( i % 4 ) )
+		{
+			ent->pos.trType = trType_t::TR_LINEAR;
+			VectorSet( ent->pos.trDelta, speed( rng ), speed( rng ), 0 );
+			ent->legsAnim = 1;
+			ent->torsoAnim = 2;
+			ent->weapon = 1 + i % 8;
+		}
+	}
+
+	frames.resize( numFrames );
+
+	for ( int f = 0; f < numFrames; f++ )
+	{
+		netFrame_t *frame = &frames[ f ];
+		int time = f * 50;
+		int missing = ( f / 20 ) % numEntities;
+
+		memset( &frame->ps, 0, sizeof( frame->ps ) );
+		frame->ps.commandTime = time;
+		frame->ps.clientNum = 0;
+		frame->ps.weapon = 1;
+		frame->ps.eventSequence = f / 10;
+		VectorSet( frame->ps.origin, 100.0f + f * 16.0f, 200.0f, 24.0f );
+		VectorSet( frame->ps.velocity, 320.0f, 0.0f, f % 8 ? 0.0f : 270.0f );
+		VectorSet( frame->ps.viewangles, 0.0f, ( f * 7 ) % 360, 0.0f );
+
+		frame->entities.clear();
+
+		for ( int i = 0; i < numEntities; i++ )
+		{
+			entityState_t *ent = &entities[ i ];
+
+			if ( ent->pos.trType == trType_t::TR_LINEAR )
+			{
+				VectorMA( ent->pos.trBase, 0.05f, ent->pos.trDelta, ent->pos.trBase );
+				VectorCopy( ent->pos.trBase, ent->origin );
+				ent->pos.trTime = time;
+				ent->apos.trBase[ YAW ] = ( f * 11 + i ) % 360;
+				ent->legsAnim = 1 + ( f / 16 ) % 4;
+			}
+
+			if ( i != missing || ( f % 20 ) >= 10 )
+			{
+				frame->entities.push_back( *ent );
+			}
+		}
+	}
+}
+
+/*
+===============
+SV_BenchWriteFrame
+
+Writes a frame the way SV_WriteSnapshotToClient does, delta compressed
+against the previous one when there is one
+===============
+*/
+static void SV_BenchWriteFrame( msg_t *msg, netFrame_t *from, netFrame_t *to, int64_t *entityBits )
+{
+	static entityState_t baseline;
+	size_t numOld = from ? from->entities.size() : 0;
+	size_t oldIndex = 0, newIndex = 0;
+
+	MSG_WriteDeltaPlayerstate( msg, from ? &from->ps : nullptr, &to->ps );
+
+	int startBit = msg->bit;
+
+	while ( oldIndex < numOld || newIndex < to->entities.size() )
+	{
+		entityState_t *oldent = oldIndex < numOld ? &from->entities[ oldIndex ] : nullptr;
+		entityState_t *newent = newIndex < to->entities.size() ? &to->entities[ newIndex ] : nullptr;
+		int oldnum = oldent ? oldent->number : MAX_GENTITIES;
+		int newnum = newent ? newent->number : MAX_GENTITIES;
+
+		if ( newnum == oldnum )
+		{
+			MSG_WriteDeltaEntity( msg, oldent, newent, false );
+			oldIndex++;
+			newIndex++;
+		}
+		else if ( newnum < oldnum )
+		{
+			MSG_WriteDeltaEntity( msg, &baseline, newent, true );
+			newIndex++;
+		}
+		else
+		{
+			MSG_WriteDeltaEntity( msg, oldent, nullptr, true );
+			oldIndex++;
+		}
+	}
+
+	MSG_WriteBits( msg, MAX_GENTITIES - 1, GENTITYNUM_BITS );
+
+	*entityBits += msg->bit - startBit;
+}
+
+/*
+===============
+SV_BenchReadFrame
+
+Reads a frame the way the client parses snapshots, entities the message
+doesn't mention stay as they were
+===============
+*/
+static bool SV_BenchReadFrame( msg_t *msg, netFrame_t *from, netFrame_t *to )
+{
+	static const entityState_t baseline{};
+	size_t numOld = from ? from->entities.size() : 0;
+	size_t oldIndex = 0;
+
+	MSG_ReadDeltaPlayerstate( msg, from ? &from->ps : nullptr, &to->ps );
+
+	to->entities.clear();
+
+	while ( true )
+	{
+		int newnum = MSG_ReadBits( msg, GENTITYNUM_BITS );
+
+		if ( msg->readcount > msg->cursize )
+		{
+			return false;
+		}
+
+		if ( newnum == MAX_GENTITIES - 1 )
+		{
+			break;
+		}
+
+		while ( oldIndex < numOld && from->entities[ oldIndex ].number < newnum )
+		{
+			to->entities.push_back( from->entities[ oldIndex++ ] );
+		}
+
+		entityState_t state;
+
+		if ( oldIndex < numOld && from->entities[ oldIndex ].number == newnum )
+		{
+			MSG_ReadDeltaEntity( msg, &from->entities[ oldIndex++ ], &state, newnum );
+		}
+		else
+		{
+			MSG_ReadDeltaEntity( msg, &baseline, &state, newnum );
+		}
+
+		if ( state.number != MAX_GENTITIES - 1 )
+		{
+			to->entities.push_back( state );
+		}
+	}
+
+	while ( oldIndex < numOld )
+	{
+		to->entities.push_back( from->entities[ oldIndex++ ] );
+	}
+
+	return true;
+}
+
+/*
+===============
+SV_LoopbackInUse
+
+The netchan stage goes through the loopback buffers, it would eat the
+packets of a local client
+===============
+*/
+bool SV_LoopbackInUse()
+{
+	if ( !com_sv_running->integer )
+	{
+		return false;
+	}
+
+	for ( int i = 0; i < sv_maxclients->integer; i++ )
+	{
+		const client_t &cl = svs.clients[ i ];
+
+		if ( cl.state != clientState_t::CS_FREE && cl.netchan.remoteAddress.type == netadrtype_t::NA_LOOPBACK )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static double SV_MBytesPerSecond( int64_t bytes, Sys::SteadyClock::duration time )
+{
+	double seconds = std::chrono::duration<double>( time ).count();
+
+	return seconds > 0 ? bytes / seconds / ( 1024 * 1024 ) : 0;
+}
+
+class NetBenchCmd: public Cmd::StaticCmd
+{
+public:
+	NetBenchCmd():
+		StaticCmd("netbench", Cmd::SYSTEM, "Measures the snapshot encoding, huffman and netchan throughput")
+	{}
+
+	void Run(const Cmd::Args& args) const OVERRIDE
+	{
+		std::vector<netFrame_t> frames;
+		int numRuns = 10;
+
+		if ( args.Argc() < 2 )
+		{
+			PrintUsage( args, "<capture name> [runs] | synthetic [entities] [frames] [runs]", "" );
+			return;
+		}
+
+		if ( args.Argv( 1 ) == "synthetic" )
+		{
+			int numEntities = 128, numFrames = 200;
+
+			if ( args.Argc() > 2 )
+			{
+				numEntities = Math::Clamp( atoi( args.Argv( 2 ).c_str() ), 1, 512 );
+			}
+
+			if ( args.Argc() > 3 )
+			{
+				numFrames = Math::Clamp( atoi( args.Argv( 3 ).c_str() ), 1, 10000 );
+			}
+
+			if ( args.Argc() > 4 )
+			{
+				numRuns = Math::Clamp( atoi( args.Argv( 4 ).c_str() ), 1, 1000 );
+			}
+
+			SV_SyntheticNetFrames( numEntities, numFrames, frames );
+		}
+		else
+		{
+			if ( args.Argc() > 2 )
+			{
+				numRuns = Math::Clamp( atoi( args.Argv( 2 ).c_str() ), 1, 1000 );
+			}
+
+			if ( !SV_LoadNetCapture( args.Argv( 1 ), frames ) )
+			{
+				return;
+			}
+		}
+
+		if ( frames.empty() )
+		{
+			Print( "netbench: no frames to replay" );
+			return;
+		}
+
+		int numFrames = frames.size();
+		std::vector<std::vector<byte>> encoded( numFrames );
+		std::vector<netFrame_t> decoded( 2 );
+		std::vector<byte> scratch( 2 * MAX_MSGLEN );
+		int64_t streamBytes = 0, totalEntities = 0;
+		int64_t entityBits = 0;
+		int mismatches = 0;
+		Sys::SteadyClock::duration encodeTime{}, decodeTime{}, compressTime{}, decompressTime{};
+		int64_t compressedBytes = 0;
+
+		for ( netFrame_t &frame : frames )
+		{
+			totalEntities += frame.entities.size();
+		}
+
+		for ( netFrame_t &frame : decoded )
+		{
+			frame.entities.reserve( MAX_GENTITIES );
+		}
+
+		// delta encoding, the first run also keeps the messages
+		for ( int run = 0; run < numRuns; run++ )
+		{
+			for ( int f = 0; f < numFrames; f++ )
+			{
+				msg_t msg;
+
+				MSG_Init( &msg, scratch.data(), MAX_MSGLEN );
+				msg.allowoverflow = true;
+
+				Sys::SteadyClock::time_point start = Sys::SteadyClock::now();
+				SV_BenchWriteFrame( &msg, f ? &frames[ f - 1 ] : nullptr, &frames[ f ], &entityBits );
+				encodeTime += Sys::SteadyClock::now() - start;
+
+				if ( msg.overflowed )
+				{
+					Print( "netbench: frame %d doesn't fit in a message", f );
+					return;
+				}
+
+				if ( !run )
+				{
+					encoded[ f ].assign( msg.data, msg.data + msg.cursize );
+					streamBytes += msg.cursize;
+				}
+			}
+		}
+
+		// decoding, checked against the source on the first run
+		for ( int run = 0; run < numRuns; run++ )
+		{
+			for ( int f = 0; f < numFrames; f++ )
+			{
+				msg_t msg;
+
+				MSG_Init( &msg, encoded[ f ].data(), encoded[ f ].size() );
+				msg.cursize = encoded[ f ].size();
+				MSG_BeginReading( &msg );
+
+				netFrame_t *to = &decoded[ f & 1 ];
+
+				Sys::SteadyClock::time_point start = Sys::SteadyClock::now();
+				bool ok = SV_BenchReadFrame( &msg, f ? &decoded[ ( f - 1 ) & 1 ] : nullptr, to );
+				decodeTime += Sys::SteadyClock::now() - start;
+
+				if ( !ok )
+				{
+					Print( "netbench: frame %d read past its end", f );
+					return;
+				}
+
+				if ( !run )
+				{
+					const std::vector<entityState_t> &source = frames[ f ].entities;
+
+					if ( to->entities.size() != source.size() )
+					{
+						mismatches += std::abs( int( to->entities.size() ) - int( source.size() ) );
+					}
+
+					for ( size_t i = 0; i < std::min( source.size(), to->entities.size() ); i++ )
+					{
+						mismatches += memcmp( &source[ i ], &to->entities[ i ], sizeof( entityState_t ) ) != 0;
+					}
+				}
+			}
+		}
+
+		// the huffman coding of connectionless packets, on the same bytes
+		for ( int run = 0; run < numRuns; run++ )
+		{
+			for ( int f = 0; f < numFrames; f++ )
+			{
+				msg_t msg;
+
+				MSG_InitOOB( &msg, scratch.data(), scratch.size() );
+				memcpy( msg.data, encoded[ f ].data(), encoded[ f ].size() );
+				msg.cursize = encoded[ f ].size();
+
+				Sys::SteadyClock::time_point start = Sys::SteadyClock::now();
+				Huff_Compress( &msg, 0 );
+				Sys::SteadyClock::time_point middle = Sys::SteadyClock::now();
+				int compressed = msg.cursize;
+				Huff_Decompress( &msg, 0 );
+				Sys::SteadyClock::time_point end = Sys::SteadyClock::now();
+
+				compressTime += middle - start;
+				decompressTime += end - middle;
+
+				if ( !run )
+				{
+					compressedBytes += compressed;
+
+					if ( msg.cursize != int( encoded[ f ].size() ) || memcmp( msg.data, encoded[ f ].data(), msg.cursize ) )
+					{
+						mismatches++;
+					}
+				}
+			}
+		}
+
+		double frameBytes = double( streamBytes ) / numFrames;
+
+		Print( "%d frames, %.1f entities and %.0f bytes per frame, %d runs",
+		       numFrames, double( totalEntities ) / numFrames, frameBytes, numRuns );
+		Print( "delta encode:     %8.2f MB/s, %.1f bits per entity",
+		       SV_MBytesPerSecond( streamBytes * numRuns, encodeTime ),
+		       totalEntities ? double( entityBits ) / numRuns / totalEntities : 0.0 );
+		Print( "delta decode:     %8.2f MB/s", SV_MBytesPerSecond( streamBytes * numRuns, decodeTime ) );
+		Print( "huff compress:    %8.2f MB/s, %.1f%% of the input",
+		       SV_MBytesPerSecond( streamBytes * numRuns, compressTime ), 100.0 * compressedBytes / streamBytes );
+		Print( "huff decompress:  %8.2f MB/s", SV_MBytesPerSecond( streamBytes * numRuns, decompressTime ) );
+
+		if ( SV_LoopbackInUse() )
+		{
+			Print( "netchan:          skipped, a local client is using the loopback" );
+		}
+		else
+		{
+			RunNetchan( encoded, numRuns, streamBytes, mismatches );
+		}
+
+		if ( mismatches )
+		{
+			Print( "%d entities or messages came back different from what was sent", mismatches );
+		}
+	}
+
+private:
+	// sends the messages from a server netchan to a client one over the
+	// loopback, fragmenting the large ones
+	void RunNetchan( const std::vector<std::vector<byte>> &encoded, int numRuns, int64_t streamBytes, int &mismatches ) const
+	{
+		netadr_t loopback = {};
+		netchan_t serverChan, clientChan;
+		netadr_t from;
+		byte recvBuffer[ MAX_MSGLEN ];
+		msg_t recv;
+		int numPackets = 0, numFragmented = 0;
+
+		loopback.type = netadrtype_t::NA_LOOPBACK;
+		Netchan_Setup( netsrc_t::NS_SERVER, &serverChan, loopback, 0 );
+		Netchan_Setup( netsrc_t::NS_CLIENT, &clientChan, loopback, 0 );
+		MSG_Init( &recv, recvBuffer, sizeof( recvBuffer ) );
+
+		Sys::SteadyClock::time_point start = Sys::SteadyClock::now();
+
+		for ( int run = 0; run < numRuns; run++ )
+		{
+			for ( const std::vector<byte> &message : encoded )
+			{
+				int received = 0;
+
+				Netchan_Transmit( &serverChan, message.size(), message.data() );
+				numFragmented += serverChan.unsentFragments;
+
+				while ( true )
+				{
+					// the loopback only holds a few packets, so each is
+					// processed as soon as it is sent
+					while ( NET_GetLoopPacket( netsrc_t::NS_CLIENT, &from, &recv ) )
+					{
+						numPackets++;
+
+						if ( Netchan_Process( &clientChan, &recv ) )
+						{
+							received++;
+
+							if ( recv.cursize - recv.readcount != int( message.size() ) )
+							{
+								mismatches++;
+							}
+						}
+					}
+
+					if ( !serverChan.unsentFragments )
+					{
+						break;
+					}
+
+					Netchan_TransmitNextFragment( &serverChan );
+				}
+
+				mismatches += received != 1;
+			}
+		}
+
+		Sys::SteadyClock::duration time = Sys::SteadyClock::now() - start;
+
+		Print( "netchan loopback: %8.2f MB/s, %d packets, %d fragmented messages",
+		       SV_MBytesPerSecond( streamBytes * numRuns, time ), numPackets, numFragmented );
+	}
+};
+static NetBenchCmd NetBenchCmdRegistration;
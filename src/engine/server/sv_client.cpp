@@ -38,6 +38,9 @@ Maryland 20850 USA.
 #include "CryptoChallenge.h"
 #include "framework/Network.h"
 
+// Download window of the clients that acknowledge every block in order
+static const int DOWNLOAD_LEGACY_WINDOW = 8;
+
 static void SV_CloseDownload( client_t *cl );
 
 void SV_GetChallenge( netadr_t from )
@@ -515,42 +518,206 @@ void SV_DoneDownload_f( client_t *cl, const Cmd::Args& )
 	SV_SendClientGameState( cl );
 }
 
+/*
+==================
+SV_DownloadTimeout
+
+How long a block may go unacknowledged before it is sent again. It comes
+from the round trip times measured on the blocks, the way TCP does it,
+or from the ping of the client until there is a measurement.
+==================
+*/
+static int SV_DownloadTimeout( const client_t *cl )
+{
+	int timeout;
+
+	if ( cl->downloadSrtt )
+	{
+		timeout = cl->downloadSrtt + 4 * cl->downloadRttVar;
+	}
+	else if ( cl->ping > 0 && cl->ping < 999 )
+	{
+		timeout = 2 * cl->ping;
+	}
+	else
+	{
+		timeout = 1000;
+	}
+
+	// blocks only go out with snapshots
+	return Math::Clamp( timeout + cl->snapshotMsec, 100, 3000 );
+}
+
+/*
+==================
+SV_DownloadAcked
+==================
+*/
+static void SV_DownloadAcked( client_t *cl, int block )
+{
+	int index = block % MAX_DOWNLOAD_WINDOW;
+
+	// the time of a block that was sent again doesn't tell which send arrived
+	if ( cl->downloadBlockSends[ index ] == 1 )
+	{
+		int rtt = std::max( svs.time - cl->downloadBlockSentTime[ index ], 1 );
+
+		if ( !cl->downloadSrtt )
+		{
+			cl->downloadSrtt = rtt;
+			cl->downloadRttVar = rtt / 2;
+		}
+		else
+		{
+			cl->downloadRttVar = ( 3 * cl->downloadRttVar + abs( cl->downloadSrtt - rtt ) ) / 4;
+			cl->downloadSrtt = std::max( ( 7 * cl->downloadSrtt + rtt ) / 8, 1 );
+		}
+	}
+
+	cl->downloadBlockAcked[ index ] = true;
+
+	// grow quickly up to the threshold, then by a block per window
+	if ( cl->downloadCwnd < cl->downloadSsthresh )
+	{
+		cl->downloadCwnd += 1.0f;
+	}
+	else
+	{
+		cl->downloadCwnd += 1.0f / cl->downloadCwnd;
+	}
+
+	// clients that don't acknowledge selectively drop every block after a
+	// lost one, keep their window as small as before
+	int maxWindow = cl->downloadSelectiveAck ? MAX_DOWNLOAD_WINDOW : DOWNLOAD_LEGACY_WINDOW;
+	cl->downloadCwnd = std::min( cl->downloadCwnd, float( maxWindow ) );
+}
+
+/*
+==================
+SV_DownloadLost
+
+Marks a block for sending again and shrinks the window, once for all the
+blocks lost from the same window
+==================
+*/
+static void SV_DownloadLost( client_t *cl, int block )
+{
+	int index = block % MAX_DOWNLOAD_WINDOW;
+
+	// as if its timeout passed
+	cl->downloadBlockSentTime[ index ] = svs.time - 2 * SV_DownloadTimeout( cl );
+
+	if ( block >= cl->downloadRecover )
+	{
+		cl->downloadSsthresh = std::max( int( cl->downloadCwnd / 2 ), 2 );
+		cl->downloadCwnd = cl->downloadSsthresh;
+		cl->downloadRecover = cl->downloadCurrentBlock;
+	}
+}
+
 /*
 ==================
 SV_NextDownload_f
 
-The argument will be the last acknowledged block from the client, it should be
-the same as cl->downloadClientBlock
+The first argument is the last block the client has with all the blocks
+before it. Clients that set sv_dl_selectiveAck also send a bitmap of the
+MAX_DOWNLOAD_WINDOW blocks after it they already got.
 ==================
 */
 void SV_NextDownload_f( client_t *cl, const Cmd::Args& args )
 {
 	int block;
+	int selective = 0;
 	if (args.Argc() < 2 or not Str::ParseInt(block, args.Argv(1))) {
 		return;
 	}
+	if (args.Argc() > 2) {
+		if (not Str::ParseInt(selective, args.Argv(2))) {
+			return;
+		}
 
-	if ( block == cl->downloadClientBlock )
+		cl->downloadSelectiveAck = true;
+	}
+
+	if ( block >= cl->downloadCurrentBlock )
+	{
+		// The client acknowledges a block we never sent, drop the client
+		// FIXME: this is bad... the client will never parse the disconnect message
+		//          because the cgame isn't loaded yet
+		SV_DropClient( cl, "broken download" );
+		return;
+	}
+
+	// older acknowledgements may arrive after newer ones
+	if ( block >= cl->downloadClientBlock )
 	{
 		Log::Debug( "clientDownload: %d: client acknowledge of block %d", ( int )( cl - svs.clients ), block );
 
-		// Find out if we are done.  A zero-length block indicates EOF
-		if ( cl->downloadBlockSize[ cl->downloadClientBlock % MAX_DOWNLOAD_WINDOW ] == 0 )
+		for ( int b = cl->downloadClientBlock; b <= block; b++ )
 		{
-			Log::Notice( "clientDownload: %d : file \"%s\" completed\n", ( int )( cl - svs.clients ), cl->downloadName );
-			SV_CloseDownload( cl );
-			return;
+			int index = b % MAX_DOWNLOAD_WINDOW;
+
+			if ( !cl->downloadBlockAcked[ index ] )
+			{
+				SV_DownloadAcked( cl, b );
+			}
+
+			// Find out if we are done.  A zero-length block indicates EOF
+			if ( cl->downloadBlockSize[ index ] == 0 )
+			{
+				Log::Notice( "clientDownload: %d : file \"%s\" completed in %d ms, %d blocks sent again, rtt %d ms\n",
+				             ( int )( cl - svs.clients ), cl->downloadName, svs.time - cl->downloadStartTime,
+				             cl->downloadResent, cl->downloadSrtt );
+				SV_CloseDownload( cl );
+				return;
+			}
 		}
 
-		cl->downloadSendTime = svs.time;
-		cl->downloadClientBlock++;
-		return;
+		cl->downloadClientBlock = block + 1;
 	}
 
-	// We aren't getting an acknowledge for the correct block, drop the client
-	// FIXME: this is bad... the client will never parse the disconnect message
-	//          because the cgame isn't loaded yet
-	SV_DropClient( cl, "broken download" );
+	int highest = -1;
+
+	for ( int i = 0; i < MAX_DOWNLOAD_WINDOW; i++ )
+	{
+		int b = block + 1 + i;
+
+		if ( !( unsigned( selective ) & ( 1u << i ) ) || b < cl->downloadClientBlock || b >= cl->downloadCurrentBlock )
+		{
+			continue;
+		}
+
+		if ( !cl->downloadBlockAcked[ b % MAX_DOWNLOAD_WINDOW ] )
+		{
+			SV_DownloadAcked( cl, b );
+		}
+
+		highest = b;
+	}
+
+	// a block that three blocks sent after it overtook is lost, there is
+	// no need to wait for its timeout
+	for ( int b = cl->downloadClientBlock; b < highest; b++ )
+	{
+		int index = b % MAX_DOWNLOAD_WINDOW;
+		int overtaken = 0;
+
+		if ( cl->downloadBlockAcked[ index ] || !cl->downloadBlockSends[ index ]
+		     || cl->downloadBlockSentTime[ index ] > cl->downloadBlockSentTime[ highest % MAX_DOWNLOAD_WINDOW ] )
+		{
+			continue;
+		}
+
+		for ( int n = b + 1; n <= highest; n++ )
+		{
+			overtaken += cl->downloadBlockAcked[ n % MAX_DOWNLOAD_WINDOW ];
+		}
+
+		if ( overtaken >= 3 )
+		{
+			SV_DownloadLost( cl, b );
+		}
+	}
 }
 
 /*
@@ -761,7 +928,9 @@ void SV_WriteDownloadToClient( client_t *cl, msg_t *msg )
 		// NOTE: this is called repeatedly while a client connects. Maybe we should sort of cache the message or something
 		// FIXME: we need to abstract this to an independent module for maximum configuration/usability by server admins
 		// FIXME: I could rework that, it's crappy
-		if ( sv_wwwDownload->integer )
+		std::string httpBaseURL = SV_HttpBaseURL();
+
+		if ( sv_wwwDownload->integer || !httpBaseURL.empty() )
 		{
 			std::string name, version;
 			Util::optional<uint32_t> checksum;
@@ -784,7 +953,9 @@ void SV_WriteDownloadToClient( client_t *cl, msg_t *msg )
 			{
 				if ( success )
 				{
-					Q_strncpyz( cl->downloadURL, va("%s/%s", sv_wwwBaseURL->string, pakName.c_str()),
+					// the built-in server has the paks of the map for sure
+					const char *baseURL = httpBaseURL.empty() ? sv_wwwBaseURL->string : httpBaseURL.c_str();
+					Q_strncpyz( cl->downloadURL, va("%s/%s", baseURL, pakName.c_str()),
 								sizeof( cl->downloadURL ) );
 
 					//bani - prevent multiple download notifications
@@ -862,9 +1033,17 @@ void SV_WriteDownloadToClient( client_t *cl, msg_t *msg )
 		}
 
 		// is valid source, init
-		cl->downloadCurrentBlock = cl->downloadClientBlock = cl->downloadXmitBlock = 0;
+		cl->downloadCurrentBlock = cl->downloadClientBlock = 0;
 		cl->downloadCount = 0;
 		cl->downloadEOF = false;
+		cl->downloadCwnd = 2;
+		cl->downloadSsthresh = MAX_DOWNLOAD_WINDOW;
+		cl->downloadSelectiveAck = false;
+		cl->downloadStartTime = svs.time;
+		cl->downloadResent = 0;
+		cl->downloadRecover = 0;
+		cl->downloadSrtt = 0;
+		cl->downloadRttVar = 0;
 
 		bTellRate = true;
 	}
@@ -888,6 +1067,8 @@ void SV_WriteDownloadToClient( client_t *cl, msg_t *msg )
 		}
 
 		cl->downloadCount += cl->downloadBlockSize[ curindex ];
+		cl->downloadBlockSends[ curindex ] = 0;
+		cl->downloadBlockAcked[ curindex ] = false;
 
 		// Load in next block
 		cl->downloadCurrentBlock++;
@@ -897,7 +1078,10 @@ void SV_WriteDownloadToClient( client_t *cl, msg_t *msg )
 	if ( cl->downloadCount == cl->downloadSize &&
 	     !cl->downloadEOF && cl->downloadCurrentBlock - cl->downloadClientBlock < MAX_DOWNLOAD_WINDOW )
 	{
-		cl->downloadBlockSize[ cl->downloadCurrentBlock % MAX_DOWNLOAD_WINDOW ] = 0;
+		curindex = cl->downloadCurrentBlock % MAX_DOWNLOAD_WINDOW;
+		cl->downloadBlockSize[ curindex ] = 0;
+		cl->downloadBlockSends[ curindex ] = 0;
+		cl->downloadBlockAcked[ curindex ] = false;
 		cl->downloadCurrentBlock++;
 
 		cl->downloadEOF = true; // We have added the EOF block
@@ -940,40 +1124,48 @@ void SV_WriteDownloadToClient( client_t *cl, msg_t *msg )
 		blockspersnap = 1;
 	}
 
-	while ( blockspersnap-- )
+	// blocks still on their way that haven't timed out, the window
+	// limits how many there can be
+	int timeout = SV_DownloadTimeout( cl );
+	int inFlight = 0;
+
+	for ( int block = cl->downloadClientBlock; block < cl->downloadCurrentBlock; block++ )
 	{
-		// Write out the next section of the file, if we have already reached our window,
-		// automatically start retransmitting
+		curindex = block % MAX_DOWNLOAD_WINDOW;
 
-		if ( cl->downloadClientBlock == cl->downloadCurrentBlock )
+		if ( cl->downloadBlockAcked[ curindex ] || !cl->downloadBlockSends[ curindex ] )
 		{
-			return; // Nothing to transmit
+			continue;
 		}
 
-		if ( cl->downloadXmitBlock == cl->downloadCurrentBlock )
+		if ( svs.time - cl->downloadBlockSentTime[ curindex ] > timeout )
 		{
-			// We have transmitted the complete window, should we start resending?
-
-			//FIXME:  This uses a hardcoded one second timeout for lost blocks
-			//the timeout should be based on client rate somehow
-			if ( svs.time - cl->downloadSendTime > 1000 )
-			{
-				cl->downloadXmitBlock = cl->downloadClientBlock;
-			}
-			else
-			{
-				return;
-			}
+			SV_DownloadLost( cl, block );
 		}
+		else
+		{
+			inFlight++;
+		}
+	}
+
+	blockspersnap = std::min( blockspersnap, int( cl->downloadCwnd ) - inFlight );
 
-		// Send current block
-		curindex = ( cl->downloadXmitBlock % MAX_DOWNLOAD_WINDOW );
+	// Write out the blocks that were never sent or were lost, oldest first
+	for ( int block = cl->downloadClientBlock; block < cl->downloadCurrentBlock && blockspersnap > 0; block++ )
+	{
+		curindex = block % MAX_DOWNLOAD_WINDOW;
+
+		if ( cl->downloadBlockAcked[ curindex ] ||
+		     ( cl->downloadBlockSends[ curindex ] && svs.time - cl->downloadBlockSentTime[ curindex ] <= timeout ) )
+		{
+			continue;
+		}
 
 		MSG_WriteByte( msg, svc_download );
-		MSG_WriteShort( msg, cl->downloadXmitBlock );
+		MSG_WriteShort( msg, block );
 
 		// block zero is special, contains file size
-		if ( cl->downloadXmitBlock == 0 )
+		if ( block == 0 )
 		{
 			MSG_WriteLong( msg, cl->downloadSize );
 		}
@@ -986,13 +1178,18 @@ void SV_WriteDownloadToClient( client_t *cl, msg_t *msg )
 			MSG_WriteData( msg, cl->downloadBlocks[ curindex ], cl->downloadBlockSize[ curindex ] );
 		}
 
-		Log::Debug( "clientDownload: %d: writing block %d", ( int )( cl - svs.clients ), cl->downloadXmitBlock );
+		Log::Debug( "clientDownload: %d: writing block %d%s", ( int )( cl - svs.clients ), block,
+		            cl->downloadBlockSends[ curindex ] ? " again" : "" );
 
-		// Move on to the next block
 		// It will get sent with next snap shot.  The rate will keep us in line.
-		cl->downloadXmitBlock++;
+		if ( cl->downloadBlockSends[ curindex ] )
+		{
+			cl->downloadResent++;
+		}
 
-		cl->downloadSendTime = svs.time;
+		cl->downloadBlockSentTime[ curindex ] = svs.time;
+		cl->downloadBlockSends[ curindex ]++;
+		blockspersnap--;
 	}
 }
 
@@ -0,0 +1,707 @@
+/*
+===========================================================================
+
+Daemon GPL Source Code
+Copyright (C) 2024 Daemon Developers
+
+This file is part of the Daemon GPL Source Code (Daemon Source Code).
+
+Daemon Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Daemon Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Daemon Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+===========================================================================
+*/
+// sv_http.cpp -- built-in HTTP server for pak downloads
+#include <common/FileSystem.h>
+#include "server.h"
+#include "framework/CvarSystem.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#ifdef _WIN32
+#       include <winsock2.h>
+#       include <ws2tcpip.h>
+#       define socketWouldBlock ( WSAGetLastError() == WSAEWOULDBLOCK )
+using ioctlarg_t = u_long;
+#else
+#       include <arpa/inet.h>
+#       include <fcntl.h>
+#       include <netinet/in.h>
+#       include <sys/ioctl.h>
+#       include <sys/select.h>
+#       include <sys/socket.h>
+#       include <unistd.h>
+#       ifdef __linux__
+#               include <sys/sendfile.h>
+#       endif
+using SOCKET = int;
+using ioctlarg_t = int;
+#       define INVALID_SOCKET   -1
+#       define SOCKET_ERROR     -1
+#       define closesocket      close
+#       define ioctlsocket      ioctl
+#       define socketWouldBlock ( errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR )
+#endif
+
+#ifndef MSG_NOSIGNAL
+#       define MSG_NOSIGNAL 0
+#endif
+
+/*
+=============================================================================
+
+HTTP DOWNLOADS
+
+With sv_httpPort set, a thread listens on that TCP port and serves the
+zip paks the server has loaded, by the name_version.pk3 names the www
+download redirect uses. It only answers GET and HEAD for those names,
+supports single byte ranges so interrupted downloads can resume, and
+paces every client address to sv_httpMaxRate, however many connections
+it opens. When sv_httpAddress is also set, clients that need a pak are
+redirected to it, so the download doesn't go through the game socket.
+Nothing is served while sv_allowDownload is off.
+
+A client gets sv_httpMaxConnectionsPerAddress connections at most, and
+HTTP_HEADER_TIMEOUT_MSEC to send its whole request header, so trickling
+the header a byte at a time doesn't hold a connection open.
+
+On Linux the file data is sent with sendfile(), so it never leaves the
+kernel; elsewhere it is read into a buffer first.
+
+=============================================================================
+*/
+
+static Cvar::Range<Cvar::Cvar<int>> sv_httpPort(
+	"sv_httpPort", "TCP port of the built-in download server, 0 to disable it; read when a map loads",
+	Cvar::NONE, 0, 0, 65535 );
+static Cvar::Cvar<std::string> sv_httpAddress(
+	"sv_httpAddress", "host name or address the clients reach the built-in download server at, "
+	"clients are only redirected to it when this is set", Cvar::NONE, "" );
+static Cvar::Range<Cvar::Cvar<int>> sv_httpMaxRate(
+	"sv_httpMaxRate", "bytes per second sent to each client address, 0 for no limit; read when a map loads",
+	Cvar::NONE, 0, 0, std::numeric_limits<int>::max() );
+static Cvar::Range<Cvar::Cvar<int>> sv_httpMaxConnections(
+	"sv_httpMaxConnections", "most download connections open at the same time; read when a map loads",
+	Cvar::NONE, 16, 1, 256 );
+static Cvar::Range<Cvar::Cvar<int>> sv_httpMaxConnectionsPerAddress(
+	"sv_httpMaxConnectionsPerAddress", "most download connections open from one client address; read when a map loads",
+	Cvar::NONE, 4, 1, 256 );
+
+static const int    HTTP_MAX_REQUEST = 4096;
+static const int    HTTP_CHUNK = 64 * 1024;
+static const int    HTTP_TIMEOUT_MSEC = 30000;
+static const int    HTTP_HEADER_TIMEOUT_MSEC = 10000;
+
+struct httpConnection_t
+{
+	SOCKET      socket;
+	std::string request;
+	std::string header; // response header still to send
+	size_t      headerSent;
+	FILE        *file;
+	int64_t     offset; // next byte of the file to send
+	int64_t     end; // one past the last byte to send
+	uint32_t    address; // IPv4 address of the client, in network order
+	int         accepted;
+	int         lastActive; // last time part of the response went out
+};
+
+static std::thread                                  httpThread;
+static std::atomic<bool>                            httpStop;
+static SOCKET                                       httpSocket = INVALID_SOCKET;
+static int                                          httpPort;
+static std::atomic<int>                             httpMaxRate;
+static std::atomic<int>                             httpMaxConnections;
+static std::atomic<int>                             httpMaxConnectionsPerAddress;
+static std::mutex                                   httpFilesMutex;
+static std::unordered_map<std::string, std::string> httpFiles; // served name -> path
+
+/*
+=================
+SV_HttpFindFile
+=================
+*/
+static bool SV_HttpFindFile( const std::string &name, std::string &path )
+{
+	std::lock_guard<std::mutex> lock( httpFilesMutex );
+	auto it = httpFiles.find( name );
+
+	if ( it == httpFiles.end() )
+	{
+		return false;
+	}
+
+	path = it->second;
+	return true;
+}
+
+static void SV_HttpClose( httpConnection_t &conn )
+{
+	if ( conn.file )
+	{
+		fclose( conn.file );
+		conn.file = nullptr;
+	}
+
+	closesocket( conn.socket );
+	conn.socket = INVALID_SOCKET;
+}
+
+static void SV_HttpRespond( httpConnection_t &conn, int status, const char *reason, const std::string &extra = "" )
+{
+	conn.header = Str::Format( "HTTP/1.1 %d %s\r\nServer: " Q3_ENGINE "\r\nConnection: close\r\n%s\r\n",
+	                           status, reason, extra );
+	conn.headerSent = 0;
+}
+
+/*
+=================
+SV_HttpParseRange
+
+Reads a "bytes=first-last" range, either end may be missing
+=================
+*/
+static bool SV_HttpParseRange( const std::string &value, int64_t size, int64_t &first, int64_t &last )
+{
+	long long a = -1, b = -1;
+	char dash;
+
+	if ( value.compare( 0, 6, "bytes=" ) || value.find( ',' ) != std::string::npos )
+	{
+		return false;
+	}
+
+	const char *spec = value.c_str() + 6;
+
+	if ( sscanf( spec, "%lld%c%lld", &a, &dash, &b ) == 3 && dash == '-' )
+	{
+		first = a;
+		last = std::min<int64_t>( b, size - 1 );
+	}
+	else if ( sscanf( spec, "%lld%c", &a, &dash ) == 2 && dash == '-' )
+	{
+		first = a;
+		last = size - 1;
+	}
+	else if ( sscanf( spec, "-%lld", &b ) == 1 )
+	{
+		// the last b bytes
+		first = std::max<int64_t>( 0, size - b );
+		last = size - 1;
+	}
+	else
+	{
+		return false;
+	}
+
+	return first >= 0 && first <= last && first < size;
+}
+
+/*
+=================
+SV_HttpHandleRequest
+
+Called once the whole request header arrived, sets up the response
+=================
+*/
+static void SV_HttpHandleRequest( httpConnection_t &conn, bool allowDownload )
+{
+	std::string method, target, range;
+	size_t lineEnd = conn.request.find( "\r\n" );
+	std::string requestLine = conn.request.substr( 0, lineEnd );
+	size_t space1 = requestLine.find( ' ' );
+	size_t space2 = requestLine.find( ' ', space1 + 1 );
+
+	if ( space1 == std::string::npos || space2 == std::string::npos )
+	{
+		SV_HttpRespond( conn, 400, "Bad Request" );
+		return;
+	}
+
+	method = requestLine.substr( 0, space1 );
+	target = requestLine.substr( space1 + 2, space2 - space1 - 2 ); // without the leading '/'
+
+	if ( requestLine[ space1 + 1 ] != '/' )
+	{
+		SV_HttpRespond( conn, 400, "Bad Request" );
+		return;
+	}
+
+	for ( size_t start = lineEnd + 2; start < conn.request.size(); )
+	{
+		size_t end = conn.request.find( "\r\n", start );
+		std::string line = conn.request.substr( start, end - start );
+		size_t colon = line.find( ':' );
+
+		// the empty line ends the header
+		if ( line.empty() )
+		{
+			break;
+		}
+
+		if ( colon != std::string::npos && !Q_stricmp( line.substr( 0, colon ).c_str(), "Range" ) )
+		{
+			size_t value = line.find_first_not_of( ' ', colon + 1 );
+			range = value != std::string::npos ? line.substr( value ) : "";
+		}
+
+		start = end + 2;
+	}
+
+	bool head = method == "HEAD";
+
+	if ( method != "GET" && !head )
+	{
+		SV_HttpRespond( conn, 405, "Method Not Allowed", "Allow: GET, HEAD\r\n" );
+		return;
+	}
+
+	if ( !allowDownload )
+	{
+		SV_HttpRespond( conn, 403, "Forbidden", "Content-Length: 0\r\n" );
+		return;
+	}
+
+	std::string path;
+
+	// only the exact names in the table are served, so nothing else on
+	// the disk can be reached by crafting a path
+	if ( !SV_HttpFindFile( target, path ) || !( conn.file = fopen( path.c_str(), "rb" ) ) )
+	{
+		SV_HttpRespond( conn, 404, "Not Found", "Content-Length: 0\r\n" );
+		return;
+	}
+
+	fseek( conn.file, 0, SEEK_END );
+	int64_t size = ftell( conn.file );
+	int64_t first = 0, last = size - 1;
+
+	if ( !range.empty() )
+	{
+		if ( !SV_HttpParseRange( range, size, first, last ) )
+		{
+			SV_HttpRespond( conn, 416, "Range Not Satisfiable", Str::Format( "Content-Range: bytes */%lld\r\n", ( long long ) size ) );
+			fclose( conn.file );
+			conn.file = nullptr;
+			return;
+		}
+
+		SV_HttpRespond( conn, 206, "Partial Content", Str::Format(
+			"Content-Type: application/zip\r\nAccept-Ranges: bytes\r\nContent-Length: %lld\r\nContent-Range: bytes %lld-%lld/%lld\r\n",
+			( long long )( last - first + 1 ), ( long long ) first, ( long long ) last, ( long long ) size ) );
+	}
+	else
+	{
+		SV_HttpRespond( conn, 200, "OK", Str::Format(
+			"Content-Type: application/zip\r\nAccept-Ranges: bytes\r\nContent-Length: %lld\r\n", ( long long ) size ) );
+	}
+
+	conn.offset = first;
+	conn.end = head ? first : last + 1;
+	fseek( conn.file, first, SEEK_SET );
+}
+
+/*
+=================
+SV_HttpRead
+
+Returns false when the connection is done for
+=================
+*/
+static bool SV_HttpRead( httpConnection_t &conn, bool allowDownload )
+{
+	char buffer[ 1024 ];
+	int len = recv( conn.socket, buffer, sizeof( buffer ), 0 );
+
+	if ( len <= 0 )
+	{
+		return len < 0 && socketWouldBlock;
+	}
+
+	conn.request.append( buffer, len );
+
+	if ( conn.request.find( "\r\n\r\n" ) != std::string::npos )
+	{
+		SV_HttpHandleRequest( conn, allowDownload );
+	}
+	else if ( conn.request.size() > HTTP_MAX_REQUEST )
+	{
+		SV_HttpRespond( conn, 431, "Request Header Fields Too Large" );
+	}
+
+	return true;
+}
+
+/*
+=================
+SV_HttpWrite
+
+Returns false when the connection is done for
+=================
+*/
+static bool SV_HttpWrite( httpConnection_t &conn, int maxRate, double &allowance )
+{
+	if ( conn.headerSent < conn.header.size() )
+	{
+		int len = send( conn.socket, conn.header.data() + conn.headerSent, conn.header.size() - conn.headerSent, MSG_NOSIGNAL );
+
+		if ( len < 0 )
+		{
+			return socketWouldBlock;
+		}
+
+		conn.headerSent += len;
+		return true;
+	}
+
+	int64_t count = std::min<int64_t>( conn.end - conn.offset, HTTP_CHUNK );
+
+	if ( maxRate )
+	{
+		count = std::min<int64_t>( count, allowance );
+	}
+
+	if ( count <= 0 )
+	{
+		return conn.offset < conn.end;
+	}
+
+#ifdef __linux__
+	off_t offset = conn.offset;
+	ssize_t len = sendfile( conn.socket, fileno( conn.file ), &offset, count );
+#else
+	char buffer[ HTTP_CHUNK ];
+	int len = -1;
+
+	if ( fseek( conn.file, conn.offset, SEEK_SET ) == 0 && fread( buffer, 1, count, conn.file ) == size_t( count ) )
+	{
+		len = send( conn.socket, buffer, count, MSG_NOSIGNAL );
+	}
+	else
+	{
+		return false;
+	}
+#endif
+
+	if ( len < 0 )
+	{
+		return socketWouldBlock;
+	}
+
+	conn.offset += len;
+	allowance -= len;
+	return len > 0;
+}
+
+/*
+=================
+SV_HttpThread
+=================
+*/
+static void SV_HttpThread( SOCKET listenSocket, const Cvar::SnapshotHandle *allowDownloadCvar )
+{
+	std::vector<httpConnection_t> connections;
+	std::unordered_map<uint32_t, double> allowances; // per client address, bytes that may be sent before the rate limit kicks in
+	int lastTime = Sys_Milliseconds();
+
+	while ( !httpStop )
+	{
+		int now = Sys_Milliseconds();
+		int maxRate = httpMaxRate;
+		bool allowDownload = !allowDownloadCvar || allowDownloadCvar->Get()->integer != 0;
+		bool throttled = false;
+		fd_set readSet, writeSet;
+		SOCKET highest = listenSocket;
+
+		FD_ZERO( &readSet );
+		FD_ZERO( &writeSet );
+
+		if ( int( connections.size() ) < httpMaxConnections )
+		{
+			FD_SET( listenSocket, &readSet );
+		}
+
+		for ( auto &it : allowances )
+		{
+			// up to a second of rate can be saved up
+			it.second = std::min<double>( it.second + double( maxRate ) * ( now - lastTime ) / 1000, maxRate );
+		}
+
+		for ( httpConnection_t &conn : connections )
+		{
+			if ( conn.header.empty() )
+			{
+				FD_SET( conn.socket, &readSet );
+			}
+			else if ( !maxRate || allowances[ conn.address ] >= 1 || conn.headerSent < conn.header.size() )
+			{
+				FD_SET( conn.socket, &writeSet );
+			}
+			else
+			{
+				throttled = true;
+				continue;
+			}
+
+			highest = std::max( highest, conn.socket );
+		}
+
+		lastTime = now;
+
+		timeval timeout = { 0, throttled ? 10000 : 100000 };
+
+		if ( select( highest + 1, &readSet, &writeSet, nullptr, &timeout ) == SOCKET_ERROR )
+		{
+			continue;
+		}
+
+		if ( FD_ISSET( listenSocket, &readSet ) )
+		{
+			sockaddr_in from = {};
+			socklen_t fromLength = sizeof( from );
+			SOCKET socket = accept( listenSocket, ( sockaddr * ) &from, &fromLength );
+			ioctlarg_t nonBlocking = 1;
+
+#ifndef _WIN32
+			// select can't watch it
+			if ( socket >= FD_SETSIZE )
+			{
+				closesocket( socket );
+				socket = INVALID_SOCKET;
+			}
+#endif
+
+			if ( socket != INVALID_SOCKET )
+			{
+				uint32_t address = from.sin_addr.s_addr;
+				int sameAddress = std::count_if( connections.begin(), connections.end(),
+					[ address ]( const httpConnection_t &conn ) { return conn.address == address; } );
+
+				if ( sameAddress >= httpMaxConnectionsPerAddress )
+				{
+					closesocket( socket );
+				}
+				else
+				{
+					ioctlsocket( socket, FIONBIO, &nonBlocking );
+					connections.push_back( { socket, "", "", 0, nullptr, 0, 0, address, now, now } );
+
+					// a new address starts with a full second of rate
+					allowances.emplace( address, double( maxRate ) );
+				}
+			}
+		}
+
+		for ( httpConnection_t &conn : connections )
+		{
+			bool alive = true;
+			int64_t offset = conn.offset;
+			size_t headerSent = conn.headerSent;
+
+			if ( FD_ISSET( conn.socket, &readSet ) )
+			{
+				alive = SV_HttpRead( conn, allowDownload );
+			}
+			else if ( FD_ISSET( conn.socket, &writeSet ) )
+			{
+				alive = SV_HttpWrite( conn, maxRate, allowances[ conn.address ] );
+			}
+
+			// the response is done once the header and the file are out
+			if ( !conn.header.empty() && conn.headerSent == conn.header.size() && conn.offset >= conn.end )
+			{
+				alive = false;
+			}
+
+			if ( conn.header.empty() )
+			{
+				// request bytes don't count as activity, the whole header
+				// has to arrive in time however slowly it is sent
+				if ( now - conn.accepted > HTTP_HEADER_TIMEOUT_MSEC )
+				{
+					alive = false;
+				}
+			}
+			else if ( conn.offset != offset || conn.headerSent != headerSent )
+			{
+				conn.lastActive = now;
+			}
+			else if ( now - conn.lastActive > HTTP_TIMEOUT_MSEC )
+			{
+				alive = false;
+			}
+
+			if ( !alive )
+			{
+				SV_HttpClose( conn );
+			}
+		}
+
+		connections.erase( std::remove_if( connections.begin(), connections.end(),
+			[]( const httpConnection_t &conn ) { return conn.socket == INVALID_SOCKET; } ), connections.end() );
+
+		// forget the addresses that closed all their connections
+		for ( auto it = allowances.begin(); it != allowances.end(); )
+		{
+			uint32_t address = it->first;
+
+			if ( std::none_of( connections.begin(), connections.end(),
+				[ address ]( const httpConnection_t &conn ) { return conn.address == address; } ) )
+			{
+				it = allowances.erase( it );
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+
+	for ( httpConnection_t &conn : connections )
+	{
+		SV_HttpClose( conn );
+	}
+}
+
+/*
+=================
+SV_HttpShutdown
+=================
+*/
+void SV_HttpShutdown()
+{
+	if ( httpThread.joinable() )
+	{
+		httpStop = true;
+		httpThread.join();
+	}
+
+	if ( httpSocket != INVALID_SOCKET )
+	{
+		closesocket( httpSocket );
+		httpSocket = INVALID_SOCKET;
+	}
+
+	httpPort = 0;
+}
+
+/*
+=================
+SV_HttpListen
+=================
+*/
+static bool SV_HttpListen( int port )
+{
+	SOCKET listenSocket = socket( PF_INET, SOCK_STREAM, IPPROTO_TCP );
+	sockaddr_in address = {};
+	ioctlarg_t nonBlocking = 1;
+	int reuse = 1;
+
+	if ( listenSocket == INVALID_SOCKET )
+	{
+		return false;
+	}
+
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = INADDR_ANY;
+	address.sin_port = htons( port );
+
+	setsockopt( listenSocket, SOL_SOCKET, SO_REUSEADDR, ( const char * ) &reuse, sizeof( reuse ) );
+
+	if ( ioctlsocket( listenSocket, FIONBIO, &nonBlocking ) == SOCKET_ERROR
+	     || bind( listenSocket, ( sockaddr * ) &address, sizeof( address ) ) == SOCKET_ERROR
+	     || listen( listenSocket, 16 ) == SOCKET_ERROR )
+	{
+		closesocket( listenSocket );
+		return false;
+	}
+
+	httpSocket = listenSocket;
+	httpPort = port;
+	httpStop = false;
+	httpThread = std::thread( SV_HttpThread, listenSocket, Cvar::GetSnapshotHandle( "sv_allowDownload" ) );
+	return true;
+}
+
+/*
+=================
+SV_HttpUpdate
+
+Called when a map was loaded, serves the paks of the new map and
+(re)starts the listener when the port changed
+=================
+*/
+void SV_HttpUpdate()
+{
+	{
+		std::lock_guard<std::mutex> lock( httpFilesMutex );
+
+		httpFiles.clear();
+
+		for ( const FS::LoadedPakInfo &pak : FS::PakPath::GetLoadedPaks() )
+		{
+			if ( pak.pathPrefix.empty() && pak.type == FS::pakType_t::PAK_ZIP )
+			{
+				httpFiles[ pak.name + "_" + pak.version + ".pk3" ] = pak.path;
+			}
+		}
+	}
+
+	httpMaxRate = sv_httpMaxRate.Get();
+	httpMaxConnections = sv_httpMaxConnections.Get();
+	httpMaxConnectionsPerAddress = sv_httpMaxConnectionsPerAddress.Get();
+
+	int port = sv_httpPort.Get();
+
+	if ( port == httpPort )
+	{
+		return;
+	}
+
+	SV_HttpShutdown();
+
+	if ( !port )
+	{
+		return;
+	}
+
+	if ( SV_HttpListen( port ) )
+	{
+		Log::Notice( "serving downloads over HTTP on port %d", port );
+	}
+	else
+	{
+		Log::Warn( "Couldn't open the download server on TCP port %d", port );
+	}
+}
+
+/*
+=================
+SV_HttpBaseURL
+
+Where the clients find the paks, empty when they should not be sent to
+the built-in server
+=================
+*/
+std::string SV_HttpBaseURL()
+{
+	if ( !httpPort || sv_httpAddress.Get().empty() || !sv_allowDownload->integer )
+	{
+		return "";
+	}
+
+	return Str::Format( "http://%s:%d", sv_httpAddress.Get(), httpPort );
+}
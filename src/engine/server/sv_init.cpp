@@ -493,7 +493,7 @@ void SV_SpawnServer(const std::string pakname, const std::string server)
 	}
 
 	// allocate the snapshot entities on the hunk
-	svs.snapshotEntities = ( entityState_t * ) Hunk_Alloc( sizeof( entityState_t ) * svs.numSnapshotEntities, ha_pref::h_high );
+	svs.snapshotEntities = ( entityState_t * ) Hunk_Alloc( sizeof( entityState_t ) * svs.numSnapshotEntities, hunkTag_t::HT_SERVER );
 	svs.nextSnapshotEntities = 0;
 
 	// toggle the server bit so clients can detect that a
@@ -602,6 +602,7 @@ void SV_SpawnServer(const std::string pakname, const std::string server)
 	// out which pk3s should be auto-downloaded
 
 	Cvar_Set( "sv_paks", FS_LoadedPaks() );
+	SV_HttpUpdate();
 
 	// save systeminfo and serverinfo strings
 	cvar_modifiedFlags &= ~CVAR_SYSTEMINFO;
@@ -690,12 +691,15 @@ void SV_Init()
 	sv_dl_maxRate = Cvar_Get( "sv_dl_maxRate", "42000", 0 );
 
 	sv_wwwDownload = Cvar_Get( "sv_wwwDownload", "0", 0 );
+	// tells clients they can acknowledge download blocks out of order
+	Cvar_Get( "sv_dl_selectiveAck", "1", CVAR_SYSTEMINFO | CVAR_ROM );
 	sv_wwwBaseURL = Cvar_Get( "sv_wwwBaseURL", WWW_BASEURL, 0 );
 	sv_wwwDlDisconnected = Cvar_Get( "sv_wwwDlDisconnected", "0", 0 );
 	sv_wwwFallbackURL = Cvar_Get( "sv_wwwFallbackURL", "", 0 );
 
 	//bani
 	sv_packetdelay = Cvar_Get( "sv_packetdelay", "0", CVAR_CHEAT );
+	sv_packetloss = Cvar_Get( "sv_packetloss", "0", CVAR_CHEAT );
 
 	// fretn - note: redirecting of clients to other servers relies on this,
 	// ET://someserver.com
@@ -776,6 +780,8 @@ void SV_Shutdown( const char *finalmsg )
 
 	SV_RemoveOperatorCommands();
 	SV_MasterShutdown();
+	SV_StopNetCapture();
+	SV_HttpShutdown();
 	SV_ShutdownGameProgs();
 
 	// free current level
@@ -41,6 +41,7 @@ Maryland 20850 USA.
 #include "framework/CommandSystem.h"
 #include "framework/CvarSystem.h"
 #include "framework/Network.h"
+#include "framework/Profiler.h"
 
 serverStatic_t svs; // persistent server info
 server_t       sv; // local server
@@ -82,6 +83,7 @@ cvar_t *sv_wwwFallbackURL; // URL to send to if an http/ftp fails or is refused
 
 //bani
 cvar_t *sv_packetdelay;
+cvar_t *sv_packetloss;
 
 // fretn
 cvar_t *sv_fullmsg;
@@ -1386,6 +1388,8 @@ happen before SV_Frame is called
 */
 void SV_Frame( int msec )
 {
+	PROFILE_ZONE( "SV_Frame" );
+
 	int        frameMsec;
 	int        startTime;
 	char       mapname[ MAX_QPATH ];
@@ -36,6 +36,34 @@ Maryland 20850 USA.
 #include "qcommon/qcommon.h"
 #include "server.h"
 
+#include <deque>
+
+/*
+=============================================================================
+
+QUEUED MESSAGES
+
+Messages sent while the previous one still has fragments to go wait in a
+ring of NETCHAN_QUEUE_SLOTS buffers per client. The ring is allocated the
+first time a client needs it and kept until the client slot is freed, so
+gamestate and snapshot bursts don't go through the allocator.
+
+When the ring is full the oldest message is dropped rather than sent early,
+which would burst past the client rate. Snapshots are superseded by later
+ones, and reliable commands and the gamestate are sent again until the
+client acknowledges them, so a dropped message is recovered like a lost
+packet.
+
+=============================================================================
+*/
+
+static struct
+{
+	int queued; // messages that had to wait
+	int peak; // most messages waiting for one client
+	int overflows; // messages dropped because the queue was full
+} netchanQueueStats;
+
 /*
 =================
 SV_Netchan_FreeQueue
@@ -43,16 +71,35 @@ SV_Netchan_FreeQueue
 */
 void SV_Netchan_FreeQueue( client_t *client )
 {
-	netchan_buffer_t *netbuf, *next;
-
-	for ( netbuf = client->netchan_start_queue; netbuf; netbuf = next )
+	if ( client->netchan_queue )
 	{
-		next = netbuf->next;
-		Z_Free( netbuf );
+		Z_Free( client->netchan_queue );
 	}
 
-	client->netchan_start_queue = nullptr;
-	client->netchan_end_queue = client->netchan_start_queue;
+	client->netchan_queue = nullptr;
+	client->netchan_queueHead = 0;
+	client->netchan_queueCount = 0;
+}
+
+/*
+=================
+SV_Netchan_TransmitQueued
+
+Sends queued messages for as long as nothing is left of the previous one
+=================
+*/
+static void SV_Netchan_TransmitQueued( client_t *client )
+{
+	while ( !client->netchan.unsentFragments && client->netchan_queueCount )
+	{
+		// the last fragment was transmitted, send the oldest queued message
+		netchan_buffer_t *netbuf = &client->netchan_queue[ client->netchan_queueHead ];
+
+		client->netchan_queueHead = ( client->netchan_queueHead + 1 ) % NETCHAN_QUEUE_SLOTS;
+		client->netchan_queueCount--;
+
+		Netchan_Transmit( &client->netchan, netbuf->cursize, netbuf->data );
+	}
 }
 
 /*
@@ -64,29 +111,212 @@ void SV_Netchan_TransmitNextFragment( client_t *client )
 {
 	Netchan_TransmitNextFragment( &client->netchan );
 
-	while ( !client->netchan.unsentFragments && client->netchan_start_queue )
+	SV_Netchan_TransmitQueued( client );
+}
+
+/*
+=================
+SV_Netchan_DropOldest
+=================
+*/
+static void SV_Netchan_DropOldest( client_t *client )
+{
+	netchanQueueStats.overflows++;
+
+	client->netchan_queueHead = ( client->netchan_queueHead + 1 ) % NETCHAN_QUEUE_SLOTS;
+	client->netchan_queueCount--;
+}
+
+/*
+=================
+SV_Netchan_Enqueue
+=================
+*/
+static void SV_Netchan_Enqueue( client_t *client, const msg_t *msg )
+{
+	if ( !client->netchan_queue )
+	{
+		client->netchan_queue = ( netchan_buffer_t * ) Z_Malloc( NETCHAN_QUEUE_SLOTS * sizeof( netchan_buffer_t ) );
+		client->netchan_queueHead = 0;
+		client->netchan_queueCount = 0;
+	}
+
+	if ( client->netchan_queueCount == NETCHAN_QUEUE_SLOTS )
 	{
-		// make sure the netchan queue has been properly initialized (you never know)
-		//% if (!client->netchan_end_queue) {
-		//%     Com_Error(ERR_DROP, "netchan queue is not properly initialized in SV_Netchan_TransmitNextFragment");
-		//% }
-		// the last fragment was transmitted, check whether we have queued messages
-		netchan_buffer_t *netbuf = client->netchan_start_queue;
+		SV_Netchan_DropOldest( client );
+	}
 
-		// pop from queue
-		client->netchan_start_queue = netbuf->next;
+	int slot = ( client->netchan_queueHead + client->netchan_queueCount ) % NETCHAN_QUEUE_SLOTS;
+	netchan_buffer_t *netbuf = &client->netchan_queue[ slot ];
 
-		if ( !client->netchan_start_queue )
+	netbuf->cursize = msg->cursize;
+	memcpy( netbuf->data, msg->data, msg->cursize );
+	client->netchan_queueCount++;
+
+	netchanQueueStats.queued++;
+	netchanQueueStats.peak = std::max( netchanQueueStats.peak, client->netchan_queueCount );
+}
+
+/*
+=================
+SV_Netchan_TestQueue
+
+Sends messages of many sizes over the loopback, two per frame while the
+rate only lets one fragment out, so that messages get queued and the queue
+overflows. Every message that wasn't dropped must reach the client intact
+and in order.
+=================
+*/
+static void SV_Netchan_TestQueue( int numMessages, int &received, int &dropped, int &errors )
+{
+	netadr_t                      loopback = {};
+	netadr_t                      from;
+	netchan_t                     clientChan;
+	std::unique_ptr<client_t>     client( new client_t() );
+	std::deque<std::vector<byte>> expected;
+	byte                          sendBuffer[ MAX_MSGLEN ];
+	byte                          recvBuffer[ MAX_MSGLEN ];
+	msg_t                         send, recv;
+	int                           overflows = netchanQueueStats.overflows;
+	int                           next = 0;
+
+	loopback.type = netadrtype_t::NA_LOOPBACK;
+	Netchan_Setup( netsrc_t::NS_SERVER, &client->netchan, loopback, 0 );
+	Netchan_Setup( netsrc_t::NS_CLIENT, &clientChan, loopback, 0 );
+	MSG_Init( &recv, recvBuffer, sizeof( recvBuffer ) );
+
+	received = 0;
+	errors = 0;
+
+	// the loopback only holds a few packets, so they are read after every send
+	auto receive = [ & ]()
+	{
+		while ( NET_GetLoopPacket( netsrc_t::NS_CLIENT, &from, &recv ) )
+		{
+			if ( !Netchan_Process( &clientChan, &recv ) )
+			{
+				continue;
+			}
+
+			const byte *data = recv.data + recv.readcount;
+			size_t     length = recv.cursize - recv.readcount;
+
+			// skip the messages dropped from the queue, but never go back
+			while ( !expected.empty() && ( expected.front().size() != length || memcmp( expected.front().data(), data, length ) ) )
+			{
+				expected.pop_front();
+			}
+
+			if ( expected.empty() )
+			{
+				errors++;
+				continue;
+			}
+
+			expected.pop_front();
+			received++;
+		}
+	};
+
+	while ( next < numMessages || client->netchan.unsentFragments )
+	{
+		if ( client->netchan.unsentFragments )
 		{
-			client->netchan_end_queue = nullptr;
+			SV_Netchan_TransmitNextFragment( client.get() );
+			receive();
 		}
 
-		Netchan_Transmit( &client->netchan, netbuf->msg.cursize, netbuf->msg.data );
+		for ( int i = 0; i < 2 && next < numMessages; i++, next++ )
+		{
+			int size = 16 + ( next * 7919 ) % ( MAX_MSGLEN / 4 );
+
+			MSG_Init( &send, sendBuffer, sizeof( sendBuffer ) );
+			MSG_WriteLong( &send, next );
+
+			for ( int j = 4; j < size; j++ )
+			{
+				MSG_WriteByte( &send, next * 31 + j );
+			}
 
-		Z_Free( netbuf );
+			SV_Netchan_Transmit( client.get(), &send );
+			expected.emplace_back( send.data, send.data + send.cursize );
+			receive();
+		}
+	}
+
+	dropped = netchanQueueStats.overflows - overflows;
+
+	// only the dropped messages may be missing
+	if ( received + dropped != numMessages )
+	{
+		errors++;
 	}
+
+	SV_Netchan_FreeQueue( client.get() );
 }
 
+class NetchanQueueCmd: public Cmd::StaticCmd
+{
+public:
+	NetchanQueueCmd():
+		StaticCmd("netchanqueue", Cmd::SYSTEM, "Shows the messages waiting for fragmented ones to be sent")
+	{}
+
+	void Run(const Cmd::Args& args) const OVERRIDE
+	{
+		if ( args.Argc() > 1 && args.Argv( 1 ) == "reset" )
+		{
+			netchanQueueStats = {};
+			return;
+		}
+
+		if ( args.Argc() > 1 && args.Argv( 1 ) == "test" )
+		{
+			int numMessages = 1000;
+			int received, dropped, errors;
+
+			if ( args.Argc() > 2 )
+			{
+				numMessages = Math::Clamp( atoi( args.Argv( 2 ).c_str() ), 1, 100000 );
+			}
+
+			if ( SV_LoopbackInUse() )
+			{
+				Print( "A local client is connected, the test needs the loopback" );
+				return;
+			}
+
+			// the test messages don't count in the statistics
+			auto stats = netchanQueueStats;
+			SV_Netchan_TestQueue( numMessages, received, dropped, errors );
+			netchanQueueStats = stats;
+
+			Print( "%d messages: %d received in order, %d dropped from a full queue, %d errors",
+			       numMessages, received, dropped, errors );
+			return;
+		}
+
+		Print( "queued: %d peak: %d/%d overflows: %d",
+		       netchanQueueStats.queued, netchanQueueStats.peak, NETCHAN_QUEUE_SLOTS, netchanQueueStats.overflows );
+
+		if ( !com_sv_running->integer )
+		{
+			return;
+		}
+
+		for ( int i = 0; i < sv_maxclients->integer; i++ )
+		{
+			const client_t &cl = svs.clients[ i ];
+
+			if ( cl.state != clientState_t::CS_FREE && cl.netchan_queue )
+			{
+				Print( "%3d %s: %d waiting", i, cl.name, cl.netchan_queueCount );
+			}
+		}
+	}
+};
+static NetchanQueueCmd NetchanQueueCmdRegistration;
+
 /*
 ===============
 SV_WriteBinaryMessage
@@ -131,33 +361,12 @@ void SV_Netchan_Transmit( client_t *client, msg_t *msg )
 
 	if ( client->netchan.unsentFragments )
 	{
-		netchan_buffer_t *netbuf;
-
 		//Log::Debug("SV_Netchan_Transmit: there are unsent fragments remaining");
-		netbuf = ( netchan_buffer_t * ) Z_Malloc( sizeof( netchan_buffer_t ) );
-
-		MSG_Copy( &netbuf->msg, netbuf->msgBuffer, sizeof( netbuf->msgBuffer ), msg );
-
-		// copy the command, since the command number used for encryption is
-		// already compressed in the buffer, and receiving a new command would
-		// otherwise lose the proper encryption key
-		strcpy( netbuf->lastClientCommandString, client->lastClientCommandString );
-
-		netbuf->next = nullptr;
-
-		if ( !client->netchan_start_queue )
-		{
-			client->netchan_start_queue = netbuf;
-		}
-		else
-		{
-			client->netchan_end_queue->next = netbuf;
-		}
-
-		client->netchan_end_queue = netbuf;
+		SV_Netchan_Enqueue( client, msg );
 
-		// emit the next fragment of the current message for now
-		Netchan_TransmitNextFragment( &client->netchan );
+		// emit the next fragment of the current message for now, the queue
+		// must start right after the last one
+		SV_Netchan_TransmitNextFragment( client );
 	}
 	else
 	{
@@ -39,6 +39,7 @@ Maryland 20850 USA.
 #include "qcommon/crypto.h"
 #include "framework/CommonVMServices.h"
 #include "framework/CommandSystem.h"
+#include "framework/Profiler.h"
 
 // these functions must be used instead of pointer arithmetic, because
 // the game allocates gentities with private information after the server shared part
@@ -337,6 +338,12 @@ static void SV_InitGameVM()
 		svs.clients[ i ].gentity = nullptr;
 	}
 
+	// let the VM use our collision model instead of loading its own
+	if ( CM_SharedModel() )
+	{
+		gvm.SendMsg<VM::ShareCollisionModelMsg>( CM_SharedModel() );
+	}
+
 	// use the current msec count for a random seed
 	// init for this gamestate
 	gvm.GameInit( sv.time, Com_Milliseconds());
@@ -480,6 +487,7 @@ void GameVM::GameMessageRecieved(int clientNum, const uint8_t *buf, size_t size,
 
 void GameVM::Syscall(uint32_t id, Util::Reader reader, IPC::Channel& channel)
 {
+	PROFILE_ZONE("GameVM::Syscall");
 	int major = id >> 16;
 	int minor = id & 0xffff;
 	if (major == VM::QVM) {
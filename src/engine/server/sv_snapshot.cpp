@@ -948,6 +948,7 @@ void SV_SendClientSnapshot( client_t *client )
 
 	// build the snapshot
 	SV_BuildClientSnapshot( client );
+	SV_NetCaptureFrame( client );
 
 	// bots need to have their snapshots built, but
 	// those are queried directly without needing to be sent
@@ -30,6 +30,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "common/Common.h"
 #include "common/IPC/CommonSyscalls.h"
+#include "common/cm/cm_public.h"
 #include "VMMain.h"
 
 // The old console command handler that should be defined in all VMs
@@ -507,6 +508,15 @@ namespace VM {
                 Cvar::HandleSyscall(minor, reader, channel);
                 break;
 
+            case VM::MISC:
+                if (minor != VM::SHARE_COLLISION_MODEL) {
+                    Sys::Drop("Unhandled misc VM syscall minor number %i", minor);
+                }
+                IPC::HandleMsg<VM::ShareCollisionModelMsg>(channel, std::move(reader), [](IPC::SharedMemory shm) {
+                    CM_ReceiveSharedModel(std::move(shm));
+                });
+                break;
+
             default:
                 Sys::Drop("Unhandled common VM syscall major number %i", major);
         }
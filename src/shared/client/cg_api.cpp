@@ -473,6 +473,20 @@ int trap_R_BuildSkeleton( refSkeleton_t *skel, qhandle_t anim, int startFrame, i
 	return result;
 }
 
+void trap_R_BuildSkeletons( const refSkeletonJob_t *jobs, int numJobs, refSkeleton_t *skels, int *results )
+{
+	std::vector<refSkeleton_t> mySkels;
+	std::vector<int> myResults;
+	VM::SendMsg<Render::BuildSkeletonsMsg>(std::vector<refSkeletonJob_t>(jobs, jobs + numJobs), mySkels, myResults);
+
+	if (mySkels.size() != size_t(numJobs) || myResults.size() != size_t(numJobs)) {
+		Sys::Drop("trap_R_BuildSkeletons: got %d skeletons for %d jobs", mySkels.size(), numJobs);
+	}
+
+	std::copy(mySkels.begin(), mySkels.end(), skels);
+	std::copy(myResults.begin(), myResults.end(), results);
+}
+
 // Shamelessly stolen from tr_animation.cpp
 int trap_R_BlendSkeleton( refSkeleton_t *skel, const refSkeleton_t *blend, float frac )
 {